@@ -23,17 +23,88 @@
  * ***************************************************************/
 
 #include "ADC.h"
+#include "flightRecorder.h"
+#include "profiler.h"
 
-circBuf_t g_inBuffer;
+sampleRing_t g_inBuffer;
+
+static uint16_t g_adcBlock[2][ADC_DMA_BLOCK_SIZE];      // Ping-pong blocks filled by the uDMA
+static volatile TickType_t g_sampleTick = 0;            // Tick count at which the newest block completed
+
+// uDMA channel control table. Must be aligned to its own size.
+#if defined(ccs)
+#pragma DATA_ALIGN(g_dmaControlTable, ADC_DMA_TABLE_SIZE)
+static uint8_t g_dmaControlTable[ADC_DMA_TABLE_SIZE];
+#else
+static uint8_t g_dmaControlTable[ADC_DMA_TABLE_SIZE] __attribute__ ((aligned(ADC_DMA_TABLE_SIZE)));
+#endif
+
+
+/*
+ * Function:    armADCBlock
+ * -------------------------
+ * Re-arms one half of the ping-pong uDMA transfer so that it
+ * refills its block from the ADC sequence FIFO.
+ *
+ * @params:
+ *      - uint32_t select: UDMA_PRI_SELECT or UDMA_ALT_SELECT.
+ *      - uint16_t* block: The block to be filled.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+armADCBlock(uint32_t select, uint16_t* block)
+{
+    uDMAChannelTransferSet(ADC_DMA_CHANNEL | select, UDMA_MODE_PINGPONG,
+                           (void *)(ADC_BASE + ADC_O_SSFIFO3), block, ADC_DMA_BLOCK_SIZE);
+}
+
+
+/*
+ * Function:    processADCBlock
+ * -----------------------------
+ * Hands a completed block of samples over to the sample ring
+ * and sets the buffer full flag once enough samples have been
+ * received to find the ground reference.
+ *
+ * @params:
+ *      - const uint16_t* block: The completed block of samples.
+ *      - BaseType_t* higherPriorityTaskWoken: Set if a context
+ *      switch is required on exit from the interrupt.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+processADCBlock(const uint16_t* block, BaseType_t* higherPriorityTaskWoken)
+{
+    uint8_t i;
+    uint32_t ground_flag;
+
+    recordADCBlock(block, ADC_DMA_BLOCK_SIZE);
+    for (i = 0; i < ADC_DMA_BLOCK_SIZE; i++) {
+        writeSampleRing(&g_inBuffer, block[i]);                                 // Writes the ADC value and updates the running sum
+    }
+    g_sampleTick = xTaskGetTickCountFromISR();
+
+    ground_flag = xEventGroupGetBitsFromISR(xFoundAltReference);                // Calculate the current state of the ground flag
+
+    // Check if the ground (0% altitude) value can and should be initalised
+    if ((getSampleRingFill(&g_inBuffer) >= ADC_BUF_SIZE) && (ground_flag == GROUND_NOT_FOUND)) {
+        xEventGroupSetBitsFromISR(xFoundAltReference, GROUND_BUFFER_FULL,
+                                  higherPriorityTaskWoken);                     // Set flag indicating the buffer is full and can now be averaged
+    }
+}
 
 
 /*
  * Function:    ADCIntHandler
  * ---------------------------
- * Handles each interrupt caused by the ADC trigger task.
- * Reads data from the ADC channel and writes to the circular
- * buffer.
- * Sets flag when buffer is filled.
+ * Handles the interrupt raised each time the uDMA completes a
+ * ping-pong block of ADC samples.
+ * Passes the completed block to the sample ring and re-arms
+ * it while the other block is being filled.
  *
  * @params:
  *      - NULL
@@ -44,21 +115,80 @@ circBuf_t g_inBuffer;
 void
 ADCIntHandler(void)
 {
-    uint32_t ulValue;
-    uint32_t ground_flag;
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
 
-    ground_flag = xEventGroupGetBits(xFoundAltReference);                               // Calculate the current state of the ground flag
+    profileStart(PROFILE_ADC_ISR);
+    ADCIntClear(ADC_BASE, ADC_SEQ_NUM);                                         // Clears the interrupt
 
-    // Check if the ground (0% altitude) value can and should be initalised
-    if ((g_inBuffer.windex) == (ADC_BUF_SIZE - 1) && (ground_flag == GROUND_NOT_FOUND)) {
-        xEventGroupSetBitsFromISR(xFoundAltReference, GROUND_BUFFER_FULL, pdFALSE);     // Set flag indicating the buffer is full and can now be averaged
-        UARTSend("ADC Buffer Full\n\r");
+    // A stopped half of the ping-pong transfer has a full block ready
+    if (uDMAChannelModeGet(ADC_DMA_CHANNEL | UDMA_PRI_SELECT) == UDMA_MODE_STOP) {
+        processADCBlock(g_adcBlock[0], &higherPriorityTaskWoken);
+        armADCBlock(UDMA_PRI_SELECT, g_adcBlock[0]);
+    }
+    if (uDMAChannelModeGet(ADC_DMA_CHANNEL | UDMA_ALT_SELECT) == UDMA_MODE_STOP) {
+        processADCBlock(g_adcBlock[1], &higherPriorityTaskWoken);
+        armADCBlock(UDMA_ALT_SELECT, g_adcBlock[1]);
     }
+    profileEnd(PROFILE_ADC_ISR);
 
-    // Sample the analog waveform and store the value in a circular buffer
-    ADCSequenceDataGet(ADC0_BASE, ADC_SEQ_NUM, &ulValue);                         // Runs the A-D Conversion and stores the value in ulValue
-    writeCircBuf(&g_inBuffer, ulValue);                                           // Writes the ADC value to the Circular Buffer
-    ADCIntClear(ADC0_BASE, ADC_SEQ_NUM);                                          // Clears the interrupt
+    portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+
+/*
+ * Function:    initADCTimer
+ * --------------------------
+ * Configures a periodic hardware timer to trigger an ADC
+ * conversion at ADC_SAMPLE_RATE_HZ.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+initADCTimer(void)
+{
+    SysCtlPeripheralEnable(ADC_TIMER_PERIPH);
+    while(!SysCtlPeripheralReady(ADC_TIMER_PERIPH));
+
+    TimerConfigure(ADC_TIMER_BASE, TIMER_CFG_PERIODIC);
+    TimerLoadSet(ADC_TIMER_BASE, TIMER_A, SysCtlClockGet() / ADC_SAMPLE_RATE_HZ - 1);
+    TimerControlTrigger(ADC_TIMER_BASE, TIMER_A, true);                 // Timeouts trigger the ADC sequence
+    TimerEnable(ADC_TIMER_BASE, TIMER_A);
+}
+
+
+/*
+ * Function:    initADCDMA
+ * ------------------------
+ * Configures the uDMA channel of the ADC sequence for ping-pong
+ * transfers into the two sample blocks.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+initADCDMA(void)
+{
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_UDMA));
+
+    uDMAEnable();
+    uDMAControlBaseSet(g_dmaControlTable);
+
+    uDMAChannelAttributeDisable(ADC_DMA_CHANNEL, UDMA_ATTR_ALL);
+    uDMAChannelControlSet(ADC_DMA_CHANNEL | UDMA_PRI_SELECT,
+                          UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
+    uDMAChannelControlSet(ADC_DMA_CHANNEL | UDMA_ALT_SELECT,
+                          UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
+    armADCBlock(UDMA_PRI_SELECT, g_adcBlock[0]);
+    armADCBlock(UDMA_ALT_SELECT, g_adcBlock[1]);
+    uDMAChannelEnable(ADC_DMA_CHANNEL);
 }
 
 
@@ -67,9 +197,11 @@ ADCIntHandler(void)
  * ---------------------
  * Initializes the Analog-Digital conversion.
  * Enables the ADC0 peripheral.
- * Configures the ADC0 sequence on Channel 9.
- * Configures and enables the ADC interrupt.
- * Initializes the circular buffer used to store ADC values.
+ * Configures the ADC0 sequence on Channel 9, triggered by a
+ * hardware timer at ADC_SAMPLE_RATE_HZ.
+ * Configures the uDMA to move samples into ping-pong blocks and
+ * enables the block complete interrupt.
+ * Initializes the sample ring used to store ADC values.
  *
  * @params:
  *      - NULL
@@ -80,41 +212,41 @@ ADCIntHandler(void)
 void
 initADC(void)
 {
+    initSampleRing(&g_inBuffer, ADC_BUF_SIZE);
+
     SysCtlPeripheralEnable(ADC_PERIPH);                                 // Enables ADC peripheral
     while(!SysCtlPeripheralReady(ADC_PERIPH));
 
     ADCSequenceConfigure(ADC_BASE, ADC_SEQ_NUM,
-                         ADC_TRIGGER_PROCESSOR, ADC_PRIORITY);          // Sets module, sample sequence, trigger, and priority
-    ADCSequenceStepConfigure(ADC_BASE, ADC_SEQ_NUM, ADC_STEP,           // Configures the module, sample sequence, step, and channel            // Change to CH9 for heli
-                         ADC_CTL_CH9 | ADC_CTL_IE | ADC_CTL_END);
+                         ADC_TRIGGER_TIMER, ADC_PRIORITY);              // Sets module, sample sequence, trigger, and priority
+    ADCSequenceStepConfigure(ADC_BASE, ADC_SEQ_NUM, ADC_STEP,           // Configures the module, sample sequence, step, and channel
+                         ADC_CHANNEL | ADC_CTL_IE | ADC_CTL_END);
+    ADCSequenceDMAEnable(ADC_BASE, ADC_SEQ_NUM);                        // Each conversion raises a uDMA request instead of an interrupt
+
+    initADCDMA();
+
     ADCSequenceEnable(ADC_BASE, ADC_SEQ_NUM);                           // Enables Sequencing on ADC module
-    ADCIntRegister(ADC_BASE, ADC_SEQ_NUM, ADCIntHandler);               // Registers the interrupt and sets ADCIntHandler to handle the interrupt
-    ADCIntEnable(ADC_BASE, ADC_SEQ_NUM);                                // Enables interrupts on ADC module
+    ADCIntRegister(ADC_BASE, ADC_SEQ_NUM, ADCIntHandler);               // Registers the block complete (uDMA done) interrupt handler
+    IntPrioritySet(ADC_INT, ADC_INT_PRIORITY);                          // Allow the handler to use FreeRTOS ISR functions
 
-    initCircBuf (&g_inBuffer, ADC_BUF_SIZE);
+    initADCTimer();                                                     // Start sampling
 }
 
 
 /*
- * Function:    Trigger_ADC
- * -------------------------
- * FreeRTOS task that periodically triggers the ADC interrupt in
- * order to run the ADC interrupt handler.
+ * Function:    getADCSampleTick
+ * ------------------------------
+ * Returns the tick count at which the newest block of ADC
+ * samples was completed.
  *
  * @params:
  *      - NULL
  * @return:
- *      - NULL
+ *      - TickType_t tick: Tick count of the newest sample.
  * ---------------------
  */
-void
-TriggerADC(void *pvParameters)
+TickType_t
+getADCSampleTick(void)
 {
-    while(1){
-        ADCProcessorTrigger(ADC0_BASE, ADC_SEQ_NUM);                // Trigger an ADC reading
-
-        vTaskDelay(SAMPLING_PERIOD / portTICK_RATE_MS);
-    }
+    return g_sampleTick;
 }
-
-
@@ -27,8 +27,15 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_adc.h"
 #include "driverlib/adc.h"
-#include "OrbitOLED/circBufT.h"
+#include "driverlib/timer.h"
+#include "driverlib/udma.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
+#include "sampleRing.h"
 #include "FreeRTOS.h"
 #include "event_groups.h"
 #include "uart.h"
@@ -39,23 +46,49 @@
 #define ADC_BASE                ADC0_BASE
 #define ADC_PRIORITY            1
 #define ADC_CHANNEL             ADC_CTL_CH9
-#define ADC_BUF_SIZE            8                   // Size of the circular buffer used for moving averages
+#define ADC_INT                 INT_ADC0SS3
+#define ADC_INT_PRIORITY        (2 << 5)            // Interrupt priority. Must be numerically >= configMAX_SYSCALL_INTERRUPT_PRIORITY
+#define ADC_SAMPLE_RATE_HZ      1000                // Rate at which the hardware timer triggers ADC conversions
+#define ADC_TIMER_PERIPH        SYSCTL_PERIPH_TIMER0
+#define ADC_TIMER_BASE          TIMER0_BASE
+#define ADC_DMA_CHANNEL         UDMA_CHANNEL_ADC3
+#define ADC_DMA_BLOCK_SIZE      16                  // Samples per ping-pong block. One interrupt occurs per block
+#define ADC_DMA_TABLE_SIZE      1024                // Size of the uDMA channel control table (bytes)
+#define ADC_BUF_SIZE            64                  // Number of samples in the moving average (up to SAMPLE_RING_CAPACITY)
 #define VOLTAGE_DROP_ADC        1200                // Voltage drop value found on HeliRig
 #define GROUND_NOT_FOUND        (0 << 0)            // Flag value to indicate that ground reference hasn't been found
 #define GROUND_BUFFER_FULL      (1 << 0)            // Flag value to indicate that the ADC buffer is full
 #define GROUND_FOUND            (1 << 1)            // Flag value to indicate that ground reference has been found
 
-extern circBuf_t g_inBuffer;
+extern sampleRing_t g_inBuffer;
 
 
+/*
+ * Function:    ADCIntHandler
+ * ---------------------------
+ * Handles the interrupt raised each time the uDMA completes a
+ * ping-pong block of ADC samples.
+ * Passes the completed block to the sample ring and re-arms
+ * it while the other block is being filled.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void ADCIntHandler(void);
+
 /*
  * Function:    initADC
  * ---------------------
  * Initializes the Analog-Digital conversion.
  * Enables the ADC0 peripheral.
- * Configures the ADC0 sequence on Channel 9.
- * Configures and enables the ADC interrupt.
- * Initializes the circular buffer used to store ADC values.
+ * Configures the ADC0 sequence on Channel 9, triggered by a
+ * hardware timer at ADC_SAMPLE_RATE_HZ.
+ * Configures the uDMA to move samples into ping-pong blocks and
+ * enables the block complete interrupt.
+ * Initializes the sample ring used to store ADC values.
  *
  * @params:
  *      - NULL
@@ -66,19 +99,18 @@ extern circBuf_t g_inBuffer;
 void initADC(void);
 
 /*
- * Function:    Trigger_ADC
- * -------------------------
- * FreeRTOS task that periodically triggers the ADC interrupt in
- * order to run the ADC interrupt handler.
+ * Function:    getADCSampleTick
+ * ------------------------------
+ * Returns the tick count at which the newest block of ADC
+ * samples was completed.
  *
  * @params:
  *      - NULL
  * @return:
- *      - NULL
+ *      - TickType_t tick: Tick count of the newest sample.
  * ---------------------
  */
-void TriggerADC(void *pvParameters);
-
+TickType_t getADCSampleTick(void);
 
 
 #endif /*ADC_H*/
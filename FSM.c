@@ -21,6 +21,37 @@
  * ***************************************************************/
 
 #include "FSM.h"
+#include "autotune.h"
+#include "trajectory.h"
+#include "profiler.h"
+#include "flightState.h"
+
+#define FSM_NO_CHANGE           0xFF    // Next state of an internal transition, which runs its action only
+
+/* ******************************************************
+ * Actions of a state. Either may be NULL.
+ * *****************************************************/
+typedef struct FSMStates {
+    const char* name;
+    void        (*entry)(void);
+    void        (*exit)(void);
+} fsmState_t;
+
+/* ******************************************************
+ * One row of the transition table.
+ * *****************************************************/
+typedef struct FSMRows {
+    uint8_t     state;                  // State the row applies in
+    uint8_t     event;                  // Event that fires it
+    uint8_t     next;                   // State to enter, or FSM_NO_CHANGE
+    bool        (*guard)(void);         // The row only fires if this returns true, may be NULL
+    void        (*action)(void);        // Run between the exit and entry actions, may be NULL
+} fsmRow_t;
+
+static uint8_t g_state = LANDED;                    // Current state
+static int32_t g_descentAlt = LANDING_ALT;          // Desired altitude while LANDING
+static fsmTransition_t g_log[FSM_LOG_SIZE];         // Latest transitions, oldest overwritten first
+static uint32_t g_logCount = 0;                     // Transitions logged since start-up
 
 
 /*
@@ -43,24 +74,20 @@ GetStackUsage(void)
     uint32_t StatusLED_stack;
     uint32_t OLEDDisp_stack;
     uint32_t UARTDisp_stack;
+    uint32_t UARTCmd_stack;
     uint32_t BtnCheck_stack;
     uint32_t SwitchCheck_stack;
-    uint32_t ADCTrig_stack;
-    uint32_t ADCMean_stack;
-    uint32_t MainPWM_stack;
-    uint32_t TailPWM_stack;
+    uint32_t ControlExec_stack;
     uint32_t FSMTask_stack;
 
     // Retrieve stack usage information from each task
     StatusLED_stack   = uxTaskGetStackHighWaterMark(StatLED);
     OLEDDisp_stack    = uxTaskGetStackHighWaterMark(OLEDDisp);
     UARTDisp_stack    = uxTaskGetStackHighWaterMark(UARTDisp);
+    UARTCmd_stack     = uxTaskGetStackHighWaterMark(UARTCmd);
     BtnCheck_stack    = uxTaskGetStackHighWaterMark(BtnCheck);
     SwitchCheck_stack = uxTaskGetStackHighWaterMark(SwiCheck);
-    ADCTrig_stack     = uxTaskGetStackHighWaterMark(ADCTrig);
-    ADCMean_stack     = uxTaskGetStackHighWaterMark(ADCMean);
-    MainPWM_stack     = uxTaskGetStackHighWaterMark(MainPWM);
-    TailPWM_stack     = uxTaskGetStackHighWaterMark(TailPWM);
+    ControlExec_stack = uxTaskGetStackHighWaterMark(ControlExec);
     FSMTask_stack     = uxTaskGetStackHighWaterMark(FSMTask);
 
     // Send stack information via UART
@@ -70,17 +97,13 @@ GetStackUsage(void)
     UARTSend(cMessage);
     usnprintf(cMessage, sizeof(cMessage), "OLEDDisp unused: %d words\n",    UARTDisp_stack);
     UARTSend(cMessage);
+    usnprintf(cMessage, sizeof(cMessage), "UARTCmd unused: %d words\n",     UARTCmd_stack);
+    UARTSend(cMessage);
     usnprintf(cMessage, sizeof(cMessage), "BtnCheck Unused: %d words\n",    BtnCheck_stack);
     UARTSend(cMessage);
     usnprintf(cMessage, sizeof(cMessage), "SwiCheck Unused: %d words\n",    SwitchCheck_stack);
     UARTSend(cMessage);
-    usnprintf(cMessage, sizeof(cMessage), "ADCTrig Unused: %d words\n",     ADCTrig_stack);
-    UARTSend(cMessage);
-    usnprintf(cMessage, sizeof(cMessage), "ADCMean Unused: %d words\n",     ADCMean_stack);
-    UARTSend(cMessage);
-    usnprintf(cMessage, sizeof(cMessage), "MainPWM Unused: %d words\n",     MainPWM_stack);
-    UARTSend(cMessage);
-    usnprintf(cMessage, sizeof(cMessage), "TailPWM Unused: %d words\n",     TailPWM_stack);
+    usnprintf(cMessage, sizeof(cMessage), "Control Unused: %d words\n",     ControlExec_stack);
     UARTSend(cMessage);
     usnprintf(cMessage, sizeof(cMessage), "FSMTask Unused: %d words\n",     FSMTask_stack);
     UARTSend(cMessage);
@@ -92,7 +115,7 @@ GetStackUsage(void)
  * --------------------------------
  * Callback function for the timer started during the
  * landing sequence.
- * Increases timer ID each time function is called.
+ * Posts a landing timer event to the FSM.
  *
  * @params:
  *      - NULL
@@ -102,23 +125,62 @@ GetStackUsage(void)
  */
 void vLandTimerCallback( TimerHandle_t xTimer )
 {
-    uint32_t ulCount;
     UARTSend("Landing Timer Callback\n\r");
+    postFSMEvent(FSM_EVENT_LAND_TIMER);
+}
+
+
+/*
+ * Function:    postFSMEvent
+ * --------------------------
+ * Queues an event for the FSM without blocking. The FSM task
+ * wakes to handle it at once.
+ *
+ * @params:
+ *      - fsmEvent_t event: The event.
+ * @return:
+ *      - bool queued: False if the event queue was full.
+ * ---------------------
+ */
+bool
+postFSMEvent(fsmEvent_t event)
+{
+    uint8_t item = event;
+
+    return xQueueSend(xFSMEventQueue, &item, 0) == pdPASS;
+}
+
+
+/*
+ * Function:    postFSMEventFromISR
+ * ---------------------------------
+ * Queues an event for the FSM from an interrupt.
+ *
+ * @params:
+ *      - fsmEvent_t event: The event.
+ *      - BaseType_t* higherPriorityTaskWoken: Set if the FSM task
+ *      should run when the interrupt returns.
+ * @return:
+ *      - bool queued: False if the event queue was full.
+ * ---------------------
+ */
+bool
+postFSMEventFromISR(fsmEvent_t event, BaseType_t* higherPriorityTaskWoken)
+{
+    uint8_t item = event;
 
-    ulCount = ( uint32_t ) pvTimerGetTimerID( xTimer );
-    ulCount++;
-    vTimerSetTimerID( xTimer, (void *) ulCount );
+    return xQueueSendFromISR(xFSMEventQueue, &item, higherPriorityTaskWoken) == pdPASS;
 }
 
 
 /*
  * Function:    findYawRef
  * ------------------------
- * Disables the PWM control, buttons, and switches.
- * Sets the main PWM to be 50% duty cycle in order for the
+ * Disables the PWM control and the buttons.
+ * Sets the main PWM to be 15% duty cycle in order for the
  * helicopter to spin.
- * Once the yaw reference flag has been set by an interrupt,
- * all tasks resume.
+ * Once the yaw reference has been latched by an interrupt,
+ * the reference found event takes off again.
  *
  * @params:
  *      - NULL
@@ -130,6 +192,8 @@ static void
 findYawRef(void)
 {
     UARTSend("Finding Ref\n\r");
+    enableControl(false);       // Hold off the PWM control systems until ref is found
+    vTaskSuspend(BtnCheck);     // Disable user input while the ref is being found
 
     // Start rotating until reference yaw is found
     setRotorPWM(FIND_REF_PWM_MAIN, IS_MAIN_ROTOR);
@@ -138,13 +202,48 @@ findYawRef(void)
 
 
 /*
- * Function:    takeoff
+ * Function:    enterLanded
+ * -------------------------
+ * Entry action of LANDED.
+ * Disables all input with the exception of the switches, stops
+ * the rotors and resets the controllers.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
  * ---------------------
+ */
+static void
+enterLanded(void)
+{
+    enableControl(false); // Hold off the control system while landed
+    vTaskSuspend(BtnCheck); // Disable changes to yaw and altitude while landed
+
+    // Set motor duty cycles to minimum
+    setRotorPWM(MIN_DUTY, IS_MAIN_ROTOR);
+    setRotorPWM(MIN_DUTY, IS_TAIL_ROTOR);
+
+    // Reset error on controllers
+    resetController(&g_alt_controller);
+    resetController(&g_yaw_controller);
+    resetController(&g_yaw_rate_controller);
+    resetTrajectory(&g_alt_trajectory); // Restart the reference profiles from the measurements on takeoff
+    resetTrajectory(&g_yaw_trajectory);
+
+    // Get max stack usage
+    GetStackUsage();
+}
+
+
+/*
+ * Function:    enterTakeoff
+ * --------------------------
+ * Entry action of TAKEOFF.
  * If the reference has not be found, the findYawRef function is
  * called.
- * If the reference flag has been set, the helicopter ascends to
- * 20% height, and rotates to 0 degrees yaw.
- * Once this position has been reached, the state changes to FLYING.
+ * If the reference has been found, the helicopter ascends to
+ * 15% height, and rotates to 0 degrees yaw.
  *
  * @params:
  *      - NULL
@@ -153,51 +252,24 @@ findYawRef(void)
  * ---------------------
  */
 static void
-takeoff(void)
+enterTakeoff(void)
 {
-    int32_t yaw;
-    int32_t alt;
-    int32_t desired_yaw = 0;
-    int32_t desired_alt = TAKEOFF_ALT;
-    int32_t found_yaw;
-    int32_t state;
-
-    found_yaw = xEventGroupGetBits(xFoundYawReference);
-
-    if(!found_yaw) {                // If the reference yaw has not been found
-        vTaskSuspend(MainPWM);      // Suspend the PWM control systems until ref is found
-        vTaskSuspend(TailPWM);
-        vTaskSuspend(BtnCheck);     // Disable user input while the ref is being found
-        vTaskSuspend(SwiCheck);     // Stop checking the switches until takeoff is complete
-        findYawRef();               // Find the reference yaw
+    if (!isYawReferenced()) {
+        findYawRef(); // Find the reference yaw
     } else {
-        xQueueOverwrite(xYawDesQueue, &desired_yaw); // Rotate to reference yaw
-        xQueueOverwrite(xAltDesQueue, &desired_alt); // Ascend to 20% altitude
-        vTaskResume(MainPWM);       // Re-enable the control system
-        vTaskResume(TailPWM);
+        setReferences(FLIGHT_WRITER_FSM, TAKEOFF_ALT, 0); // Ascend to 15% altitude at the reference yaw
+        enableControl(true);        // Re-enable the control system
         vTaskResume(BtnCheck);      // Re-enable user input
-        vTaskResume(SwiCheck);
-        xQueuePeek(xAltMeasQueue, &alt, TICKS_TO_WAIT); // Retrieve the current altitude value
-        xQueuePeek(xYawMeasQueue, &yaw, TICKS_TO_WAIT); // Retrieve the current yaw value
-
-        if ((yaw > (-YAW_TOLERANCE)) && (yaw < YAW_TOLERANCE)) { // If reached desired yaw
-
-            if (alt > (desired_alt - ALT_TOLERANCE) && (alt < (desired_alt + ALT_TOLERANCE))) { // If reached desired altitude
-
-                state = FLYING;
-                xQueueOverwrite(xFSMQueue, &state); // Set state to hover mode
-            }
-        }
     }
 }
 
 
 /*
- * Function:    hover
- * -------------------
- * Basic flying mode. All tasks are functional.
- * Movement is controlled by the GPIO buttons and the PID
- * controller.
+ * Function:    enterFlying
+ * -------------------------
+ * Entry action of FLYING.
+ * Basic flying mode. Movement is controlled by the GPIO buttons
+ * and the PID controller.
  *
  * @params:
  *      - NULL
@@ -206,23 +278,20 @@ takeoff(void)
  * ---------------------
  */
 static void
-hover(void)
+enterFlying(void)
 {
-    // Resume suspended tasks
-    vTaskResume(MainPWM);
-    vTaskResume(TailPWM);
+    enableControl(true);
     vTaskResume(BtnCheck);
-    vTaskResume(SwiCheck);
 }
 
 
 /*
- * Function:    land
- * ------------------
- * Function that sets the desired altitude to 10%, and then
- * decreases this value by 2% every second.
- * Once the desired position is reached, the state is changed to
- * LANDED.
+ * Function:    enterAutotune
+ * ---------------------------
+ * Entry action of AUTOTUNE.
+ * The control task of the axis being tuned runs the relay
+ * experiment while user input is held off. The switch can still
+ * land.
  *
  * @params:
  *      - NULL
@@ -231,55 +300,95 @@ hover(void)
  * ---------------------
  */
 static void
-land(void)
+enterAutotune(void)
 {
-    int32_t ref_yaw = 0;
-    int32_t meas_yaw;
-    int32_t meas_alt;
-    int32_t state = LANDING;
-    static int32_t descent_alt = LANDING_ALT;
-    static int32_t prev_timerID = 0;
+    enableControl(true);
+    vTaskSuspend(BtnCheck); // Hold the setpoints during the experiment
+}
 
-    int32_t timerID = ( uint32_t ) pvTimerGetTimerID( xLandingTimer );
 
+/*
+ * Function:    enterLanding
+ * --------------------------
+ * Entry action of LANDING.
+ * Returns to the reference yaw and starts descending from the
+ * current altitude. The landing timer steps the descent.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+enterLanding(void)
+{
+    altitudeSample_t alt_sample;
+
+    cancelAutotune(); // Return both rotors to their controllers
+    enableControl(true); // Still off if takeoff was abandoned while finding the reference
     vTaskSuspend(BtnCheck); // Disable changes to yaw and altitude while landing
-    vTaskSuspend(SwiCheck); // Disable changes to the helicopter state while landing
-
-    xQueueOverwrite(xYawDesQueue, &ref_yaw);
-    xQueuePeek(xAltMeasQueue, &meas_alt, TICKS_TO_WAIT);
-    xQueuePeek(xYawMeasQueue, &meas_yaw, TICKS_TO_WAIT);
-
-    if (timerID == 0){
-        xTimerStart(xLandingTimer, TICKS_TO_WAIT); // Starts timer
-        vTimerSetTimerID( xLandingTimer, (void *) 1 );
-        descent_alt = meas_alt;
-    }else if ((timerID != prev_timerID) && (meas_alt <= descent_alt)){
-        descent_alt -= ALT_CHANGE; // Slowely decrement altitude
-        if (descent_alt <= 0){ // When landing the heli gives up sometimes and cuts power before reaching the ground
-            descent_alt = 0;
+
+    getAltMeasured(&alt_sample);
+    g_descentAlt = alt_sample.altitude;
+    setReferences(FLIGHT_WRITER_FSM, g_descentAlt, 0);
+    xTimerStart(xLandingTimer, TICKS_TO_WAIT); // Starts timer
+}
+
+
+/*
+ * Function:    stepDescent
+ * -------------------------
+ * Action of the landing timer event while LANDING.
+ * Lowers the desired altitude by ALT_CHANGE once the helicopter
+ * has come down to it.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+stepDescent(void)
+{
+    altitudeSample_t alt_sample;
+
+    getAltMeasured(&alt_sample);
+    if (alt_sample.altitude <= g_descentAlt) {
+        g_descentAlt -= ALT_CHANGE; // Slowely decrement altitude
+        if (g_descentAlt <= 0) { // When landing the heli gives up sometimes and cuts power before reaching the ground
+            g_descentAlt = 0;
         }
+        setAltDesired(FLIGHT_WRITER_FSM, g_descentAlt);
     }
-    prev_timerID = timerID;
-
-    // Check if have reached landed position
-    if (descent_alt < ALT_TOLERANCE && meas_alt <= ALT_TOLERANCE && (meas_yaw <= YAW_TOLERANCE) && (meas_yaw >= YAW_TOLERANCE)) {
-        UARTSend("LANDING_SEQ_FIN\n\r");
-        state = LANDED;
-        vTimerSetTimerID( xLandingTimer, (void *) 0 );
-        prev_timerID = 0;
-        xTimerStop( xLandingTimer, 0 );
-        vTaskResume(SwiCheck);
-    }
-    xQueueOverwrite(xAltDesQueue, &descent_alt);
-    xQueueOverwrite(xFSMQueue, &state);
 }
 
 
 /*
- * Function:    landed
- * --------------------
- * Disables all input with the exception of the switches.
- * Helicopter is in an idle state.
+ * Function:    isDescended
+ * -------------------------
+ * Guard of the target reached event while LANDING. The target is
+ * only the landed position once the descent has stepped down to
+ * the ground.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - bool descended: True if the desired altitude is the ground.
+ * ---------------------
+ */
+static bool
+isDescended(void)
+{
+    return g_descentAlt < ALT_TOLERANCE;
+}
+
+
+/*
+ * Function:    exitLanding
+ * -------------------------
+ * Exit action of LANDING. Stops the landing timer.
  *
  * @params:
  *      - NULL
@@ -288,33 +397,214 @@ land(void)
  * ---------------------
  */
 static void
-landed(void)
+exitLanding(void)
 {
-    // Suspend unwanted tasks
-    vTaskSuspend(MainPWM); // Suspend the control system while landed
-    vTaskSuspend(TailPWM);
-    vTaskSuspend(BtnCheck); // Disable changes to yaw and altitude while landed
-    vTaskResume(SwiCheck); // Resume checking the switches
+    UARTSend("LANDING_SEQ_FIN\n\r");
+    xTimerStop(xLandingTimer, 0);
+}
 
-    // Set motor duty cycles to minimum
-    setRotorPWM(MIN_DUTY, IS_MAIN_ROTOR);
-    setRotorPWM(MIN_DUTY, IS_TAIL_ROTOR);
 
-    // Reset error on controllers
-    g_alt_controller.previousError   = 0;
-    g_yaw_controller.previousError   = 0;
-    g_alt_controller.integratedError = 0;
-    g_yaw_controller.integratedError = 0;
+/* ******************************************************
+ * State machine tables
+ * *****************************************************/
+
+// Actions of each state, indexed by HELI_STATE
+static const fsmState_t g_states[NUM_STATES] = {
+    { "landed",   enterLanded,   NULL        },
+    { "takeoff",  enterTakeoff,  NULL        },
+    { "flying",   enterFlying,   NULL        },
+    { "landing",  enterLanding,  exitLanding },
+    { "autotune", enterAutotune, NULL        }
+};
+
+// Transitions. Events with no row in the current state, or whose guards all fail, are ignored
+static const fsmRow_t g_table[] = {
+    { LANDED,   FSM_EVENT_SWITCH_UP,       TAKEOFF,       NULL,        NULL           },
+    { TAKEOFF,  FSM_EVENT_REFERENCE_FOUND, TAKEOFF,       NULL,        NULL           }, // Enter again to climb from the reference
+    { TAKEOFF,  FSM_EVENT_TARGET_REACHED,  FLYING,        NULL,        NULL           },
+    { TAKEOFF,  FSM_EVENT_SWITCH_DOWN,     LANDING,       NULL,        NULL           },
+    { FLYING,   FSM_EVENT_SWITCH_DOWN,     LANDING,       NULL,        NULL           },
+    { FLYING,   FSM_EVENT_TUNE_START,      AUTOTUNE,      NULL,        NULL           },
+    { AUTOTUNE, FSM_EVENT_TUNE_END,        FLYING,        NULL,        finishAutotune }, // Report and stage the result
+    { AUTOTUNE, FSM_EVENT_SWITCH_DOWN,     LANDING,       NULL,        NULL           },
+    { LANDING,  FSM_EVENT_LAND_TIMER,      FSM_NO_CHANGE, NULL,        stepDescent    },
+    { LANDING,  FSM_EVENT_SWITCH_UP,       TAKEOFF,       NULL,        NULL           },
+    { LANDING,  FSM_EVENT_TARGET_REACHED,  LANDED,        isDescended, NULL           }
+};
+
+// Names of the events, indexed by fsmEvent_t
+static const char* g_eventNames[NUM_FSM_EVENTS] = {
+    "start", "swup", "swdown", "ref", "reached", "landtmr", "tune", "tuned"  // No event is only logged at start-up
+};
 
-    // Get max stack usage
-    GetStackUsage();
+
+/*
+ * Function:    logTransition
+ * ---------------------------
+ * Adds a transition to the transition log, overwriting the oldest
+ * once it is full.
+ *
+ * @params:
+ *      - uint8_t from: State left.
+ *      - uint8_t to: State entered.
+ *      - fsmEvent_t event: Event that caused it.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+logTransition(uint8_t from, uint8_t to, fsmEvent_t event)
+{
+    fsmTransition_t* entry = &g_log[g_logCount % FSM_LOG_SIZE];
+
+    taskENTER_CRITICAL();
+    entry->tick = xTaskGetTickCount();
+    entry->from = from;
+    entry->to = to;
+    entry->event = event;
+    g_logCount++;
+    taskEXIT_CRITICAL();
+}
+
+
+/*
+ * Function:    enterState
+ * ------------------------
+ * Enters a state: publishes it, logs the transition and runs the
+ * state's entry action.
+ *
+ * @params:
+ *      - uint8_t state: The state to enter.
+ *      - fsmEvent_t event: Event that caused the transition.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+enterState(uint8_t state, fsmEvent_t event)
+{
+    logTransition(g_state, state, event);
+    g_state = state;
+    setFSMState(state);
+    if (g_states[state].entry != NULL) {
+        g_states[state].entry();
+    }
+}
+
+
+/*
+ * Function:    dispatchEvent
+ * ---------------------------
+ * Looks the event up in the transition table for the current
+ * state. The first row whose guard passes fires, and events with
+ * no such row are ignored. A transition to the
+ * same state runs the exit and entry actions again, an internal
+ * one (FSM_NO_CHANGE) only runs its action.
+ *
+ * @params:
+ *      - fsmEvent_t event: The event.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+dispatchEvent(fsmEvent_t event)
+{
+    const fsmRow_t* row;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(g_table) / sizeof(g_table[0]); i++) {
+        row = &g_table[i];
+        if (row->state != g_state || row->event != event || (row->guard != NULL && !row->guard())) {
+            continue;
+        }
+        if (row->next == FSM_NO_CHANGE) {
+            if (row->action != NULL) {
+                row->action();
+            }
+            return;
+        }
+        if (g_states[g_state].exit != NULL) {
+            g_states[g_state].exit();
+        }
+        if (row->action != NULL) {
+            row->action();
+        }
+        enterState(row->next, event);
+        return;
+    }
+}
+
+
+/*
+ * Function:    getFSMTransition
+ * ------------------------------
+ * Copies a transition from the log.
+ *
+ * @params:
+ *      - uint8_t age: 0 for the latest transition, 1 for the one
+ *      before and so on.
+ *      - fsmTransition_t* transition: Filled with the transition.
+ * @return:
+ *      - bool found: False if the log does not go back that far.
+ * ---------------------
+ */
+bool
+getFSMTransition(uint8_t age, fsmTransition_t* transition)
+{
+    bool found;
+
+    taskENTER_CRITICAL();
+    found = age < FSM_LOG_SIZE && age < g_logCount;
+    if (found) {
+        *transition = g_log[(g_logCount - 1 - age) % FSM_LOG_SIZE];
+    }
+    taskEXIT_CRITICAL();
+    return found;
+}
+
+
+/*
+ * Function:    getFSMStateName
+ * -----------------------------
+ * Returns the name of a state.
+ *
+ * @params:
+ *      - uint8_t state: The state.
+ * @return:
+ *      - const char* name: Its name.
+ * ---------------------
+ */
+const char*
+getFSMStateName(uint8_t state)
+{
+    return (state < NUM_STATES) ? g_states[state].name : "?";
 }
 
+
+/*
+ * Function:    getFSMEventName
+ * -----------------------------
+ * Returns the name of an event.
+ *
+ * @params:
+ *      - fsmEvent_t event: The event.
+ * @return:
+ *      - const char* name: Its name.
+ * ---------------------
+ */
+const char*
+getFSMEventName(fsmEvent_t event)
+{
+    return (event < NUM_FSM_EVENTS) ? g_eventNames[event] : "?";
+}
+
+
 /*
  * Function:    FSM
  * -----------------
- * FreeRTOS task that periodically checks the current state of the
- * helicopter and runs the appropriate function.
+ * FreeRTOS task that runs the helicopter's state machine. Blocks
+ * on the event queue and handles each event as it arrives.
  *
  * @params:
  *      - NULL
@@ -325,32 +615,16 @@ landed(void)
 void
 FSM(void *pvParameters) {
 
-    uint32_t state = 0;
+    uint8_t event;
+
+    profileTask(PROFILE_FSM_TASK);
+    enterState(LANDED, FSM_EVENT_NONE);
 
     while(1)
     {
-        xQueuePeek(xFSMQueue, &state, TICKS_TO_WAIT);      // Read the current flight mode/state.
-        switch(state) {
-            case LANDED:
-                landed();
-                break;
-            case TAKEOFF:
-                takeoff();
-                break;
-            case FLYING:
-                hover();
-                break;
-            case LANDING:
-                land();
-                break;
-
-            default:
-                UARTSend("FSM Error\n");
-        }
-
-
-        vTaskDelay(FSM_PERIOD / portTICK_RATE_MS);
-
+        xQueueReceive(xFSMEventQueue, &event, portMAX_DELAY);
+        profileStart(PROFILE_FSM_TASK);
+        dispatchEvent(event);
+        profileEnd(PROFILE_FSM_TASK);
     }
-
 }
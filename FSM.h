@@ -33,14 +33,45 @@
 #include "uart.h"
 #include "FreeRTOSCreate.h"
 
-#define ALT_TOLERANCE           2       // The tolerance in altitude value to trigger state change
-#define YAW_TOLERANCE           2       // The tolerance in yaw value to trigger state change
+#define ALT_TOLERANCE           2       // The altitude error, below which the target is reached
+#define YAW_TOLERANCE           2       // The yaw error, below which the target is reached
 #define FIND_REF_PWM_MAIN       15      // The main rotor PWM used to find the reference yaw
 #define FIND_REF_PWM_TAIL       0       // The tail rotor PWM used to find the reference yaw
 #define TAKEOFF_ALT             15      // The desired altitude during the takeoff sequence
 #define LANDING_ALT             30      // The inital desired altitude during the landing sequence
 #define LAND_TMR_PERIOD         300
 #define UART_MESSAGE_SIZE       17      // The number of chars that will be transmitted over UART
+#define FSM_EVENT_QUEUE_SIZE    8       // Events that can wait for the FSM task
+#define FSM_LOG_SIZE            16      // Transitions kept in the transition log
+
+/* ******************************************************
+ * Events that drive the FSM. The switch task, the yaw
+ * reference interrupt, the landing timer and the UART
+ * commands post them, the control executive posts the
+ * target reached event and the autotune experiment its
+ * end.
+ * *****************************************************/
+typedef enum FSMEvents {
+    FSM_EVENT_NONE = 0,             // No event
+    FSM_EVENT_SWITCH_UP,            // The switch was moved up
+    FSM_EVENT_SWITCH_DOWN,          // The switch was moved down
+    FSM_EVENT_REFERENCE_FOUND,      // The yaw reference was latched
+    FSM_EVENT_TARGET_REACHED,       // The measured altitude and yaw came within tolerance of the desired
+    FSM_EVENT_LAND_TIMER,           // The landing timer expired
+    FSM_EVENT_TUNE_START,           // An autotune experiment was started
+    FSM_EVENT_TUNE_END,             // The autotune experiment finished or was cancelled
+    NUM_FSM_EVENTS
+} fsmEvent_t;
+
+/* ******************************************************
+ * One entry of the transition log.
+ * *****************************************************/
+typedef struct FSMTransitions {
+    TickType_t  tick;               // Tick the state was entered
+    uint8_t     from;               // State left
+    uint8_t     to;                 // State entered
+    uint8_t     event;              // Event that caused the transition
+} fsmTransition_t;
 
 
 /*
@@ -48,7 +79,7 @@
  * --------------------------------
  * Callback function for the timer started during the
  * landing sequence.
- * Increases timer ID each time function is called.
+ * Posts a landing timer event to the FSM.
  *
  * @params:
  *      - NULL
@@ -59,11 +90,86 @@
 void vLandTimerCallback( TimerHandle_t xTimer );
 
 
+/*
+ * Function:    postFSMEvent
+ * --------------------------
+ * Queues an event for the FSM without blocking. The FSM task
+ * wakes to handle it at once.
+ *
+ * @params:
+ *      - fsmEvent_t event: The event.
+ * @return:
+ *      - bool queued: False if the event queue was full.
+ * ---------------------
+ */
+bool postFSMEvent(fsmEvent_t event);
+
+
+/*
+ * Function:    postFSMEventFromISR
+ * ---------------------------------
+ * Queues an event for the FSM from an interrupt.
+ *
+ * @params:
+ *      - fsmEvent_t event: The event.
+ *      - BaseType_t* higherPriorityTaskWoken: Set if the FSM task
+ *      should run when the interrupt returns.
+ * @return:
+ *      - bool queued: False if the event queue was full.
+ * ---------------------
+ */
+bool postFSMEventFromISR(fsmEvent_t event, BaseType_t* higherPriorityTaskWoken);
+
+
+/*
+ * Function:    getFSMTransition
+ * ------------------------------
+ * Copies a transition from the log.
+ *
+ * @params:
+ *      - uint8_t age: 0 for the latest transition, 1 for the one
+ *      before and so on.
+ *      - fsmTransition_t* transition: Filled with the transition.
+ * @return:
+ *      - bool found: False if the log does not go back that far.
+ * ---------------------
+ */
+bool getFSMTransition(uint8_t age, fsmTransition_t* transition);
+
+
+/*
+ * Function:    getFSMStateName
+ * -----------------------------
+ * Returns the name of a state.
+ *
+ * @params:
+ *      - uint8_t state: The state.
+ * @return:
+ *      - const char* name: Its name.
+ * ---------------------
+ */
+const char* getFSMStateName(uint8_t state);
+
+
+/*
+ * Function:    getFSMEventName
+ * -----------------------------
+ * Returns the name of an event.
+ *
+ * @params:
+ *      - fsmEvent_t event: The event.
+ * @return:
+ *      - const char* name: Its name.
+ * ---------------------
+ */
+const char* getFSMEventName(fsmEvent_t event);
+
+
 /*
  * Function:    FSM
- * ------------------------
- * FreeRTOS task that periodically checks the current state of the
- * helicopter and runs the appropriate function.
+ * -----------------
+ * FreeRTOS task that runs the helicopter's state machine. Blocks
+ * on the event queue and handles each event as it arrives.
  *
  * @params:
  *      - NULL
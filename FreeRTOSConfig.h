@@ -25,7 +25,7 @@
 
 #define configUSE_IDLE_HOOK 1
 
-#define configUSE_TICK_HOOK 0
+#define configUSE_TICK_HOOK 1 // Closes the load monitor's windows
 
 #define configUSE_MUTEXES 1
 
@@ -71,14 +71,28 @@
 
 #define configUSE_TIMERS 1
 
-#define configGENERATE_RUN_TIME_STATS 1
+#define configGENERATE_RUN_TIME_STATS 0 // The load monitor keeps each task's share of the CPU
 
-#define configUSE_STATS_FORMATTING_FUNCTIONS 1
+#define configUSE_STATS_FORMATTING_FUNCTIONS 0
 
 #define configUSE_TRACE_FACILITY 1
 
-#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() do {} while (0)
+#ifndef PROFILER_ENABLE
+#define PROFILER_ENABLE 1 // 1 times the profiled handlers and tasks (profiler.h), 0 compiles the timing hooks out
+#endif
 
-#define portGET_RUN_TIME_COUNTER_VALUE() xTaskGetTickCount()
+#define configUSE_APPLICATION_TASK_TAG 1 // Profiled tasks tag themselves with their profile slot
+
+#if PROFILER_ENABLE
+#define traceTASK_SWITCHED_IN() profileTaskSwitchedIn((void *) pxCurrentTCB->pxTaskTag)
+
+#define traceTASK_SWITCHED_OUT() profileTaskSwitchedOut((void *) pxCurrentTCB->pxTaskTag)
+
+// Profiler hooks, declared here as the kernel does not include profiler.h. Kept from the port's assembly files
+#ifndef __ASSEMBLER__
+void profileTaskSwitchedIn(void *tag);
+void profileTaskSwitchedOut(void *tag);
+#endif /* __ASSEMBLER__ */
+#endif /* PROFILER_ENABLE */
 
 #endif /* FREERTOSCONFIG_H_ */
@@ -18,27 +18,20 @@
 TaskHandle_t FSMTask;
 TaskHandle_t OLEDDisp;
 TaskHandle_t UARTDisp;
+TaskHandle_t UARTCmd;
 TaskHandle_t StatLED;
 TaskHandle_t BtnCheck;
 TaskHandle_t SwiCheck;
-TaskHandle_t ADCTrig;
-TaskHandle_t ADCMean;
-TaskHandle_t MainPWM;
-TaskHandle_t TailPWM;
-
-QueueHandle_t xAltMeasQueue;
-QueueHandle_t xAltDesQueue;
-QueueHandle_t xYawMeasQueue;
-QueueHandle_t xYawDesQueue;
-QueueHandle_t xYawSlotQueue;
-QueueHandle_t xFSMQueue;
+TaskHandle_t ControlExec;
+
+QueueHandle_t xUARTRxQueue;
+QueueHandle_t xFSMEventQueue;
 
 SemaphoreHandle_t xUARTMutex;
 SemaphoreHandle_t xUpBtnSemaphore;
 SemaphoreHandle_t xYawFlipSemaphore;
 
 EventGroupHandle_t xFoundAltReference;
-EventGroupHandle_t xFoundYawReference;
 
 TimerHandle_t xUpBtnTimer;
 TimerHandle_t xDownBtnTimer;
@@ -62,12 +55,10 @@ createTasks(void)
     xTaskCreate(StatusLED,      "LED Task",     LED_STACK_DEPTH,        NULL,       LED_TASK_PRIORITY,      &StatLED);
     xTaskCreate(OLEDDisplay,    "OLED Task",    OLED_STACK_DEPTH,       NULL,       OLED_TASK_PRIORITY,     &OLEDDisp);
     xTaskCreate(UARTDisplay,    "UART Task",    UART_STACK_DEPTH,       NULL,       UART_TASK_PRIORITY,     &UARTDisp);
+    xTaskCreate(UARTCommand,    "UART Cmd",     UART_CMD_STACK_DEPTH,   NULL,       UART_CMD_TASK_PRIORITY, &UARTCmd);
     xTaskCreate(ButtonsCheck,   "Btn Poll",     BTN_STACK_DEPTH,        NULL,       BTN_TASK_PRIORITY,      &BtnCheck);
     xTaskCreate(SwitchesCheck,  "Switch Poll",  SWITCH_STACK_DEPTH,     NULL,       SWI_TASK_PRIORITY,      &SwiCheck);
-    xTaskCreate(TriggerADC,     "ADC Handler",  ADC_STACK_DEPTH,        NULL,       ADC_TASK_PRIORITY,      &ADCTrig);
-    xTaskCreate(MeanADC,        "ADC Mean",     MEAN_STACK_DEPTH,       NULL,       MEAN_TASK_PRIORITY,     &ADCMean);
-    xTaskCreate(SetMainDuty,    "Main PWM",     MAIN_PWM_STACK_DEPTH,   NULL,       MAIN_PWM_TASK_PRIORITY, &MainPWM);
-    xTaskCreate(SetTailDuty,    "Tail PWM",     TAIL_PWM_STACK_DEPTH,   NULL,       TAIL_PWM_TASK_PRIORITY, &TailPWM);
+    xTaskCreate(ControlExecutive, "Control",    CONTROL_STACK_DEPTH,    NULL,       CONTROL_TASK_PRIORITY,  &ControlExec);
     xTaskCreate(FSM,            "FSM",          FSM_STACK_DEPTH,        NULL,       FSM_TASK_PRIORITY,      &FSMTask);
 }
 
@@ -76,7 +67,7 @@ createTasks(void)
  * Function:    createQueues
  * -------------------------
  * Creates all FreeRTOS queues used in the system and
- * initialises the values to zero.
+ * clears the shared flight state.
  *
  * @params:
  *      - NULL
@@ -87,23 +78,11 @@ createTasks(void)
 static void
 createQueues(void)
 {
-    int32_t queue_init = 0; // Value used to initalise queuea
-
     // Create queues
-    xAltMeasQueue   = xQueueCreate(1, sizeof( int32_t ) );
-    xAltDesQueue    = xQueueCreate(1, sizeof( int32_t ) );
-    xYawMeasQueue   = xQueueCreate(1, sizeof( int32_t ) );
-    xYawDesQueue    = xQueueCreate(1, sizeof( int32_t ) );
-    xFSMQueue       = xQueueCreate(1, sizeof( int32_t ) );
-    xYawSlotQueue   = xQueueCreate(1, sizeof( int32_t ) );
-
-    // Initalise queues
-    xQueueOverwrite(xAltMeasQueue,       &queue_init);
-    xQueueOverwrite(xAltDesQueue,        &queue_init);
-    xQueueOverwrite(xYawMeasQueue,       &queue_init);
-    xQueueOverwrite(xYawDesQueue,        &queue_init);
-    xQueueOverwrite(xFSMQueue,           &queue_init);
-    xQueueOverwrite(xYawSlotQueue,       &queue_init);
+    xUARTRxQueue    = xQueueCreate(UART_RX_QUEUE_SIZE, sizeof( char ) );
+    xFSMEventQueue  = xQueueCreate(FSM_EVENT_QUEUE_SIZE, sizeof( uint8_t ) );
+
+    initFlightState(); // The shared altitude, yaw and state live in the flight state, not in queues
 }
 
 
@@ -148,11 +127,9 @@ createEventGroups(void)
 
     // Create event groups to act as flags
     xFoundAltReference = xEventGroupCreate();
-    xFoundYawReference = xEventGroupCreate();
 
     // Initalise event groups to zero
     xEventGroupSetBits(xFoundAltReference, event_init);
-    xEventGroupSetBits(xFoundYawReference, event_init);
 }
 
 /*
@@ -28,30 +28,28 @@
 #include "ADC.h"
 #include "altitude.h"
 #include "pwm.h"
+#include "controlExecutive.h"
 #include "FSM.h"
+#include "uartCommand.h"
 
 // Task stack sizes in words, calculated experimentally based on uxTaskGetStackHighWaterMark()
 #define LED_STACK_DEPTH         32
 #define OLED_STACK_DEPTH        128
 #define UART_STACK_DEPTH        128
+#define UART_CMD_STACK_DEPTH    128
 #define BTN_STACK_DEPTH         64
 #define SWITCH_STACK_DEPTH      64
-#define ADC_STACK_DEPTH         32
-#define MEAN_STACK_DEPTH        64
-#define MAIN_PWM_STACK_DEPTH    128
-#define TAIL_PWM_STACK_DEPTH    128
+#define CONTROL_STACK_DEPTH     192
 #define FSM_STACK_DEPTH         128
 
 // Task priorities. Max priority is 8
 #define LED_TASK_PRIORITY       4
 #define OLED_TASK_PRIORITY      4
 #define UART_TASK_PRIORITY      4
+#define UART_CMD_TASK_PRIORITY  4
 #define BTN_TASK_PRIORITY       5
 #define SWI_TASK_PRIORITY       5
-#define ADC_TASK_PRIORITY       8
-#define MEAN_TASK_PRIORITY      7
-#define MAIN_PWM_TASK_PRIORITY  6
-#define TAIL_PWM_TASK_PRIORITY  6
+#define CONTROL_TASK_PRIORITY   7
 #define FSM_TASK_PRIORITY       5
 
 // Task periods (in ms)
@@ -59,10 +57,11 @@
 #define DISPLAY_PERIOD          200         // Period to refresh the OLED display
 #define UART_PERIOD             1000        // The period used to send information over UART
 #define INPUT_PERIOD            25          // The period used for the button and switch polling FreeRTOS tasks
-#define SAMPLING_PERIOD         10          // Period of ADC trigger task used to sample the altitude
-#define ALTITUDE_PERIOD         200         // Period used to average and calculate the altitude
-#define CONTROL_PERIOD          20          // Period used in the control loops
-#define FSM_PERIOD              200         // Period used to control state changes in the helicopter's FSM
+#define ALTITUDE_PERIOD         CONTROL_PERIOD // Initial period used to average and calculate the altitude. Runs with the altitude loop
+#ifndef CONTROL_RATE_HZ
+#define CONTROL_RATE_HZ         50          // Rate of the control loops. Up to 1000, and must divide 1000
+#endif
+#define CONTROL_PERIOD          (1000 / CONTROL_RATE_HZ) // Period used in the control loops
 
 // Timer periods
 #define DBL_BTN_TMR_PERIOD      1000
@@ -75,27 +74,20 @@
 extern TaskHandle_t FSMTask;
 extern TaskHandle_t OLEDDisp;
 extern TaskHandle_t UARTDisp;
+extern TaskHandle_t UARTCmd;
 extern TaskHandle_t StatLED;
 extern TaskHandle_t BtnCheck;
 extern TaskHandle_t SwiCheck;
-extern TaskHandle_t ADCTrig;
-extern TaskHandle_t ADCMean;
-extern TaskHandle_t MainPWM;
-extern TaskHandle_t TailPWM;
+extern TaskHandle_t ControlExec;
 
-extern QueueHandle_t xAltMeasQueue;
-extern QueueHandle_t xAltDesQueue;
-extern QueueHandle_t xYawMeasQueue;
-extern QueueHandle_t xYawDesQueue;
-extern QueueHandle_t xYawSlotQueue;
-extern QueueHandle_t xFSMQueue;
+extern QueueHandle_t xUARTRxQueue;
+extern QueueHandle_t xFSMEventQueue;
 
 extern SemaphoreHandle_t xUARTMutex;
 extern SemaphoreHandle_t xUpBtnSemaphore;
 extern SemaphoreHandle_t xYawFlipSemaphore;
 
 extern EventGroupHandle_t xFoundAltReference;
-extern EventGroupHandle_t xFoundYawReference;
 
 extern TimerHandle_t xUpBtnTimer;
 extern TimerHandle_t xDownBtnTimer;
@@ -14,6 +14,8 @@
  * ***************************************************************/
 
 #include "OLED.h"
+#include "profiler.h"
+#include "flightState.h"
 
 
 /*
@@ -32,33 +34,31 @@ void
 OLEDDisplay (void *pvParameters)
 {
     char string[DISPLAY_SIZE];  // String of the correct size to be displayed on the OLED screen
-    int32_t    des_alt;         // Desired altitude
-    int32_t    act_alt;         // Actual altitude
-    int32_t    des_yaw;         // Desired yaw
+    flightState_t flight;       // Desired and actual altitude, desired yaw and FSM state
     int32_t    act_yaw;         // Actual yaw
     uint32_t   main_PWM;        // Current main duty cycle
     uint32_t   tail_PWM;        // Current tail duty cycle
-    uint32_t   state;           // Current state in the FSM
 
-    char* states[NUM_STATES] = {"Landed", "Take Off", "Flying", "Landing"};
+    char* states[NUM_STATES] = {"Landed", "Take Off", "Flying", "Landing", "Autotune"};
+
+    profileTask(PROFILE_OLED_TASK);
 
     while(1)
     {
+        profileStart(PROFILE_OLED_TASK);
+
         // Retrieve altitude, yaw and PWM information
-        xQueuePeek(xAltDesQueue, &des_alt, TICKS_TO_WAIT);
-        xQueuePeek(xAltMeasQueue, &act_alt, TICKS_TO_WAIT);
-        xQueuePeek(xYawDesQueue, &des_yaw, TICKS_TO_WAIT);
-        xQueuePeek(xYawMeasQueue, &act_yaw, TICKS_TO_WAIT);
-        xQueuePeek(xFSMQueue, &state, TICKS_TO_WAIT);
+        getFlightState(&flight);
+        act_yaw = getYaw();
         main_PWM = PWMPulseWidthGet(PWM0_BASE, PWM_OUT_7);
         tail_PWM = PWMPulseWidthGet(PWM1_BASE, PWM_OUT_5);
 
         // Print altitude information
-        usnprintf(string, sizeof(string), "Alt(%%) %3d|%3d ", des_alt, act_alt);
+        usnprintf(string, sizeof(string), "Alt(%%) %3d|%3d ", flight.altDesired, flight.altMeasured.altitude);
         OLEDStringDraw(string, COLUMN_ZERO, ROW_ZERO);
 
         // Print yaw information
-        usnprintf(string, sizeof(string), "Yaw   %4d|%3d ", des_yaw, act_yaw);
+        usnprintf(string, sizeof(string), "Yaw   %4d|%3d ", flight.yawDesired, act_yaw);
         OLEDStringDraw(string, COLUMN_ZERO, ROW_ONE);
 
         // Print PWM information
@@ -66,8 +66,9 @@ OLEDDisplay (void *pvParameters)
         OLEDStringDraw(string, COLUMN_ZERO, ROW_TWO);
 
         // Print state information
-        usnprintf(string, sizeof(string), "%s     ", states[state]);
+        usnprintf(string, sizeof(string), "%s     ", states[flight.fsmState]);
         OLEDStringDraw(string, COLUMN_ZERO, ROW_THREE);
+        profileEnd(PROFILE_OLED_TASK);
 
         vTaskDelay(DISPLAY_PERIOD / portTICK_RATE_MS);
     }
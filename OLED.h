@@ -32,7 +32,7 @@
 #define ROW_THREE               3       // Row three on the OLED display
 #define COLUMN_ZERO             0       // Column zero on the OLED display
 #define DISPLAY_SIZE            17      // Size of strings for the OLED display
-#define NUM_STATES              4       // The number of helicopter states
+#define NUM_STATES              5       // The number of helicopter states
 
 
 /*
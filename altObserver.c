@@ -0,0 +1,100 @@
+/* ****************************************************************
+ * altObserver.c
+ *
+ * Source file for the altitude observer module
+ * Fixed-point alpha-beta observer which estimates the helicopter's
+ * altitude and vertical velocity from the averaged ADC readings.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include "altObserver.h"
+
+#define MS_PER_SECOND       1000        // Conversion factor from ms to s
+
+
+/*
+ * Function:    initObserver
+ * --------------------------
+ * Initialises an alpha-beta observer for a fixed update period.
+ *
+ * @params:
+ *      - observer_t* observer: The observer to initialise.
+ *      - int32_t alpha: Position correction gain (Q16.16).
+ *      - int32_t beta: Velocity correction gain (Q16.16).
+ *      - uint32_t timeStep: Update period in ms.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initObserver(observer_t* observer, int32_t alpha, int32_t beta, uint32_t timeStep)
+{
+    observer->position = 0;
+    observer->velocity = 0;
+    observer->alpha = alpha;
+    observer->beta = beta;
+    observer->initialised = false;
+    setObserverTimeStep(observer, timeStep);
+}
+
+
+/*
+ * Function:    setObserverTimeStep
+ * ---------------------------------
+ * Changes the update period of an observer, keeping its state.
+ *
+ * @params:
+ *      - observer_t* observer: The observer to modify.
+ *      - uint32_t timeStep: Update period in ms.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+setObserverTimeStep(observer_t* observer, uint32_t timeStep)
+{
+    observer->betaRate = (int32_t) ((int64_t) observer->beta * MS_PER_SECOND / timeStep);
+    observer->timeStep = (int32_t) (((int64_t) timeStep << OBSERVER_Q_BITS) / MS_PER_SECOND);
+}
+
+
+/*
+ * Function:    updateObserver
+ * ----------------------------
+ * Predicts the state forward by one time step and corrects it
+ * with a new measurement. The first measurement initialises the
+ * position with zero velocity.
+ *
+ * @params:
+ *      - observer_t* observer: The observer to update.
+ *      - int32_t measurement: New measurement (Q16.16).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+updateObserver(observer_t* observer, int32_t measurement)
+{
+    int32_t predicted;
+    int32_t residual;
+
+    if (!observer->initialised) {
+        observer->position = measurement;
+        observer->velocity = 0;
+        observer->initialised = true;
+        return;
+    }
+
+    // Predict the position one step ahead, then correct both states with the residual
+    predicted = observer->position + (int32_t) (((int64_t) observer->velocity * observer->timeStep) >> OBSERVER_Q_BITS);
+    residual = measurement - predicted;
+
+    observer->position = predicted + (int32_t) (((int64_t) observer->alpha * residual) >> OBSERVER_Q_BITS);
+    observer->velocity += (int32_t) (((int64_t) observer->betaRate * residual) >> OBSERVER_Q_BITS);
+}
@@ -0,0 +1,90 @@
+/* ****************************************************************
+ * altObserver.h
+ *
+ * Header file for the altitude observer module
+ * Fixed-point alpha-beta observer which estimates the helicopter's
+ * altitude and vertical velocity from the averaged ADC readings.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef ALTOBSERVER_H_
+#define ALTOBSERVER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define OBSERVER_Q_BITS     16                      // Fractional bits of observer values (Q16.16)
+#define OBSERVER_Q_ONE      (1 << OBSERVER_Q_BITS)
+#define ALT_OBSERVER_ALPHA  22938                   // Position correction gain, 0.35 in Q16.16
+#define ALT_OBSERVER_BETA   3932                    // Velocity correction gain, 0.06 in Q16.16
+
+
+/* ******************************************************
+ * State of an alpha-beta observer. Position is in the
+ * measurement's units and velocity in units per second,
+ * both in Q16.16.
+ * *****************************************************/
+typedef struct Observers {
+    int32_t     position;       // Estimated position (Q16.16)
+    int32_t     velocity;       // Estimated velocity per second (Q16.16)
+    int32_t     alpha;          // Position correction gain (Q16.16)
+    int32_t     beta;           // Velocity correction gain (Q16.16)
+    int32_t     betaRate;       // Velocity correction gain divided by the time step in seconds (Q16.16)
+    int32_t     timeStep;       // Time step in seconds (Q16.16)
+    bool        initialised;    // False until the first measurement has been applied
+} observer_t;
+
+
+/*
+ * Function:    initObserver
+ * --------------------------
+ * Initialises an alpha-beta observer for a fixed update period.
+ *
+ * @params:
+ *      - observer_t* observer: The observer to initialise.
+ *      - int32_t alpha: Position correction gain (Q16.16).
+ *      - int32_t beta: Velocity correction gain (Q16.16).
+ *      - uint32_t timeStep: Update period in ms.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initObserver(observer_t* observer, int32_t alpha, int32_t beta, uint32_t timeStep);
+
+/*
+ * Function:    setObserverTimeStep
+ * ---------------------------------
+ * Changes the update period of an observer, keeping its state.
+ *
+ * @params:
+ *      - observer_t* observer: The observer to modify.
+ *      - uint32_t timeStep: Update period in ms.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void setObserverTimeStep(observer_t* observer, uint32_t timeStep);
+
+/*
+ * Function:    updateObserver
+ * ----------------------------
+ * Predicts the state forward by one time step and corrects it
+ * with a new measurement. The first measurement initialises the
+ * position with zero velocity.
+ *
+ * @params:
+ *      - observer_t* observer: The observer to update.
+ *      - int32_t measurement: New measurement (Q16.16).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void updateObserver(observer_t* observer, int32_t measurement);
+
+#endif /* ALTOBSERVER_H_ */
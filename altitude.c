@@ -14,77 +14,67 @@
 
 #include "altitude.h"
 
+static observer_t g_observer;                   // Altitude and vertical velocity estimator
+static int32_t g_ground;                        // ADC reading at ground level
+static int32_t g_altitude = 0;                  // Latest altitude estimate (%)
+static uint32_t g_observerStep = ALTITUDE_PERIOD; // Period the observer is set for (ms)
+static volatile bool g_groundPending = false;   // True from finding the ground reference until it is reported
+
 
 /*
  * Function:    calculateMean
  * ---------------------------
- * Sums up all values in the circular buffer and then divides by the
- * number of elements in order to calculate the average value of
- * the circular buffer.
+ * Returns the average value of the ADC sample ring. The ring keeps
+ * a running sum as samples arrive, so this is constant time
+ * regardless of ADC_BUF_SIZE.
  *
  * @params:
  *      - NULL
  * @return:
- *      - int32_t mean: The average value of the circular
- *      buffer.
+ *      - int32_t mean: The average value of the sample ring.
  * ---------------------
  */
 static int32_t
 calculateMean(void)
 {
-    uint8_t i;
-    int32_t sum = 0;
-    int32_t reading;
-    int32_t mean = 0;
-
-    // Sum all values in the circular buffer
-    for (i = 0; i < ADC_BUF_SIZE; i++){
-        reading = readCircBuf(&g_inBuffer);
-        sum = sum + reading;
-    }
-
-    mean = (sum/ADC_BUF_SIZE);
-    return mean;
+    return readSampleRingMean(&g_inBuffer);
 }
 
 
 /*
  * Function:    percentageHeight
  * ------------------------------
- * Converts the average value of the circular buffer to a percentage
- * value of the maximum height.
+ * Converts the average value of the sample ring to a percentage
+ * value of the maximum height, keeping the fractional part so the
+ * observer is not fed quantised percentages.
  *
  * @params:
  *      - int32_t groundLevel: The ADC value when the helicopter is
  *      grounded. Used as a reference to 0% height.
- *      - int32_t currentValue: The current circular buffer average
+ *      - int32_t currentValue: The current sample ring average
  *      to be converted to a percentage height.
  * @return:
- *      - int32_t percent: The current circular buffer average as a
- *      percentage of the total height range.
+ *      - int32_t percent: The current sample ring average as a
+ *      percentage of the total height range (Q16.16).
  * ---------------------
  */
 static int32_t
 percentageHeight(int32_t groundLevel, int32_t currentValue)
 {
-    //char cMessage[17];
-    int32_t maxHeight = 0;
     int32_t percent = 0;
 
-    maxHeight = groundLevel - VOLTAGE_DROP_ADC;                      // ADC value at maximum height
-    percent = HUNDRED_PERCENT - HUNDRED_PERCENT *
-            (currentValue - maxHeight)/(VOLTAGE_DROP_ADC);           // Calculates percentage altitude
+    percent = (int32_t) (((int64_t) HUNDRED_PERCENT * OBSERVER_Q_ONE *
+            (groundLevel - currentValue)) / VOLTAGE_DROP_ADC);       // Calculates percentage altitude
 
     return percent;
 }
 
 
 /*
- * Function:    Mean_ADC
- * ----------------------
- * FreeRTOS task that periodically calls functions to calculate the
- * current average value of the circular buffer, and then converts
- * to percentage height.
+ * Function:    initAltitude
+ * --------------------------
+ * Starts the altitude observer. Must be called before
+ * updateAltitude.
  *
  * @params:
  *      - NULL
@@ -93,33 +83,87 @@ percentageHeight(int32_t groundLevel, int32_t currentValue)
  * ---------------------
  */
 void
-MeanADC(void *pvParameters)
+initAltitude(void)
+{
+    initObserver(&g_observer, ALT_OBSERVER_ALPHA, ALT_OBSERVER_BETA, ALTITUDE_PERIOD);
+    g_observerStep = ALTITUDE_PERIOD;
+}
+
+
+/*
+ * Function:    updateAltitude
+ * ----------------------------
+ * Called by the control executive each time the altitude loop
+ * runs. Calculates the current average value of the sample ring,
+ * converts it to percentage height, and publishes a timestamped
+ * altitude and vertical velocity estimated by the altitude
+ * observer.
+ *
+ * @params:
+ *      - altitudeSample_t* sample: Filled with the new estimate.
+ *      - uint32_t timeStep: The altitude loop period (ms). The
+ *      observer follows it when it is changed at runtime.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+updateAltitude(altitudeSample_t* sample, uint32_t timeStep)
 {
-    char cMessage[17];
     int32_t mean;
-    int32_t altitude = 0;
-    static int32_t ground;
     int32_t ground_flag;
 
-    while(1){
-        ground_flag = xEventGroupGetBits(xFoundAltReference); // Retrieve the current state of the ground reference
-
-        // Set ground reference if needed
-        if (ground_flag == GROUND_BUFFER_FULL) {
-            ground = calculateMean();
-            xEventGroupClearBits(xFoundAltReference, GROUND_BUFFER_FULL); // Clear previous flag
-            xEventGroupSetBits(xFoundAltReference, GROUND_FOUND); // Set flag indicating that the ground reference has been set
-            usnprintf(cMessage, sizeof(cMessage), "Ground Found: %d\n\r", ground);
-            UARTSend(cMessage);
-
-        // If ground reference has already been set, calculate the current average ADC reading
-        } else if (ground_flag == GROUND_FOUND) {
-            mean = calculateMean();
-            altitude = percentageHeight(ground, mean);
+    ground_flag = xEventGroupGetBits(xFoundAltReference); // Retrieve the current state of the ground reference
+
+    // Set ground reference if needed
+    if (ground_flag == GROUND_BUFFER_FULL) {
+        g_ground = calculateMean();
+        xEventGroupClearBits(xFoundAltReference, GROUND_BUFFER_FULL); // Clear previous flag
+        xEventGroupSetBits(xFoundAltReference, GROUND_FOUND); // Set flag indicating that the ground reference has been set
+        setSampleRingWindow(&g_inBuffer, ALT_FILTER_WINDOW); // The observer does the smoothing from here on
+        g_groundPending = true; // Reported by a lower priority task, as the UART can block
+
+    // If ground reference has already been set, calculate the current average ADC reading
+    } else if (ground_flag == GROUND_FOUND) {
+        if (timeStep != g_observerStep) {
+            setObserverTimeStep(&g_observer, timeStep); // The altitude loop period was changed over UART
+            g_observerStep = timeStep;
         }
+        mean = calculateMean();
+        updateObserver(&g_observer, percentageHeight(g_ground, mean));
+        g_altitude = (g_observer.position + OBSERVER_Q_ONE / 2) >> OBSERVER_Q_BITS; // Round to the nearest percent
+    }
+
+    // Stamp the estimate with its time and the age of the newest ADC sample used
+    sample->altitude = g_altitude;
+    sample->rate = g_observer.velocity;
+    sample->timestamp = xTaskGetTickCount();
+    sample->sampleAge = sample->timestamp - getADCSampleTick();
+    setAltMeasured(sample); // Publish the new measurement
+}
+
 
-        xQueueOverwrite(xAltMeasQueue, &altitude); // Update the altitude queue with the new measurement
+/*
+ * Function:    reportGround
+ * --------------------------
+ * Sends the ground reference over UART once, after updateAltitude
+ * has found it. Called from a low priority task so the control
+ * executive never waits on the UART.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+reportGround(void)
+{
+    char cMessage[23];
 
-        vTaskDelay(ALTITUDE_PERIOD / portTICK_RATE_MS);
+    if (g_groundPending) {
+        g_groundPending = false;
+        usnprintf(cMessage, sizeof(cMessage), "Ground Found: %d\n\r", g_ground);
+        UARTSend(cMessage);
     }
 }
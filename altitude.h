@@ -18,22 +18,59 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "ADC.h"
+#include "altObserver.h"
 #include "utils/ustdlib.h"
-#include "OrbitOLED/circBufT.h"
+#include "sampleRing.h"
 #include "uart.h"
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "event_groups.h"
 #include "FreeRTOSCreate.h"
+#include "flightState.h"
 
 #define HUNDRED_PERCENT     100         // Value used for percentage calculations
+#define ALT_FILTER_WINDOW   16          // ADC samples averaged ahead of the observer once the ground is found
+
+
+/*
+ * Function:    initAltitude
+ * --------------------------
+ * Starts the altitude observer. Must be called before
+ * updateAltitude.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initAltitude(void);
+
+/*
+ * Function:    updateAltitude
+ * ----------------------------
+ * Called by the control executive each time the altitude loop
+ * runs. Calculates the current average value of the sample ring,
+ * converts it to percentage height, and publishes a timestamped
+ * altitude and vertical velocity estimated by the altitude
+ * observer.
+ *
+ * @params:
+ *      - altitudeSample_t* sample: Filled with the new estimate.
+ *      - uint32_t timeStep: The altitude loop period (ms). The
+ *      observer follows it when it is changed at runtime.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void updateAltitude(altitudeSample_t* sample, uint32_t timeStep);
 
 /*
- * Function:    Mean_ADC
- * ----------------------
- * FreeRTOS task that periodically calls functions to calculate the
- * current average value of the circular buffer, and then converts
- * to percentage height.
+ * Function:    reportGround
+ * --------------------------
+ * Sends the ground reference over UART once, after updateAltitude
+ * has found it. Called from a low priority task so the control
+ * executive never waits on the UART.
  *
  * @params:
  *      - NULL
@@ -41,6 +78,6 @@
  *      - NULL
  * ---------------------
  */
-void MeanADC(void *pvParameters);
+void reportGround(void);
 
 #endif /* ALTITUDE_H_ */
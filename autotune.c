@@ -0,0 +1,461 @@
+/* ****************************************************************
+ * autotune.c
+ *
+ * Source file of the autotune module.
+ * Runs a relay feedback experiment on the altitude or yaw loop
+ * around the current operating point, measures the ultimate gain
+ * and period of the oscillation and calculates PID gains from them
+ * with a selectable tuning rule.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include "autotune.h"
+#include "gainSchedule.h"
+#include "FSM.h"
+
+/* ******************************************************
+ * Tuning rule constants. Kp = Ku * kpNum / kpDen,
+ * Ti = Pu * tiNum / tiDen and Td = Pu * tdNum / tdDen.
+ * *****************************************************/
+typedef struct TuneRuleConstants {
+    int32_t kpNum;
+    int32_t kpDen;
+    int32_t tiNum;
+    int32_t tiDen;
+    int32_t tdNum;
+    int32_t tdDen;
+} tuneRuleConstants_t;
+
+static const tuneRuleConstants_t g_tuneRules[NUM_TUNE_RULES] = {
+    { 3,  5,  1,  2,  1,  8 },    // Ziegler-Nichols: 0.6 Ku, Pu / 2, Pu / 8
+    { 5, 11, 11,  5, 10, 63 },    // Tyreus-Luyben: Ku / 2.2, 2.2 Pu, Pu / 6.3
+    { 1,  5,  1,  2,  1,  3 }     // No overshoot: 0.2 Ku, Pu / 2, Pu / 3
+};
+
+static relayTuner_t g_tuner;                                    // Owned by the control task of the axis being tuned
+static volatile autotuneStatus_t g_status = AUTOTUNE_IDLE;
+static bool g_isYaw;                                            // Axis being tuned. Set before g_status leaves AUTOTUNE_IDLE
+static tuneRule_t g_rule;                                       // Rule used for the result
+static int32_t g_tunePoint;                                     // Reference the experiment ran at. Owned by the control task
+
+
+/*
+ * Function:    initRelayTuner
+ * ----------------------------
+ * Starts a relay experiment.
+ *
+ * @params:
+ *      - relayTuner_t* tuner: The experiment state.
+ *      - int32_t bias: Duty cycle to switch around.
+ *      - int32_t amplitude: Relay amplitude (% duty).
+ *      - int32_t hysteresis: Error band the relay ignores.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initRelayTuner(relayTuner_t* tuner, int32_t bias, int32_t amplitude, int32_t hysteresis)
+{
+    tuner->bias = bias;
+    tuner->amplitude = amplitude;
+    tuner->hysteresis = hysteresis;
+    tuner->high = false;
+    tuner->elapsed = 0;
+    tuner->lastRise = 0;
+    tuner->rises = 0;
+    tuner->errorMax = 0;
+    tuner->errorMin = 0;
+    tuner->cycles = 0;
+    tuner->periodSum = 0;
+    tuner->peakToPeakSum = 0;
+}
+
+
+/*
+ * Function:    updateRelayTuner
+ * ------------------------------
+ * Runs one control cycle of the relay experiment. The relay output
+ * goes high when the error rises above the hysteresis band and low
+ * when it falls below it. Each time the relay switches high a full
+ * oscillation cycle has passed, so its period and the error
+ * peak-to-peak amplitude are recorded once the relay has settled.
+ *
+ * @params:
+ *      - relayTuner_t* tuner: The experiment state.
+ *      - int32_t errorSignal: Reference minus measurement.
+ *      - uint32_t timeStep: Time since the last call (ms).
+ * @return:
+ *      - int32_t dutyCycle: Relay output duty cycle.
+ * ---------------------
+ */
+int32_t
+updateRelayTuner(relayTuner_t* tuner, int32_t errorSignal, uint32_t timeStep)
+{
+    int32_t dutyCycle;
+
+    tuner->elapsed += timeStep;
+
+    if (errorSignal > tuner->errorMax) {
+        tuner->errorMax = errorSignal;
+    }
+    if (errorSignal < tuner->errorMin) {
+        tuner->errorMin = errorSignal;
+    }
+
+    if (!tuner->high && errorSignal > tuner->hysteresis) {
+        tuner->high = true;
+
+        if (tuner->rises > AUTOTUNE_SETTLE_CYCLES) {
+            tuner->periodSum += tuner->elapsed - tuner->lastRise;
+            tuner->peakToPeakSum += tuner->errorMax - tuner->errorMin;
+            tuner->cycles++;
+        }
+        tuner->lastRise = tuner->elapsed;
+        tuner->rises++;
+        tuner->errorMax = errorSignal;                          // Start tracking the peaks of the next cycle
+        tuner->errorMin = errorSignal;
+    } else if (tuner->high && errorSignal < -tuner->hysteresis) {
+        tuner->high = false;
+    }
+
+    dutyCycle = tuner->high ? tuner->bias + tuner->amplitude : tuner->bias - tuner->amplitude;
+
+    if (dutyCycle > MAX_DUTY) {
+        dutyCycle = MAX_DUTY;
+    } else if (dutyCycle < MIN_DUTY) {
+        dutyCycle = MIN_DUTY;
+    }
+
+    return dutyCycle;
+}
+
+
+/*
+ * Function:    isRelayTunerDone
+ * ------------------------------
+ * Returns whether enough cycles have been measured.
+ *
+ * @params:
+ *      - const relayTuner_t* tuner: The experiment state.
+ * @return:
+ *      - bool done: True once AUTOTUNE_CYCLES have been measured.
+ * ---------------------
+ */
+bool
+isRelayTunerDone(const relayTuner_t* tuner)
+{
+    return tuner->cycles >= AUTOTUNE_CYCLES;
+}
+
+
+/*
+ * Function:    getRelayTunerResult
+ * ---------------------------------
+ * Calculates the ultimate gain and period from the measured cycles.
+ * The ultimate gain is the describing function estimate
+ * Ku = 4 d / (pi a), where d is the relay amplitude and a is half
+ * the mean error peak-to-peak amplitude.
+ *
+ * @params:
+ *      - const relayTuner_t* tuner: The experiment state.
+ *      - int32_t* ultimateGainQ: Ultimate gain in duty per unit
+ *      error (Q format).
+ *      - uint32_t* ultimatePeriod: Ultimate period (ms).
+ * @return:
+ *      - bool valid: False if nothing usable was measured.
+ * ---------------------
+ */
+bool
+getRelayTunerResult(const relayTuner_t* tuner, int32_t* ultimateGainQ, uint32_t* ultimatePeriod)
+{
+    if (tuner->cycles == 0 || tuner->peakToPeakSum <= 0 || tuner->periodSum == 0) {
+        return false;
+    }
+
+    // 4 d / (pi a) with a = peakToPeakSum / (2 cycles)
+    *ultimateGainQ = (int32_t) (((int64_t) 8 * tuner->amplitude * tuner->cycles * PID_Q_ONE * 10000) /
+                                ((int64_t) AUTOTUNE_PI_X10000 * tuner->peakToPeakSum));
+    *ultimatePeriod = tuner->periodSum / tuner->cycles;
+
+    return true;
+}
+
+
+/*
+ * Function:    getTunedParams
+ * ----------------------------
+ * Calculates controller gains from an ultimate gain and period.
+ * Kp, Ki and Kd are written in the controller's divisor units, with
+ * Ki = Kp / Ti and Kd = Kp Td. The other parameters are left
+ * unchanged.
+ *
+ * @params:
+ *      - int32_t ultimateGainQ: Ultimate gain (Q format).
+ *      - uint32_t ultimatePeriod: Ultimate period (ms).
+ *      - tuneRule_t rule: Tuning rule to use.
+ *      - int32_t divisor: The controller's gain divisor.
+ *      - controllerParams_t* params: Parameters to update.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+getTunedParams(int32_t ultimateGainQ, uint32_t ultimatePeriod, tuneRule_t rule, int32_t divisor,
+               controllerParams_t* params)
+{
+    const tuneRuleConstants_t* constants = &g_tuneRules[rule];
+    int64_t kpScaled = (int64_t) ultimateGainQ * constants->kpNum * divisor;   // Kp * kpDen * PID_Q_ONE
+    int64_t kpDenominator = (int64_t) constants->kpDen * PID_Q_ONE;
+
+    params->Kp = (int32_t) (kpScaled / kpDenominator);
+    params->Ki = (int32_t) ((kpScaled * constants->tiDen * MS_TO_SECONDS) /
+                            (kpDenominator * ultimatePeriod * constants->tiNum));
+    params->Kd = (int32_t) ((kpScaled * ultimatePeriod * constants->tdNum) /
+                            (kpDenominator * MS_TO_SECONDS * constants->tdDen));
+}
+
+
+/*
+ * Function:    requestAutotune
+ * -----------------------------
+ * Requests an experiment on one axis. The control task for that
+ * axis starts the relay on its next cycle.
+ *
+ * @params:
+ *      - bool isYaw: True to tune yaw, false for altitude.
+ *      - tuneRule_t rule: Tuning rule to use for the result.
+ * @return:
+ *      - bool requested: False if an experiment is already active,
+ *      or for yaw when yaw control is cascaded.
+ * ---------------------
+ */
+bool
+requestAutotune(bool isYaw, tuneRule_t rule)
+{
+    bool requested = false;
+
+    taskENTER_CRITICAL();
+    // The relay drives the tail duty from the angle error, which does not fit the cascaded loops
+    if (g_status == AUTOTUNE_IDLE && rule < NUM_TUNE_RULES && !(isYaw && YAW_CASCADED)) {
+        g_isYaw = isYaw;
+        g_rule = rule;
+        g_status = AUTOTUNE_STARTING;
+        requested = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return requested;
+}
+
+
+/*
+ * Function:    cancelAutotune
+ * ----------------------------
+ * Abandons any experiment and returns both axes to PID control.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+cancelAutotune(void)
+{
+    g_status = AUTOTUNE_IDLE;
+}
+
+
+/*
+ * Function:    isAutotuning
+ * --------------------------
+ * Returns whether the relay should drive an axis this cycle.
+ *
+ * @params:
+ *      - bool isYaw: True for yaw, false for altitude.
+ * @return:
+ *      - bool tuning: True if the control task should call
+ *      updateAutotune instead of its controller.
+ * ---------------------
+ */
+bool
+isAutotuning(bool isYaw)
+{
+    autotuneStatus_t status = g_status;
+
+    return (status == AUTOTUNE_STARTING || status == AUTOTUNE_RUNNING) && g_isYaw == isYaw;
+}
+
+
+/*
+ * Function:    setStatus
+ * -----------------------
+ * Moves the experiment on from the control task, unless it has
+ * been cancelled in the meantime. An experiment that ends tells
+ * the FSM.
+ *
+ * @params:
+ *      - autotuneStatus_t status: New status.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+setStatus(autotuneStatus_t status)
+{
+    bool ended = false;
+
+    taskENTER_CRITICAL();
+    if (g_status != AUTOTUNE_IDLE) {
+        g_status = status;
+        ended = (status == AUTOTUNE_DONE || status == AUTOTUNE_FAILED);
+    }
+    taskEXIT_CRITICAL();
+
+    if (ended) {
+        postFSMEvent(FSM_EVENT_TUNE_END);
+    }
+}
+
+
+/*
+ * Function:    updateAutotune
+ * ----------------------------
+ * Runs one cycle of the experiment from the control task. The relay
+ * switches around the duty the controller was producing when the
+ * experiment started, and the reference it starts at is the
+ * tuning point. The experiment is abandoned if the error grows
+ * past the axis limit or it runs too long.
+ *
+ * @params:
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - int32_t lastDuty: The duty last set on this axis.
+ *      - uint32_t timeStep: Control period (ms).
+ * @return:
+ *      - int32_t dutyCycle: Duty cycle to set.
+ * ---------------------
+ */
+int32_t
+updateAutotune(int32_t reference, int32_t measurement, int32_t lastDuty, uint32_t timeStep)
+{
+    int32_t limit = g_isYaw ? AUTOTUNE_YAW_LIMIT : AUTOTUNE_ALT_LIMIT;
+    int32_t errorSignal = wrapDifference(reference - measurement, g_isYaw);
+    int32_t dutyCycle;
+
+    if (g_status == AUTOTUNE_STARTING) {
+        g_tunePoint = reference;
+        initRelayTuner(&g_tuner, lastDuty,
+                       g_isYaw ? AUTOTUNE_YAW_RELAY : AUTOTUNE_ALT_RELAY,
+                       g_isYaw ? AUTOTUNE_YAW_HYSTERESIS : AUTOTUNE_ALT_HYSTERESIS);
+        setStatus(AUTOTUNE_RUNNING);
+    }
+
+    if (errorSignal > limit || errorSignal < -limit || g_tuner.elapsed > AUTOTUNE_TIMEOUT_MS) {
+        setStatus(AUTOTUNE_FAILED);
+        return g_tuner.bias;                                    // Hand back to the controller from the hover duty
+    }
+
+    dutyCycle = updateRelayTuner(&g_tuner, errorSignal, timeStep);
+    if (isRelayTunerDone(&g_tuner)) {
+        setStatus(AUTOTUNE_DONE);
+    }
+
+    return dutyCycle;
+}
+
+
+/*
+ * Function:    getAutotuneStatus
+ * -------------------------------
+ * Returns the progress of the experiment.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - autotuneStatus_t status: Current progress.
+ * ---------------------
+ */
+autotuneStatus_t
+getAutotuneStatus(void)
+{
+    return g_status;
+}
+
+
+/*
+ * Function:    unscaleGain
+ * -------------------------
+ * Divides a gain by a multiplier, rounding to the nearest.
+ *
+ * @params:
+ *      - int32_t gain: The gain.
+ *      - int32_t scaleQ: The multiplier (Q format).
+ * @return:
+ *      - int32_t gain: The gain divided by the multiplier.
+ * ---------------------
+ */
+static int32_t
+unscaleGain(int32_t gain, int32_t scaleQ)
+{
+    return (int32_t) ((((int64_t) gain << PID_Q_BITS) + scaleQ / 2) / scaleQ);
+}
+
+
+/*
+ * Function:    finishAutotune
+ * ----------------------------
+ * Reports the result of a finished or failed experiment over UART
+ * and, if it succeeded, stages the new gains through the normal
+ * parameter path. Returns the module to idle. The altitude gain
+ * schedule multiplies the staged gains, so tuned altitude gains
+ * are divided by its multipliers at the tuning point and reported
+ * again as the base gains staged. The gains then run as tuned
+ * there, and the schedule still shapes them elsewhere.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+finishAutotune(void)
+{
+    controller_t* controller = g_isYaw ? &g_yaw_controller : &g_alt_controller;
+    controllerParams_t params;
+    gainScale_t scale;
+    int32_t ultimateGainQ;
+    uint32_t ultimatePeriod;
+    char message[MAX_STR_LEN];
+
+    if (g_status == AUTOTUNE_DONE && getRelayTunerResult(&g_tuner, &ultimateGainQ, &ultimatePeriod)) {
+        getControllerParams(controller, &params);
+        getTunedParams(ultimateGainQ, ultimatePeriod, g_rule, controller->divisor, &params);
+
+        usnprintf(message, sizeof(message), "Ku %d/100 Pu %d ms\n",
+                  (int32_t) (((int64_t) ultimateGainQ * 100) >> PID_Q_BITS), ultimatePeriod);
+        UARTSend(message);
+        usnprintf(message, sizeof(message), "Kp %d Ki %d Kd %d\n", params.Kp, params.Ki, params.Kd);
+        UARTSend(message);
+        if (!g_isYaw) {
+            getAltitudeGainScale(g_tunePoint, &scale);
+            params.Kp = unscaleGain(params.Kp, scale.Kp);
+            params.Ki = unscaleGain(params.Ki, scale.Ki);
+            params.Kd = unscaleGain(params.Kd, scale.Kd);
+            usnprintf(message, sizeof(message), "Base Kp %d Ki %d Kd %d\n", params.Kp, params.Ki, params.Kd);
+            UARTSend(message);
+        }
+        UARTSend(stageControllerParams(controller, &params) ? "Tune applied\n" : "Tune rejected\n");
+    } else {
+        UARTSend("Tune failed\n");
+    }
+
+    g_status = AUTOTUNE_IDLE;
+}
@@ -0,0 +1,254 @@
+/* ****************************************************************
+ * autotune.h
+ *
+ * Header file of the autotune module.
+ * Runs a relay feedback experiment on the altitude or yaw loop
+ * around the current operating point, measures the ultimate gain
+ * and period of the oscillation and calculates PID gains from them
+ * with a selectable tuning rule.
+ *
+ * The relay experiment (relayTuner_t) only uses integer arithmetic
+ * and has no hardware or FreeRTOS dependencies, so it can be run
+ * against a plant model.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef AUTOTUNE_H_
+#define AUTOTUNE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pidController.h"
+
+#define AUTOTUNE_ALT_RELAY      8           // Relay amplitude around the hover duty for altitude (% duty)
+#define AUTOTUNE_YAW_RELAY      10          // Relay amplitude around the current duty for yaw (% duty)
+#define AUTOTUNE_ALT_HYSTERESIS 1           // Error band the relay ignores for altitude (%)
+#define AUTOTUNE_YAW_HYSTERESIS 2           // Error band the relay ignores for yaw (degrees)
+#define AUTOTUNE_ALT_LIMIT      15          // Largest altitude error allowed before the experiment is abandoned (%)
+#define AUTOTUNE_YAW_LIMIT      60          // Largest yaw error allowed before the experiment is abandoned (degrees)
+#define AUTOTUNE_SETTLE_CYCLES  1           // Oscillation cycles ignored while the relay settles
+#define AUTOTUNE_CYCLES         4           // Oscillation cycles averaged for the result
+#define AUTOTUNE_TIMEOUT_MS     60000       // Longest an experiment may run (ms)
+#define AUTOTUNE_PI_X10000      31416       // Pi scaled by 10000
+
+
+/* ******************************************************
+ * Rules used to turn the ultimate gain and period into
+ * PID gains
+ * *****************************************************/
+typedef enum TuneRules {
+    TUNE_ZIEGLER_NICHOLS = 0,     // Classic Ziegler-Nichols. Fast, around 25 % overshoot
+    TUNE_TYREUS_LUYBEN,           // Tyreus-Luyben. Slower, more robust
+    TUNE_NO_OVERSHOOT,            // Ziegler-Nichols "no overshoot" variant
+    NUM_TUNE_RULES
+} tuneRule_t;
+
+/* ******************************************************
+ * Progress of the autotune experiment
+ * *****************************************************/
+typedef enum AutotuneStatus {
+    AUTOTUNE_IDLE = 0,            // No experiment requested
+    AUTOTUNE_STARTING,            // Requested, waiting for the control task to start the relay
+    AUTOTUNE_RUNNING,             // Relay is driving the rotor
+    AUTOTUNE_DONE,                // Oscillation measured, waiting for the gains to be applied
+    AUTOTUNE_FAILED               // Abandoned (error limit or timeout)
+} autotuneStatus_t;
+
+/* ******************************************************
+ * State of a relay feedback experiment
+ * *****************************************************/
+typedef struct RelayTuners {
+    int32_t     bias;             // Duty cycle the relay switches around
+    int32_t     amplitude;        // Relay amplitude (% duty)
+    int32_t     hysteresis;       // Error band the relay ignores
+    bool        high;             // True while the relay output is bias + amplitude
+    uint32_t    elapsed;          // Time since the experiment started (ms)
+    uint32_t    lastRise;         // Time the relay last switched high (ms)
+    uint32_t    rises;            // Number of times the relay has switched high
+    int32_t     errorMax;         // Largest error in the current cycle
+    int32_t     errorMin;         // Smallest error in the current cycle
+    uint32_t    cycles;           // Cycles measured so far
+    uint32_t    periodSum;        // Sum of the measured cycle periods (ms)
+    int32_t     peakToPeakSum;    // Sum of the measured error peak-to-peak amplitudes
+} relayTuner_t;
+
+
+/*
+ * Function:    initRelayTuner
+ * ----------------------------
+ * Starts a relay experiment.
+ *
+ * @params:
+ *      - relayTuner_t* tuner: The experiment state.
+ *      - int32_t bias: Duty cycle to switch around.
+ *      - int32_t amplitude: Relay amplitude (% duty).
+ *      - int32_t hysteresis: Error band the relay ignores.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initRelayTuner(relayTuner_t* tuner, int32_t bias, int32_t amplitude, int32_t hysteresis);
+
+/*
+ * Function:    updateRelayTuner
+ * ------------------------------
+ * Runs one control cycle of the relay experiment.
+ *
+ * @params:
+ *      - relayTuner_t* tuner: The experiment state.
+ *      - int32_t errorSignal: Reference minus measurement.
+ *      - uint32_t timeStep: Time since the last call (ms).
+ * @return:
+ *      - int32_t dutyCycle: Relay output duty cycle.
+ * ---------------------
+ */
+int32_t updateRelayTuner(relayTuner_t* tuner, int32_t errorSignal, uint32_t timeStep);
+
+/*
+ * Function:    isRelayTunerDone
+ * ------------------------------
+ * Returns whether enough cycles have been measured.
+ *
+ * @params:
+ *      - const relayTuner_t* tuner: The experiment state.
+ * @return:
+ *      - bool done: True once AUTOTUNE_CYCLES have been measured.
+ * ---------------------
+ */
+bool isRelayTunerDone(const relayTuner_t* tuner);
+
+/*
+ * Function:    getRelayTunerResult
+ * ---------------------------------
+ * Calculates the ultimate gain and period from the measured cycles.
+ *
+ * @params:
+ *      - const relayTuner_t* tuner: The experiment state.
+ *      - int32_t* ultimateGainQ: Ultimate gain in duty per unit
+ *      error (Q format).
+ *      - uint32_t* ultimatePeriod: Ultimate period (ms).
+ * @return:
+ *      - bool valid: False if nothing usable was measured.
+ * ---------------------
+ */
+bool getRelayTunerResult(const relayTuner_t* tuner, int32_t* ultimateGainQ, uint32_t* ultimatePeriod);
+
+/*
+ * Function:    getTunedParams
+ * ----------------------------
+ * Calculates controller gains from an ultimate gain and period.
+ * Kp, Ki and Kd are written in the controller's divisor units.
+ * The other parameters are left unchanged.
+ *
+ * @params:
+ *      - int32_t ultimateGainQ: Ultimate gain (Q format).
+ *      - uint32_t ultimatePeriod: Ultimate period (ms).
+ *      - tuneRule_t rule: Tuning rule to use.
+ *      - int32_t divisor: The controller's gain divisor.
+ *      - controllerParams_t* params: Parameters to update.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void getTunedParams(int32_t ultimateGainQ, uint32_t ultimatePeriod, tuneRule_t rule, int32_t divisor,
+                    controllerParams_t* params);
+
+/*
+ * Function:    requestAutotune
+ * -----------------------------
+ * Requests an experiment on one axis. The control task for that
+ * axis starts the relay on its next cycle.
+ *
+ * @params:
+ *      - bool isYaw: True to tune yaw, false for altitude.
+ *      - tuneRule_t rule: Tuning rule to use for the result.
+ * @return:
+ *      - bool requested: False if an experiment is already active,
+ *      or for yaw when yaw control is cascaded.
+ * ---------------------
+ */
+bool requestAutotune(bool isYaw, tuneRule_t rule);
+
+/*
+ * Function:    cancelAutotune
+ * ----------------------------
+ * Abandons any experiment and returns both axes to PID control.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void cancelAutotune(void);
+
+/*
+ * Function:    isAutotuning
+ * --------------------------
+ * Returns whether the relay should drive an axis this cycle.
+ *
+ * @params:
+ *      - bool isYaw: True for yaw, false for altitude.
+ * @return:
+ *      - bool tuning: True if the control task should call
+ *      updateAutotune instead of its controller.
+ * ---------------------
+ */
+bool isAutotuning(bool isYaw);
+
+/*
+ * Function:    updateAutotune
+ * ----------------------------
+ * Runs one cycle of the experiment from the control task. The relay
+ * switches around the duty the controller was producing when the
+ * experiment started. The reference it starts at is the
+ * tuning point.
+ *
+ * @params:
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - int32_t lastDuty: The duty last set on this axis.
+ *      - uint32_t timeStep: Control period (ms).
+ * @return:
+ *      - int32_t dutyCycle: Duty cycle to set.
+ * ---------------------
+ */
+int32_t updateAutotune(int32_t reference, int32_t measurement, int32_t lastDuty, uint32_t timeStep);
+
+/*
+ * Function:    getAutotuneStatus
+ * -------------------------------
+ * Returns the progress of the experiment.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - autotuneStatus_t status: Current progress.
+ * ---------------------
+ */
+autotuneStatus_t getAutotuneStatus(void);
+
+/*
+ * Function:    finishAutotune
+ * ----------------------------
+ * Reports the result of a finished or failed experiment over UART
+ * and, if it succeeded, stages the new gains through the normal
+ * parameter path. Returns the module to idle. Tuned altitude gains
+ * are divided by the gain schedule's multipliers at the tuning
+ * point, so they run as tuned there.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void finishAutotune(void);
+
+#endif /* AUTOTUNE_H_ */
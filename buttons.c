@@ -23,6 +23,10 @@
  * ***************************************************************/
 
 #include "buttons.h"
+#include "flightRecorder.h"
+#include "profiler.h"
+#include "flightState.h"
+#include "FSM.h"
 
 static bool btn_state[NUM_BTNS];    // Corresponds to the electrical state
 static bool btn_normal[NUM_BTNS];   // Corresponds to the electrical state
@@ -158,6 +162,8 @@ updateButtons(void)
     btn_value[DOWN] =   (GPIOPinRead(D_BTN_PORT_BASE, D_BTN_PIN) == D_BTN_PIN);
     btn_value[LEFT] =   (GPIOPinRead(L_BTN_PORT_BASE, L_BTN_PIN) == L_BTN_PIN);
     btn_value[RIGHT] =  (GPIOPinRead(R_BTN_PORT_BASE, R_BTN_PIN) == R_BTN_PIN);
+    recordButtons((btn_value[UP] << UP) | (btn_value[DOWN] << DOWN) |
+                  (btn_value[LEFT] << LEFT) | (btn_value[RIGHT] << RIGHT));
 
     // Iterate through the buttons, updating button variables as required
     for (i = 0; i < NUM_BTNS; i++)
@@ -220,10 +226,9 @@ checkButton(uint8_t btnName)
 static void
 upButtonPush(void)
 {
-    int32_t alt_desired = 0;
+    int32_t alt_desired = getAltDesired();
 
     UARTSend ("Up\n");
-    xQueuePeek(xAltDesQueue, &alt_desired, TICKS_TO_WAIT); // Retrieve desired altitude data from the RTOS queue
 
     alt_desired += ALT_CHANGE; // Increment altitude
 
@@ -232,7 +237,7 @@ upButtonPush(void)
     {
         alt_desired = MAX_ALT;
     }
-    xQueueOverwrite(xAltDesQueue, &alt_desired); // Update the RTOS altitude reference queue
+    setAltDesired(FLIGHT_WRITER_BUTTONS, alt_desired); // Update the altitude reference
 }
 
 /*
@@ -250,10 +255,9 @@ upButtonPush(void)
 static void
 downButtonPush(void)
 {
-    int32_t alt_desired = 0;
+    int32_t alt_desired = getAltDesired();
 
     UARTSend ("Down\n");
-    xQueuePeek(xAltDesQueue, &alt_desired, TICKS_TO_WAIT); // Retrieve desired altitude data from the RTOS queue
     alt_desired -= ALT_CHANGE;  // Decrement altitude
 
     // Check lower limits of the altitude when left button is pressed
@@ -261,7 +265,7 @@ downButtonPush(void)
     {
         alt_desired = MIN_ALT;
     }
-    xQueueOverwrite(xAltDesQueue, &alt_desired); // Update the RTOS altitude reference queue
+    setAltDesired(FLIGHT_WRITER_BUTTONS, alt_desired); // Update the altitude reference
 }
 
 /*
@@ -279,10 +283,9 @@ downButtonPush(void)
 static void
 rightButtonPush(void)
 {
-    int32_t yaw_desired = 0;
+    int32_t yaw_desired = getYawDesired();
 
     UARTSend ("Right\n");
-    xQueuePeek(xYawDesQueue, &yaw_desired, TICKS_TO_WAIT); // Retrieve desired yaw data from the RTOS queue
 
     // Check upper limits of the yaw when left button is pressed
     if (yaw_desired <= (MAX_YAW - YAW_CHANGE)) {
@@ -290,7 +293,7 @@ rightButtonPush(void)
     } else {
         yaw_desired = -DEGREES_CIRCLE + YAW_CHANGE + yaw_desired; // Increment yaw
     }
-    xQueueOverwrite(xYawDesQueue, &yaw_desired); // Update the RTOS yaw reference queue
+    setYawDesired(FLIGHT_WRITER_BUTTONS, yaw_desired); // Update the yaw reference
 }
 
 /*
@@ -308,10 +311,9 @@ rightButtonPush(void)
 static void
 leftButtonPush(void)
 {
-    int32_t yaw_desired = 0;
+    int32_t yaw_desired = getYawDesired();
 
     UARTSend ("Left\n");
-    xQueuePeek(xYawDesQueue, &yaw_desired, TICKS_TO_WAIT); // Retrieve desired yaw data from the RTOS queue
 
     // Check upper limits of the yaw if right button is pressed
     if (yaw_desired >= (MIN_YAW + YAW_CHANGE)) {
@@ -319,7 +321,7 @@ leftButtonPush(void)
     } else {
         yaw_desired = DEGREES_CIRCLE - YAW_CHANGE + yaw_desired; // Decrement yaw
     }
-    xQueueOverwrite(xYawDesQueue, &yaw_desired); // Update the RTOS yaw reference queue
+    setYawDesired(FLIGHT_WRITER_BUTTONS, yaw_desired); // Update the yaw reference
 }
 
 /*
@@ -349,17 +351,20 @@ ButtonsCheck(void *pvParameters)
     int32_t desired_yaw;
 
     ui16LastTaskTime = xTaskGetTickCount(); // Get the current tick count.
+    profileTask(PROFILE_BUTTONS_TASK);
 
     // Loop forever.
     while(1)
     {
+        profileStart(PROFILE_BUTTONS_TASK);
+
         // Initalise timers used to count double button presses
         inUpTimeLoop = ( uint32_t ) pvTimerGetTimerID( xUpBtnTimer );
         inYawTimeLoop = ( uint32_t ) pvTimerGetTimerID( xDownBtnTimer );
 
         // Retrieve desired helicopter values
-        xQueuePeek(xYawDesQueue, &desired_yaw, TICKS_TO_WAIT);
-        xQueuePeek(xAltDesQueue, &desired_alt, TICKS_TO_WAIT);
+        desired_yaw = getYawDesired();
+        desired_alt = getAltDesired();
 
         updateButtons(); // Check if any buttons have been pressed
 
@@ -375,7 +380,7 @@ ButtonsCheck(void *pvParameters)
             if (uxSemaphoreGetCount(xUpBtnSemaphore) == 1) { // If a double button press is recorded
                 xSemaphoreTake(xUpBtnSemaphore, TICKS_TO_WAIT);
                 desired_alt = MODE_1_ALT;
-                xQueueOverwrite(xAltDesQueue, &desired_alt);
+                setAltDesired(FLIGHT_WRITER_BUTTONS, desired_alt);
             } else { // If a single button press is recorded
                 upButtonPush();
             }
@@ -398,8 +403,7 @@ ButtonsCheck(void *pvParameters)
                     desired_yaw = DEGREES_CIRCLE - MODE_2_YAW_CHANGE + desired_yaw;
                 }
                 desired_alt += ALT_CHANGE;
-                xQueueOverwrite(xYawDesQueue, &desired_yaw);
-                xQueueOverwrite(xAltDesQueue, &desired_alt);
+                setReferences(FLIGHT_WRITER_BUTTONS, desired_alt, desired_yaw);
             } else { // If a single button press is recorded
                 downButtonPush();
             }
@@ -412,16 +416,39 @@ ButtonsCheck(void *pvParameters)
         {
             rightButtonPush();
         }
+        profileEnd(PROFILE_BUTTONS_TASK);
 
         vTaskDelayUntil(&ui16LastTaskTime, INPUT_PERIOD/portTICK_RATE_MS); // Wait for the required amount of time to check back.
     }
 }
 
+/*
+ * Function:    readSwitches
+ * --------------------------
+ * Reads both switches at once and passes their levels to the
+ * flight recorder.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint16_t levels: R_SW_PIN and L_SW_PIN set when high.
+ * ---------------------
+ */
+static uint16_t
+readSwitches(void)
+{
+    uint16_t levels = GPIOPinRead(SW_PORT_BASE, R_SW_PIN | L_SW_PIN);
+
+    recordSwitches(levels);
+    return levels;
+}
+
 /*
  * Function:    SwitchesCheck
  * ---------------------
  * FreeRTOS task which polls the switches to check for switch pushes
- * For each button the following procedure is run:
+ * Moving the right switch posts a switch up or down event to the
+ * FSM, which ignores it in states it does not apply to.
  *
  * @params:
  *      - NULL
@@ -433,39 +460,37 @@ void
 SwitchesCheck(void *pvParameters)
 {
     portTickType ui16LastTaskTime;
-    uint32_t state;
-    uint16_t R_PREV = GPIOPinRead(SW_PORT_BASE, R_SW_PIN);
-    uint16_t L_PREV = GPIOPinRead(SW_PORT_BASE, L_SW_PIN);
+    uint16_t switches = readSwitches();
+    uint16_t R_PREV = switches & R_SW_PIN;
+    uint16_t L_PREV = switches & L_SW_PIN;
 
     ui16LastTaskTime = xTaskGetTickCount(); // Get the current tick count.
+    profileTask(PROFILE_SWITCHES_TASK);
 
     while(1) {
-        xQueuePeek(xFSMQueue, &state, TICKS_TO_WAIT);
-        if(GPIOPinRead(SW_PORT_BASE, R_SW_PIN) != R_PREV)
+        profileStart(PROFILE_SWITCHES_TASK);
+        switches = readSwitches();
+        if((switches & R_SW_PIN) != R_PREV)
         {
-            R_PREV = GPIOPinRead(SW_PORT_BASE, R_SW_PIN);
+            R_PREV = switches & R_SW_PIN;
             if(R_PREV == R_SW_PIN){
                 UARTSend ("R_SW High\n\r");
-                state = TAKEOFF;
-
+                postFSMEvent(FSM_EVENT_SWITCH_UP);
             } else{
                 UARTSend ("R_SW Low\n\r");
-                if(state == FLYING){
-                    state = LANDING;
-                }
+                postFSMEvent(FSM_EVENT_SWITCH_DOWN);
             }
-
-            xQueueOverwrite(xFSMQueue, &state);
         }
-        if(GPIOPinRead(SW_PORT_BASE, L_SW_PIN) != L_PREV)
+        if((switches & L_SW_PIN) != L_PREV)
         {
-            L_PREV = GPIOPinRead(SW_PORT_BASE, L_SW_PIN);
+            L_PREV = switches & L_SW_PIN;
             if(L_PREV == L_SW_PIN){
                 UARTSend ("L_SW High\n\r");
             } else{
                 UARTSend ("L_SW Low\n\r");
             }
         }
+        profileEnd(PROFILE_SWITCHES_TASK);
         vTaskDelayUntil(&ui16LastTaskTime, INPUT_PERIOD/portTICK_RATE_MS);
     }
 }
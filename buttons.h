@@ -75,7 +75,7 @@
 
 enum btnNames   {UP = 0, DOWN, LEFT, RIGHT, NUM_BTNS};
 enum btnStates  {RELEASED = 0, PUSHED, NO_CHANGE};
-typedef enum HELI_STATE {LANDED = 0, TAKEOFF = 1, FLYING = 2, LANDING = 3} HELI_STATE;
+typedef enum HELI_STATE {LANDED = 0, TAKEOFF = 1, FLYING = 2, LANDING = 3, AUTOTUNE = 4} HELI_STATE;
 
 
 /*
@@ -0,0 +1,408 @@
+/* ****************************************************************
+ * controlExecutive.c
+ *
+ * Source file of the control executive module.
+ * A single task, released by a hardware timer, that runs the whole
+ * control stack in a fixed order each cycle: sample and estimate
+ * the altitude and yaw, run the controllers, mix in the
+ * feedforward terms and write the rotor duties. Each loop counts
+ * down its controller's timeStep and runs on the cycle that reaches
+ * it, so the gains stay scaled to the period they actually run at.
+ * A loop whose cycle is lost to an overrun runs late, on the next
+ * cycle, rather than waiting for the following period. Tells the
+ * FSM when the helicopter reaches the desired altitude and yaw.
+ * Records how late each cycle starts and how long it runs.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include "controlExecutive.h"
+#include "driverlib/interrupt.h"
+#include "pidController.h"
+#include "altitude.h"
+#include "yaw.h"
+#include "pwm.h"
+#include "flightRecorder.h"
+#include "profiler.h"
+#include "flightState.h"
+#include "FSM.h"
+
+#if (1000 % CONTROL_RATE_HZ) || (CONTROL_RATE_HZ > 1000)
+#error "CONTROL_RATE_HZ must divide 1000"
+#endif
+#if (CONTROL_PERIOD % EXECUTIVE_PERIOD) || (YAW_CASCADED && (YAW_RATE_PERIOD % EXECUTIVE_PERIOD))
+#error "The control periods must be multiples of the executive period"
+#endif
+
+static uint32_t g_timerLoad;                    // Control timer counts per cycle, less one
+static volatile bool g_controlEnabled = false;  // Set to run the controllers and rotor outputs
+
+// Time until each loop next runs (ms). Zero runs them all on the first cycle
+static uint32_t g_mainCountdown = 0;
+static uint32_t g_yawCountdown = 0;
+#if YAW_CASCADED
+static uint32_t g_tailCountdown = 0;
+#endif /* YAW_CASCADED */
+
+// Target latch. Set once the FSM has been told the target was reached, cleared when it is left or moved
+static bool g_targetPosted = false;
+static int32_t g_targetAlt = 0;
+static int32_t g_targetYaw = 0;
+
+// Cycle timing since the statistics were last read, in timer counts
+static uint32_t g_cycles = 0;
+static uint32_t g_overruns = 0;
+static uint32_t g_latencyMin = UINT32_MAX;
+static uint32_t g_latencyMax = 0;
+static uint64_t g_latencySum = 0;
+static uint32_t g_runMax = 0;
+
+
+/*
+ * Function:    controlTimerInterrupt
+ * -----------------------------------
+ * Interrupt handler for the control timer. Releases the control
+ * executive.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+controlTimerInterrupt(void)
+{
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+    profileStart(PROFILE_CONTROL_ISR);
+    TimerIntClear(CONTROL_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+    recordControlCycle();
+    profileRelease(PROFILE_CONTROL_TASK);
+    vTaskNotifyGiveFromISR(ControlExec, &higherPriorityTaskWoken);
+    profileEnd(PROFILE_CONTROL_ISR);
+
+    portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+
+/*
+ * Function:    initControlExecutive
+ * ----------------------------------
+ * Starts the hardware timer that releases the control executive
+ * every EXECUTIVE_PERIOD.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initControlExecutive(void)
+{
+    SysCtlPeripheralEnable(CONTROL_TIMER_PERIPH);
+    while(!SysCtlPeripheralReady(CONTROL_TIMER_PERIPH));
+
+    g_timerLoad = SysCtlClockGet() / 1000 * EXECUTIVE_PERIOD - 1;
+    TimerConfigure(CONTROL_TIMER_BASE, TIMER_CFG_PERIODIC);
+    TimerLoadSet(CONTROL_TIMER_BASE, TIMER_A, g_timerLoad);
+    TimerIntRegister(CONTROL_TIMER_BASE, TIMER_A, controlTimerInterrupt);
+    IntPrioritySet(CONTROL_TIMER_INT, CONTROL_TIMER_INT_PRIORITY);       // Allow the handler to use FreeRTOS ISR functions
+    TimerIntEnable(CONTROL_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+    TimerEnable(CONTROL_TIMER_BASE, TIMER_A);
+}
+
+
+/*
+ * Function:    enableControl
+ * ---------------------------
+ * Starts or stops the controllers and rotor outputs. The altitude
+ * and yaw estimates keep running while control is stopped.
+ *
+ * @params:
+ *      - bool enable: True to run the controllers.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+enableControl(bool enable)
+{
+    g_controlEnabled = enable;
+}
+
+
+/*
+ * Function:    getExecutiveStats
+ * -------------------------------
+ * Returns the cycle timing since the statistics were last read,
+ * then starts a new window.
+ *
+ * @params:
+ *      - executiveStats_t* stats: Filled with the timing.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+getExecutiveStats(executiveStats_t* stats)
+{
+    uint32_t clocksPerUs = CONTROL_CLOCKS_PER_US;
+
+    taskENTER_CRITICAL();
+    stats->cycles = g_cycles;
+    stats->overruns = g_overruns;
+    stats->latencyMin = g_cycles ? g_latencyMin / clocksPerUs : 0;
+    stats->latencyMax = g_latencyMax / clocksPerUs;
+    stats->latencyMean = g_cycles ? (uint32_t) (g_latencySum / g_cycles / clocksPerUs) : 0;
+    stats->runMax = g_runMax / clocksPerUs;
+
+    g_cycles = 0;
+    g_overruns = 0;
+    g_latencyMin = UINT32_MAX;
+    g_latencyMax = 0;
+    g_latencySum = 0;
+    g_runMax = 0;
+    taskEXIT_CRITICAL();
+}
+
+
+/*
+ * Function:    readCycleTime
+ * ---------------------------
+ * Returns the time since the control timer last released a cycle.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint32_t counts: Time since the release (timer counts).
+ * ---------------------
+ */
+static uint32_t
+readCycleTime(void)
+{
+    return g_timerLoad - TimerValueGet(CONTROL_TIMER_BASE, TIMER_A); // The timer counts down from the load value
+}
+
+
+/*
+ * Function:    recordCycleTime
+ * -----------------------------
+ * Adds one cycle to the timing statistics.
+ *
+ * @params:
+ *      - uint32_t releases: Timer releases taken at the start of the cycle.
+ *      - uint32_t start: Time from the release to the start of the cycle (counts).
+ *      - uint32_t end: Time from the release to the end of the cycle (counts).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+recordCycleTime(uint32_t releases, uint32_t start, uint32_t end)
+{
+    if (end < start) {
+        end += g_timerLoad + 1;             // The timer released the next cycle before this one finished
+    }
+
+    taskENTER_CRITICAL();
+    g_cycles++;
+    g_overruns += releases - 1;
+    g_latencySum += start;
+    if (start < g_latencyMin) {
+        g_latencyMin = start;
+    }
+    if (start > g_latencyMax) {
+        g_latencyMax = start;
+    }
+    if (end > g_runMax) {
+        g_runMax = end;
+    }
+    taskEXIT_CRITICAL();
+}
+
+
+/*
+ * Function:    isDue
+ * -------------------
+ * Counts down the time until a loop next runs, and checks whether
+ * it runs this cycle. A loop that runs restarts its countdown from
+ * its period, so one delayed by an overrun runs late and the next
+ * run is a whole period after it. A countdown left longer than the
+ * period by a longer period swapped out is cut to the new period.
+ *
+ * @params:
+ *      - uint32_t* countdown: Time until the loop runs (ms).
+ *      - uint32_t period: The loop period (ms).
+ *      - uint32_t elapsed: Time since the previous cycle (ms).
+ * @return:
+ *      - bool due: True if the countdown has run out.
+ * ---------------------
+ */
+static bool
+isDue(uint32_t* countdown, uint32_t period, uint32_t elapsed)
+{
+    if (*countdown > period) {
+        *countdown = period;
+    }
+    if (elapsed < *countdown) {
+        *countdown -= elapsed;
+        return false;
+    }
+
+    *countdown = period;
+    return true;
+}
+
+
+/*
+ * Function:    checkTarget
+ * -------------------------
+ * Tells the FSM when the measured altitude and yaw come within
+ * tolerance of the desired ones, as the reference latch does when
+ * the reference is found. The event is sent again if the desired
+ * altitude or yaw moves or the helicopter leaves the target, and
+ * on the next check if the FSM's queue was full.
+ *
+ * @params:
+ *      - int32_t altitude: Measured altitude (%).
+ *      - int32_t yaw: Measured yaw (degrees).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+checkTarget(int32_t altitude, int32_t yaw)
+{
+    flightState_t flight;
+    int32_t altError;
+    int32_t yawError;
+    bool onTarget;
+
+    getFlightState(&flight);
+    altError = flight.altDesired - altitude;
+    yawError = wrapDifference(flight.yawDesired - yaw, true);
+    onTarget = (altError > -ALT_TOLERANCE) && (altError < ALT_TOLERANCE)
+               && (yawError > -YAW_TOLERANCE) && (yawError < YAW_TOLERANCE);
+
+    if (!onTarget || flight.altDesired != g_targetAlt || flight.yawDesired != g_targetYaw) {
+        g_targetPosted = false; // The next arrival is at a new target
+        g_targetAlt = flight.altDesired;
+        g_targetYaw = flight.yawDesired;
+    }
+    if (onTarget && !g_targetPosted) {
+        g_targetPosted = postFSMEvent(FSM_EVENT_TARGET_REACHED);
+    }
+}
+
+
+/*
+ * Function:    ControlExecutive
+ * ------------------------------
+ * FreeRTOS task released by the control timer. Each cycle samples
+ * and estimates the altitude and yaw, runs the altitude and yaw
+ * loops that are due, mixing in the feedforward terms, and writes
+ * their duties to the rotors.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+ControlExecutive(void *pvParameters)
+{
+    altitudeSample_t alt_meas = {0};
+    int32_t yaw_meas = 0;
+    int32_t yaw_rate = 0;
+    int32_t alt_PWM = 0;
+    int32_t yaw_PWM = 0;
+#if YAW_CASCADED
+    int32_t rate_command = 0;
+#endif /* YAW_CASCADED */
+    uint32_t releases;
+    uint32_t start;
+    uint32_t elapsed;
+    bool mainDue;
+    bool yawDue;
+    bool tailDue;
+
+    initAltitude();
+    profileTask(PROFILE_CONTROL_TASK);
+
+    while (1)
+    {
+        releases = ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Block until the control timer releases the next cycle
+        start = readCycleTime();
+        profileStart(PROFILE_CONTROL_TASK);
+        elapsed = EXECUTIVE_PERIOD * releases; // Missed releases still count towards the loop periods
+
+        // Swap in any parameters staged over UART before counting down, so each loop runs on the time step it uses
+        applyControllerParams(&g_alt_controller);
+        applyControllerParams(&g_yaw_controller);
+#if YAW_CASCADED
+        applyControllerParams(&g_yaw_rate_controller);
+#endif /* YAW_CASCADED */
+
+        mainDue = isDue(&g_mainCountdown, g_alt_controller.timeStep, elapsed);
+        yawDue = isDue(&g_yawCountdown, g_yaw_controller.timeStep, elapsed);
+#if YAW_CASCADED
+        tailDue = isDue(&g_tailCountdown, g_yaw_rate_controller.timeStep, elapsed);
+#else
+        tailDue = yawDue;
+#endif /* YAW_CASCADED */
+
+        // Sample and estimate. The altitude is estimated at the altitude loop's period
+        if (mainDue) {
+            updateAltitude(&alt_meas, g_alt_controller.timeStep);
+        }
+        if (yawDue) {
+            updateYawReference(); // Apply any reference crossings and slew out encoder drift
+            yaw_meas = getYaw(); // Convert the decoder slot count to degrees
+        }
+        if (yawDue || tailDue) {
+            yaw_rate = updateYawRate(); // Estimate the yaw rate from the edge timestamps
+        }
+
+        if (g_controlEnabled) {
+            if (mainDue) {
+                checkTarget(alt_meas.altitude, yaw_meas);
+            }
+
+            // Control and mix. The tail loop uses the main duty from this cycle to cancel its torque
+            if (mainDue) {
+                alt_PWM = updateMainDuty(alt_meas.altitude, alt_meas.rate);
+            }
+#if YAW_CASCADED
+            if (yawDue) {
+                rate_command = updateYawAngle(yaw_meas, yaw_rate);
+            }
+            if (tailDue) {
+                yaw_PWM = updateTailRate(alt_PWM, rate_command, yaw_rate);
+            }
+#else
+            if (tailDue) {
+                yaw_PWM = updateTailDuty(alt_PWM, yaw_meas, yaw_rate);
+            }
+#endif /* YAW_CASCADED */
+
+            // Write the duties
+            if (mainDue) {
+                setRotorPWM(alt_PWM, IS_MAIN_ROTOR);
+            }
+            if (tailDue) {
+                setRotorPWM(yaw_PWM, IS_TAIL_ROTOR);
+            }
+        }
+
+        profileEnd(PROFILE_CONTROL_TASK);
+        recordCycleTime(releases, start, readCycleTime());
+    }
+}
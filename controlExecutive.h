@@ -0,0 +1,117 @@
+/* ****************************************************************
+ * controlExecutive.h
+ *
+ * Header file of the control executive module.
+ * A single task, released by a hardware timer, that runs the whole
+ * control stack in a fixed order each cycle: sample and estimate
+ * the altitude and yaw, run the controllers, mix in the
+ * feedforward terms and write the rotor duties. Each loop counts
+ * down its controller's timeStep and runs on the cycle that reaches
+ * it, so the gains stay scaled to the period they actually run at.
+ * A loop whose cycle is lost to an overrun runs late, on the next
+ * cycle, rather than waiting for the following period.
+ * Records how late each cycle starts and how long it runs.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef CONTROLEXECUTIVE_H_
+#define CONTROLEXECUTIVE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+
+#define CONTROL_TIMER_PERIPH        SYSCTL_PERIPH_TIMER2
+#define CONTROL_TIMER_BASE          TIMER2_BASE
+#define CONTROL_TIMER_INT           INT_TIMER2A
+#define CONTROL_TIMER_INT_PRIORITY  (2 << 5)        // Interrupt priority. Must be numerically >= configMAX_SYSCALL_INTERRUPT_PRIORITY
+#define CONTROL_CLOCKS_PER_US       (SysCtlClockGet() / 1000000)
+
+// Executive cycle (ms). The fastest loop period, which every other period must be a multiple of
+#define EXECUTIVE_PERIOD            ((YAW_CASCADED && YAW_RATE_PERIOD < CONTROL_PERIOD) ? YAW_RATE_PERIOD : CONTROL_PERIOD)
+
+
+/* ******************************************************
+ * Timing of the executive cycles since the statistics
+ * were last read.
+ * *****************************************************/
+typedef struct ExecutiveStats {
+    uint32_t    cycles;             // Cycles run
+    uint32_t    overruns;           // Timer releases missed because the previous cycle was still running
+    uint32_t    latencyMin;         // Shortest time from the timer release to the start of a cycle (us)
+    uint32_t    latencyMax;         // Longest time from the timer release to the start of a cycle (us)
+    uint32_t    latencyMean;        // Mean time from the timer release to the start of a cycle (us)
+    uint32_t    runMax;             // Longest time from the timer release to the end of a cycle (us)
+} executiveStats_t;
+
+
+/*
+ * Function:    initControlExecutive
+ * ----------------------------------
+ * Starts the hardware timer that releases the control executive
+ * every EXECUTIVE_PERIOD.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initControlExecutive(void);
+
+/*
+ * Function:    enableControl
+ * ---------------------------
+ * Starts or stops the controllers and rotor outputs. The altitude
+ * and yaw estimates keep running while control is stopped.
+ *
+ * @params:
+ *      - bool enable: True to run the controllers.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void enableControl(bool enable);
+
+/*
+ * Function:    getExecutiveStats
+ * -------------------------------
+ * Returns the cycle timing since the statistics were last read,
+ * then starts a new window.
+ *
+ * @params:
+ *      - executiveStats_t* stats: Filled with the timing.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void getExecutiveStats(executiveStats_t* stats);
+
+/*
+ * Function:    ControlExecutive
+ * ------------------------------
+ * FreeRTOS task released by the control timer. Each cycle samples
+ * and estimates the altitude and yaw, runs the altitude and yaw
+ * loops that are due, mixing in the feedforward terms, and writes
+ * their duties to the rotors.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void ControlExecutive(void *pvParameters);
+
+#endif /* CONTROLEXECUTIVE_H_ */
@@ -0,0 +1,618 @@
+/* ****************************************************************
+ * flightRecorder.c
+ *
+ * Source file of the flight recorder module.
+ * Records every input the control stack reads (ADC blocks,
+ * quadrature readings, reference pulses, control timer releases,
+ * edge timer reads, button and switch levels and UART characters)
+ * and the rotor duties it writes, stamped with the tick count,
+ * into a compact binary buffer. The buffer is dumped over UART with the "trace"
+ * command and replayed through the same code on the host by
+ * sim/heliReplay, which checks the duties come out the same.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include "flightRecorder.h"
+#include "uart.h"
+#include "utils/ustdlib.h"
+
+#define FLIGHT_RECORD_MAX_BYTES (1 + 5 + 1 + FLIGHT_RECORD_MAX_SAMPLES * 3) // Header, tick varint, count and samples
+#define FLIGHT_RECORD_TYPE_SHIFT 4
+#define FLIGHT_RECORD_NIBBLE    0x0F
+#define VARINT_MORE             0x80        // Set on every varint byte but the last
+#define VARINT_BITS             7
+#define NO_LEVELS               0xFFFF      // Levels value before the first poll is recorded
+
+#if FLIGHT_RECORDER_ENABLE
+static uint8_t g_recording[FLIGHT_RECORDER_BYTES];
+
+// Running values the records are stored relative to. Only changed inside a critical section
+static TickType_t g_lastTick = 0;
+static uint16_t g_lastSample = 0;
+static uint32_t g_lastEdgeTime = 0;
+static uint16_t g_lastButtons = NO_LEVELS;
+static uint16_t g_lastSwitches = NO_LEVELS;
+#else
+static uint8_t g_recording[1];
+#endif /* FLIGHT_RECORDER_ENABLE */
+static uint32_t g_recordedBytes = 0;
+static bool g_stopped = false;              // Set once the buffer fills or the recording is dumped
+
+static const char g_hexDigits[] = "0123456789abcdef";
+
+
+#if FLIGHT_RECORDER_ENABLE
+/*
+ * Function:    putVarint
+ * -----------------------
+ * Writes a value seven bits at a time, lowest first.
+ *
+ * @params:
+ *      - uint8_t* out: Where to write.
+ *      - uint32_t value: The value.
+ * @return:
+ *      - uint32_t length: Bytes written.
+ * ---------------------
+ */
+static uint32_t
+putVarint(uint8_t* out, uint32_t value)
+{
+    uint32_t length = 0;
+
+    while (value >= VARINT_MORE) {
+        out[length++] = (uint8_t) (value | VARINT_MORE);
+        value >>= VARINT_BITS;
+    }
+    out[length++] = (uint8_t) value;
+    return length;
+}
+
+
+/*
+ * Function:    putHeader
+ * -----------------------
+ * Writes the type and tick of a record stamped with the current
+ * tick count. Must be called inside the critical section.
+ *
+ * @params:
+ *      - uint8_t* out: Where to write.
+ *      - uint8_t type: The record type.
+ * @return:
+ *      - uint32_t length: Bytes written.
+ * ---------------------
+ */
+static uint32_t
+putHeader(uint8_t* out, uint8_t type)
+{
+    TickType_t tick = xTaskGetTickCountFromISR();
+    uint32_t delta = tick - g_lastTick;
+
+    g_lastTick = tick;
+    if (delta < FLIGHT_RECORD_LONG_DELTA) {
+        out[0] = (type << FLIGHT_RECORD_TYPE_SHIFT) | delta;
+        return 1;
+    }
+    out[0] = (type << FLIGHT_RECORD_TYPE_SHIFT) | FLIGHT_RECORD_LONG_DELTA;
+    return 1 + putVarint(&out[1], delta - FLIGHT_RECORD_LONG_DELTA);
+}
+
+
+/*
+ * Function:    appendRecord
+ * --------------------------
+ * Copies a record to the buffer. A record that does not fit
+ * stops the recording, marked by a FLIGHT_RECORD_FULL record, as
+ * a replay cannot skip inputs. Must be called inside the critical
+ * section.
+ *
+ * @params:
+ *      - const uint8_t* record: The record.
+ *      - uint32_t length: Its length (bytes).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+appendRecord(const uint8_t* record, uint32_t length)
+{
+    uint32_t i;
+
+    if (g_stopped) {
+        return;
+    }
+    if (g_recordedBytes + length >= FLIGHT_RECORDER_BYTES) {   // Always leaves a byte for the full marker
+        g_recording[g_recordedBytes++] = FLIGHT_RECORD_FULL << FLIGHT_RECORD_TYPE_SHIFT;
+        g_stopped = true;
+        return;
+    }
+    for (i = 0; i < length; i++) {
+        g_recording[g_recordedBytes++] = record[i];
+    }
+}
+
+
+/*
+ * Function:    recordValue
+ * -------------------------
+ * Records a record holding a single byte or varint value.
+ *
+ * @params:
+ *      - uint8_t type: The record type.
+ *      - uint32_t value: The value.
+ *      - bool isVarint: True to store the value as a varint,
+ *      false to store its low byte.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+recordValue(uint8_t type, uint32_t value, bool isVarint)
+{
+    uint8_t record[FLIGHT_RECORD_MAX_BYTES];
+    uint32_t length;
+    UBaseType_t mask;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();                           // Usable from tasks and interrupts
+    length = putHeader(record, type);
+    if (isVarint) {
+        length += putVarint(&record[length], value);
+    } else {
+        record[length++] = (uint8_t) value;
+    }
+    appendRecord(record, length);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+
+/*
+ * Function:    recordEvent
+ * -------------------------
+ * Records a record with no value.
+ *
+ * @params:
+ *      - uint8_t type: The record type.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+recordEvent(uint8_t type)
+{
+    uint8_t record[FLIGHT_RECORD_MAX_BYTES];
+    uint32_t length;
+    UBaseType_t mask;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    length = putHeader(record, type);
+    appendRecord(record, length);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+#endif /* FLIGHT_RECORDER_ENABLE */
+
+
+/*
+ * Function:    recordADCBlock
+ * ----------------------------
+ * Records a block of ADC samples as it is handed to the sample
+ * ring. Called from the ADC interrupt. Samples are stored as the
+ * zigzag encoded difference from the previous one, so noise
+ * around a steady level takes a byte a sample.
+ *
+ * @params:
+ *      - const uint16_t* samples: The block.
+ *      - uint8_t count: Number of samples, up to FLIGHT_RECORD_MAX_SAMPLES.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+recordADCBlock(const uint16_t* samples, uint8_t count)
+{
+#if FLIGHT_RECORDER_ENABLE
+    uint8_t record[FLIGHT_RECORD_MAX_BYTES];
+    uint32_t length;
+    int32_t difference;
+    UBaseType_t mask;
+    uint8_t i;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    length = putHeader(record, FLIGHT_RECORD_ADC_BLOCK);
+    record[length++] = count;
+    for (i = 0; i < count; i++) {
+        difference = (int32_t) samples[i] - g_lastSample;
+        length += putVarint(&record[length], ((uint32_t) difference << 1) ^ (uint32_t) (difference >> 31));
+        g_lastSample = samples[i];
+    }
+    appendRecord(record, length);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+#endif /* FLIGHT_RECORDER_ENABLE */
+}
+
+
+/*
+ * Function:    recordQuadrature
+ * ------------------------------
+ * Records the channel reading taken by the quadrature interrupt.
+ *
+ * @params:
+ *      - uint8_t reading: The two channel levels.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+recordQuadrature(uint8_t reading)
+{
+#if FLIGHT_RECORDER_ENABLE
+    recordValue(FLIGHT_RECORD_QUADRATURE, reading, false);
+#endif /* FLIGHT_RECORDER_ENABLE */
+}
+
+
+/*
+ * Function:    recordReference
+ * -----------------------------
+ * Records a reference interrupt.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+recordReference(void)
+{
+#if FLIGHT_RECORDER_ENABLE
+    recordEvent(FLIGHT_RECORD_REFERENCE);
+#endif /* FLIGHT_RECORDER_ENABLE */
+}
+
+
+/*
+ * Function:    recordControlCycle
+ * --------------------------------
+ * Records the control timer releasing a control executive cycle.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+recordControlCycle(void)
+{
+#if FLIGHT_RECORDER_ENABLE
+    recordEvent(FLIGHT_RECORD_CONTROL_TIMER);
+#endif /* FLIGHT_RECORDER_ENABLE */
+}
+
+
+/*
+ * Function:    recordUARTChar
+ * ----------------------------
+ * Records a character taken by the UART receive interrupt.
+ *
+ * @params:
+ *      - char character: The character.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+recordUARTChar(char character)
+{
+#if FLIGHT_RECORDER_ENABLE
+    recordValue(FLIGHT_RECORD_UART_RX, (uint8_t) character, false);
+#endif /* FLIGHT_RECORDER_ENABLE */
+}
+
+
+/*
+ * Function:    recordButtons
+ * ---------------------------
+ * Records the button levels read by a poll if any have changed
+ * since the previous poll. Only the button task calls this.
+ *
+ * @params:
+ *      - uint8_t levels: One bit per button, indexed by butNames.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+recordButtons(uint8_t levels)
+{
+#if FLIGHT_RECORDER_ENABLE
+    if (levels != g_lastButtons) {
+        g_lastButtons = levels;
+        recordValue(FLIGHT_RECORD_BUTTONS, levels, false);
+    }
+#endif /* FLIGHT_RECORDER_ENABLE */
+}
+
+
+/*
+ * Function:    recordSwitches
+ * ----------------------------
+ * Records the switch levels read by a poll if either has changed
+ * since the previous poll. Only the switch task calls this.
+ *
+ * @params:
+ *      - uint8_t levels: The switch pins read from their port.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+recordSwitches(uint8_t levels)
+{
+#if FLIGHT_RECORDER_ENABLE
+    if (levels != g_lastSwitches) {
+        g_lastSwitches = levels;
+        recordValue(FLIGHT_RECORD_SWITCHES, levels, false);
+    }
+#endif /* FLIGHT_RECORDER_ENABLE */
+}
+
+
+/*
+ * Function:    recordEdgeTimer
+ * -----------------------------
+ * Records a read of the yaw edge timer, as the difference from
+ * the previous read.
+ *
+ * @params:
+ *      - uint32_t count: The value read.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+recordEdgeTimer(uint32_t count)
+{
+#if FLIGHT_RECORDER_ENABLE
+    uint8_t record[FLIGHT_RECORD_MAX_BYTES];
+    uint32_t length;
+    UBaseType_t mask;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    length = putHeader(record, FLIGHT_RECORD_EDGE_TIMER);
+    length += putVarint(&record[length], count - g_lastEdgeTime);  // Unsigned difference handles timer wrap
+    g_lastEdgeTime = count;
+    appendRecord(record, length);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+#endif /* FLIGHT_RECORDER_ENABLE */
+}
+
+
+/*
+ * Function:    recordRotorDuty
+ * -----------------------------
+ * Records a rotor duty written to the PWM.
+ *
+ * @params:
+ *      - uint32_t duty: The duty (%).
+ *      - bool isMain: True for the main rotor.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+recordRotorDuty(uint32_t duty, bool isMain)
+{
+#if FLIGHT_RECORDER_ENABLE
+    recordValue(isMain ? FLIGHT_RECORD_MAIN_DUTY : FLIGHT_RECORD_TAIL_DUTY, duty, true);
+#endif /* FLIGHT_RECORDER_ENABLE */
+}
+
+
+/*
+ * Function:    getFlightRecording
+ * --------------------------------
+ * Returns the recording so far.
+ *
+ * @params:
+ *      - uint32_t* length: Set to the number of bytes recorded.
+ * @return:
+ *      - const uint8_t* data: The recording.
+ * ---------------------
+ */
+const uint8_t*
+getFlightRecording(uint32_t* length)
+{
+    *length = g_recordedBytes;
+    return g_recording;
+}
+
+
+/*
+ * Function:    dumpFlightRecording
+ * ---------------------------------
+ * Stops recording and sends the recording over UART as hex, one
+ * "REC <offset> <bytes>" line at a time, between "REC SIZE <n>"
+ * and "REC END" lines. Sending again repeats the same recording,
+ * so a dump with lines lost to other UART output can be retried.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+dumpFlightRecording(void)
+{
+    char line[MAX_STR_LEN];
+    uint32_t offset;
+    uint32_t length;
+    uint32_t i;
+
+    taskENTER_CRITICAL();
+    g_stopped = true;                                               // Nothing more changes the recording
+    taskEXIT_CRITICAL();
+
+    usnprintf(line, sizeof(line), "REC SIZE %u\n", g_recordedBytes);
+    UARTSend(line);
+    for (offset = 0; offset < g_recordedBytes; offset += FLIGHT_DUMP_LINE_BYTES) {
+        length = usnprintf(line, sizeof(line), "REC %06x ", offset);
+        for (i = offset; i < g_recordedBytes && i < offset + FLIGHT_DUMP_LINE_BYTES; i++) {
+            line[length++] = g_hexDigits[g_recording[i] >> 4];
+            line[length++] = g_hexDigits[g_recording[i] & FLIGHT_RECORD_NIBBLE];
+        }
+        line[length++] = '\n';
+        line[length] = '\0';
+        UARTSend(line);
+    }
+    UARTSend("REC END\n");
+}
+
+
+/*
+ * Function:    initFlightReader
+ * ------------------------------
+ * Starts decoding a recording from its first record.
+ *
+ * @params:
+ *      - flightReader_t* reader: The reader to start.
+ *      - const uint8_t* data: The recording.
+ *      - uint32_t length: Its length (bytes).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initFlightReader(flightReader_t* reader, const uint8_t* data, uint32_t length)
+{
+    reader->data = data;
+    reader->length = length;
+    reader->offset = 0;
+    reader->tick = 0;
+    reader->sample = 0;
+    reader->edgeTime = 0;
+}
+
+
+/*
+ * Function:    getVarint
+ * -----------------------
+ * Reads a varint from a recording.
+ *
+ * @params:
+ *      - flightReader_t* reader: The reader.
+ *      - uint32_t* value: Set to the value.
+ * @return:
+ *      - bool found: False if the recording ends part way through.
+ * ---------------------
+ */
+static bool
+getVarint(flightReader_t* reader, uint32_t* value)
+{
+    uint32_t shift = 0;
+    uint8_t byte;
+
+    *value = 0;
+    do {
+        if (reader->offset >= reader->length || shift >= 32) {
+            return false;
+        }
+        byte = reader->data[reader->offset++];
+        *value |= (uint32_t) (byte & ~VARINT_MORE) << shift;
+        shift += VARINT_BITS;
+    } while (byte & VARINT_MORE);
+
+    return true;
+}
+
+
+/*
+ * Function:    readFlightRecord
+ * ------------------------------
+ * Decodes the next record of a recording.
+ *
+ * @params:
+ *      - flightReader_t* reader: The reader.
+ *      - flightRecord_t* record: Filled with the record.
+ * @return:
+ *      - bool found: False at the end of the recording or if it is
+ *      cut off part way through a record.
+ * ---------------------
+ */
+bool
+readFlightRecord(flightReader_t* reader, flightRecord_t* record)
+{
+    uint8_t header;
+    uint32_t delta;
+    uint32_t value;
+    uint8_t i;
+
+    if (reader->offset >= reader->length) {
+        return false;
+    }
+    header = reader->data[reader->offset++];
+    record->type = header >> FLIGHT_RECORD_TYPE_SHIFT;
+    delta = header & FLIGHT_RECORD_NIBBLE;
+    if (delta == FLIGHT_RECORD_LONG_DELTA) {
+        if (!getVarint(reader, &value)) {
+            return false;
+        }
+        delta += value;
+    }
+    reader->tick += delta;
+    record->tick = reader->tick;
+    record->value = 0;
+    record->count = 0;
+
+    switch (record->type) {
+        case FLIGHT_RECORD_ADC_BLOCK:
+            if (reader->offset >= reader->length || reader->data[reader->offset] > FLIGHT_RECORD_MAX_SAMPLES) {
+                return false;
+            }
+            record->count = reader->data[reader->offset++];
+            for (i = 0; i < record->count; i++) {
+                if (!getVarint(reader, &value)) {
+                    return false;
+                }
+                reader->sample += (uint16_t) ((value >> 1) ^ -(value & 1));    // Undo the zigzag encoding
+                record->samples[i] = reader->sample;
+            }
+            break;
+        case FLIGHT_RECORD_QUADRATURE:
+        case FLIGHT_RECORD_UART_RX:
+        case FLIGHT_RECORD_BUTTONS:
+        case FLIGHT_RECORD_SWITCHES:
+            if (reader->offset >= reader->length) {
+                return false;
+            }
+            record->value = reader->data[reader->offset++];
+            break;
+        case FLIGHT_RECORD_EDGE_TIMER:
+            if (!getVarint(reader, &value)) {
+                return false;
+            }
+            reader->edgeTime += value;
+            record->value = reader->edgeTime;
+            break;
+        case FLIGHT_RECORD_MAIN_DUTY:
+        case FLIGHT_RECORD_TAIL_DUTY:
+            if (!getVarint(reader, &record->value)) {
+                return false;
+            }
+            break;
+        case FLIGHT_RECORD_REFERENCE:
+        case FLIGHT_RECORD_CONTROL_TIMER:
+        case FLIGHT_RECORD_FULL:
+            break;
+        default:
+            return false;                                           // Not a recording, or corrupted
+    }
+
+    return true;
+}
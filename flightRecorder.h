@@ -0,0 +1,266 @@
+/* ****************************************************************
+ * flightRecorder.h
+ *
+ * Header file of the flight recorder module.
+ * Records every input the control stack reads (ADC blocks,
+ * quadrature readings, reference pulses, control timer releases,
+ * edge timer reads, button and switch levels and UART characters)
+ * and the rotor duties it writes, stamped with the tick count,
+ * into a compact binary buffer. The buffer is dumped over UART with the "trace"
+ * command and replayed through the same code on the host by
+ * sim/heliReplay, which checks the duties come out the same.
+ *
+ * Each record starts with a byte holding the record type in the
+ * high nibble and the ticks since the previous record in the low
+ * nibble. A nibble of FLIGHT_RECORD_LONG_DELTA is followed by a
+ * varint of the remaining ticks. ADC samples and edge timer reads
+ * are stored as varints of the difference from the previous one.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef FLIGHTRECORDER_H_
+#define FLIGHTRECORDER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef FLIGHT_RECORDER_ENABLE
+#define FLIGHT_RECORDER_ENABLE  0           // 1 records the inputs and outputs from start-up. The host build sets it
+#endif
+#ifndef FLIGHT_RECORDER_BYTES
+#define FLIGHT_RECORDER_BYTES   4096        // Recording buffer size. Holds the first few seconds after start-up on the target
+#endif
+#define FLIGHT_RECORD_LONG_DELTA 0x0F       // Tick nibble value meaning a varint of the ticks follows
+#define FLIGHT_RECORD_MAX_SAMPLES 16        // Most ADC samples in one block record
+#define FLIGHT_DUMP_LINE_BYTES  8           // Recording bytes per line of the UART dump
+
+// Record types, stored in the high nibble of the first byte
+enum flightRecordTypes {
+    FLIGHT_RECORD_ADC_BLOCK = 1,            // Block of ADC samples handed to the sample ring
+    FLIGHT_RECORD_QUADRATURE,               // Channel reading taken by the quadrature interrupt
+    FLIGHT_RECORD_REFERENCE,                // Reference interrupt
+    FLIGHT_RECORD_UART_RX,                  // Character received by the UART interrupt
+    FLIGHT_RECORD_BUTTONS,                  // Button levels, recorded when they change
+    FLIGHT_RECORD_SWITCHES,                 // Switch levels, recorded when they change
+    FLIGHT_RECORD_EDGE_TIMER,               // Edge timer count read by the yaw module
+    FLIGHT_RECORD_MAIN_DUTY,                // Main rotor duty written
+    FLIGHT_RECORD_TAIL_DUTY,                // Tail rotor duty written
+    FLIGHT_RECORD_FULL,                     // The buffer filled and recording stopped
+    FLIGHT_RECORD_CONTROL_TIMER             // Control timer released a control executive cycle
+};
+
+/* ******************************************************
+ * One decoded record.
+ * *****************************************************/
+typedef struct FlightRecords {
+    uint8_t     type;
+    TickType_t  tick;
+    uint32_t    value;                                  // Reading, levels, character, timer count or duty
+    uint8_t     count;                                  // Number of ADC samples
+    uint16_t    samples[FLIGHT_RECORD_MAX_SAMPLES];
+} flightRecord_t;
+
+/* ******************************************************
+ * Position and running values of a recording being
+ * decoded.
+ * *****************************************************/
+typedef struct FlightReaders {
+    const uint8_t*  data;
+    uint32_t        length;
+    uint32_t        offset;
+    TickType_t      tick;                               // Tick of the previous record
+    uint16_t        sample;                             // Previous ADC sample
+    uint32_t        edgeTime;                           // Previous edge timer read
+} flightReader_t;
+
+
+/*
+ * Function:    recordADCBlock
+ * ----------------------------
+ * Records a block of ADC samples as it is handed to the sample
+ * ring. Called from the ADC interrupt.
+ *
+ * @params:
+ *      - const uint16_t* samples: The block.
+ *      - uint8_t count: Number of samples, up to FLIGHT_RECORD_MAX_SAMPLES.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void recordADCBlock(const uint16_t* samples, uint8_t count);
+
+/*
+ * Function:    recordQuadrature
+ * ------------------------------
+ * Records the channel reading taken by the quadrature interrupt.
+ *
+ * @params:
+ *      - uint8_t reading: The two channel levels.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void recordQuadrature(uint8_t reading);
+
+/*
+ * Function:    recordReference
+ * -----------------------------
+ * Records a reference interrupt.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void recordReference(void);
+
+/*
+ * Function:    recordControlCycle
+ * --------------------------------
+ * Records the control timer releasing a control executive cycle.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void recordControlCycle(void);
+
+/*
+ * Function:    recordUARTChar
+ * ----------------------------
+ * Records a character taken by the UART receive interrupt.
+ *
+ * @params:
+ *      - char character: The character.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void recordUARTChar(char character);
+
+/*
+ * Function:    recordButtons
+ * ---------------------------
+ * Records the button levels read by a poll if any have changed
+ * since the previous poll.
+ *
+ * @params:
+ *      - uint8_t levels: One bit per button, indexed by butNames.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void recordButtons(uint8_t levels);
+
+/*
+ * Function:    recordSwitches
+ * ----------------------------
+ * Records the switch levels read by a poll if either has changed
+ * since the previous poll.
+ *
+ * @params:
+ *      - uint8_t levels: The switch pins read from their port.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void recordSwitches(uint8_t levels);
+
+/*
+ * Function:    recordEdgeTimer
+ * -----------------------------
+ * Records a read of the yaw edge timer.
+ *
+ * @params:
+ *      - uint32_t count: The value read.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void recordEdgeTimer(uint32_t count);
+
+/*
+ * Function:    recordRotorDuty
+ * -----------------------------
+ * Records a rotor duty written to the PWM.
+ *
+ * @params:
+ *      - uint32_t duty: The duty (%).
+ *      - bool isMain: True for the main rotor.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void recordRotorDuty(uint32_t duty, bool isMain);
+
+/*
+ * Function:    getFlightRecording
+ * --------------------------------
+ * Returns the recording so far.
+ *
+ * @params:
+ *      - uint32_t* length: Set to the number of bytes recorded.
+ * @return:
+ *      - const uint8_t* data: The recording.
+ * ---------------------
+ */
+const uint8_t* getFlightRecording(uint32_t* length);
+
+/*
+ * Function:    dumpFlightRecording
+ * ---------------------------------
+ * Stops recording and sends the recording over UART as hex, one
+ * "REC <offset> <bytes>" line at a time, between "REC SIZE <n>"
+ * and "REC END" lines. Sending again repeats the same recording,
+ * so a dump with lines lost to other UART output can be retried.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void dumpFlightRecording(void);
+
+/*
+ * Function:    initFlightReader
+ * ------------------------------
+ * Starts decoding a recording from its first record.
+ *
+ * @params:
+ *      - flightReader_t* reader: The reader to start.
+ *      - const uint8_t* data: The recording.
+ *      - uint32_t length: Its length (bytes).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initFlightReader(flightReader_t* reader, const uint8_t* data, uint32_t length);
+
+/*
+ * Function:    readFlightRecord
+ * ------------------------------
+ * Decodes the next record of a recording.
+ *
+ * @params:
+ *      - flightReader_t* reader: The reader.
+ *      - flightRecord_t* record: Filled with the record.
+ * @return:
+ *      - bool found: False at the end of the recording or if it is
+ *      cut off part way through a record.
+ * ---------------------
+ */
+bool readFlightRecord(flightReader_t* reader, flightRecord_t* record);
+
+#endif /* FLIGHTRECORDER_H_ */
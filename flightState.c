@@ -0,0 +1,547 @@
+/* ****************************************************************
+ * flightState.c
+ *
+ * Source file of the flight state module.
+ * Holds the state shared between the tasks: the altitude estimate,
+ * the desired altitude and yaw and the FSM state, each stamped
+ * with the tick it was written. Each group of fields has a single
+ * writer and is kept twice, with a sequence count that points
+ * readers at the copy not being written. The desired altitude and
+ * yaw are written by more than one task, so each of those writers
+ * has its own group, stamped with a version that orders the
+ * writes, and readers take the newest. Writers never wait and
+ * never mask interrupts, and a reader that preempts a writer
+ * still finds a whole copy. Readers never block or mask
+ * interrupts either. They copy the fields and copy them again if
+ * a count moved, so a snapshot of several fields always comes
+ * from a single point in time. Readable from tasks and interrupts.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include "flightState.h"
+
+// Keep the field accesses between the sequence count accesses. Only the order a writer stores in and a reader
+// loads in matters, so neither needs a full barrier
+#define FLIGHT_STATE_WRITE_BARRIER()    __atomic_thread_fence(__ATOMIC_RELEASE)
+#define FLIGHT_STATE_READ_BARRIER()     __atomic_thread_fence(__ATOMIC_ACQUIRE)
+
+/* ******************************************************
+ * The altitude estimate, written by the control executive.
+ * *****************************************************/
+typedef struct AltitudeLatches {
+    uint32_t            sequence;               // Readers read copy (sequence & 1)
+    altitudeSample_t    copies[2];
+} altitudeLatch_t;
+
+/* ******************************************************
+ * The FSM state, written by the FSM task.
+ * *****************************************************/
+typedef struct FSMCopies {
+    uint32_t    state;
+    TickType_t  stateTick;
+} fsmCopy_t;
+
+typedef struct FSMLatches {
+    uint32_t    sequence;
+    fsmCopy_t   copies[2];
+} fsmLatch_t;
+
+/* ******************************************************
+ * One writer's copy of the desired altitude and yaw.
+ * *****************************************************/
+typedef struct ReferenceCopies {
+    uint32_t    altVersion;                     // Version of the write that set the desired altitude
+    int32_t     altDesired;
+    TickType_t  altDesiredTick;
+    uint32_t    yawVersion;                     // Version of the write that set the desired yaw
+    int32_t     yawDesired;
+    TickType_t  yawDesiredTick;
+} referenceCopy_t;
+
+typedef struct ReferenceLatches {
+    uint32_t        sequence;
+    uint32_t        version;                    // Version of the writer's latest write
+    referenceCopy_t copies[2];
+} referenceLatch_t;
+
+static volatile altitudeLatch_t g_altitude;
+static volatile fsmLatch_t g_fsm;
+static volatile referenceLatch_t g_references[NUM_FLIGHT_WRITERS];
+
+
+/*
+ * Function:    advanceLatch
+ * --------------------------
+ * Moves readers from the copy a writer is about to write to the
+ * other one. A write stores the first copy, advances, then stores
+ * the second, so readers always have a whole copy to read and a
+ * reader that interrupts a write never waits for it. Only the
+ * group's own writer may call this, so nothing needs masking.
+ *
+ * @params:
+ *      - volatile uint32_t* sequence: The group's sequence count.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+advanceLatch(volatile uint32_t* sequence)
+{
+    FLIGHT_STATE_WRITE_BARRIER();
+    (*sequence)++;
+    FLIGHT_STATE_WRITE_BARRIER();
+}
+
+
+/*
+ * Function:    isNewer
+ * ---------------------
+ * Compares two write versions, allowing for the counter wrapping.
+ *
+ * @params:
+ *      - uint32_t version: The version to test.
+ *      - uint32_t than: The version to compare against.
+ * @return:
+ *      - bool newer: True if version came after than.
+ * ---------------------
+ */
+static bool
+isNewer(uint32_t version, uint32_t than)
+{
+    return (int32_t) (version - than) > 0;
+}
+
+
+/*
+ * Function:    writeReferences
+ * -----------------------------
+ * Publishes a writer's copy of the references. Changed fields are
+ * stamped with a version one after the newest write of any
+ * writer. Each writer's version is a single word, so reading them
+ * needs no retry. Two writes that overlap may get the same
+ * version, and readers then take the lower writer, which is a
+ * valid order for writes that overlapped.
+ *
+ * @params:
+ *      - flightWriter_t writer: The calling task.
+ *      - referenceCopy_t* copy: The references.
+ *      - bool altChanged: True if the desired altitude was set.
+ *      - bool yawChanged: True if the desired yaw was set.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+writeReferences(flightWriter_t writer, referenceCopy_t* copy, bool altChanged, bool yawChanged)
+{
+    volatile referenceLatch_t* latch = &g_references[writer];
+    uint32_t version = latch->version;
+    uint32_t i;
+
+    for (i = 0; i < NUM_FLIGHT_WRITERS; i++) {
+        if (isNewer(g_references[i].version, version)) {
+            version = g_references[i].version;
+        }
+    }
+    version++;
+    latch->version = version;
+    if (altChanged) {
+        copy->altVersion = version;
+    }
+    if (yawChanged) {
+        copy->yawVersion = version;
+    }
+
+    advanceLatch(&latch->sequence);
+    latch->copies[0] = *copy;
+    advanceLatch(&latch->sequence);
+    latch->copies[1] = *copy;
+}
+
+
+/*
+ * Function:    readReferences
+ * ----------------------------
+ * Fills a snapshot's desired altitude and yaw from the newest
+ * write to each across the writers' copies. The caller must check
+ * the copies' sequence counts around this.
+ *
+ * @params:
+ *      - const uint32_t* sequences: Counts from readReferenceSequences.
+ *      - flightState_t* state: Filled with the references.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+readReferences(const uint32_t* sequences, flightState_t* state)
+{
+    referenceCopy_t copy;
+    uint32_t altVersion = 0;
+    uint32_t yawVersion = 0;
+    uint32_t i;
+
+    for (i = 0; i < NUM_FLIGHT_WRITERS; i++) {
+        copy = g_references[i].copies[sequences[i] & 1];
+        if (i == 0 || isNewer(copy.altVersion, altVersion)) {
+            altVersion = copy.altVersion;
+            state->altDesired = copy.altDesired;
+            state->altDesiredTick = copy.altDesiredTick;
+        }
+        if (i == 0 || isNewer(copy.yawVersion, yawVersion)) {
+            yawVersion = copy.yawVersion;
+            state->yawDesired = copy.yawDesired;
+            state->yawDesiredTick = copy.yawDesiredTick;
+        }
+    }
+}
+
+
+/*
+ * Function:    readReferenceSequences
+ * ------------------------------------
+ * Copies the sequence counts of the writers' copies of the
+ * references.
+ *
+ * @params:
+ *      - uint32_t* sequences: Filled with NUM_FLIGHT_WRITERS counts.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+readReferenceSequences(uint32_t* sequences)
+{
+    uint32_t i;
+
+    for (i = 0; i < NUM_FLIGHT_WRITERS; i++) {
+        sequences[i] = g_references[i].sequence;
+    }
+}
+
+
+/*
+ * Function:    referencesMoved
+ * -----------------------------
+ * Checks whether any writer's copy of the references has been
+ * written since its sequence count was read.
+ *
+ * @params:
+ *      - const uint32_t* sequences: Counts from readReferenceSequences.
+ * @return:
+ *      - bool moved: True if a count has changed.
+ * ---------------------
+ */
+static bool
+referencesMoved(const uint32_t* sequences)
+{
+    uint32_t i;
+
+    for (i = 0; i < NUM_FLIGHT_WRITERS; i++) {
+        if (sequences[i] != g_references[i].sequence) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/*
+ * Function:    getReferences
+ * ---------------------------
+ * Takes a consistent snapshot of the desired altitude and yaw.
+ *
+ * @params:
+ *      - flightState_t* state: Filled with the references.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+getReferences(flightState_t* state)
+{
+    uint32_t sequences[NUM_FLIGHT_WRITERS];
+
+    do {
+        readReferenceSequences(sequences);
+        FLIGHT_STATE_READ_BARRIER();
+        readReferences(sequences, state);
+        FLIGHT_STATE_READ_BARRIER();
+    } while (referencesMoved(sequences));
+}
+
+
+/*
+ * Function:    initFlightState
+ * -----------------------------
+ * Clears the flight state: landed, on the ground, with zero
+ * desired altitude and yaw. Must be called before the scheduler
+ * starts.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initFlightState(void)
+{
+    const altitudeLatch_t altitude = {0};
+    const fsmLatch_t fsm = {0};
+    const referenceLatch_t references = {0};
+    uint32_t i;
+
+    g_altitude = altitude;
+    g_fsm = fsm;
+    for (i = 0; i < NUM_FLIGHT_WRITERS; i++) {
+        g_references[i] = references;
+    }
+}
+
+
+/*
+ * Function:    setAltMeasured
+ * ----------------------------
+ * Publishes a new altitude estimate. Only the control executive
+ * may call this.
+ *
+ * @params:
+ *      - const altitudeSample_t* sample: The estimate.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+setAltMeasured(const altitudeSample_t* sample)
+{
+    advanceLatch(&g_altitude.sequence);
+    g_altitude.copies[0] = *sample;
+    advanceLatch(&g_altitude.sequence);
+    g_altitude.copies[1] = *sample;
+}
+
+
+/*
+ * Function:    setAltDesired
+ * ---------------------------
+ * Sets the desired altitude.
+ *
+ * @params:
+ *      - flightWriter_t writer: The calling task.
+ *      - int32_t altitude: The desired altitude (%).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+setAltDesired(flightWriter_t writer, int32_t altitude)
+{
+    referenceCopy_t copy = g_references[writer].copies[0]; // Both copies match between this writer's writes
+
+    copy.altDesired = altitude;
+    copy.altDesiredTick = xTaskGetTickCountFromISR();
+    writeReferences(writer, &copy, true, false);
+}
+
+
+/*
+ * Function:    setYawDesired
+ * ---------------------------
+ * Sets the desired yaw.
+ *
+ * @params:
+ *      - flightWriter_t writer: The calling task.
+ *      - int32_t yaw: The desired yaw (degrees).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+setYawDesired(flightWriter_t writer, int32_t yaw)
+{
+    referenceCopy_t copy = g_references[writer].copies[0];
+
+    copy.yawDesired = yaw;
+    copy.yawDesiredTick = xTaskGetTickCountFromISR();
+    writeReferences(writer, &copy, false, true);
+}
+
+
+/*
+ * Function:    setReferences
+ * ---------------------------
+ * Sets the desired altitude and yaw in one write, so no reader
+ * sees one changed without the other.
+ *
+ * @params:
+ *      - flightWriter_t writer: The calling task.
+ *      - int32_t altitude: The desired altitude (%).
+ *      - int32_t yaw: The desired yaw (degrees).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+setReferences(flightWriter_t writer, int32_t altitude, int32_t yaw)
+{
+    referenceCopy_t copy;
+    TickType_t tick = xTaskGetTickCountFromISR();
+
+    copy.altDesired = altitude;
+    copy.altDesiredTick = tick;
+    copy.yawDesired = yaw;
+    copy.yawDesiredTick = tick;
+    writeReferences(writer, &copy, true, true);
+}
+
+
+/*
+ * Function:    setFSMState
+ * -------------------------
+ * Sets the state of the FSM. Only the FSM task may call this.
+ *
+ * @params:
+ *      - uint32_t state: The new state.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+setFSMState(uint32_t state)
+{
+    fsmCopy_t copy;
+
+    copy.state = state;
+    copy.stateTick = xTaskGetTickCountFromISR();
+    advanceLatch(&g_fsm.sequence);
+    g_fsm.copies[0] = copy;
+    advanceLatch(&g_fsm.sequence);
+    g_fsm.copies[1] = copy;
+}
+
+
+/*
+ * Function:    getFlightState
+ * ----------------------------
+ * Takes a consistent snapshot of the whole flight state.
+ *
+ * @params:
+ *      - flightState_t* state: Filled with the snapshot.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+getFlightState(flightState_t* state)
+{
+    uint32_t altSequence;
+    uint32_t fsmSequence;
+    uint32_t references[NUM_FLIGHT_WRITERS];
+    fsmCopy_t fsm;
+
+    do {
+        altSequence = g_altitude.sequence;
+        fsmSequence = g_fsm.sequence;
+        readReferenceSequences(references);
+        FLIGHT_STATE_READ_BARRIER();
+        state->altMeasured = g_altitude.copies[altSequence & 1];
+        fsm = g_fsm.copies[fsmSequence & 1];
+        readReferences(references, state);
+        FLIGHT_STATE_READ_BARRIER();
+    } while (altSequence != g_altitude.sequence || fsmSequence != g_fsm.sequence
+             || referencesMoved(references)); // Copy again if a write came in between
+    state->fsmState = fsm.state;
+    state->fsmStateTick = fsm.stateTick;
+}
+
+
+/*
+ * Function:    getAltMeasured
+ * ----------------------------
+ * Copies the latest altitude estimate.
+ *
+ * @params:
+ *      - altitudeSample_t* sample: Filled with the estimate.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+getAltMeasured(altitudeSample_t* sample)
+{
+    uint32_t sequence;
+
+    do {
+        sequence = g_altitude.sequence;
+        FLIGHT_STATE_READ_BARRIER();
+        *sample = g_altitude.copies[sequence & 1];
+        FLIGHT_STATE_READ_BARRIER();
+    } while (sequence != g_altitude.sequence);
+}
+
+
+/*
+ * Function:    getAltDesired
+ * ---------------------------
+ * Returns the desired altitude.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t altitude: The desired altitude (%).
+ * ---------------------
+ */
+int32_t
+getAltDesired(void)
+{
+    flightState_t state;
+
+    getReferences(&state);
+    return state.altDesired;
+}
+
+
+/*
+ * Function:    getYawDesired
+ * ---------------------------
+ * Returns the desired yaw.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t yaw: The desired yaw (degrees).
+ * ---------------------
+ */
+int32_t
+getYawDesired(void)
+{
+    flightState_t state;
+
+    getReferences(&state);
+    return state.yawDesired;
+}
+
+
+/*
+ * Function:    getFSMState
+ * -------------------------
+ * Returns the state of the FSM.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint32_t state: The current state.
+ * ---------------------
+ */
+uint32_t
+getFSMState(void)
+{
+    return g_fsm.copies[g_fsm.sequence & 1].state; // A single word is read in one access, so needs no retry
+}
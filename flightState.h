@@ -0,0 +1,222 @@
+/* ****************************************************************
+ * flightState.h
+ *
+ * Header file of the flight state module.
+ * Holds the state shared between the tasks: the altitude estimate,
+ * the desired altitude and yaw and the FSM state, each stamped
+ * with the tick it was written. Each group of fields has a single
+ * writer and is kept twice, with a sequence count that points
+ * readers at the copy not being written. The desired altitude and
+ * yaw are written by more than one task, so each of those writers
+ * has its own group, stamped with a version that orders the
+ * writes, and readers take the newest. Writers never wait and
+ * never mask interrupts, and a reader that preempts a writer
+ * still finds a whole copy. Readers never block or mask
+ * interrupts either. They copy the fields and copy them again if
+ * a count moved, so a snapshot of several fields always comes
+ * from a single point in time. Readable from tasks and interrupts.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef FLIGHTSTATE_H_
+#define FLIGHTSTATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* ******************************************************
+ * Altitude estimate published to the control loop each
+ * control period, stamped so consumers can tell how old
+ * the underlying ADC data is.
+ * *****************************************************/
+typedef struct AltitudeSamples {
+    int32_t     altitude;       // Altitude as a percentage of the maximum height
+    int32_t     rate;           // Vertical velocity in percent per second (Q16.16)
+    TickType_t  timestamp;      // Tick count when the estimate was made
+    TickType_t  sampleAge;      // Age (in ticks) of the newest ADC sample at the time of the estimate
+} altitudeSample_t;
+
+/* ******************************************************
+ * The tasks that write the desired altitude and yaw. Each
+ * has its own copy of them.
+ * *****************************************************/
+typedef enum FlightWriters {
+    FLIGHT_WRITER_FSM = 0,                      // The FSM task
+    FLIGHT_WRITER_BUTTONS,                      // The button polling task
+    NUM_FLIGHT_WRITERS
+} flightWriter_t;
+
+/* ******************************************************
+ * Snapshot of the shared flight state.
+ * *****************************************************/
+typedef struct FlightStates {
+    altitudeSample_t altMeasured;               // Stamped by the altitude module
+    int32_t     altDesired;                     // Desired altitude (%)
+    TickType_t  altDesiredTick;                 // Tick the desired altitude was written
+    int32_t     yawDesired;                     // Desired yaw (degrees)
+    TickType_t  yawDesiredTick;                 // Tick the desired yaw was written
+    uint32_t    fsmState;                       // State of the FSM, from the FSM's states
+    TickType_t  fsmStateTick;                   // Tick the state was written
+} flightState_t;
+
+
+/*
+ * Function:    initFlightState
+ * -----------------------------
+ * Clears the flight state: landed, on the ground, with zero
+ * desired altitude and yaw. Must be called before the scheduler
+ * starts.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initFlightState(void);
+
+/*
+ * Function:    setAltMeasured
+ * ----------------------------
+ * Publishes a new altitude estimate. Only the control executive
+ * may call this.
+ *
+ * @params:
+ *      - const altitudeSample_t* sample: The estimate.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void setAltMeasured(const altitudeSample_t* sample);
+
+/*
+ * Function:    setAltDesired
+ * ---------------------------
+ * Sets the desired altitude.
+ *
+ * @params:
+ *      - flightWriter_t writer: The calling task.
+ *      - int32_t altitude: The desired altitude (%).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void setAltDesired(flightWriter_t writer, int32_t altitude);
+
+/*
+ * Function:    setYawDesired
+ * ---------------------------
+ * Sets the desired yaw.
+ *
+ * @params:
+ *      - flightWriter_t writer: The calling task.
+ *      - int32_t yaw: The desired yaw (degrees).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void setYawDesired(flightWriter_t writer, int32_t yaw);
+
+/*
+ * Function:    setReferences
+ * ---------------------------
+ * Sets the desired altitude and yaw in one write, so no reader
+ * sees one changed without the other.
+ *
+ * @params:
+ *      - flightWriter_t writer: The calling task.
+ *      - int32_t altitude: The desired altitude (%).
+ *      - int32_t yaw: The desired yaw (degrees).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void setReferences(flightWriter_t writer, int32_t altitude, int32_t yaw);
+
+/*
+ * Function:    setFSMState
+ * -------------------------
+ * Sets the state of the FSM. Only the FSM task may call this.
+ *
+ * @params:
+ *      - uint32_t state: The new state.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void setFSMState(uint32_t state);
+
+/*
+ * Function:    getFlightState
+ * ----------------------------
+ * Takes a consistent snapshot of the whole flight state.
+ *
+ * @params:
+ *      - flightState_t* state: Filled with the snapshot.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void getFlightState(flightState_t* state);
+
+/*
+ * Function:    getAltMeasured
+ * ----------------------------
+ * Copies the latest altitude estimate.
+ *
+ * @params:
+ *      - altitudeSample_t* sample: Filled with the estimate.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void getAltMeasured(altitudeSample_t* sample);
+
+/*
+ * Function:    getAltDesired
+ * ---------------------------
+ * Returns the desired altitude.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t altitude: The desired altitude (%).
+ * ---------------------
+ */
+int32_t getAltDesired(void);
+
+/*
+ * Function:    getYawDesired
+ * ---------------------------
+ * Returns the desired yaw.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t yaw: The desired yaw (degrees).
+ * ---------------------
+ */
+int32_t getYawDesired(void);
+
+/*
+ * Function:    getFSMState
+ * -------------------------
+ * Returns the state of the FSM.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint32_t state: The current state.
+ * ---------------------
+ */
+uint32_t getFSMState(void);
+
+#endif /* FLIGHTSTATE_H_ */
@@ -0,0 +1,121 @@
+/* ****************************************************************
+ * gainSchedule.c
+ *
+ * Source file of the gain schedule module.
+ * Scales the altitude controller gains with the measured altitude
+ * so ground effect near 0% and the dynamics near 100% can each be
+ * tuned for, instead of detuning for the worst case.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include "gainSchedule.h"
+
+// Gain multipliers at ALT_SCHEDULE_MIN, then every ALT_SCHEDULE_STEP % of altitude.
+// The base gains (ALT_KP, ALT_KI, ALT_KD or those set over UART) are multiplied by these.
+static const gainScale_t g_altGainSchedule[ALT_SCHEDULE_POINTS] = {
+    //  Kp                  Ki                  Kd
+    { GAIN_SCALE(0.80), GAIN_SCALE(0.70), GAIN_SCALE(0.80) },  //   0 %, ground effect stiffens the response
+    { GAIN_SCALE(1.00), GAIN_SCALE(1.00), GAIN_SCALE(1.00) },  //  25 %
+    { GAIN_SCALE(1.00), GAIN_SCALE(1.00), GAIN_SCALE(1.00) },  //  50 %
+    { GAIN_SCALE(1.10), GAIN_SCALE(1.00), GAIN_SCALE(1.10) },  //  75 %
+    { GAIN_SCALE(1.20), GAIN_SCALE(1.10), GAIN_SCALE(1.20) }   // 100 %
+};
+
+
+/*
+ * Function:    interpolate
+ * -------------------------
+ * Linearly interpolates between two Q format values.
+ *
+ * @params:
+ *      - int32_t low: Value at the lower entry.
+ *      - int32_t high: Value at the upper entry.
+ *      - int32_t fraction: Position between the entries (Q format).
+ * @return:
+ *      - int32_t value: The interpolated value.
+ * ---------------------
+ */
+static int32_t
+interpolate(int32_t low, int32_t high, int32_t fraction)
+{
+    return low + (int32_t) (((int64_t) (high - low) * fraction) >> PID_Q_BITS);
+}
+
+
+/*
+ * Function:    getAltitudeGainScale
+ * ----------------------------------
+ * Looks up the altitude gain multipliers for an altitude,
+ * interpolating linearly between the two nearest table entries.
+ * The entries are evenly spaced so the lower entry is found with a
+ * single division by a constant. Altitudes outside the table use
+ * the end entries. With the schedule disabled every multiplier
+ * is 1.
+ *
+ * @params:
+ *      - int32_t altitude: Altitude (%).
+ *      - gainScale_t* scale: Destination for the multipliers.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+getAltitudeGainScale(int32_t altitude, gainScale_t* scale)
+{
+#if ALT_SCHEDULE_ENABLE
+    int32_t offset = altitude - ALT_SCHEDULE_MIN;
+    int32_t index;
+    int32_t fraction;
+
+    // Clamp to the table, leaving room for the upper entry
+    if (offset < 0) {
+        offset = 0;
+    } else if (offset > ALT_SCHEDULE_STEP * (ALT_SCHEDULE_POINTS - 1)) {
+        offset = ALT_SCHEDULE_STEP * (ALT_SCHEDULE_POINTS - 1);
+    }
+    index = offset / ALT_SCHEDULE_STEP;
+    if (index == ALT_SCHEDULE_POINTS - 1) {
+        index--;
+    }
+    fraction = ((offset - index * ALT_SCHEDULE_STEP) << PID_Q_BITS) / ALT_SCHEDULE_STEP;
+
+    scale->Kp = interpolate(g_altGainSchedule[index].Kp, g_altGainSchedule[index + 1].Kp, fraction);
+    scale->Ki = interpolate(g_altGainSchedule[index].Ki, g_altGainSchedule[index + 1].Ki, fraction);
+    scale->Kd = interpolate(g_altGainSchedule[index].Kd, g_altGainSchedule[index + 1].Kd, fraction);
+#else
+    scale->Kp = PID_Q_ONE;
+    scale->Ki = PID_Q_ONE;
+    scale->Kd = PID_Q_ONE;
+#endif /* ALT_SCHEDULE_ENABLE */
+}
+
+
+/*
+ * Function:    scheduleAltitudeGains
+ * -----------------------------------
+ * Scales the altitude controller gains for the measured altitude
+ * by the multipliers from getAltitudeGainScale.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: The altitude controller.
+ *      - int32_t altitude: Measured altitude (%).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+scheduleAltitudeGains(controller_t* controllerPointer, int32_t altitude)
+{
+#if ALT_SCHEDULE_ENABLE
+    gainScale_t scale;
+
+    getAltitudeGainScale(altitude, &scale);
+    scaleControllerGains(controllerPointer, &scale);
+#endif /* ALT_SCHEDULE_ENABLE */
+}
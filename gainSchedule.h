@@ -0,0 +1,65 @@
+/* ****************************************************************
+ * gainSchedule.h
+ *
+ * Header file of the gain schedule module.
+ * Scales the altitude controller gains with the measured altitude
+ * so ground effect near 0% and the dynamics near 100% can each be
+ * tuned for, instead of detuning for the worst case.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef GAINSCHEDULE_H_
+#define GAINSCHEDULE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pidController.h"
+
+#define ALT_SCHEDULE_ENABLE     1           // 1 scales the altitude gains with altitude, 0 uses the base gains throughout
+#define ALT_SCHEDULE_MIN        0           // Altitude of the first table entry (%)
+#define ALT_SCHEDULE_STEP       25          // Altitude between table entries (%)
+#define ALT_SCHEDULE_POINTS     5           // Number of table entries
+
+#define GAIN_SCALE(x)           ((int32_t) ((x) * PID_Q_ONE))   // Converts a multiplier to Q format at compile time
+
+
+/*
+ * Function:    getAltitudeGainScale
+ * ----------------------------------
+ * Looks up the altitude gain multipliers for an altitude,
+ * interpolating linearly between the two nearest table entries.
+ * With the schedule disabled every multiplier is 1.
+ *
+ * @params:
+ *      - int32_t altitude: Altitude (%).
+ *      - gainScale_t* scale: Destination for the multipliers.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void getAltitudeGainScale(int32_t altitude, gainScale_t* scale);
+
+/*
+ * Function:    scheduleAltitudeGains
+ * -----------------------------------
+ * Scales the altitude controller gains for the measured altitude,
+ * interpolating linearly between the two nearest table entries.
+ * Should be called each control cycle before the control signal
+ * is calculated.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: The altitude controller.
+ *      - int32_t altitude: Measured altitude (%).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void scheduleAltitudeGains(controller_t* controllerPointer, int32_t altitude);
+
+#endif /* GAINSCHEDULE_H_ */
@@ -2,7 +2,11 @@
  * hookFunctions.c
  *
  * Source file for the hookFunctions module
- * Create FreeRTOS hook functions to monitor stack and CPU usage
+ * Create FreeRTOS hook functions to monitor stack and CPU usage.
+ * The idle hook tags the idle task so the profiler counts its
+ * cycles. The tick hook closes a load window every LOAD_WINDOW_MS
+ * and works out the CPU load and each task's share of the window
+ * in fixed point, for the "load" command and the UART display.
  *
  * ENCE464 Assignment 1 Group 2
  * Creators: Grayson Mynott      56353855
@@ -14,6 +18,10 @@
 
 #include "hookFunctions.h"
 
+static loadReport_t g_report;               // Report of the last complete window
+static profileLoad_t g_windowStart;         // Run times at the start of the current window
+static uint16_t g_windowTicks = 0;          // Ticks into the current window
+
 
 /*
  * Function:    vApplicationStackOverflowHook
@@ -39,24 +47,92 @@ vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
 
 /*
  * Function:    vApplicationIdleHook
- * ------------------
- * Idle hook
- * Calculates CPU load for each task
- * This function is run when no other task is running.
+ * ----------------------------------
+ * Idle hook. Run on every pass of the idle task.
+ * Tags the idle task on the first pass, after which the profiler's
+ * task switch hooks count its cycles.
  *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+vApplicationIdleHook(void)
+{
+    static bool tagged = false;
+
+    if (!tagged) {
+        profileTask(PROFILE_IDLE_TASK);
+        tagged = true;
+    }
+}
+
+
+/*
+ * Function:    vApplicationTickHook
+ * ----------------------------------
+ * Tick hook. Run from the tick interrupt.
+ * Counts the ticks of the load window and, once it is
+ * LOAD_WINDOW_MS long, works out the window's load report and
+ * starts the next window. Runs even when the CPU is too busy for
+ * the idle task.
  *
  * @params:
- *      - xTask: Task that triggered the stack
- *      overflow.
+ *      - NULL
  * @return:
  *      - NULL
  * ---------------------
  */
 void
-vApplicationIdleHook( void )
+vApplicationTickHook(void)
 {
-    static char runtime_stats_buffer[STAT_BUFFER_SIZE];
+    profileLoad_t windowEnd;
+    uint32_t scale;                         // Cycles per share unit
+    uint32_t used;                          // Share units accounted for
+    uint32_t idle;
+    uint8_t i;
+
+    if (++g_windowTicks < LOAD_WINDOW_MS / portTICK_RATE_MS) {
+        return;
+    }
+    g_windowTicks = 0;
+
+    getProfileLoad(&windowEnd);             // The first window starts from the zero times at start-up
+    scale = (windowEnd.now - g_windowStart.now) / LOAD_SHARE_SCALE;
+    if (scale == 0) {
+        return;                             // The cycle counter is stopped, as in the host replay
+    }
+    g_report.interrupts = (windowEnd.interrupts - g_windowStart.interrupts) / scale;
+    used = g_report.interrupts;
+    for (i = 0; i < PROFILE_TASKS; i++) {
+        g_report.tasks[i] = (windowEnd.tasks[i] - g_windowStart.tasks[i]) / scale;
+        used += g_report.tasks[i];
+    }
+    idle = g_report.tasks[PROFILE_IDLE_TASK - PROFILE_FIRST_TASK];
+    g_report.load = (idle < LOAD_SHARE_SCALE) ? LOAD_SHARE_SCALE - idle : 0;
+    g_report.other = (used < LOAD_SHARE_SCALE) ? LOAD_SHARE_SCALE - used : 0;    // Rounding can take used just over
+    g_report.windows++;
+    g_windowStart = windowEnd;
+}
+
 
-    vTaskGetRunTimeStats(runtime_stats_buffer); // Calculate CPU load stats
-    UARTSend(runtime_stats_buffer); // Print CPU load stats to UART
+/*
+ * Function:    getLoadReport
+ * ---------------------------
+ * Copies the report of the last complete load window.
+ *
+ * @params:
+ *      - loadReport_t* report: Filled with the report.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+getLoadReport(loadReport_t* report)
+{
+    taskENTER_CRITICAL();
+    *report = g_report;
+    taskEXIT_CRITICAL();
 }
@@ -2,7 +2,11 @@
  * hookFunctions.h
  *
  * Header file for the hookFunctions module
- * Create FreeRTOS hook functions to monitor stack and CPU usage
+ * Create FreeRTOS hook functions to monitor stack and CPU usage.
+ * The idle hook tags the idle task so the profiler counts its
+ * cycles. The tick hook closes a load window every LOAD_WINDOW_MS
+ * and works out the CPU load and each task's share of the window
+ * in fixed point, for the "load" command and the UART display.
  *
  * ENCE464 Assignment 1 Group 2
  * Creators: Grayson Mynott      56353855
@@ -19,8 +23,22 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "uart.h"
+#include "profiler.h"
 
-#define STAT_BUFFER_SIZE    512     // The UART buffer size used to send CPU load information
+#define LOAD_WINDOW_MS      1000    // Length of a load window. Must stay under 2^32 cycles
+#define LOAD_SHARE_SCALE    1000    // Shares are in 1/LOAD_SHARE_SCALE of the window (0.1 %)
+
+/* ******************************************************
+ * CPU use over the last complete load window, in
+ * 1/LOAD_SHARE_SCALE of the window.
+ * *****************************************************/
+typedef struct LoadReports {
+    uint32_t    windows;                    // Windows closed since start-up, 0 until the first one closes
+    uint16_t    load;                       // Time not spent in the idle task
+    uint16_t    interrupts;                 // Time spent in profiled interrupt handlers
+    uint16_t    other;                      // Time left over: the kernel and tasks that are not profiled
+    uint16_t    tasks[PROFILE_TASKS];       // Each profiled task's share, from PROFILE_FIRST_TASK on
+} loadReport_t;
 
 
 /*
@@ -40,20 +58,48 @@ void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName);
 
 /*
  * Function:    vApplicationIdleHook
- * ------------------
- * Idle hook
- * Calculates CPU load for each task
- * This function is run when no other task is running.
+ * ----------------------------------
+ * Idle hook. Run on every pass of the idle task.
+ * Tags the idle task on the first pass, after which the profiler's
+ * task switch hooks count its cycles.
  *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void vApplicationIdleHook(void);
+
+/*
+ * Function:    vApplicationTickHook
+ * ----------------------------------
+ * Tick hook. Run from the tick interrupt.
+ * Counts the ticks of the load window and, once it is
+ * LOAD_WINDOW_MS long, works out the window's load report and
+ * starts the next window. Runs even when the CPU is too busy for
+ * the idle task.
  *
  * @params:
- *      - xTask: Task that triggered the stack
- *      overflow.
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void vApplicationTickHook(void);
+
+/*
+ * Function:    getLoadReport
+ * ---------------------------
+ * Copies the report of the last complete load window.
+ *
+ * @params:
+ *      - loadReport_t* report: Filled with the report.
  * @return:
  *      - NULL
  * ---------------------
  */
-void vApplicationIdleHook( void );
+void getLoadReport(loadReport_t* report);
 
 
 #endif /* HOOKFUNCTIONS_H_ */
@@ -21,6 +21,7 @@
 #include "FreeRTOS.h"
 #include "FreeRTOSCreate.h"
 #include "reset.h"
+#include "profiler.h"
 
 
 /*
@@ -57,8 +58,10 @@ initSystem(void)
 {
     IntMasterDisable();         // Disable system interrupts while the program is initializing.
     initClk();                  // Initialise the system clock
+    initProfiler();             // Start the cycle counter
     initialiseUSB_UART();       // Initialise UART communication over USB
     initFreeRTOS();             // Initialise FreeRTOS components
+    initUARTCommand();          // Initialise the UART command receive interrupt
     initReset();                // Initialise the hard reset of the system
     initLED();                  // Initialise the status LED
     OLEDInitialise();           // Initialise the OLED display
@@ -67,6 +70,7 @@ initSystem(void)
     initQuadrature();           // Initialise the quadrature decoding interrupts
     initReferenceYaw();         // Initialise the reference yaw interrupt
     initPWM();                  // Initialise the PWM modules
+    initControlExecutive();     // Start the control timer
     IntMasterEnable();          // Re-enable system interrupts
 
 }
@@ -0,0 +1,101 @@
+/* ****************************************************************
+ * mixer.c
+ *
+ * Source file of the output mixer module.
+ * Provides the feedforward terms added to the PID outputs: the
+ * hover duty for the main rotor and the tail duty needed to cancel
+ * the main rotor's torque, looked up from a calibration curve.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include "mixer.h"
+
+// Tail duty (%) that cancels the main rotor torque at 0 %, then every MIXER_COUPLING_STEP % of main duty.
+// Starts from the old 64/100 factor. Recalibrate by holding a hover at each main duty and recording
+// how much the yaw integrator settles to.
+static const int32_t g_tailCoupling[MIXER_COUPLING_POINTS] = {
+     0,  6, 13, 19, 26, 32, 38, 45, 51, 58, 64
+};
+
+
+/*
+ * Function:    getHoverFeedforward
+ * ---------------------------------
+ * Returns the duty fed forward into the altitude loop so its
+ * integrator only has to hold the difference from hover.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t duty: Main rotor feedforward duty (%).
+ * ---------------------
+ */
+int32_t
+getHoverFeedforward(void)
+{
+#if MIXER_HOVER_ENABLE
+    return MIXER_HOVER_DUTY;
+#else
+    return 0;
+#endif /* MIXER_HOVER_ENABLE */
+}
+
+
+/*
+ * Function:    getCouplingFeedforward
+ * ------------------------------------
+ * Returns the tail duty needed to cancel the torque of the main
+ * rotor at a given main duty, interpolating linearly between the
+ * two nearest entries of the coupling table. Duties outside the
+ * table use the end entries.
+ *
+ * @params:
+ *      - int32_t mainDuty: The main rotor duty (%).
+ * @return:
+ *      - int32_t duty: Tail rotor feedforward duty (%).
+ * ---------------------
+ */
+int32_t
+getCouplingFeedforward(int32_t mainDuty)
+{
+#if MIXER_COUPLING_ENABLE
+    int32_t index;
+    int32_t remainder;
+    int32_t low;
+    int32_t high;
+    int32_t change;
+
+    // Clamp to the table, leaving room for the upper entry
+    if (mainDuty < 0) {
+        mainDuty = 0;
+    } else if (mainDuty > MIXER_COUPLING_STEP * (MIXER_COUPLING_POINTS - 1)) {
+        mainDuty = MIXER_COUPLING_STEP * (MIXER_COUPLING_POINTS - 1);
+    }
+    index = mainDuty / MIXER_COUPLING_STEP;
+    if (index == MIXER_COUPLING_POINTS - 1) {
+        index--;
+    }
+    remainder = mainDuty - index * MIXER_COUPLING_STEP;
+
+    low = g_tailCoupling[index];
+    high = g_tailCoupling[index + 1];
+
+    // Round to the nearest percent, away from zero on a falling segment as on a rising one.
+    // Division truncates towards zero, so the half step is added in the direction of the change
+    change = (high - low) * remainder * 2;
+    if (change >= 0) {
+        change += MIXER_COUPLING_STEP;
+    } else {
+        change -= MIXER_COUPLING_STEP;
+    }
+    return low + change / (MIXER_COUPLING_STEP * 2);
+#else
+    return 0;
+#endif /* MIXER_COUPLING_ENABLE */
+}
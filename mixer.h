@@ -0,0 +1,59 @@
+/* ****************************************************************
+ * mixer.h
+ *
+ * Header file of the output mixer module.
+ * Provides the feedforward terms added to the PID outputs: the
+ * hover duty for the main rotor and the tail duty needed to cancel
+ * the main rotor's torque, looked up from a calibration curve.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef MIXER_H_
+#define MIXER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MIXER_HOVER_ENABLE      1           // 1 feeds the hover duty forward into the altitude loop
+#define MIXER_HOVER_DUTY        30          // Main duty that roughly holds a hover. Calibrate on the rig
+#define MIXER_COUPLING_ENABLE   1           // 1 feeds the main rotor torque compensation forward into the yaw loop
+#define MIXER_COUPLING_STEP     10          // Main duty between coupling table entries (%)
+#define MIXER_COUPLING_POINTS   11          // Number of coupling table entries, covering 0 to 100 % main duty
+
+
+/*
+ * Function:    getHoverFeedforward
+ * ---------------------------------
+ * Returns the duty fed forward into the altitude loop so its
+ * integrator only has to hold the difference from hover.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t duty: Main rotor feedforward duty (%).
+ * ---------------------
+ */
+int32_t getHoverFeedforward(void);
+
+/*
+ * Function:    getCouplingFeedforward
+ * ------------------------------------
+ * Returns the tail duty needed to cancel the torque of the main
+ * rotor at a given main duty, interpolating linearly between the
+ * two nearest entries of the coupling table.
+ *
+ * @params:
+ *      - int32_t mainDuty: The main rotor duty (%).
+ * @return:
+ *      - int32_t duty: Tail rotor feedforward duty (%).
+ * ---------------------
+ */
+int32_t getCouplingFeedforward(int32_t mainDuty);
+
+#endif /* MIXER_H_ */
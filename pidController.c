@@ -23,6 +23,265 @@
 
 controller_t g_alt_controller;
 controller_t g_yaw_controller;
+controller_t g_yaw_rate_controller;
+
+
+/*
+ * Function:    scaleGain
+ * -----------------------
+ * Converts the ratio numerator/denominator into a rounded
+ * fixed-point value with PID_Q_BITS fractional bits. Takes 64 bit
+ * operands as the products of a gain and the time step or ms to s
+ * conversion overflow 32 bits for large gains.
+ *
+ * @params:
+ *      - int64_t numerator: Numerator of the gain ratio.
+ *      - int64_t denominator: Denominator of the gain ratio.
+ * @return:
+ *      - int32_t gain: The ratio in Q format.
+ * ---------------------
+ */
+static int32_t
+scaleGain(int64_t numerator, int64_t denominator)
+{
+    int64_t scaled = numerator * PID_Q_ONE;
+
+    // Round to the nearest representable value rather than truncating
+    if (scaled >= 0) {
+        scaled += denominator / 2;
+    } else {
+        scaled -= denominator / 2;
+    }
+
+    return (int32_t) (scaled / denominator);
+}
+
+
+/*
+ * Function:    updateControllerGains
+ * -----------------------------------
+ * Recalculates the pre-scaled fixed-point gains of a controller
+ * from its Kp, Ki, Kd, timeStep and divisor values. Must be called
+ * whenever any of those values change.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+updateControllerGains(controller_t* controllerPointer)
+{
+    int32_t timeStep = controllerPointer->timeStep;
+    int32_t divisor = controllerPointer->divisor;
+
+    // Fold the divisor, the control period and the ms to s conversion into each gain
+    controllerPointer->KpBaseQ = scaleGain(controllerPointer->Kp, divisor);
+    controllerPointer->KiBaseQ = scaleGain((int64_t) controllerPointer->Ki * timeStep, (int64_t) MS_TO_SECONDS * divisor);
+    controllerPointer->KdBaseQ = scaleGain((int64_t) controllerPointer->Kd * MS_TO_SECONDS, (int64_t) timeStep * divisor);
+    controllerPointer->KdRateBaseQ = scaleGain(controllerPointer->Kd, divisor);
+    controllerPointer->KffQ = scaleGain(controllerPointer->Kff, divisor);
+
+    // Run unscaled until a schedule says otherwise
+    controllerPointer->KpQ = controllerPointer->KpBaseQ;
+    controllerPointer->KiQ = controllerPointer->KiBaseQ;
+    controllerPointer->KdQ = controllerPointer->KdBaseQ;
+    controllerPointer->KdRateQ = controllerPointer->KdRateBaseQ;
+}
+
+
+/*
+ * Function:    scaleControllerGains
+ * ----------------------------------
+ * Sets the gains used by the kernel to the base gains multiplied
+ * by a set of scales. The integral state is held in duty units so
+ * changing the scales does not bump the output.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ *      - const gainScale_t* scale: Multipliers for each gain.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+scaleControllerGains(controller_t* controllerPointer, const gainScale_t* scale)
+{
+    controllerPointer->KpQ = (int32_t) (((int64_t) controllerPointer->KpBaseQ * scale->Kp) >> PID_Q_BITS);
+    controllerPointer->KiQ = (int32_t) (((int64_t) controllerPointer->KiBaseQ * scale->Ki) >> PID_Q_BITS);
+    controllerPointer->KdQ = (int32_t) (((int64_t) controllerPointer->KdBaseQ * scale->Kd) >> PID_Q_BITS);
+    controllerPointer->KdRateQ = (int32_t) (((int64_t) controllerPointer->KdRateBaseQ * scale->Kd) >> PID_Q_BITS);
+}
+
+/*
+ * Function:    getControllerParams
+ * ---------------------------------
+ * Copies the parameters the controller is currently running with.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ *      - controllerParams_t* params: Destination for the parameters.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+getControllerParams(controller_t* controllerPointer, controllerParams_t* params)
+{
+    taskENTER_CRITICAL();                           // Don't copy half of a swap
+    params->Kp = controllerPointer->Kp;
+    params->Ki = controllerPointer->Ki;
+    params->Kd = controllerPointer->Kd;
+    params->timeStep = controllerPointer->timeStep;
+    params->outputMin = controllerPointer->outputMin;
+    params->outputMax = controllerPointer->outputMax;
+    taskEXIT_CRITICAL();
+}
+
+
+/*
+ * Function:    stageControllerParams
+ * -----------------------------------
+ * Copies a new parameter set into the controller's shadow copy.
+ * The control task swaps it in on its next cycle.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ *      - const controllerParams_t* params: The new parameters.
+ * @return:
+ *      - bool staged: False if a gain is outside 0 to PID_MAX_GAIN,
+ *      the limits are out of range, the time step is not a whole
+ *      number of executive cycles or a previous set has not been
+ *      swapped in yet.
+ * ---------------------
+ */
+bool
+stageControllerParams(controller_t* controllerPointer, const controllerParams_t* params)
+{
+    bool staged = false;
+
+    if (params->Kp < 0 || params->Kp > PID_MAX_GAIN || params->Ki < 0 || params->Ki > PID_MAX_GAIN ||
+        params->Kd < 0 || params->Kd > PID_MAX_GAIN ||
+        params->timeStep < PID_MIN_TIME_STEP || params->timeStep > PID_MAX_TIME_STEP ||
+        params->timeStep % EXECUTIVE_PERIOD != 0 ||                 // The control executive only runs a loop on its own cycles
+        params->outputMin < controllerPointer->outputRangeMin || params->outputMax > controllerPointer->outputRangeMax ||
+        params->outputMin >= params->outputMax) {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    if (!controllerPointer->paramsPending) {
+        controllerPointer->shadowParams = *params;
+        controllerPointer->paramsPending = true;    // Set last, inside the critical section, so the copy is complete
+        staged = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return staged;
+}
+
+
+/*
+ * Function:    applyControllerParams
+ * -----------------------------------
+ * Swaps in any staged parameter set and recalculates the gains.
+ * Must be called by the control task at the start of a control
+ * cycle. The integral state is kept in duty units, so a gain
+ * change does not bump the output.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+applyControllerParams(controller_t* controllerPointer)
+{
+    if (controllerPointer->paramsPending) {
+        taskENTER_CRITICAL();
+        controllerPointer->Kp = controllerPointer->shadowParams.Kp;
+        controllerPointer->Ki = controllerPointer->shadowParams.Ki;
+        controllerPointer->Kd = controllerPointer->shadowParams.Kd;
+        controllerPointer->timeStep = controllerPointer->shadowParams.timeStep;
+        controllerPointer->outputMin = controllerPointer->shadowParams.outputMin;
+        controllerPointer->outputMax = controllerPointer->shadowParams.outputMax;
+        updateControllerGains(controllerPointer);
+        controllerPointer->paramsPending = false;
+        taskEXIT_CRITICAL();
+    }
+}
+
+
+/*
+ * Function:    setControllerPreset
+ * ---------------------------------
+ * Sets the anti-windup method, derivative form, derivative filter,
+ * setpoint weighting and output limits of a controller from a
+ * preset. Does not change the gains.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ *      - pidPreset_t preset: The controller form to use.
+ *      - bool isYaw: True if the controller is for yaw.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+setControllerPreset(controller_t* controllerPointer, pidPreset_t preset, bool isYaw)
+{
+    controllerPointer->outputMin = MIN_DUTY;
+    controllerPointer->outputMax = MAX_DUTY;
+    controllerPointer->outputRangeMin = MIN_DUTY;       // Runtime limits may narrow the duty range, not widen it
+    controllerPointer->outputRangeMax = MAX_DUTY;
+    controllerPointer->backCalcQ = PID_BACK_CALC_GAIN;
+
+    if (preset == PID_PRESET_IMPROVED) {
+        controllerPointer->antiWindup = PID_WINDUP_BACK_CALC;
+        controllerPointer->derivativeOnMeasurement = true;  // No derivative kick on setpoint steps
+        controllerPointer->dFilterQ = PID_D_FILTER;
+        controllerPointer->setpointWeightQ = isYaw ? PID_Q_ONE : ALT_SETPOINT_WEIGHT;
+    } else {
+        controllerPointer->antiWindup = PID_WINDUP_LEGACY;
+        controllerPointer->derivativeOnMeasurement = false;
+        controllerPointer->dFilterQ = PID_Q_ONE;
+        controllerPointer->setpointWeightQ = PID_Q_ONE;
+    }
+}
+
+
+/*
+ * Function:    resetController
+ * -----------------------------
+ * Clears the integral, derivative and previous value state of a
+ * controller so it starts cleanly.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+resetController(controller_t* controllerPointer)
+{
+    controllerPointer->previousError = 0;
+    controllerPointer->previousMeasurement = 0;
+    controllerPointer->previousReference = 0;
+    controllerPointer->primed = false;
+    controllerPointer->derivativeState = 0;
+    controllerPointer->integratedError = 0;
+}
+
 
 /*
  * Function:    initController
@@ -34,7 +293,6 @@ controller_t g_yaw_controller;
  *      controller struct.
  *      - bool isYaw: True if the controller is for yaw. False if
  *      controller is for altitude.
- *      - uint32_t timeStep: Control period in ms.
  * @return:
  *      - NULL
  * ---------------------
@@ -43,21 +301,400 @@ void
 initController(controller_t* controllerPointer, bool isYaw)
 {
     if (isYaw){
+#if YAW_CASCADED
+        controllerPointer->Kp = YAW_ANGLE_KP;
+        controllerPointer->Ki = YAW_ANGLE_KI;
+        controllerPointer->Kd = YAW_ANGLE_KD;
+        controllerPointer->Kff = YAW_ANGLE_KFF;
+        setControllerPreset(controllerPointer, YAW_PRESET, true);
+
+        // The output is a rate command rather than a duty cycle
+        controllerPointer->outputMin = -YAW_RATE_LIMIT;
+        controllerPointer->outputMax = YAW_RATE_LIMIT;
+        controllerPointer->outputRangeMin = -YAW_RATE_RANGE;
+        controllerPointer->outputRangeMax = YAW_RATE_RANGE;
+#else
         controllerPointer->Kp = YAW_KP;
         controllerPointer->Ki = YAW_KI;
         controllerPointer->Kd = YAW_KD;
+        controllerPointer->Kff = YAW_KFF;
+        setControllerPreset(controllerPointer, YAW_PRESET, true);
+#endif /* YAW_CASCADED */
     } else {
         controllerPointer->Kp = ALT_KP;
         controllerPointer->Ki = ALT_KI;
         controllerPointer->Kd = ALT_KD;
+        controllerPointer->Kff = ALT_KFF;
+        setControllerPreset(controllerPointer, ALT_PRESET, false);
     }
     controllerPointer->timeStep = CONTROL_PERIOD;
     controllerPointer->divisor = CONTROL_DIVISOR;
+    controllerPointer->feedforward = 0;
+    controllerPointer->paramsPending = false;
 
-    controllerPointer->previousError = 0;
-    controllerPointer->integratedError = 0;
+    resetController(controllerPointer);
+    updateControllerGains(controllerPointer);
+}
+
+/*
+ * Function:    initYawRateController
+ * -----------------------------------
+ * Initializes the inner yaw rate loop used in cascaded mode. Its
+ * reference and measurement are yaw rates in deg/s and its output
+ * is the tail duty cycle.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initYawRateController(controller_t* controllerPointer)
+{
+    controllerPointer->Kp = YAW_RATE_KP;
+    controllerPointer->Ki = YAW_RATE_KI;
+    controllerPointer->Kd = YAW_RATE_KD;
+    controllerPointer->Kff = 0;
+    setControllerPreset(controllerPointer, YAW_PRESET, true); // Treated as yaw so the reference is not weighted
+    controllerPointer->timeStep = YAW_RATE_PERIOD;
+    controllerPointer->divisor = CONTROL_DIVISOR;
+    controllerPointer->feedforward = 0;
+    controllerPointer->paramsPending = false;
+
+    resetController(controllerPointer);
+    updateControllerGains(controllerPointer);
+}
+
+/*
+ * Function:    setControllerFeedforward
+ * --------------------------------------
+ * Sets the duty added to the PID terms before the output limits
+ * are applied, so the integrator only has to hold what the
+ * feedforward does not predict.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ *      - int32_t feedforward: Feedforward duty (%).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+setControllerFeedforward(controller_t* controllerPointer, int32_t feedforward)
+{
+    controllerPointer->feedforward = feedforward;
+}
+
+/*
+ * Function:    wrapDifference
+ * ----------------------------
+ * Wraps a difference in yaw so the helicopter always turns the
+ * short way round, as yaw is logged from 0 to 179 and -180 to 0.
+ * Altitude differences are returned unchanged.
+ *
+ * @params:
+ *      - int32_t difference: The difference to wrap.
+ *      - bool isYaw: True if the difference is in yaw.
+ * @return:
+ *      - int32_t difference: The (wrapped) difference.
+ * ---------------------
+ */
+int32_t
+wrapDifference(int32_t difference, bool isYaw)
+{
+    //Clockwise rotation corresponds to low power in motors
+    if(isYaw)
+    {
+        // If the difference would cause a rotation in the wrong direction
+        if(difference >= (DEGREES_CIRCLE/2))
+        {
+            difference = difference - DEGREES_CIRCLE;
+        } else if(difference < (-(DEGREES_CIRCLE/2)))
+        {
+            difference = DEGREES_CIRCLE + difference;
+        }
+    }
+
+    return difference;
+}
+
+
+#if PID_FIXED_POINT
+/*
+ * Function:    clampQ
+ * --------------------
+ * Limits a Q format duty contribution to +/-PID_INTEGRAL_LIMIT.
+ *
+ * @params:
+ *      - int64_t value: The value to limit.
+ * @return:
+ *      - int32_t value: The limited value.
+ * ---------------------
+ */
+static int32_t
+clampQ(int64_t value)
+{
+    int64_t limit = (int64_t) PID_INTEGRAL_LIMIT * PID_Q_ONE;
+
+    if (value > limit) {
+        value = limit;
+    } else if (value < -limit) {
+        value = -limit;
+    }
+
+    return (int32_t) value;
+}
+
+
+/*
+ * Function:    applyControl
+ * --------------------------
+ * Kernel shared by both control signal functions. Filters the
+ * derivative term, integrates the error with the selected
+ * anti-windup method, sums the PID terms and enforces the duty
+ * cycle limits.
+ *
+ * @params:
+ *      - controller_t* piController: Pointer to the relevant
+ *      controller struct.
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - bool isYaw: True if the controller is for yaw.
+ *      - int64_t derivativeTerm: The unfiltered derivative
+ *      contribution to the duty cycle (Q format).
+ *      - int64_t feedforwardTerm: Duty added to the PID terms
+ *      before the limits are applied (Q format).
+ * @return:
+ *      - int32_t dutyCycle: The limited duty cycle.
+ * ---------------------
+ */
+static int32_t
+applyControl(controller_t* piController, int32_t reference, int32_t measurement, bool isYaw,
+             int64_t derivativeTerm, int64_t feedforwardTerm)
+{
+    int32_t errorSignal = wrapDifference(reference - measurement, isYaw);
+    int32_t dutyCycle;
+    int64_t proportionalTerm;
+    int64_t controlSignal;
+    int64_t upperLimit = (int64_t) piController->outputMax << PID_Q_BITS;
+    int64_t lowerLimit = (int64_t) piController->outputMin << PID_Q_BITS;
+    bool integrate = true;
+
+    // Setpoint weighting only makes sense for altitude, where the reference has a fixed zero
+    if (isYaw || piController->setpointWeightQ == PID_Q_ONE) {
+        proportionalTerm = (int64_t) piController->KpQ * errorSignal;
+    } else {
+        proportionalTerm = ((int64_t) piController->KpQ *
+                            ((int64_t) piController->setpointWeightQ * reference
+                             - ((int64_t) measurement << PID_Q_BITS))) >> PID_Q_BITS;
+    }
+
+    // First order low-pass filter on the derivative contribution
+    piController->derivativeState = clampQ(piController->derivativeState +
+        (((derivativeTerm - piController->derivativeState) * piController->dFilterQ) >> PID_Q_BITS));
+
+    // Conditional integration holds the integrator while the error would push further into saturation
+    if (piController->antiWindup == PID_WINDUP_CONDITIONAL) {
+        controlSignal = feedforwardTerm + proportionalTerm + piController->integratedError +
+                        piController->derivativeState;
+        if ((controlSignal > upperLimit && errorSignal > 0) || (controlSignal < lowerLimit && errorSignal < 0)) {
+            integrate = false;
+        }
+    }
+
+    // Accumulate the integral contribution directly in duty units
+    if (integrate) {
+        piController->integratedError = clampQ((int64_t) piController->integratedError +
+                                               (int64_t) piController->KiQ * errorSignal);
+    }
+
+    //Calculate the control signal using PID methods and duty cycle. The gains are pre-scaled so only
+    //multiplies and shifts are needed here
+    controlSignal = feedforwardTerm + proportionalTerm + piController->integratedError +
+                    piController->derivativeState;
+
+    // Convert from Q format, truncating towards zero as the original double-precision kernel did
+    if (controlSignal >= 0) {
+        dutyCycle = (int32_t) (controlSignal >> PID_Q_BITS);
+    } else {
+        dutyCycle = -(int32_t) ((-controlSignal) >> PID_Q_BITS);
+    }
+
+    piController->previousError = errorSignal;
+    piController->previousMeasurement = measurement;
+    piController->previousReference = reference;
+
+    //Enforce duty cycle output limits
+    if(dutyCycle > piController->outputMax)
+    {
+        dutyCycle = piController->outputMax;
+        if (piController->antiWindup == PID_WINDUP_LEGACY) {
+            piController->integratedError -= (int32_t) ((int64_t) piController->KiQ * errorSignal / MS_TO_SECONDS);
+        }
+    } else if(dutyCycle < piController->outputMin)
+    {
+        dutyCycle = piController->outputMin;
+    } else {
+        return dutyCycle;
+    }
+
+    // Back-calculation bleeds the part of the control signal lost to saturation out of the integrator
+    if (piController->antiWindup == PID_WINDUP_BACK_CALC) {
+        controlSignal = (((int64_t) dutyCycle << PID_Q_BITS) - controlSignal) * piController->backCalcQ;
+        piController->integratedError = clampQ(piController->integratedError + (controlSignal >> PID_Q_BITS));
+    }
+
+    return dutyCycle;
+}
+#else
+/*
+ * Function:    clampDuty
+ * -----------------------
+ * Limits a duty contribution to +/-PID_INTEGRAL_LIMIT.
+ *
+ * @params:
+ *      - double value: The value to limit.
+ * @return:
+ *      - double value: The limited value.
+ * ---------------------
+ */
+static double
+clampDuty(double value)
+{
+    if (value > PID_INTEGRAL_LIMIT) {
+        value = PID_INTEGRAL_LIMIT;
+    } else if (value < -PID_INTEGRAL_LIMIT) {
+        value = -PID_INTEGRAL_LIMIT;
+    }
+
+    return value;
+}
+
+
+/*
+ * Function:    applyControl
+ * --------------------------
+ * Double-precision form of the kernel shared by both control
+ * signal functions. Filters the derivative term, integrates the
+ * error with the selected anti-windup method, sums the PID terms
+ * and enforces the duty cycle limits. The gains and the terms
+ * passed in are the same Q format values the fixed-point kernel
+ * uses, converted to double here.
+ *
+ * @params:
+ *      - controller_t* piController: Pointer to the relevant
+ *      controller struct.
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - bool isYaw: True if the controller is for yaw.
+ *      - int64_t derivativeTerm: The unfiltered derivative
+ *      contribution to the duty cycle (Q format).
+ *      - int64_t feedforwardTerm: Duty added to the PID terms
+ *      before the limits are applied (Q format).
+ * @return:
+ *      - int32_t dutyCycle: The limited duty cycle.
+ * ---------------------
+ */
+static int32_t
+applyControl(controller_t* piController, int32_t reference, int32_t measurement, bool isYaw,
+             int64_t derivativeTerm, int64_t feedforwardTerm)
+{
+    int32_t errorSignal = wrapDifference(reference - measurement, isYaw);
+    int32_t dutyCycle;
+    double gainP = (double) piController->KpQ / PID_Q_ONE;
+    double gainI = (double) piController->KiQ / PID_Q_ONE;
+    double feedforward = (double) feedforwardTerm / PID_Q_ONE;
+    double proportionalTerm;
+    double controlSignal;
+    bool integrate = true;
+
+    // Setpoint weighting only makes sense for altitude, where the reference has a fixed zero
+    if (isYaw || piController->setpointWeightQ == PID_Q_ONE) {
+        proportionalTerm = gainP * errorSignal;
+    } else {
+        proportionalTerm = gainP * ((double) piController->setpointWeightQ / PID_Q_ONE * reference - measurement);
+    }
+
+    // First order low-pass filter on the derivative contribution
+    piController->derivativeState = clampDuty(piController->derivativeState +
+        ((double) derivativeTerm / PID_Q_ONE - piController->derivativeState) * piController->dFilterQ / PID_Q_ONE);
+
+    // Conditional integration holds the integrator while the error would push further into saturation
+    if (piController->antiWindup == PID_WINDUP_CONDITIONAL) {
+        controlSignal = feedforward + proportionalTerm + piController->integratedError + piController->derivativeState;
+        if ((controlSignal > piController->outputMax && errorSignal > 0) ||
+            (controlSignal < piController->outputMin && errorSignal < 0)) {
+            integrate = false;
+        }
+    }
+
+    if (integrate) {
+        piController->integratedError = clampDuty(piController->integratedError + gainI * errorSignal);
+    }
+
+    //Calculate the control signal using PID methods and duty cycle
+    controlSignal = feedforward + proportionalTerm + piController->integratedError + piController->derivativeState;
+    dutyCycle = (int32_t) controlSignal;
+
+    piController->previousError = errorSignal;
+    piController->previousMeasurement = measurement;
+    piController->previousReference = reference;
+
+    //Enforce duty cycle output limits
+    if(dutyCycle > piController->outputMax)
+    {
+        dutyCycle = piController->outputMax;
+        if (piController->antiWindup == PID_WINDUP_LEGACY) {
+            piController->integratedError -= gainI * errorSignal / MS_TO_SECONDS;
+        }
+    } else if(dutyCycle < piController->outputMin)
+    {
+        dutyCycle = piController->outputMin;
+    } else {
+        return dutyCycle;
+    }
+
+    // Back-calculation bleeds the part of the control signal lost to saturation out of the integrator
+    if (piController->antiWindup == PID_WINDUP_BACK_CALC) {
+        piController->integratedError = clampDuty(piController->integratedError +
+            (dutyCycle - controlSignal) * piController->backCalcQ / PID_Q_ONE);
+    }
+
+    return dutyCycle;
+}
+#endif /* PID_FIXED_POINT */
+
+
+/*
+ * Function:    primeController
+ * -----------------------------
+ * Records the current measurement and reference as the previous
+ * values on the first cycle after a reset, so differencing them
+ * does not cause a derivative kick.
+ *
+ * @params:
+ *      - controller_t* piController: Pointer to the relevant
+ *      controller struct.
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t measurement: Actual yaw/altitude
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+primeController(controller_t* piController, int32_t reference, int32_t measurement)
+{
+    if (!piController->primed) {
+        piController->previousMeasurement = measurement;
+        piController->previousReference = reference;
+        piController->primed = true;
+    }
 }
 
+
 /*
  * Function:    getControlSignal
  * ------------------------------
@@ -85,45 +722,67 @@ initController(controller_t* controllerPointer, bool isYaw)
 int32_t
 getControlSignal(controller_t* piController, int32_t reference, int32_t measurement, bool isYaw)
 {
-    int32_t dutyCycle;
-    int32_t controlSignal;
-
-    double errorSignal;
-    double derivativeError;
+    int64_t derivativeTerm;
 
-    // Calculate error signal
-    errorSignal = reference - measurement;
+    primeController(piController, reference, measurement);
 
-    //Clockwise rotation corresponds to low power in motors
-    if(isYaw)
-    {
-        // If the error would cause a rotation in the wrong direction
-        if(errorSignal >= (DEGREES_CIRCLE/2))
-        {
-            errorSignal = errorSignal - DEGREES_CIRCLE;
-        } else if(errorSignal < (-(DEGREES_CIRCLE/2)))
-        {
-            errorSignal = DEGREES_CIRCLE + errorSignal;
-        }
+    if (piController->derivativeOnMeasurement) {
+        derivativeTerm = -(int64_t) piController->KdQ *
+                         wrapDifference(measurement - piController->previousMeasurement, isYaw);
+    } else {
+        derivativeTerm = (int64_t) piController->KdQ *
+                         (wrapDifference(reference - measurement, isYaw) - piController->previousError);
     }
 
-    //Calculate the control signal using PID methods and duty cycle
-    derivativeError = (errorSignal - piController->previousError)/(piController->timeStep);
-    piController->integratedError += piController->timeStep * errorSignal;
-    controlSignal = (piController->Kp * errorSignal)  + (piController->Ki * piController->integratedError)/MS_TO_SECONDS + (piController->Kd) * derivativeError * MS_TO_SECONDS;
-    dutyCycle = (controlSignal/(piController->divisor));
+    return applyControl(piController, reference, measurement, isYaw, derivativeTerm,
+                        (int64_t) piController->feedforward << PID_Q_BITS);
+}
 
-    piController->previousError = errorSignal;
 
-    //Enforce duty cycle output limits
-    if(dutyCycle > MAX_DUTY)
-    {
-        dutyCycle = MAX_DUTY;
-        piController->integratedError -= piController->timeStep * errorSignal/MS_TO_SECONDS;
-    } else if(dutyCycle < MIN_DUTY)
-    {
-        dutyCycle = MIN_DUTY;
+/*
+ * Function:    getControlSignalWithRate
+ * --------------------------------------
+ * As getControlSignal, but the derivative term acts on a measured
+ * rate supplied by an observer instead of differencing the
+ * measurement. With derivative on measurement the reference rate
+ * from the trajectory generator is fed forward through the same
+ * gain. With derivative on error the change in reference is used
+ * instead, as it already carries the reference rate. The reference
+ * rate is also fed forward through Kff so the integrator does not
+ * have to wind up to follow a moving reference.
+ *
+ * @params:
+ *      - controller_t* piController: Pointer to the relevant
+ *      conroller struct.
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t referenceRate: Rate of change of the reference
+ *      in units per second (Q16.16)
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - int32_t measurementRate: Rate of change of the measurement
+ *      in units per second (Q16.16)
+ *      - bool isYaw: True if the controller is for yaw. False if
+ *      controller is for altitude.
+ * @return:
+ *      - int32_t dutyCycle: Appropriate duty cycle for the relevant
+ *      PWM output as calculated by the control system
+ * ---------------------
+ */
+int32_t
+getControlSignalWithRate(controller_t* piController, int32_t reference, int32_t referenceRate,
+                         int32_t measurement, int32_t measurementRate, bool isYaw)
+{
+    int64_t derivativeTerm = -(((int64_t) piController->KdRateQ * measurementRate) >> PID_RATE_Q_BITS);
+    int64_t feedforwardTerm = ((int64_t) piController->feedforward << PID_Q_BITS) +
+                              (((int64_t) piController->KffQ * referenceRate) >> PID_RATE_Q_BITS);
+
+    primeController(piController, reference, measurement);
+
+    if (piController->derivativeOnMeasurement) {
+        derivativeTerm += ((int64_t) piController->KdRateQ * referenceRate) >> PID_RATE_Q_BITS;
+    } else {
+        derivativeTerm += (int64_t) piController->KdQ *
+                          wrapDifference(reference - piController->previousReference, isYaw);
     }
 
-    return dutyCycle;
+    return applyControl(piController, reference, measurement, isYaw, derivativeTerm, feedforwardTerm);
 }
@@ -27,14 +27,23 @@
 #include <stdlib.h>
 #include "uart.h"
 #include "FreeRTOSCreate.h"
+#include "pidGains.h"
 
-#define ALT_KP              45          // Altitude proportional gain
-#define ALT_KI              15          // Altitude integral gain
-#define ALT_KD              10          // Altitude derivative gain
-
-#define YAW_KP              30          // Yaw proportional gain
-#define YAW_KI              7           // Yaw integral gain
-#define YAW_KD              1           // Yaw derivative gain
+// Cascaded yaw control: an outer angle loop commands a yaw rate which a faster inner loop tracks.
+// The outer loop uses g_yaw_controller, its gains are in deg/s of rate command per degree of error
+#ifndef YAW_CASCADED
+#define YAW_CASCADED        0           // 1 for cascaded angle and rate loops, 0 for a single angle loop
+#endif
+#define YAW_ANGLE_KP        200         // Outer angle loop proportional gain
+#define YAW_ANGLE_KI        0           // Outer angle loop integral gain. The rate loop integrator removes the offset
+#define YAW_ANGLE_KD        0           // Outer angle loop derivative gain
+#define YAW_ANGLE_KFF       100         // Outer angle loop reference rate feedforward. 100 passes the trajectory rate straight on
+#define YAW_RATE_KP         50          // Inner rate loop proportional gain
+#define YAW_RATE_KI         100         // Inner rate loop integral gain
+#define YAW_RATE_KD         0           // Inner rate loop derivative gain
+#define YAW_RATE_LIMIT      200         // Largest rate the angle loop may command (deg/s)
+#define YAW_RATE_RANGE      720         // Largest rate limit that may be set at runtime (deg/s)
+#define YAW_RATE_PERIOD     5           // Inner rate loop period (ms)
 
 #define CONTROL_DIVISOR     100         // Divisor used to achieve certain gains without the use of floating point numbers
 
@@ -43,6 +52,79 @@
 #define MAX_DUTY            98          // The maximum duty cycle for the rotors
 #define MIN_DUTY            2           // The minimum duty cycle for the rotors
 
+// Control kernel selection. The fixed-point kernel avoids the software emulated double
+// arithmetic of the double-precision kernel (the M4F FPU is single precision only). With the
+// legacy preset its duty output matches the original double-precision kernel to within +/-1 % duty.
+#ifndef PID_FIXED_POINT
+#define PID_FIXED_POINT     1           // 1 selects the fixed-point kernel, 0 the double-precision kernel
+#endif
+#define PID_Q_BITS          16          // Fractional bits used by the kernel (16 gives Q16.16)
+#define PID_Q_ONE           (1 << PID_Q_BITS)
+#define PID_RATE_Q_BITS     16          // Fractional bits of the reference and measured rates given to getControlSignalWithRate
+#define PID_INTEGRAL_LIMIT  (10 * MAX_DUTY) // Bound on the integral and derivative contributions (in duty) so the Q values cannot overflow
+
+#define PID_BACK_CALC_GAIN  (PID_Q_ONE / 2)         // Fraction of the saturation excess removed from the integrator each cycle
+#define PID_D_FILTER        (PID_Q_ONE / 2)         // Derivative filter smoothing factor. PID_Q_ONE disables the filter
+#define ALT_SETPOINT_WEIGHT ((PID_Q_ONE * 7) / 10)  // Fraction of an altitude setpoint step applied to the proportional term
+
+#define PID_MIN_TIME_STEP   1                       // Shortest control period accepted at runtime (ms)
+#define PID_MAX_TIME_STEP   1000                    // Longest control period accepted at runtime (ms)
+#define PID_MAX_GAIN        1000                    // Largest Kp, Ki or Kd accepted at runtime. Keeps the Q format Kd within 32 bits at PID_MIN_TIME_STEP
+
+#define ALT_PRESET          PID_PRESET_IMPROVED     // Controller form used for altitude
+#define YAW_PRESET          PID_PRESET_IMPROVED     // Controller form used for yaw
+
+
+/* ******************************************************
+ * Integrator anti-windup methods
+ * *****************************************************/
+typedef enum AntiWindup {
+    PID_WINDUP_LEGACY = 0,        // Integrator is clamped and backed off slightly above the upper output limit only
+    PID_WINDUP_BACK_CALC,         // Saturation excess is fed back into the integrator
+    PID_WINDUP_CONDITIONAL        // Integration stops while saturated and the error drives further into saturation
+} pidAntiWindup_t;
+
+/* ******************************************************
+ * Controller presets
+ * *****************************************************/
+typedef enum ControllerPresets {
+    PID_PRESET_LEGACY = 0,        // The original form: legacy anti-windup, derivative on error, no filtering
+    PID_PRESET_IMPROVED           // Back-calculation, filtered derivative on measurement, setpoint weighting
+} pidPreset_t;
+
+
+/* ******************************************************
+ * Kernel state, a contribution to the duty cycle. Q format
+ * in the fixed-point kernel, plain duty otherwise.
+ * *****************************************************/
+#if PID_FIXED_POINT
+typedef int32_t pidState_t;
+#else
+typedef double pidState_t;
+#endif /* PID_FIXED_POINT */
+
+/* ******************************************************
+ * Multipliers applied to a controller's gains, used for
+ * gain scheduling. Each is Q format, PID_Q_ONE is 1.
+ * *****************************************************/
+typedef struct GainScales {
+    int32_t     Kp;
+    int32_t     Ki;
+    int32_t     Kd;
+} gainScale_t;
+
+/* ******************************************************
+ * Runtime adjustable controller parameters. Staged in a
+ * shadow copy and swapped in at a control cycle boundary.
+ * *****************************************************/
+typedef struct ControllerParams {
+    int32_t     Kp;               // Proportional gain
+    int32_t     Ki;               // Integral gain
+    int32_t     Kd;               // Derivative gain
+    uint32_t    timeStep;         // Control period (in ms)
+    int32_t     outputMin;        // Lower output limit. A duty cycle, or a rate for the cascaded yaw angle loop
+    int32_t     outputMax;        // Upper output limit
+} controllerParams_t;
 
 /* ******************************************************
  * Define a structure which will contain all the
@@ -53,15 +135,46 @@ typedef struct Controllers {
     int32_t     Kp;               // Proportional gain
     int32_t     Ki;               // Integral gain
     int32_t     Kd;               // Derivative gain
+    int32_t     Kff;              // Reference rate feedforward gain
     uint32_t    timeStep;         // The time step used to calculate derivative and integral control (in ms)
     int32_t     divisor;          // Divisor used to correct gains without the use of floating point numbers
 
+    int32_t     KpBaseQ;          // Proportional gain in duty per unit error (Q format). Set by updateControllerGains
+    int32_t     KiBaseQ;          // Integral gain in duty per unit error per control cycle (Q format)
+    int32_t     KdBaseQ;          // Derivative gain in duty per unit change in error per control cycle (Q format)
+    int32_t     KdRateBaseQ;      // Derivative gain in duty per unit/s of measured rate (Q format)
+    int32_t     KffQ;             // Feedforward gain in duty per unit/s of reference rate (Q format). Not scheduled
+
+    int32_t     KpQ;              // Gains used by the kernel. The base gains, scaled by scaleControllerGains
+    int32_t     KiQ;
+    int32_t     KdQ;
+    int32_t     KdRateQ;
+
+    pidAntiWindup_t antiWindup;   // Integrator anti-windup method
+    int32_t     backCalcQ;        // Back-calculation gain (Q format)
+    bool        derivativeOnMeasurement; // True to differentiate the measurement instead of the error
+    int32_t     dFilterQ;         // Derivative filter smoothing factor (Q format). PID_Q_ONE disables the filter
+    int32_t     setpointWeightQ;  // Fraction of the reference used in the proportional term (Q format). Ignored for yaw
+    int32_t     outputMin;        // Lower output limit. A duty cycle, or a rate for the cascaded yaw angle loop
+    int32_t     outputMax;        // Upper output limit
+    int32_t     outputRangeMin;   // Lowest lower limit that may be set at runtime
+    int32_t     outputRangeMax;   // Highest upper limit that may be set at runtime
+    int32_t     feedforward;      // Duty added to the PID terms before the output limits are applied
+
     int32_t     previousError;    // The error signal from the last control cycle. Used in derivative control
-    int32_t     integratedError;  // The total integrated error from previous control cycles. Used in integral control
+    int32_t     previousMeasurement; // The measurement from the last control cycle
+    int32_t     previousReference;   // The reference from the last control cycle
+    bool        primed;           // False until the previous measurement and reference are valid
+    pidState_t  derivativeState;  // Filtered derivative contribution to the duty cycle
+    pidState_t  integratedError;  // Integral contribution to the duty cycle
+
+    controllerParams_t shadowParams; // Staged parameters waiting to be swapped in
+    volatile bool paramsPending;  // True while shadowParams holds a set the control task has not swapped in
 } controller_t;
 
 extern controller_t g_alt_controller;
 extern controller_t g_yaw_controller;
+extern controller_t g_yaw_rate_controller;
 
 /*
  * Function:    initController
@@ -80,6 +193,170 @@ extern controller_t g_yaw_controller;
  */
 void initController(controller_t* controllerPointer, bool isYAw);
 
+/*
+ * Function:    initYawRateController
+ * -----------------------------------
+ * Initializes the inner yaw rate loop used in cascaded mode. Its
+ * reference and measurement are yaw rates in deg/s and its output
+ * is the tail duty cycle.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initYawRateController(controller_t* controllerPointer);
+
+/*
+ * Function:    setControllerPreset
+ * ---------------------------------
+ * Sets the anti-windup method, derivative form, derivative filter,
+ * setpoint weighting and output limits of a controller from a
+ * preset. Does not change the gains.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ *      - pidPreset_t preset: The controller form to use.
+ *      - bool isYaw: True if the controller is for yaw.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void setControllerPreset(controller_t* controllerPointer, pidPreset_t preset, bool isYaw);
+
+/*
+ * Function:    resetController
+ * -----------------------------
+ * Clears the integral, derivative and previous value state of a
+ * controller so it starts cleanly.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void resetController(controller_t* controllerPointer);
+
+/*
+ * Function:    getControllerParams
+ * ---------------------------------
+ * Copies the parameters the controller is currently running with.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ *      - controllerParams_t* params: Destination for the parameters.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void getControllerParams(controller_t* controllerPointer, controllerParams_t* params);
+
+/*
+ * Function:    stageControllerParams
+ * -----------------------------------
+ * Copies a new parameter set into the controller's shadow copy.
+ * The control task swaps it in on its next cycle.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ *      - const controllerParams_t* params: The new parameters.
+ * @return:
+ *      - bool staged: False if a gain is outside 0 to PID_MAX_GAIN,
+ *      the limits are out of range, the time step is not a whole
+ *      number of executive cycles or a previous set has not been
+ *      swapped in yet.
+ * ---------------------
+ */
+bool stageControllerParams(controller_t* controllerPointer, const controllerParams_t* params);
+
+/*
+ * Function:    applyControllerParams
+ * -----------------------------------
+ * Swaps in any staged parameter set. Must be called by the control
+ * task at the start of a control cycle.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void applyControllerParams(controller_t* controllerPointer);
+
+/*
+ * Function:    updateControllerGains
+ * -----------------------------------
+ * Recalculates the pre-scaled fixed-point gains of a controller
+ * from its Kp, Ki, Kd, timeStep and divisor values. Must be called
+ * whenever any of those values change.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void updateControllerGains(controller_t* controllerPointer);
+
+/*
+ * Function:    scaleControllerGains
+ * ----------------------------------
+ * Sets the gains used by the kernel to the base gains multiplied
+ * by a set of scales. The integral state is held in duty units so
+ * changing the scales does not bump the output.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ *      - const gainScale_t* scale: Multipliers for each gain.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void scaleControllerGains(controller_t* controllerPointer, const gainScale_t* scale);
+
+/*
+ * Function:    setControllerFeedforward
+ * --------------------------------------
+ * Sets the duty added to the PID terms before the output limits
+ * are applied, so the integrator only has to hold what the
+ * feedforward does not predict.
+ *
+ * @params:
+ *      - controller_t* controllerPointer: Pointer to the relevant
+ *      controller struct.
+ *      - int32_t feedforward: Feedforward duty (%).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void setControllerFeedforward(controller_t* controllerPointer, int32_t feedforward);
+
+/*
+ * Function:    wrapDifference
+ * ----------------------------
+ * Wraps a difference in yaw so the helicopter always turns the
+ * short way round, as yaw is logged from 0 to 179 and -180 to 0.
+ * Altitude differences are returned unchanged.
+ *
+ * @params:
+ *      - int32_t difference: The difference to wrap.
+ *      - bool isYaw: True if the difference is in yaw.
+ * @return:
+ *      - int32_t difference: The (wrapped) difference.
+ * ---------------------
+ */
+int32_t wrapDifference(int32_t difference, bool isYaw);
+
 /*
  * Function:    getControlSignal
  * ------------------------------
@@ -106,4 +383,35 @@ void initController(controller_t* controllerPointer, bool isYAw);
  */
 int32_t getControlSignal(controller_t *piController, int32_t reference, int32_t measurement, bool isYaw);
 
+/*
+ * Function:    getControlSignalWithRate
+ * --------------------------------------
+ * As getControlSignal, but the derivative term acts on a measured
+ * rate supplied by an observer instead of differencing the
+ * measurement. With derivative on measurement the reference rate
+ * from the trajectory generator is fed forward through the same
+ * gain. With derivative on error the change in reference is used
+ * instead, as it already carries the reference rate. The reference
+ * rate is also fed forward through Kff so the integrator does not
+ * have to wind up to follow a moving reference.
+ *
+ * @params:
+ *      - controller_t* piController: Pointer to the relevant
+ *      conroller struct.
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t referenceRate: Rate of change of the reference
+ *      in units per second (Q16.16)
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - int32_t measurementRate: Rate of change of the measurement
+ *      in units per second (Q16.16)
+ *      - bool isYaw: True if the controller is for yaw. False if
+ *      controller is for altitude.
+ * @return:
+ *      - int32_t dutyCycle: Appropriate duty cycle for the relevant
+ *      PWM output as calculated by the control system.
+ * ---------------------
+ */
+int32_t getControlSignalWithRate(controller_t *piController, int32_t reference, int32_t referenceRate,
+                                 int32_t measurement, int32_t measurementRate, bool isYaw);
+
 #endif /* PIDCONTROLLER_H_ */
@@ -0,0 +1,29 @@
+/* ****************************************************************
+ * pidGains.h
+ *
+ * Gains of the altitude and yaw controllers. Kept apart from
+ * pidController.h so the gain search in sim/ can write a tuned
+ * set straight over this file.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef PIDGAINS_H_
+#define PIDGAINS_H_
+
+#define ALT_KP              45          // Altitude proportional gain
+#define ALT_KI              15          // Altitude integral gain
+#define ALT_KD              10          // Altitude derivative gain
+#define ALT_KFF             10          // Altitude reference rate feedforward gain. Larger gains lift the helicopter before the integrator holds it
+
+#define YAW_KP              30          // Yaw proportional gain
+#define YAW_KI              7           // Yaw integral gain
+#define YAW_KD              1           // Yaw derivative gain
+#define YAW_KFF             18          // Yaw reference rate feedforward gain. Below the tail duty per deg/s of spin, as more overshoots the end of a turn
+
+#endif /* PIDGAINS_H_ */
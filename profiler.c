@@ -0,0 +1,411 @@
+/* ****************************************************************
+ * profiler.c
+ *
+ * Source file of the profiler module.
+ * Times interrupt handlers and task jobs with the Cortex-M4 DWT
+ * cycle counter. For each profiled handler or task it keeps the
+ * longest execution time and log2 histograms of the execution
+ * time, start jitter and response time. A task's execution time
+ * leaves out the time other tasks and interrupts ran, which also
+ * gives each task's share of the CPU for the load monitor. The
+ * histograms are read over UART with the "prof" command while the
+ * scheduler keeps running.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <string.h>
+#include "profiler.h"
+#include "pidController.h"
+
+/* ******************************************************
+ * Timing of one profiled handler or task.
+ * *****************************************************/
+typedef struct ProfileSlots {
+    const char* name;
+    uint32_t    period;                     // Expected cycles between job starts, 0 if not periodic
+    uint32_t    release;                    // Cycle count when the current job was released
+    bool        released;                   // True if profileRelease marked the current job
+    uint32_t    start;                      // Cycle count at the start of the current, or last, job
+    uint32_t    runAtStart;                 // Run cycles at the start of the current job
+    uint32_t    runCycles;                  // Cycles the task has run, less interrupts, up to when it last switched out
+    uint32_t    switchedIn;                 // Cycle count when the task last switched in
+    uint32_t    interruptsAtSwitch;         // Interrupt cycles when the task last switched in
+    profileSummary_t summary;
+    uint16_t    histograms[PROFILE_HISTOGRAMS][PROFILE_BUCKETS];
+} profileSlot_t;
+
+// Names and periods, in profileSlots order
+static profileSlot_t g_slots[PROFILE_SLOTS] = {
+    { "adc",     ADC_DMA_BLOCK_SIZE * 1000 / ADC_SAMPLE_RATE_HZ * PROFILE_CYCLES_PER_MS },
+    { "quad",    0 },
+    { "ref",     0 },
+    { "ctltmr",  EXECUTIVE_PERIOD * PROFILE_CYCLES_PER_MS },
+    { "uartrx",  0 },
+    { "control", EXECUTIVE_PERIOD * PROFILE_CYCLES_PER_MS },
+    { "fsm",     0 },
+    { "btn",     INPUT_PERIOD * PROFILE_CYCLES_PER_MS },
+    { "sw",      INPUT_PERIOD * PROFILE_CYCLES_PER_MS },
+    { "oled",    DISPLAY_PERIOD * PROFILE_CYCLES_PER_MS },
+    { "uart",    UART_PERIOD * PROFILE_CYCLES_PER_MS },
+    { "idle",    0 }
+};
+
+static volatile uint32_t g_interruptCycles = 0;     // Cycles spent in profiled interrupt handlers since start-up
+static profileSlot_t* g_running = NULL;             // Slot of the running task, NULL if it is not tagged
+
+
+/*
+ * Function:    initProfiler
+ * --------------------------
+ * Starts the DWT cycle counter.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initProfiler(void)
+{
+    uint8_t i;
+
+    DEMCR_R |= DEMCR_TRCENA;
+    DWT_CTRL_R |= DWT_CTRL_CYCCNTENA;
+
+    for (i = 0; i < PROFILE_SLOTS; i++) {
+        g_slots[i].summary.name = g_slots[i].name;
+    }
+}
+
+
+#if PROFILER_ENABLE
+/*
+ * Function:    addToHistogram
+ * ----------------------------
+ * Counts a time in the log2 bucket it falls in.
+ *
+ * @params:
+ *      - uint16_t* histogram: The histogram.
+ *      - uint32_t cycles: The time (cycles).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+addToHistogram(uint16_t* histogram, uint32_t cycles)
+{
+    uint8_t bucket = 0;
+
+    cycles >>= PROFILE_MIN_BITS - 1;        // Times under 2^PROFILE_MIN_BITS cycles are now 0 or 1
+    while (cycles > 1 && bucket < PROFILE_BUCKETS - 1) {
+        cycles >>= 1;
+        bucket++;
+    }
+    if (histogram[bucket] < PROFILE_COUNT_MAX) {
+        histogram[bucket]++;
+    }
+}
+#endif /* PROFILER_ENABLE */
+
+
+/*
+ * Function:    getRunCycles
+ * --------------------------
+ * Returns the cycles a running task has run since start-up, less
+ * the time interrupts took. Must be called inside the critical
+ * section.
+ *
+ * @params:
+ *      - const profileSlot_t* slot: The running task's slot.
+ *      - uint32_t now: The cycle count.
+ * @return:
+ *      - uint32_t cycles: Cycles run.
+ * ---------------------
+ */
+static uint32_t
+getRunCycles(const profileSlot_t* slot, uint32_t now)
+{
+    return slot->runCycles + (now - slot->switchedIn) - (g_interruptCycles - slot->interruptsAtSwitch);
+}
+
+
+#if PROFILER_ENABLE
+/*
+ * Function:    profileTask
+ * -------------------------
+ * Tags the calling task with its profile slot so the time it
+ * spends switched out is left out of its execution times. Called
+ * once at the start of a profiled task.
+ *
+ * @params:
+ *      - uint8_t slot: The task's profile slot.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+profileTask(uint8_t slot)
+{
+    profileSlot_t* profile = &g_slots[slot];
+
+    taskENTER_CRITICAL();
+    profile->switchedIn = DWT_CYCCNT_R;     // The task is running now, so it missed its switch in
+    profile->interruptsAtSwitch = g_interruptCycles;
+    g_running = profile;
+    vTaskSetApplicationTaskTag(NULL, (TaskHookFunction_t) profile);
+    taskEXIT_CRITICAL();
+}
+
+
+/*
+ * Function:    profileRelease
+ * ----------------------------
+ * Marks the release of a task's next job, so its response time is
+ * measured from the release. Called by the interrupt releasing it.
+ *
+ * @params:
+ *      - uint8_t slot: The task's profile slot.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+profileRelease(uint8_t slot)
+{
+    g_slots[slot].release = DWT_CYCCNT_R;
+    g_slots[slot].released = true;
+}
+
+
+/*
+ * Function:    profileStart
+ * --------------------------
+ * Marks the start of a job, at the top of an interrupt handler or
+ * of one pass of a task's loop.
+ *
+ * @params:
+ *      - uint8_t slot: The profile slot.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+profileStart(uint8_t slot)
+{
+    profileSlot_t* profile = &g_slots[slot];
+    UBaseType_t mask;
+    uint32_t now;
+    uint32_t interval;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();                           // Usable from tasks and interrupts
+    now = DWT_CYCCNT_R;
+    if (profile->period != 0 && profile->summary.jobs != 0) {
+        interval = now - profile->start;
+        addToHistogram(profile->histograms[PROFILE_JITTER],
+                       (interval > profile->period) ? interval - profile->period : profile->period - interval);
+    }
+    profile->start = now;
+    if (slot >= PROFILE_FIRST_TASK) {
+        profile->runAtStart = getRunCycles(profile, now);
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+
+/*
+ * Function:    profileEnd
+ * ------------------------
+ * Marks the end of a job started by profileStart and adds it to
+ * the histograms.
+ *
+ * @params:
+ *      - uint8_t slot: The profile slot.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+profileEnd(uint8_t slot)
+{
+    profileSlot_t* profile = &g_slots[slot];
+    UBaseType_t mask;
+    uint32_t now;
+    uint32_t execution;
+    uint32_t response;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    now = DWT_CYCCNT_R;
+    if (slot >= PROFILE_FIRST_TASK) {
+        execution = getRunCycles(profile, now) - profile->runAtStart;
+    } else {
+        execution = now - profile->start;
+        g_interruptCycles += execution;                             // Left out of the execution time of the task it interrupted
+    }
+    response = now - (profile->released ? profile->release : profile->start);
+    profile->released = false;
+
+    addToHistogram(profile->histograms[PROFILE_EXECUTION], execution);
+    addToHistogram(profile->histograms[PROFILE_RESPONSE], response);
+    profile->summary.jobs++;
+    if (execution > profile->summary.executionMax) {
+        profile->summary.executionMax = execution;
+    }
+    if (response > profile->summary.responseMax) {
+        profile->summary.responseMax = response;
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+
+/*
+ * Function:    profileTaskSwitchedIn
+ * -----------------------------------
+ * FreeRTOS trace hook run when a task is switched in.
+ *
+ * @params:
+ *      - void* tag: The task's application tag, set by profileTask.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+profileTaskSwitchedIn(void* tag)
+{
+    profileSlot_t* profile = (profileSlot_t*) tag;
+
+    g_running = profile;
+    if (profile != NULL) {
+        profile->switchedIn = DWT_CYCCNT_R;
+        profile->interruptsAtSwitch = g_interruptCycles;
+    }
+}
+
+
+/*
+ * Function:    profileTaskSwitchedOut
+ * ------------------------------------
+ * FreeRTOS trace hook run when a task is switched out.
+ *
+ * @params:
+ *      - void* tag: The task's application tag, set by profileTask.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+profileTaskSwitchedOut(void* tag)
+{
+    profileSlot_t* profile = (profileSlot_t*) tag;
+
+    g_running = NULL;
+    if (profile != NULL) {
+        profile->runCycles = getRunCycles(profile, DWT_CYCCNT_R);
+    }
+}
+#endif /* PROFILER_ENABLE */
+
+
+/*
+ * Function:    getProfileLoad
+ * ----------------------------
+ * Copies the run times of the profiled tasks and the time spent
+ * in profiled interrupt handlers. Usable from interrupts.
+ *
+ * @params:
+ *      - profileLoad_t* load: Filled with the times.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+getProfileLoad(profileLoad_t* load)
+{
+    profileSlot_t* profile;
+    UBaseType_t mask;
+    uint8_t i;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    load->now = DWT_CYCCNT_R;
+    load->interrupts = g_interruptCycles;
+    for (i = 0; i < PROFILE_TASKS; i++) {
+        profile = &g_slots[PROFILE_FIRST_TASK + i];
+        load->tasks[i] = (profile == g_running) ? getRunCycles(profile, load->now) : profile->runCycles;
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+
+/*
+ * Function:    getProfileSlot
+ * ----------------------------
+ * Looks up a profile slot by name.
+ *
+ * @params:
+ *      - const char* name: The slot name.
+ * @return:
+ *      - int8_t slot: The slot, or -1 if there is none by that name.
+ * ---------------------
+ */
+int8_t
+getProfileSlot(const char* name)
+{
+    int8_t i;
+
+    for (i = 0; i < PROFILE_SLOTS; i++) {
+        if (strcmp(name, g_slots[i].name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+/*
+ * Function:    getProfileSummary
+ * -------------------------------
+ * Copies the summary of a slot.
+ *
+ * @params:
+ *      - uint8_t slot: The profile slot.
+ *      - profileSummary_t* summary: Filled with the summary.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+getProfileSummary(uint8_t slot, profileSummary_t* summary)
+{
+    taskENTER_CRITICAL();
+    *summary = g_slots[slot].summary;
+    taskEXIT_CRITICAL();
+}
+
+
+/*
+ * Function:    getProfileHistogram
+ * ---------------------------------
+ * Copies one histogram of a slot. The copy is taken in a critical
+ * section, so it is consistent while the scheduler keeps running.
+ *
+ * @params:
+ *      - uint8_t slot: The profile slot.
+ *      - uint8_t histogram: Which histogram, from profileHistograms.
+ *      - uint16_t* counts: Filled with PROFILE_BUCKETS counts.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+getProfileHistogram(uint8_t slot, uint8_t histogram, uint16_t* counts)
+{
+    taskENTER_CRITICAL();
+    memcpy(counts, g_slots[slot].histograms[histogram], sizeof(g_slots[slot].histograms[histogram]));
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,257 @@
+/* ****************************************************************
+ * profiler.h
+ *
+ * Header file of the profiler module.
+ * Times interrupt handlers and task jobs with the Cortex-M4 DWT
+ * cycle counter. For each profiled handler or task it keeps the
+ * longest execution time and log2 histograms of the execution
+ * time, start jitter and response time. A task's execution time
+ * leaves out the time other tasks and interrupts ran, which also
+ * gives each task's share of the CPU for the load monitor. The
+ * histograms are read over UART with the "prof" command while the
+ * scheduler keeps running. With PROFILER_ENABLE (FreeRTOSConfig.h)
+ * set to 0 the timing hooks compile to nothing, and the histograms
+ * and loads read zero.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/tm4c123gh6pm.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Cortex-M4 debug registers used for the cycle counter. Not in the TivaWare register header
+#ifndef DWT_CYCCNT_R
+#define DEMCR_R                 (*((volatile uint32_t *) 0xE000EDFC))  // Debug exception and monitor control
+#define DWT_CTRL_R              (*((volatile uint32_t *) 0xE0001000))  // Data watchpoint and trace control
+#define DWT_CYCCNT_R            (*((volatile uint32_t *) 0xE0001004))  // Cycle count
+#endif
+#define DEMCR_TRCENA            0x01000000          // Enables the DWT
+#define DWT_CTRL_CYCCNTENA      0x00000001          // Starts the cycle counter
+
+#define PROFILE_BUCKETS         20                  // Histogram buckets. Bucket n counts times of 2^(n + PROFILE_MIN_BITS - 1) cycles and up
+#define PROFILE_MIN_BITS        6                   // Bucket 0 counts times under 2^PROFILE_MIN_BITS cycles (0.8 us)
+#define PROFILE_COUNT_MAX       0xFFFF              // Histogram counts stop here
+#define PROFILE_CYCLES_PER_MS   (configCPU_CLOCK_HZ / 1000)
+
+// Profiled handlers and tasks. Interrupt handlers come first
+enum profileSlots {
+    PROFILE_ADC_ISR = 0,                    // ADCIntHandler
+    PROFILE_QUADRATURE_ISR,                 // quadratureFSMInterrupt, or qeiInterrupt with the QEI backend
+    PROFILE_REFERENCE_ISR,                  // referenceInterrupt
+    PROFILE_CONTROL_ISR,                    // controlTimerInterrupt
+    PROFILE_UART_ISR,                       // UARTRxIntHandler
+    PROFILE_CONTROL_TASK,                   // ControlExecutive
+    PROFILE_FSM_TASK,                       // FSM
+    PROFILE_BUTTONS_TASK,                   // ButtonsCheck
+    PROFILE_SWITCHES_TASK,                  // SwitchesCheck
+    PROFILE_OLED_TASK,                      // OLEDDisplay
+    PROFILE_UART_TASK,                      // UARTDisplay
+    PROFILE_IDLE_TASK,                      // The idle task, tagged by the idle hook. Only its run time is kept
+    PROFILE_SLOTS
+};
+#define PROFILE_FIRST_TASK      PROFILE_CONTROL_TASK
+#define PROFILE_TASKS           (PROFILE_SLOTS - PROFILE_FIRST_TASK)
+
+// Histograms kept for each slot
+enum profileHistograms {
+    PROFILE_EXECUTION = 0,                  // Cycles spent running the job
+    PROFILE_JITTER,                         // How far the time between job starts strays from the period
+    PROFILE_RESPONSE,                       // Cycles from the release (or the start) to the end of the job
+    PROFILE_HISTOGRAMS
+};
+
+/* ******************************************************
+ * Summary of one profiled handler or task.
+ * *****************************************************/
+typedef struct ProfileSummaries {
+    const char* name;
+    uint32_t    jobs;                       // Jobs finished
+    uint32_t    executionMax;               // Longest execution time (cycles)
+    uint32_t    responseMax;                // Longest response time (cycles)
+} profileSummary_t;
+
+/* ******************************************************
+ * Run times since start-up, less interrupts, of the
+ * profiled tasks and the time spent in the profiled
+ * interrupt handlers, all taken at one cycle count.
+ * *****************************************************/
+typedef struct ProfileLoads {
+    uint32_t    now;                        // Cycle count the times were taken at
+    uint32_t    interrupts;                 // Cycles spent in profiled interrupt handlers
+    uint32_t    tasks[PROFILE_TASKS];       // Cycles each task has run, from PROFILE_FIRST_TASK on
+} profileLoad_t;
+
+
+/*
+ * Function:    initProfiler
+ * --------------------------
+ * Starts the DWT cycle counter.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initProfiler(void);
+
+#if PROFILER_ENABLE
+/*
+ * Function:    profileTask
+ * -------------------------
+ * Tags the calling task with its profile slot so the time it
+ * spends switched out is left out of its execution times. Called
+ * once at the start of a profiled task.
+ *
+ * @params:
+ *      - uint8_t slot: The task's profile slot.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void profileTask(uint8_t slot);
+
+/*
+ * Function:    profileRelease
+ * ----------------------------
+ * Marks the release of a task's next job, so its response time is
+ * measured from the release. Called by the interrupt releasing it.
+ *
+ * @params:
+ *      - uint8_t slot: The task's profile slot.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void profileRelease(uint8_t slot);
+
+/*
+ * Function:    profileStart
+ * --------------------------
+ * Marks the start of a job, at the top of an interrupt handler or
+ * of one pass of a task's loop.
+ *
+ * @params:
+ *      - uint8_t slot: The profile slot.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void profileStart(uint8_t slot);
+
+/*
+ * Function:    profileEnd
+ * ------------------------
+ * Marks the end of a job started by profileStart and adds it to
+ * the histograms.
+ *
+ * @params:
+ *      - uint8_t slot: The profile slot.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void profileEnd(uint8_t slot);
+
+/*
+ * Function:    profileTaskSwitchedIn
+ * -----------------------------------
+ * FreeRTOS trace hook run when a task is switched in.
+ *
+ * @params:
+ *      - void* tag: The task's application tag, set by profileTask.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void profileTaskSwitchedIn(void* tag);
+
+/*
+ * Function:    profileTaskSwitchedOut
+ * ------------------------------------
+ * FreeRTOS trace hook run when a task is switched out.
+ *
+ * @params:
+ *      - void* tag: The task's application tag, set by profileTask.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void profileTaskSwitchedOut(void* tag);
+#else
+// The timing hooks compile to nothing
+#define profileTask(slot)       ((void) 0)
+#define profileRelease(slot)    ((void) 0)
+#define profileStart(slot)      ((void) 0)
+#define profileEnd(slot)        ((void) 0)
+#endif /* PROFILER_ENABLE */
+
+/*
+ * Function:    getProfileLoad
+ * ----------------------------
+ * Copies the run times of the profiled tasks and the time spent
+ * in profiled interrupt handlers. Usable from interrupts.
+ *
+ * @params:
+ *      - profileLoad_t* load: Filled with the times.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void getProfileLoad(profileLoad_t* load);
+
+/*
+ * Function:    getProfileSlot
+ * ----------------------------
+ * Looks up a profile slot by name.
+ *
+ * @params:
+ *      - const char* name: The slot name.
+ * @return:
+ *      - int8_t slot: The slot, or -1 if there is none by that name.
+ * ---------------------
+ */
+int8_t getProfileSlot(const char* name);
+
+/*
+ * Function:    getProfileSummary
+ * -------------------------------
+ * Copies the summary of a slot.
+ *
+ * @params:
+ *      - uint8_t slot: The profile slot.
+ *      - profileSummary_t* summary: Filled with the summary.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void getProfileSummary(uint8_t slot, profileSummary_t* summary);
+
+/*
+ * Function:    getProfileHistogram
+ * ---------------------------------
+ * Copies one histogram of a slot. The copy is taken in a critical
+ * section, so it is consistent while the scheduler keeps running.
+ *
+ * @params:
+ *      - uint8_t slot: The profile slot.
+ *      - uint8_t histogram: Which histogram, from profileHistograms.
+ *      - uint16_t* counts: Filled with PROFILE_BUCKETS counts.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void getProfileHistogram(uint8_t slot, uint8_t histogram, uint16_t* counts);
+
+#endif /* PROFILER_H_ */
@@ -24,6 +24,12 @@
  * ***************************************************************/
 
 #include "pwm.h"
+#include "gainSchedule.h"
+#include "autotune.h"
+#include "mixer.h"
+#include "trajectory.h"
+#include "flightRecorder.h"
+#include "flightState.h"
 
 
 /*
@@ -99,6 +105,11 @@ initControllers(void)
 {
     initController(&g_alt_controller, false);
     initController(&g_yaw_controller, true);
+    initYawRateController(&g_yaw_rate_controller);
+    initTrajectory(&g_alt_trajectory, ALT_TRAJ_MAX_RATE, ALT_TRAJ_MAX_ACCEL, false);
+    initTrajectory(&g_yaw_trajectory, YAW_TRAJ_MAX_RATE, YAW_TRAJ_MAX_ACCEL, true);
+
+    setControllerFeedforward(&g_alt_controller, getHoverFeedforward()); // The altitude integrator only holds the difference from hover
 }
 
 /*
@@ -120,6 +131,8 @@ setRotorPWM (uint32_t ui32Duty, bool SET_MAIN)
     // Calculate the PWM period corresponding to the freq.
     uint32_t ui32Period = SysCtlClockGet() / PWM_DIVIDER / PWM_START_RATE_HZ;
 
+    recordRotorDuty(ui32Duty, SET_MAIN);
+
     if (SET_MAIN == true) // Set PWM freq/duty of the main rotor
     {
         PWMGenPeriodSet(PWM_MAIN_BASE, PWM_MAIN_GEN, ui32Period);
@@ -134,71 +147,135 @@ setRotorPWM (uint32_t ui32Duty, bool SET_MAIN)
 
 
 /*
- * Function:    SetMainDuty
- * -------------------------
- * FreeRTOS task that periodically calls functions to set the PWM
- * duty cycle of the main rotor required to reach the desired
- * altitude.
+ * Function:    updateMainDuty
+ * ----------------------------
+ * Runs one cycle of the altitude loop, calculating the PWM duty
+ * cycle of the main rotor required to reach the desired altitude.
+ * Called by the control executive every altitude control period.
  *
  * @params:
- *      - NULL
+ *      - int32_t alt_meas: Measured altitude (%).
+ *      - int32_t alt_rate: Estimated vertical velocity (Q %/s).
  * @return:
- *      - NULL
+ *      - int32_t alt_PWM: Main rotor duty (%).
  * ---------------------
  */
-void
-SetMainDuty(void *pvParameters)
+int32_t
+updateMainDuty(int32_t alt_meas, int32_t alt_rate)
 {
-    int32_t alt_PWM = 0;
-    int32_t alt_meas = 0;
-    int32_t alt_desired = 0;
-
-    while (1)
-    {
-        // Retrieve altitude information
-        xQueuePeek(xAltMeasQueue, &alt_meas,    TICKS_TO_WAIT); // Retrieve measured altitude data from the RTOS queue
-        xQueuePeek(xAltDesQueue,  &alt_desired, TICKS_TO_WAIT); // Retrieve desired altitude data from the RTOS queue
+    static int32_t alt_PWM = 0;
+    int32_t alt_desired = getAltDesired();
+    int32_t alt_reference = 0;
 
-        // Set PWM duty cycle of main rotor in order to hover to the desired altitude
-        alt_PWM = getControlSignal(&g_alt_controller, alt_desired, alt_meas, false); // Use the error to calculate a PWM duty cycle for the main rotor
-        setRotorPWM(alt_PWM, IS_MAIN_ROTOR); // Set main rotor to calculated PWM
+    alt_reference = updateTrajectory(&g_alt_trajectory, alt_desired, alt_meas,
+                                     g_alt_controller.timeStep); // Profile steps in the desired altitude
 
-        vTaskDelay(CONTROL_PERIOD / portTICK_RATE_MS); // Block task so lower priority tasks can run
+    // Calculate the PWM duty cycle of main rotor in order to hover to the desired altitude
+    if (isAutotuning(false)) {
+        alt_PWM = updateAutotune(alt_reference, alt_meas, alt_PWM,
+                                 g_alt_controller.timeStep); // Relay experiment around the hover duty
+    } else {
+        scheduleAltitudeGains(&g_alt_controller, alt_meas); // Scale the gains for the current altitude
+        alt_PWM = getControlSignalWithRate(&g_alt_controller, alt_reference, getTrajectoryRate(&g_alt_trajectory),
+                                           alt_meas, alt_rate, false); // Use the error and climb rate to calculate a PWM duty cycle for the main rotor
     }
+
+    return alt_PWM;
 }
 
 
 /*
- * Function:    SetTailDuty
- * -------------------------
- * FreeRTOS task that periodically calls functions to set the PWM
- * duty cycle of the tail rotor required to reach the desired yaw.
+ * Function:    updateTailDuty
+ * ----------------------------
+ * Runs one cycle of the yaw loop, calculating the PWM duty cycle
+ * of the tail rotor required to reach the desired yaw. Called by
+ * the control executive every yaw control period, after the main
+ * rotor so the torque compensation uses the main duty from the
+ * same cycle.
  *
  * @params:
- *      - NULL
+ *      - int32_t alt_PWM: Main rotor duty from this cycle (%).
+ *      - int32_t yaw_meas: Measured yaw (degrees).
+ *      - int32_t yaw_rate: Estimated yaw rate (Q deg/s).
  * @return:
- *      - NULL
+ *      - int32_t yaw_PWM: Tail rotor duty (%).
  * ---------------------
  */
-void
-SetTailDuty(void *pvParameters)
+int32_t
+updateTailDuty(int32_t alt_PWM, int32_t yaw_meas, int32_t yaw_rate)
 {
-    int32_t yaw_PWM = 0;
-    int32_t yaw_meas = 0;
-    int32_t yaw_desired = 0;
-    int32_t alt_PWM = 0;
+    static int32_t yaw_PWM = 0;
+    int32_t yaw_desired = getYawDesired();
+    int32_t yaw_reference = 0;
 
-    while (1)
-    {
-        // Retrieve yaw information
-        xQueuePeek(xYawMeasQueue, &yaw_meas,   TICKS_TO_WAIT); // Retrieve measured yaw data from the RTOS queue
-        xQueuePeek(xYawDesQueue, &yaw_desired, TICKS_TO_WAIT); // Retrieve desired yaw data from the RTOS queue
+    setControllerFeedforward(&g_yaw_controller, getCouplingFeedforward(alt_PWM)); // Cancel the main rotor torque
 
-        // Set PWM duty cycle of tail rotor in order to spin to target yaw
-        yaw_PWM = getControlSignal(&g_yaw_controller, yaw_desired, yaw_meas, true); // Use the error to calculate a PWM duty cycle for the tail rotor
-        yaw_PWM = yaw_PWM + (alt_PWM * MAIN_ROTOR_FACTOR); // Compensate tail PWM due to effect of main rotor duty cycle
-        setRotorPWM(yaw_PWM, IS_TAIL_ROTOR); // Set tail rotor to calculated PWM
+    yaw_reference = updateTrajectory(&g_yaw_trajectory, yaw_desired, yaw_meas,
+                                     g_yaw_controller.timeStep); // Profile steps in the desired yaw
 
-        vTaskDelay(CONTROL_PERIOD / portTICK_RATE_MS); // Block task so lower priority tasks can run
+    // Calculate the PWM duty cycle of tail rotor in order to spin to target yaw
+    if (isAutotuning(true)) {
+        yaw_PWM = updateAutotune(yaw_reference, yaw_meas, yaw_PWM,
+                                 g_yaw_controller.timeStep); // Relay experiment around the current tail duty
+    } else {
+        yaw_PWM = getControlSignalWithRate(&g_yaw_controller, yaw_reference, getTrajectoryRate(&g_yaw_trajectory),
+                                           yaw_meas, yaw_rate, true); // Use the error and yaw rate to calculate a PWM duty cycle for the tail rotor
     }
+
+    return yaw_PWM;
+}
+
+
+/*
+ * Function:    updateYawAngle
+ * ----------------------------
+ * Runs one cycle of the outer angle loop used when yaw control is
+ * cascaded, turning the yaw error into a rate command for
+ * updateTailRate. Called by the control executive every yaw
+ * control period.
+ *
+ * @params:
+ *      - int32_t yaw_meas: Measured yaw (degrees).
+ *      - int32_t yaw_rate: Estimated yaw rate (Q deg/s).
+ * @return:
+ *      - int32_t rate_command: Yaw rate needed to close the error (deg/s).
+ * ---------------------
+ */
+int32_t
+updateYawAngle(int32_t yaw_meas, int32_t yaw_rate)
+{
+    int32_t yaw_desired = getYawDesired();
+    int32_t yaw_reference = 0;
+
+    yaw_reference = updateTrajectory(&g_yaw_trajectory, yaw_desired, yaw_meas,
+                                     g_yaw_controller.timeStep); // Profile steps in the desired yaw
+
+    return getControlSignalWithRate(&g_yaw_controller, yaw_reference, getTrajectoryRate(&g_yaw_trajectory),
+                                    yaw_meas, yaw_rate, true); // Rate needed to close the yaw error
+}
+
+
+/*
+ * Function:    updateTailRate
+ * ----------------------------
+ * Runs one cycle of the inner rate loop used when yaw control is
+ * cascaded, setting the tail duty to track the rate command using
+ * the encoder rate estimate. Called by the control executive every
+ * YAW_RATE_PERIOD.
+ *
+ * @params:
+ *      - int32_t alt_PWM: Main rotor duty from this cycle (%).
+ *      - int32_t rate_command: Latest command from updateYawAngle (deg/s).
+ *      - int32_t yaw_rate: Estimated yaw rate (Q deg/s).
+ * @return:
+ *      - int32_t yaw_PWM: Tail rotor duty (%).
+ * ---------------------
+ */
+int32_t
+updateTailRate(int32_t alt_PWM, int32_t rate_command, int32_t yaw_rate)
+{
+    setControllerFeedforward(&g_yaw_rate_controller, getCouplingFeedforward(alt_PWM)); // Cancel the main rotor torque
+
+    return getControlSignal(&g_yaw_rate_controller, rate_command,
+                            (yaw_rate + (1 << (YAW_RATE_Q_BITS - 1))) >> YAW_RATE_Q_BITS, false); // Round the rate to whole deg/s
 }
@@ -73,7 +73,6 @@
 
 #define IS_MAIN_ROTOR           1
 #define IS_TAIL_ROTOR           0
-#define MAIN_ROTOR_FACTOR       64/100              // Factor used to compensate for the effect of main rotor
 #define CONVERT_TO_PERCENTAGE   100                 // Factor used to convert to percentage
 
 
@@ -123,32 +122,73 @@ void setRotorPWM(uint32_t ui32Duty, bool SET_MAIN);
 
 
 /*
- * Function:    SetMainDuty
- * -------------------------
- * FreeRTOS task that periodically calls functions to set the PWM
- * duty cycle of the main rotor required to reach the desired
- * altitude.
+ * Function:    updateMainDuty
+ * ----------------------------
+ * Runs one cycle of the altitude loop, calculating the PWM duty
+ * cycle of the main rotor required to reach the desired altitude.
+ * Called by the control executive every altitude control period.
  *
  * @params:
- *      - NULL
+ *      - int32_t alt_meas: Measured altitude (%).
+ *      - int32_t alt_rate: Estimated vertical velocity (Q %/s).
  * @return:
- *      - NULL
+ *      - int32_t alt_PWM: Main rotor duty (%).
  * ---------------------
  */
-void SetMainDuty(void *pvParameters);
+int32_t updateMainDuty(int32_t alt_meas, int32_t alt_rate);
 
 /*
- * Function:    SetTailDuty
- * -------------------------
- * FreeRTOS task that periodically calls functions to set the PWM
- * duty cycle of the tail rotor required to reach the desired yaw.
+ * Function:    updateTailDuty
+ * ----------------------------
+ * Runs one cycle of the yaw loop, calculating the PWM duty cycle
+ * of the tail rotor required to reach the desired yaw. Called by
+ * the control executive every yaw control period, after the main
+ * rotor so the torque compensation uses the main duty from the
+ * same cycle.
  *
  * @params:
- *      - NULL
+ *      - int32_t alt_PWM: Main rotor duty from this cycle (%).
+ *      - int32_t yaw_meas: Measured yaw (degrees).
+ *      - int32_t yaw_rate: Estimated yaw rate (Q deg/s).
  * @return:
- *      - NULL
+ *      - int32_t yaw_PWM: Tail rotor duty (%).
+ * ---------------------
+ */
+int32_t updateTailDuty(int32_t alt_PWM, int32_t yaw_meas, int32_t yaw_rate);
+
+/*
+ * Function:    updateYawAngle
+ * ----------------------------
+ * Runs one cycle of the outer angle loop used when yaw control is
+ * cascaded, turning the yaw error into a rate command for
+ * updateTailRate. Called by the control executive every yaw
+ * control period.
+ *
+ * @params:
+ *      - int32_t yaw_meas: Measured yaw (degrees).
+ *      - int32_t yaw_rate: Estimated yaw rate (Q deg/s).
+ * @return:
+ *      - int32_t rate_command: Yaw rate needed to close the error (deg/s).
+ * ---------------------
+ */
+int32_t updateYawAngle(int32_t yaw_meas, int32_t yaw_rate);
+
+/*
+ * Function:    updateTailRate
+ * ----------------------------
+ * Runs one cycle of the inner rate loop used when yaw control is
+ * cascaded, setting the tail duty to track the rate command using
+ * the encoder rate estimate. Called by the control executive every
+ * YAW_RATE_PERIOD.
+ *
+ * @params:
+ *      - int32_t alt_PWM: Main rotor duty from this cycle (%).
+ *      - int32_t rate_command: Latest command from updateYawAngle (deg/s).
+ *      - int32_t yaw_rate: Estimated yaw rate (Q deg/s).
+ * @return:
+ *      - int32_t yaw_PWM: Tail rotor duty (%).
  * ---------------------
  */
-void SetTailDuty(void *pvParameters);
+int32_t updateTailRate(int32_t alt_PWM, int32_t rate_command, int32_t yaw_rate);
 
 #endif /* _PWM_H_ */
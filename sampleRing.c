@@ -0,0 +1,220 @@
+/* ****************************************************************
+ * sampleRing.c
+ *
+ * Source file for the sample ring module
+ * Single-producer ring buffer which keeps a running sum of its most
+ * recent samples so the moving average can be read in constant
+ * time. Safe to write from an ISR while a task reads the mean.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include "sampleRing.h"
+
+
+/*
+ * Function:    limitWindow
+ * -------------------------
+ * Limits a requested window size to the capacity of the ring.
+ *
+ * @params:
+ *      - uint32_t window: Requested window size.
+ * @return:
+ *      - uint32_t window: Window size between 1 and
+ *      SAMPLE_RING_CAPACITY.
+ * ---------------------
+ */
+static uint32_t
+limitWindow(uint32_t window)
+{
+    if (window < 1) {
+        window = 1;
+    } else if (window > SAMPLE_RING_CAPACITY) {
+        window = SAMPLE_RING_CAPACITY;
+    }
+    return window;
+}
+
+
+/*
+ * Function:    initSampleRing
+ * ----------------------------
+ * Empties the ring and sets the number of samples averaged.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to initialise.
+ *      - uint32_t window: Number of samples in the moving
+ *      average (1 to SAMPLE_RING_CAPACITY).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initSampleRing(sampleRing_t* ring, uint32_t window)
+{
+    uint32_t i;
+
+    for (i = 0; i < SAMPLE_RING_CAPACITY; i++) {
+        ring->data[i] = 0;
+    }
+    ring->sequence = 0;
+    ring->sum = 0;
+    ring->windex = 0;
+    ring->filled = 0;
+    ring->window = limitWindow(window);
+}
+
+
+/*
+ * Function:    writeSampleRing
+ * -----------------------------
+ * Adds a sample to the ring and updates the running sum in
+ * constant time. Only one context (normally an ISR) may write.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to write to.
+ *      - uint16_t value: The sample to add.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+writeSampleRing(sampleRing_t* ring, uint16_t value)
+{
+    uint32_t windex = ring->windex;
+    uint32_t window = ring->window;
+    uint32_t filled = ring->filled;
+
+    ring->sequence++;                                           // Odd: update in progress
+
+    // Remove the sample leaving the window, then add the new one. The fill count is used as
+    // windex wraps after 2^32 samples
+    if (filled >= window) {
+        ring->sum -= ring->data[(windex - window) & SAMPLE_RING_MASK];
+    }
+    ring->data[windex & SAMPLE_RING_MASK] = value;
+    ring->sum += value;
+    ring->windex = windex + 1;
+    if (filled < SAMPLE_RING_CAPACITY) {
+        ring->filled = filled + 1;
+    }
+
+    ring->sequence++;                                           // Even: update complete
+}
+
+
+/*
+ * Function:    readSampleRingMean
+ * --------------------------------
+ * Returns the mean of the samples in the current window in
+ * constant time. Retries if the producer updated the ring
+ * during the read.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to read.
+ * @return:
+ *      - int32_t mean: The mean of the window, or 0 if empty.
+ * ---------------------
+ */
+int32_t
+readSampleRingMean(sampleRing_t* ring)
+{
+    uint32_t sequence;
+    uint32_t sum;
+    uint32_t count;
+
+    do {
+        sequence = ring->sequence;
+        sum = ring->sum;
+        count = ring->filled;
+        if (count > ring->window) {
+            count = ring->window;
+        }
+    } while ((sequence & 1) || (sequence != ring->sequence));  // Retry if an update was in progress or occurred
+
+    if (count == 0) {
+        return 0;
+    }
+    return (int32_t) (sum / count);
+}
+
+
+/*
+ * Function:    getSampleRingCount
+ * --------------------------------
+ * Returns the total number of samples written to the ring.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to read.
+ * @return:
+ *      - uint32_t count: Number of samples written.
+ * ---------------------
+ */
+uint32_t
+getSampleRingCount(sampleRing_t* ring)
+{
+    return ring->windex;
+}
+
+
+/*
+ * Function:    getSampleRingFill
+ * -------------------------------
+ * Returns the number of samples stored in the ring. Unlike the
+ * count of samples written, this stops at SAMPLE_RING_CAPACITY.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to read.
+ * @return:
+ *      - uint32_t fill: Number of samples stored.
+ * ---------------------
+ */
+uint32_t
+getSampleRingFill(sampleRing_t* ring)
+{
+    return ring->filled;
+}
+
+
+/*
+ * Function:    setSampleRingWindow
+ * ---------------------------------
+ * Changes the number of samples averaged. The running sum is
+ * rebuilt once from the stored samples, after which reads and
+ * writes remain constant time.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to modify.
+ *      - uint32_t window: New number of samples in the moving
+ *      average (1 to SAMPLE_RING_CAPACITY).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+setSampleRingWindow(sampleRing_t* ring, uint32_t window)
+{
+    uint32_t i;
+    uint32_t count;
+    uint32_t sum = 0;
+
+    window = limitWindow(window);
+
+    taskENTER_CRITICAL();                                       // Keep the producer out while the sum is rebuilt
+    ring->sequence++;
+
+    count = (ring->filled < window) ? ring->filled : window;
+    for (i = 1; i <= count; i++) {
+        sum += ring->data[(ring->windex - i) & SAMPLE_RING_MASK];
+    }
+    ring->sum = sum;
+    ring->window = window;
+
+    ring->sequence++;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,134 @@
+/* ****************************************************************
+ * sampleRing.h
+ *
+ * Header file for the sample ring module
+ * Single-producer ring buffer which keeps a running sum of its most
+ * recent samples so the moving average can be read in constant
+ * time. Safe to write from an ISR while a task reads the mean.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef SAMPLERING_H_
+#define SAMPLERING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define SAMPLE_RING_CAPACITY    1024                        // Maximum window size. Must be a power of two
+#define SAMPLE_RING_MASK        (SAMPLE_RING_CAPACITY - 1)
+
+
+/* ******************************************************
+ * Ring of samples with a running sum over the last
+ * 'window' samples. The sequence counter is odd while
+ * the producer is part way through an update, so a
+ * reader can detect and retry a torn read.
+ * *****************************************************/
+typedef struct SampleRings {
+    volatile uint32_t   sequence;                       // Incremented before and after each update
+    volatile uint32_t   sum;                            // Sum of the last 'window' samples
+    volatile uint32_t   windex;                         // Total number of samples written (free running)
+    volatile uint32_t   filled;                         // Number of samples stored, up to SAMPLE_RING_CAPACITY
+    volatile uint32_t   window;                         // Number of samples averaged
+    volatile uint16_t   data[SAMPLE_RING_CAPACITY];     // Sample storage
+} sampleRing_t;
+
+
+/*
+ * Function:    initSampleRing
+ * ----------------------------
+ * Empties the ring and sets the number of samples averaged.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to initialise.
+ *      - uint32_t window: Number of samples in the moving
+ *      average (1 to SAMPLE_RING_CAPACITY).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initSampleRing(sampleRing_t* ring, uint32_t window);
+
+/*
+ * Function:    writeSampleRing
+ * -----------------------------
+ * Adds a sample to the ring and updates the running sum in
+ * constant time. Only one context (normally an ISR) may write.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to write to.
+ *      - uint16_t value: The sample to add.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void writeSampleRing(sampleRing_t* ring, uint16_t value);
+
+/*
+ * Function:    readSampleRingMean
+ * --------------------------------
+ * Returns the mean of the samples in the current window in
+ * constant time. Retries if the producer updated the ring
+ * during the read.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to read.
+ * @return:
+ *      - int32_t mean: The mean of the window, or 0 if empty.
+ * ---------------------
+ */
+int32_t readSampleRingMean(sampleRing_t* ring);
+
+/*
+ * Function:    getSampleRingCount
+ * --------------------------------
+ * Returns the total number of samples written to the ring.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to read.
+ * @return:
+ *      - uint32_t count: Number of samples written.
+ * ---------------------
+ */
+uint32_t getSampleRingCount(sampleRing_t* ring);
+
+/*
+ * Function:    getSampleRingFill
+ * -------------------------------
+ * Returns the number of samples stored in the ring. Unlike the
+ * count of samples written, this stops at SAMPLE_RING_CAPACITY.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to read.
+ * @return:
+ *      - uint32_t fill: Number of samples stored.
+ * ---------------------
+ */
+uint32_t getSampleRingFill(sampleRing_t* ring);
+
+/*
+ * Function:    setSampleRingWindow
+ * ---------------------------------
+ * Changes the number of samples averaged. The running sum is
+ * rebuilt once from the stored samples, after which reads and
+ * writes remain constant time.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring to modify.
+ *      - uint32_t window: New number of samples in the moving
+ *      average (1 to SAMPLE_RING_CAPACITY).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void setSampleRingWindow(sampleRing_t* ring, uint32_t window);
+
+#endif /* SAMPLERING_H_ */
@@ -0,0 +1,246 @@
+/* ****************************************************************
+ * adcTest.c
+ *
+ * Tests the hand-off of the ADC's uDMA ping-pong blocks to the
+ * sample ring, against the simulator's ADC, timer and uDMA
+ * stand-ins. Each conversion returns the next number of a count,
+ * so a lost, repeated or reordered sample shows in the ring.
+ *
+ * Usage: adcTest [-v]
+ *      -v  Print every check, not just the failures
+ *
+ * Checks that:
+ *      - the timer triggers one conversion per sample period
+ *      - samples reach the ring only a whole block at a time, with
+ *        one interrupt per block
+ *      - the ring holds every sample in order across many blocks,
+ *        so each block is re-armed before its turn comes round
+ *      - an interrupt that runs late by less than a block loses
+ *        nothing
+ *      - the buffer full flag is raised once the moving average
+ *        window is full, and not before
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simRTOS.h"
+#include "simHardware.h"
+#include "simTest.h"
+#include "FreeRTOSCreate.h"
+#include "ADC.h"
+
+#define TEST_BLOCKS             200         // Blocks converted in the ordering check
+#define TEST_SAMPLE_NS          (SIM_NS_PER_SECOND / ADC_SAMPLE_RATE_HZ)
+
+static uint16_t g_nextSample = 0;           // Result of the next conversion
+static uint32_t g_interrupts = 0;           // ADC interrupts run
+
+
+// The test drives the ADC itself and never starts the scheduler
+void runSimulation(void) {}
+
+
+/*
+ * Function:    convertCount
+ * --------------------------
+ * ADC input of the test. Returns a count, wrapped to 12 bits.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint16_t result: The next count.
+ * ---------------------
+ */
+static uint16_t
+convertCount(void)
+{
+    uint16_t result = g_nextSample;
+
+    g_nextSample = (g_nextSample + 1) & 0xFFF;
+    return result;
+}
+
+
+/*
+ * Function:    countInterrupt
+ * ----------------------------
+ * Stands in for the ADC interrupt vector. Counts the interrupt
+ * and runs the firmware's handler.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+countInterrupt(void)
+{
+    g_interrupts++;
+    ADCIntHandler();
+}
+
+
+/*
+ * Function:    checkRingOrder
+ * ----------------------------
+ * Checks that the newest samples in the ring are consecutive
+ * counts ending at the last one handed over.
+ *
+ * @params:
+ *      - const char* name: Name of the check.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+checkRingOrder(const char* name)
+{
+    uint32_t count = getSampleRingCount(&g_inBuffer);
+    uint32_t span = (count < SAMPLE_RING_CAPACITY) ? count : SAMPLE_RING_CAPACITY;
+    uint32_t bad = 0;
+    uint32_t i;
+
+    for (i = count - span; i < count; i++) {
+        if (g_inBuffer.data[i & SAMPLE_RING_MASK] != (i & 0xFFF)) {
+            bad++;
+        }
+    }
+    simCheck(bad == 0, "%s: %u of the newest %u samples out of order", name, (unsigned) bad, (unsigned) span);
+}
+
+
+/*
+ * Function:    testBlocks
+ * ------------------------
+ * Converts one sample at a time and checks the ring only grows a
+ * whole block at a time, with one interrupt per block, and that
+ * the buffer full flag waits for a full window.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testBlocks(void)
+{
+    uint32_t conversions;
+    uint32_t partial = 0;
+    bool earlyFlag = false;
+    bool flagged = false;
+
+    for (conversions = 1; conversions <= 2 * ADC_BUF_SIZE; conversions++) {
+        simConvertADC();
+        if (getSampleRingCount(&g_inBuffer) != conversions / ADC_DMA_BLOCK_SIZE * ADC_DMA_BLOCK_SIZE) {
+            partial++;
+        }
+        flagged = (xEventGroupGetBits(xFoundAltReference) & GROUND_BUFFER_FULL) != 0;
+        if (flagged && getSampleRingCount(&g_inBuffer) < ADC_BUF_SIZE) {
+            earlyFlag = true;
+        }
+    }
+    simCheck(partial == 0, "ring grows only by whole blocks (%u conversions off)", (unsigned) partial);
+    simCheck(g_interrupts == 2 * ADC_BUF_SIZE / ADC_DMA_BLOCK_SIZE, "one interrupt per block (%u for %u blocks)",
+             (unsigned) g_interrupts, (unsigned) (2 * ADC_BUF_SIZE / ADC_DMA_BLOCK_SIZE));
+    simCheck(!earlyFlag && flagged, "buffer full flag raised once the window of %u is full", ADC_BUF_SIZE);
+    checkRingOrder("first blocks");
+}
+
+
+/*
+ * Function:    testTimer
+ * -----------------------
+ * Lets the ADC timer run for many blocks and checks it triggers
+ * one conversion per sample period and every sample arrives in
+ * order.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testTimer(void)
+{
+    uint32_t startCount = getSampleRingCount(&g_inBuffer);
+    uint16_t startSample = g_nextSample;
+    uint32_t conversions;
+
+    simAdvanceTime(simGetTime() + (uint64_t) TEST_BLOCKS * ADC_DMA_BLOCK_SIZE * TEST_SAMPLE_NS);
+    conversions = (g_nextSample - startSample) & 0xFFF;
+    simCheck(conversions == (TEST_BLOCKS * ADC_DMA_BLOCK_SIZE) % 0x1000,
+             "timer triggers %u conversions in %u sample periods", (unsigned) conversions,
+             (unsigned) (TEST_BLOCKS * ADC_DMA_BLOCK_SIZE));
+    simCheck(getSampleRingCount(&g_inBuffer) - startCount == TEST_BLOCKS * ADC_DMA_BLOCK_SIZE,
+             "%u blocks handed to the ring", (unsigned) ((getSampleRingCount(&g_inBuffer) - startCount)
+                                                         / ADC_DMA_BLOCK_SIZE));
+    checkRingOrder("timer driven blocks");
+}
+
+
+/*
+ * Function:    testLateInterrupt
+ * -------------------------------
+ * Holds the ADC interrupt off while the next block fills and part
+ * of the one after, as a higher priority interrupt might, then
+ * lets it run. The other block takes the samples meanwhile, so
+ * none may be lost.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testLateInterrupt(void)
+{
+    uint32_t startCount = getSampleRingCount(&g_inBuffer);
+    uint32_t i;
+
+    ADCIntRegister(ADC_BASE, ADC_SEQ_NUM, NULL);                // Pended, not yet run
+    for (i = 0; i < ADC_DMA_BLOCK_SIZE + ADC_DMA_BLOCK_SIZE / 2; i++) {
+        simConvertADC();
+    }
+    simCheck(getSampleRingCount(&g_inBuffer) == startCount, "nothing handed over while the interrupt is held");
+    simRTOSRunISR(countInterrupt);
+    ADCIntRegister(ADC_BASE, ADC_SEQ_NUM, countInterrupt);
+    for (i = 0; i < ADC_DMA_BLOCK_SIZE / 2; i++) {
+        simConvertADC();
+    }
+    simCheck(getSampleRingCount(&g_inBuffer) - startCount == 2 * ADC_DMA_BLOCK_SIZE,
+             "late interrupt hands over both blocks (%u samples)",
+             (unsigned) (getSampleRingCount(&g_inBuffer) - startCount));
+    checkRingOrder("after a late interrupt");
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    simSetCheckVerbose(argc > 1 && strcmp(argv[1], "-v") == 0);
+
+    xFoundAltReference = xEventGroupCreate();
+    xEventGroupSetBits(xFoundAltReference, GROUND_NOT_FOUND);
+    simSetADCInput(convertCount);
+    initADC();
+    ADCIntRegister(ADC_BASE, ADC_SEQ_NUM, countInterrupt);
+    simCheck(getSampleRingCount(&g_inBuffer) == 0, "ring empty after initADC");
+
+    testBlocks();
+    testTimer();
+    testLateInterrupt();
+
+    return simCheckResult("adcTest");
+}
@@ -0,0 +1,219 @@
+/* ****************************************************************
+ * autotuneTest.c
+ *
+ * Runs the firmware's relay autotuner against the plant model.
+ * The helicopter is put at hover at the tuning point and the
+ * experiment is stepped each control period as the main rotor
+ * task would, with the relay's duty driving the plant. The
+ * scheduler is not started, so the test calls updateAutotune,
+ * finishAutotune and applyControllerParams itself, and reads the
+ * FSM's event queue.
+ *
+ * Usage: autotuneTest [-v]
+ *      -v  Print every check, not just the failures
+ *
+ * Checks that, for each tuning rule:
+ *      - the relay experiment finishes, tells the FSM it has
+ *        ended and stages the gains
+ *      - the relay oscillation gives an ultimate gain and period
+ *      - the altitude gains scheduled at the tuning point are the
+ *        tuned gains, to within one gain unit
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "simRTOS.h"
+#include "simHardware.h"
+#include "simTest.h"
+#include "heliPlant.h"
+#include "FreeRTOSCreate.h"
+#include "pidController.h"
+#include "gainSchedule.h"
+#include "autotune.h"
+#include "FSM.h"
+
+#define AUTOTUNE_TEST_POINT     15          // Altitude the experiment runs at (%)
+#define AUTOTUNE_TEST_SEED      1           // Plant noise seed
+#define AUTOTUNE_TEST_SECONDS   (1.0 / MS_TO_SECONDS)
+#define AUTOTUNE_TEST_Q_SLACK   3           // Q format units lost rounding and scaling a base gain
+
+
+// The test steps the experiment itself and never starts the scheduler
+void runSimulation(void) {}
+
+
+/*
+ * Function:    getGainQ
+ * ----------------------
+ * Returns a gain in Q format, computed in double precision.
+ *
+ * @params:
+ *      - int32_t gain: The gain, over CONTROL_DIVISOR.
+ * @return:
+ *      - double gain: The gain in Q format.
+ * ---------------------
+ */
+static double
+getGainQ(int32_t gain)
+{
+    return (double) gain * PID_Q_ONE / CONTROL_DIVISOR;
+}
+
+
+/*
+ * Function:    getTolerance
+ * --------------------------
+ * Returns the tolerance on a scheduled gain: one gain unit, or
+ * the rounding of the Q format gain where that is coarser, as it
+ * is for Ki at a 1 ms control period.
+ *
+ * @params:
+ *      - double unit: One gain unit in Q format.
+ * @return:
+ *      - double tolerance: The tolerance in Q format.
+ * ---------------------
+ */
+static double
+getTolerance(double unit)
+{
+    return fmax(unit, AUTOTUNE_TEST_Q_SLACK);
+}
+
+
+/*
+ * Function:    runExperiment
+ * ---------------------------
+ * Puts the plant at hover at the tuning point and steps the relay
+ * experiment until it finishes or times out.
+ *
+ * @params:
+ *      - heliPlant_t* plant: The plant model.
+ * @return:
+ *      - autotuneStatus_t status: Status the experiment ended with.
+ * ---------------------
+ */
+static autotuneStatus_t
+runExperiment(heliPlant_t* plant)
+{
+    double seconds = CONTROL_PERIOD * AUTOTUNE_TEST_SECONDS;
+    int32_t duty = (int32_t) lround(PLANT_HOVER_SPEED * 100);
+    uint32_t elapsed;
+
+    initHeliPlant(plant, AUTOTUNE_TEST_SEED);
+    plant->altitude = AUTOTUNE_TEST_POINT;
+    plant->mainSpeed = PLANT_HOVER_SPEED;
+
+    for (elapsed = 0; elapsed <= AUTOTUNE_TIMEOUT_MS && isAutotuning(false); elapsed += CONTROL_PERIOD) {
+        duty = updateAutotune(AUTOTUNE_TEST_POINT, (int32_t) lround(plant->altitude), duty, CONTROL_PERIOD);
+        stepHeliPlant(plant, duty / 100.0, 0, seconds);
+    }
+
+    return getAutotuneStatus();
+}
+
+
+/*
+ * Function:    testRule
+ * ----------------------
+ * Tunes the altitude controller with one rule and checks the
+ * gains it runs with at the tuning point.
+ *
+ * @params:
+ *      - tuneRule_t rule: The tuning rule.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testRule(tuneRule_t rule)
+{
+    char reply[SIM_UART_TX_SIZE + 1];
+    heliPlant_t plant;
+    autotuneStatus_t status;
+    int ultimateGain;
+    int ultimatePeriod;
+    int tuned[3];
+    int base[3];
+    int applied;
+    uint8_t event;
+    const char* line;
+
+    initController(&g_alt_controller, false);
+    simCheck(requestAutotune(false, rule), "rule %d: the experiment is accepted", (int) rule);
+    status = runExperiment(&plant);
+    simCheck(status == AUTOTUNE_DONE, "rule %d: the experiment finishes (status %d, altitude %.1f%%)",
+             (int) rule, (int) status, plant.altitude);
+    simCheck(xQueueReceive(xFSMEventQueue, &event, 0) == pdPASS && event == FSM_EVENT_TUNE_END
+             && xQueueReceive(xFSMEventQueue, &event, 0) != pdPASS,
+             "rule %d: the FSM is told once that the experiment ended", (int) rule);
+    finishAutotune();
+    simTakeUARTOutput(reply);
+
+    line = strstr(reply, "Base");
+    applied = (sscanf(reply, "Ku %d/100 Pu %d ms\nKp %d Ki %d Kd %d\n", &ultimateGain, &ultimatePeriod,
+                      &tuned[0], &tuned[1], &tuned[2]) == 5) && line != NULL
+              && (sscanf(line, "Base Kp %d Ki %d Kd %d\nTune applied\n", &base[0], &base[1], &base[2]) == 3)
+              && strstr(line, "Tune applied") != NULL;
+    simCheck(applied, "rule %d: the tuned gains are reported and staged (\"%.*s\")", (int) rule,
+             (int) strcspn(reply, "\n"), reply);
+    if (!applied) {
+        return;
+    }
+    simCheck(ultimateGain > 0 && ultimatePeriod > 0, "rule %d: Ku %d/100, Pu %d ms", (int) rule, ultimateGain,
+             ultimatePeriod);
+
+    applyControllerParams(&g_alt_controller);
+    simCheck(g_alt_controller.Kp == base[0] && g_alt_controller.Ki == base[1] && g_alt_controller.Kd == base[2],
+             "rule %d: the base gains are swapped in", (int) rule);
+
+    scheduleAltitudeGains(&g_alt_controller, AUTOTUNE_TEST_POINT);
+    simCheck(fabs(g_alt_controller.KpQ - getGainQ(tuned[0])) <= getTolerance(getGainQ(1)),
+             "rule %d: scheduled Kp at %d%% is the tuned %d (%.2f)", (int) rule, AUTOTUNE_TEST_POINT, tuned[0],
+             g_alt_controller.KpQ / getGainQ(1));
+    simCheck(fabs(g_alt_controller.KiQ - getGainQ(tuned[1]) * CONTROL_PERIOD / MS_TO_SECONDS)
+             <= getTolerance(getGainQ(1) * CONTROL_PERIOD / MS_TO_SECONDS),
+             "rule %d: scheduled Ki at %d%% is the tuned %d (%.2f)", (int) rule, AUTOTUNE_TEST_POINT, tuned[1],
+             g_alt_controller.KiQ * MS_TO_SECONDS / CONTROL_PERIOD / getGainQ(1));
+    simCheck(fabs(g_alt_controller.KdQ - getGainQ(tuned[2]) * MS_TO_SECONDS / CONTROL_PERIOD)
+             <= getTolerance(getGainQ(1) * MS_TO_SECONDS / CONTROL_PERIOD),
+             "rule %d: scheduled Kd at %d%% is the tuned %d (%.2f)", (int) rule, AUTOTUNE_TEST_POINT, tuned[2],
+             g_alt_controller.KdQ * CONTROL_PERIOD / MS_TO_SECONDS / getGainQ(1));
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    tuneRule_t rule;
+    int option;
+
+    while ((option = getopt(argc, argv, "v")) != -1) {
+        switch (option) {
+            case 'v':
+                simSetCheckVerbose(true);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    xUARTMutex = xSemaphoreCreateMutex();
+    xFSMEventQueue = xQueueCreate(FSM_EVENT_QUEUE_SIZE, sizeof(uint8_t));
+    initController(&g_yaw_controller, true);
+    for (rule = TUNE_ZIEGLER_NICHOLS; rule < NUM_TUNE_RULES; rule++) {
+        testRule(rule);
+    }
+
+    return simCheckResult("autotuneTest");
+}
@@ -0,0 +1,1065 @@
+/* ****************************************************************
+ * gainSearch.c
+ *
+ * Searches for the altitude and yaw controller gains on a
+ * simulated HeliRig. Each candidate gain set flies a takeoff, a
+ * flip, a climb and a return flip through the firmware's
+ * own controller, trajectory, gain schedule, mixer and altitude
+ * observer, against the plant model used by heliSim. The
+ * candidates are scored on settling time, overshoot, tracking
+ * error and actuator effort and improved by differential
+ * evolution. Every generation
+ * is evaluated in parallel on a work-stealing thread pool.
+ *
+ * This is lighter than heliSim: there is no kernel, the loops are
+ * called directly every control period and the encoder edges are
+ * timed to the plant step rather than by the edge timer. The yaw
+ * rate is estimated from those edges as updateYawRate does. Check
+ * a result with heliSim before flying it.
+ *
+ * Usage: gainSearch [-j threads] [-g generations] [-s seed] [-o pidGains.h] [-b]
+ *      -j  Worker threads (default: one per core)
+ *      -g  Generations of differential evolution (default 60)
+ *      -s  Seed of the search (default 1)
+ *      -o  Write the best gains as a replacement for pidGains.h
+ *      -b  Measure the evaluation throughput with 1 thread up to -j
+ *          threads instead of searching
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "heliPlant.h"
+#include "pidController.h"
+#include "gainSchedule.h"
+#include "trajectory.h"
+#include "mixer.h"
+#include "altObserver.h"
+#include "altitude.h"
+#include "ADC.h"
+#include "yaw.h"
+#include "FSM.h"
+
+#define SEARCH_GAINS            6           // Gains searched: altitude then yaw Kp, Ki and Kd
+#define SEARCH_POPULATION       (10 * SEARCH_GAINS)
+#define SEARCH_GENERATIONS      60
+#define SEARCH_DE_WEIGHT        0.6         // Differential weight of a mutation
+#define SEARCH_DE_CROSSOVER     0.8         // Chance each gain comes from the mutant
+#define SEARCH_SEEDS            2           // ADC noise seeds each candidate is flown with
+#define SEARCH_RUNNERS_UP       4           // Gain sets listed after the best
+#define SEARCH_MAX_THREADS      64
+
+#define SEARCH_PLANT_SUBSTEPS   4           // Plant integration steps per ms
+#define SEARCH_FLIGHT_MS        32000       // Length of each flight
+#define SEARCH_SETTLE_ALT       ALT_TOLERANCE
+#define SEARCH_SETTLE_YAW       YAW_TOLERANCE
+
+// Cost weights. Settling time in s, overshoot in % of the step, error as the IAE over the step size (s)
+// and effort in % duty change per s. The error term still ranks responses that never settle
+#define SEARCH_W_SETTLING       1.0
+#define SEARCH_W_OVERSHOOT      0.2
+#define SEARCH_W_ERROR          1.0
+#define SEARCH_W_EFFORT         0.05
+
+#define SEARCH_MS_PER_SECOND    1000.0
+
+
+/* ******************************************************
+ * One setpoint change in the flight.
+ * *****************************************************/
+typedef struct SearchSteps {
+    uint32_t    timeMs;
+    int32_t     altitude;
+    int32_t     yaw;
+    bool        isYaw;            // The axis whose response is scored
+} searchStep_t;
+
+/* ******************************************************
+ * A candidate set of gains and its score.
+ * *****************************************************/
+typedef struct Candidates {
+    int32_t     gains[SEARCH_GAINS];
+    double      cost;
+} candidate_t;
+
+/* ******************************************************
+ * Yaw rate estimate made from the encoder edges, with the
+ * state updateYawRate keeps for the firmware.
+ * *****************************************************/
+typedef struct EdgeRates {
+    int32_t     slot;             // Encoder position at the newest edge
+    double      edgeTime;         // Time of the newest edge (s)
+    bool        newEdge;          // An edge has arrived since the last estimate
+    int32_t     lastSlot;         // Encoder position at the last edge used by an estimate
+    double      lastEdgeTime;     // Time of that edge (s)
+    bool        stale;            // The last edge is too old to measure a period from
+    int32_t     rate;             // Yaw rate in degrees per second (Q16)
+} edgeRate_t;
+
+/* ******************************************************
+ * Jobs left for one worker. The owner takes from the head,
+ * thieves take from the tail.
+ * *****************************************************/
+typedef struct WorkQueues {
+    pthread_mutex_t lock;
+    int32_t     head;
+    int32_t     tail;
+} workQueue_t;
+
+/* ******************************************************
+ * The thread pool. Each batch is a set of candidates to score.
+ * *****************************************************/
+typedef struct WorkerPools {
+    pthread_t   threads[SEARCH_MAX_THREADS];
+    workQueue_t queues[SEARCH_MAX_THREADS];
+    uint32_t    threadCount;
+    pthread_mutex_t lock;
+    pthread_cond_t batchReady;
+    pthread_cond_t batchDone;
+    uint32_t    batch;            // Incremented for every new batch
+    int32_t     pending;          // Jobs of the batch not yet finished
+    bool        shutdown;
+    candidate_t* jobs;
+} workerPool_t;
+
+/* ******************************************************
+ * Argument of a worker thread.
+ * *****************************************************/
+typedef struct Workers {
+    workerPool_t* pool;
+    uint32_t    index;
+} worker_t;
+
+// The flips are short of 180 degrees so the short way round, and so the direction scored, is clear
+static const searchStep_t g_steps[] = {
+    {     0, TAKEOFF_ALT,    0, false },  // Takeoff
+    {  8000, TAKEOFF_ALT, -170, true  },  // Flip
+    { 16000,          40, -170, false },  // Climb
+    { 24000,          40,    0, true  },  // Flip back
+};
+#define SEARCH_STEP_COUNT       (sizeof(g_steps) / sizeof(g_steps[0]))
+
+static const char* g_gainNames[SEARCH_GAINS] = { "ALT_KP", "ALT_KI", "ALT_KD", "YAW_KP", "YAW_KI", "YAW_KD" };
+static const int32_t g_gainMin[SEARCH_GAINS] = {   0,   0,  0,   0,  0,  0 };
+static const int32_t g_gainMax[SEARCH_GAINS] = { 200, 150, 100, 150, 100, 40 };
+static const int32_t g_currentGains[SEARCH_GAINS] = { ALT_KP, ALT_KI, ALT_KD, YAW_KP, YAW_KI, YAW_KD };
+
+
+TickType_t
+xTaskGetTickCount(void)
+{
+    return 0;
+}
+
+
+/*
+ * Function:    wrapDegrees
+ * -------------------------
+ * Wraps an angle to -180 to 180 degrees.
+ *
+ * @params:
+ *      - double angle: Degrees.
+ * @return:
+ *      - double angle: The wrapped angle.
+ * ---------------------
+ */
+static double
+wrapDegrees(double angle)
+{
+    return angle - DEGREES_CIRCLE * floor((angle + DEGREES_HALF_CIRCLE) / DEGREES_CIRCLE);
+}
+
+
+/*
+ * Function:    measureYaw
+ * ------------------------
+ * Converts an encoder position to degrees as getYaw does.
+ *
+ * @params:
+ *      - int32_t slot: Encoder position from the reference.
+ * @return:
+ *      - int32_t yaw: -180 to 179 degrees.
+ * ---------------------
+ */
+static int32_t
+measureYaw(int32_t slot)
+{
+    int32_t yaw = slot % MAX_YAW_SLOTS;
+
+    if (yaw < 0) {
+        yaw += MAX_YAW_SLOTS;
+    }
+    yaw = yaw * DEGREES_CIRCLE / MAX_YAW_SLOTS;
+    if (yaw > MAX_YAW_LIMIT) {
+        yaw -= DEGREES_CIRCLE;
+    }
+    return yaw;
+}
+
+
+/*
+ * Function:    slotsToRate
+ * -------------------------
+ * Converts slots travelled over a time to a yaw rate.
+ *
+ * @params:
+ *      - int32_t slots: Net slots travelled.
+ *      - double elapsed: Time taken (s).
+ * @return:
+ *      - int32_t rate: Yaw rate in degrees per second (Q16).
+ * ---------------------
+ */
+static int32_t
+slotsToRate(int32_t slots, double elapsed)
+{
+    return (int32_t) (slots * DEGREES_CIRCLE * (double) (1 << YAW_RATE_Q_BITS) / (MAX_YAW_SLOTS * elapsed));
+}
+
+
+/*
+ * Function:    recordEdges
+ * -------------------------
+ * Records an encoder edge if the plant has moved to another slot
+ * since the last call.
+ *
+ * @params:
+ *      - edgeRate_t* estimate: The rate estimate.
+ *      - int32_t slot: Encoder position now.
+ *      - double now: Time now (s).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+recordEdges(edgeRate_t* estimate, int32_t slot, double now)
+{
+    if (slot != estimate->slot) {
+        estimate->slot = slot;
+        estimate->edgeTime = now;
+        estimate->newEdge = true;
+    }
+}
+
+
+/*
+ * Function:    updateEdgeRate
+ * ----------------------------
+ * Updates the yaw rate estimate from the recorded edges, the
+ * same way updateYawRate does. The rate is the net slots
+ * travelled between the newest edges of this and the last
+ * estimate over the time between them. Without new edges it is
+ * limited to one slot over the time since the last edge, and
+ * reads zero after YAW_RATE_TIMEOUT_MS.
+ *
+ * @params:
+ *      - edgeRate_t* estimate: The rate estimate.
+ *      - double now: Time now (s).
+ * @return:
+ *      - int32_t rate: Yaw rate in degrees per second (Q16).
+ * ---------------------
+ */
+static int32_t
+updateEdgeRate(edgeRate_t* estimate, double now)
+{
+    double elapsed;
+    int32_t limit;
+
+    if (estimate->newEdge) {
+        elapsed = estimate->edgeTime - estimate->lastEdgeTime;
+        if (estimate->stale || elapsed <= 0.0) {
+            estimate->rate = 0;                                     // First edge after a stop only starts the period
+        } else {
+            estimate->rate = slotsToRate(estimate->slot - estimate->lastSlot, elapsed);
+        }
+        estimate->lastSlot = estimate->slot;
+        estimate->lastEdgeTime = estimate->edgeTime;
+        estimate->newEdge = false;
+        estimate->stale = false;
+    } else if (!estimate->stale) {
+        elapsed = now - estimate->lastEdgeTime;
+        if (elapsed > YAW_RATE_TIMEOUT_MS / SEARCH_MS_PER_SECOND) {
+            estimate->rate = 0;
+            estimate->stale = true;
+        } else if (elapsed > 0.0) {
+            limit = slotsToRate(1, elapsed);                        // Fastest rate consistent with no edge since
+            if (estimate->rate > limit) {
+                estimate->rate = limit;
+            } else if (estimate->rate < -limit) {
+                estimate->rate = -limit;
+            }
+        }
+    }
+
+    return estimate->rate;
+}
+
+
+/*
+ * Function:    flyCandidate
+ * --------------------------
+ * Flies the search profile once with a set of gains and returns
+ * its cost. Only touches its own state, so any number can run at
+ * once.
+ *
+ * @params:
+ *      - const int32_t* gains: The gains, in the order of g_gainNames.
+ *      - uint32_t seed: Seed of the ADC noise.
+ * @return:
+ *      - double cost: Weighted settling time, overshoot, error and effort.
+ * ---------------------
+ */
+static double
+flyCandidate(const int32_t* gains, uint32_t seed)
+{
+    heliPlant_t plant;
+    controller_t altController;
+    controller_t yawController;
+    trajectory_t altTrajectory;
+    trajectory_t yawTrajectory;
+    observer_t observer;
+    edgeRate_t yawRate;
+    uint16_t window[ALT_FILTER_WINDOW];
+    int32_t windowSum = 0;
+    int32_t ground;
+    int32_t altMeasured = 0;
+    int32_t altReference;
+    int32_t yawMeasured;
+    int32_t yawReference;
+    int32_t altDuty = MIN_DUTY;
+    int32_t yawDuty = MIN_DUTY;
+    int32_t previousAltDuty = MIN_DUTY;
+    int32_t previousYawDuty = MIN_DUTY;
+    uint32_t stepIndex = 0;
+    const searchStep_t* step = &g_steps[0];
+    double stepStart = 0.0;
+    double stepTarget = 0.0;
+    double value;
+    double error;
+    double size;
+    double peak = 0.0;
+    uint32_t lastOutsideMs = 0;
+    double settling = 0.0;
+    double overshoot = 0.0;
+    double absError = 0.0;
+    double effort = 0.0;
+    double dt = 1.0 / SEARCH_MS_PER_SECOND / SEARCH_PLANT_SUBSTEPS;
+    uint32_t nowMs;
+    uint32_t i;
+
+    initHeliPlant(&plant, seed);
+    plant.yaw = 0.0; // Start over the reference, as the firmware does once it has found it
+
+    // Find the ground the way updateAltitude does, from a full window at rest
+    for (i = 0; i < ALT_FILTER_WINDOW; i++) {
+        window[i] = readHeliADC(&plant);
+        windowSum += window[i];
+    }
+    ground = windowSum / ALT_FILTER_WINDOW;
+
+    initController(&altController, false);
+    initController(&yawController, true);
+    altController.Kp = gains[0];
+    altController.Ki = gains[1];
+    altController.Kd = gains[2];
+    yawController.Kp = gains[3];
+    yawController.Ki = gains[4];
+    yawController.Kd = gains[5];
+    updateControllerGains(&altController);
+    updateControllerGains(&yawController);
+    setControllerFeedforward(&altController, getHoverFeedforward());
+    initTrajectory(&altTrajectory, ALT_TRAJ_MAX_RATE, ALT_TRAJ_MAX_ACCEL, false);
+    initTrajectory(&yawTrajectory, YAW_TRAJ_MAX_RATE, YAW_TRAJ_MAX_ACCEL, true);
+    initObserver(&observer, ALT_OBSERVER_ALPHA, ALT_OBSERVER_BETA, CONTROL_PERIOD);
+    memset(&yawRate, 0, sizeof(yawRate));
+    yawRate.slot = getHeliEncoderSlot(&plant);
+    yawRate.stale = true;
+
+    for (nowMs = 0; nowMs < SEARCH_FLIGHT_MS; nowMs++) {
+        // Next setpoint change. Score the last one up to here
+        if (stepIndex < SEARCH_STEP_COUNT && nowMs == g_steps[stepIndex].timeMs) {
+            if (stepIndex > 0) {
+                settling += (lastOutsideMs - step->timeMs) / SEARCH_MS_PER_SECOND;
+                overshoot += (peak > 1.0) ? (peak - 1.0) * 100.0 : 0.0;
+            }
+            step = &g_steps[stepIndex++];
+            stepStart = step->isYaw ? plant.yaw : plant.altitude;
+            stepTarget = step->isYaw ? stepStart + wrapDegrees(step->yaw - stepStart) : step->altitude;
+            peak = 0.0;
+            lastOutsideMs = nowMs;
+        }
+
+        // Controllers, run every control period as the control executive runs updateMainDuty then updateTailDuty
+        if (nowMs % CONTROL_PERIOD == 0) {
+            updateObserver(&observer, (int32_t) (((int64_t) HUNDRED_PERCENT * OBSERVER_Q_ONE *
+                                                 (ground - windowSum / ALT_FILTER_WINDOW)) / VOLTAGE_DROP_ADC));
+            altMeasured = (observer.position + OBSERVER_Q_ONE / 2) >> OBSERVER_Q_BITS;
+
+            altReference = updateTrajectory(&altTrajectory, step->altitude, altMeasured, CONTROL_PERIOD);
+            scheduleAltitudeGains(&altController, altMeasured);
+            altDuty = getControlSignalWithRate(&altController, altReference, getTrajectoryRate(&altTrajectory),
+                                               altMeasured, observer.velocity, false);
+
+            setControllerFeedforward(&yawController, getCouplingFeedforward(altDuty));
+            yawMeasured = measureYaw(getHeliEncoderSlot(&plant));
+            yawReference = updateTrajectory(&yawTrajectory, step->yaw, yawMeasured, CONTROL_PERIOD);
+            yawDuty = getControlSignalWithRate(&yawController, yawReference, getTrajectoryRate(&yawTrajectory),
+                                               yawMeasured, updateEdgeRate(&yawRate, nowMs / SEARCH_MS_PER_SECOND),
+                                               true);
+
+            effort += abs(altDuty - previousAltDuty) + abs(yawDuty - previousYawDuty);
+            previousAltDuty = altDuty;
+            previousYawDuty = yawDuty;
+        }
+
+        // Plant, then one ADC sample into the window
+        for (i = 0; i < SEARCH_PLANT_SUBSTEPS; i++) {
+            stepHeliPlant(&plant, altDuty / 100.0, yawDuty / 100.0, dt);
+            recordEdges(&yawRate, getHeliEncoderSlot(&plant), nowMs / SEARCH_MS_PER_SECOND + (i + 1) * dt);
+        }
+        windowSum -= window[nowMs % ALT_FILTER_WINDOW];
+        window[nowMs % ALT_FILTER_WINDOW] = readHeliADC(&plant);
+        windowSum += window[nowMs % ALT_FILTER_WINDOW];
+
+        // Score the response of the axis that stepped
+        value = step->isYaw ? plant.yaw : plant.altitude;
+        size = stepTarget - stepStart;
+        error = stepTarget - value;
+        if (size != 0.0) {
+            if ((value - stepStart) / size > peak) {
+                peak = (value - stepStart) / size;
+            }
+            absError += fabs(error / size) / SEARCH_MS_PER_SECOND;
+        }
+        if (fabs(error) > (step->isYaw ? SEARCH_SETTLE_YAW : SEARCH_SETTLE_ALT)) {
+            lastOutsideMs = nowMs + 1;
+        }
+    }
+    settling += (lastOutsideMs - step->timeMs) / SEARCH_MS_PER_SECOND;
+    overshoot += (peak > 1.0) ? (peak - 1.0) * 100.0 : 0.0;
+
+    return SEARCH_W_SETTLING * settling + SEARCH_W_OVERSHOOT * overshoot + SEARCH_W_ERROR * absError
+           + SEARCH_W_EFFORT * effort / (SEARCH_FLIGHT_MS / SEARCH_MS_PER_SECOND);
+}
+
+
+/*
+ * Function:    scoreCandidate
+ * ----------------------------
+ * Sets the cost of a candidate to its mean over the noise seeds.
+ *
+ * @params:
+ *      - candidate_t* candidate: The candidate to score.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+scoreCandidate(candidate_t* candidate)
+{
+    double cost = 0.0;
+    uint32_t seed;
+
+    for (seed = 1; seed <= SEARCH_SEEDS; seed++) {
+        cost += flyCandidate(candidate->gains, seed);
+    }
+    candidate->cost = cost / SEARCH_SEEDS;
+}
+
+
+/*
+ * Function:    getQueueLength
+ * ----------------------------
+ * Returns the number of jobs left in a queue, read under its
+ * lock as the owner and thieves move its ends concurrently.
+ *
+ * @params:
+ *      - workQueue_t* queue: The queue.
+ * @return:
+ *      - int32_t length: Jobs left in the queue.
+ * ---------------------
+ */
+static int32_t
+getQueueLength(workQueue_t* queue)
+{
+    int32_t length;
+
+    pthread_mutex_lock(&queue->lock);
+    length = queue->tail - queue->head;
+    pthread_mutex_unlock(&queue->lock);
+    return length;
+}
+
+
+/*
+ * Function:    takeJob
+ * ---------------------
+ * Takes the next job for a worker: the head of its own queue, or
+ * when that is empty the tail of the fullest other queue.
+ *
+ * @params:
+ *      - workerPool_t* pool: The pool.
+ *      - uint32_t self: Index of the worker.
+ * @return:
+ *      - int32_t job: Index of the job, or -1 if none are left.
+ * ---------------------
+ */
+static int32_t
+takeJob(workerPool_t* pool, uint32_t self)
+{
+    workQueue_t* own = &pool->queues[self];
+    workQueue_t* victim;
+    int32_t job = -1;
+    int32_t most;
+    int32_t length;
+    uint32_t i;
+
+    pthread_mutex_lock(&own->lock);
+    if (own->head < own->tail) {
+        job = own->head++;
+    }
+    pthread_mutex_unlock(&own->lock);
+
+    while (job < 0) {
+        // Pick the victim with the most left. The counts may change before it is locked, so check again
+        victim = NULL;
+        most = 0;
+        for (i = 0; i < pool->threadCount; i++) {
+            if (i == self) {
+                continue;
+            }
+            length = getQueueLength(&pool->queues[i]);
+            if (length > most) {
+                most = length;
+                victim = &pool->queues[i];
+            }
+        }
+        if (victim == NULL) {
+            break;
+        }
+        pthread_mutex_lock(&victim->lock);
+        if (victim->head < victim->tail) {
+            job = --victim->tail;
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+    return job;
+}
+
+
+/*
+ * Function:    workerThread
+ * --------------------------
+ * Scores jobs from each batch until the pool shuts down.
+ *
+ * @params:
+ *      - void* argument: The worker_t of this thread.
+ * @return:
+ *      - void* NULL
+ * ---------------------
+ */
+static void*
+workerThread(void* argument)
+{
+    worker_t* worker = (worker_t*) argument;
+    workerPool_t* pool = worker->pool;
+    uint32_t seenBatch = 0;
+    int32_t job;
+
+    while (1) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->batch == seenBatch && !pool->shutdown) {
+            pthread_cond_wait(&pool->batchReady, &pool->lock);
+        }
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seenBatch = pool->batch;
+        pthread_mutex_unlock(&pool->lock);
+
+        while ((job = takeJob(pool, worker->index)) >= 0) {
+            scoreCandidate(&pool->jobs[job]);
+
+            pthread_mutex_lock(&pool->lock);
+            if (--pool->pending == 0) {
+                pthread_cond_signal(&pool->batchDone);
+            }
+            pthread_mutex_unlock(&pool->lock);
+        }
+    }
+}
+
+
+/*
+ * Function:    startPool
+ * -----------------------
+ * Starts the worker threads of a pool.
+ *
+ * @params:
+ *      - workerPool_t* pool: The pool.
+ *      - worker_t* workers: Storage for the thread arguments.
+ *      - uint32_t threadCount: Number of workers.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+startPool(workerPool_t* pool, worker_t* workers, uint32_t threadCount)
+{
+    uint32_t i;
+
+    memset(pool, 0, sizeof(*pool));
+    pool->threadCount = threadCount;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->batchReady, NULL);
+    pthread_cond_init(&pool->batchDone, NULL);
+
+    for (i = 0; i < threadCount; i++) {
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+        workers[i].pool = pool;
+        workers[i].index = i;
+        pthread_create(&pool->threads[i], NULL, workerThread, &workers[i]);
+    }
+}
+
+
+/*
+ * Function:    stopPool
+ * ----------------------
+ * Stops and joins the worker threads of a pool.
+ *
+ * @params:
+ *      - workerPool_t* pool: The pool.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+stopPool(workerPool_t* pool)
+{
+    uint32_t i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->batchReady);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->threadCount; i++) {
+        pthread_join(pool->threads[i], NULL);
+        pthread_mutex_destroy(&pool->queues[i].lock);
+    }
+    pthread_cond_destroy(&pool->batchDone);
+    pthread_cond_destroy(&pool->batchReady);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+
+/*
+ * Function:    scoreBatch
+ * ------------------------
+ * Scores a batch of candidates on the pool and waits for them.
+ * The batch is dealt out to the workers in even runs, and workers
+ * that finish early steal from the others.
+ *
+ * @params:
+ *      - workerPool_t* pool: The pool.
+ *      - candidate_t* candidates: The candidates to score.
+ *      - int32_t count: Number of candidates.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+scoreBatch(workerPool_t* pool, candidate_t* candidates, int32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < pool->threadCount; i++) {
+        pthread_mutex_lock(&pool->queues[i].lock);
+        pool->queues[i].head = (int32_t) (count * i / pool->threadCount);
+        pool->queues[i].tail = (int32_t) (count * (i + 1) / pool->threadCount);
+        pthread_mutex_unlock(&pool->queues[i].lock);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->jobs = candidates;
+    pool->pending = count;
+    pool->batch++;
+    pthread_cond_broadcast(&pool->batchReady);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->batchDone, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+/*
+ * Function:    randomUnit
+ * ------------------------
+ * Returns a uniform random number from a xorshift generator.
+ *
+ * @params:
+ *      - uint64_t* state: The generator state. Must not be 0.
+ * @return:
+ *      - double random: 0 to 1, excluding 1.
+ * ---------------------
+ */
+static double
+randomUnit(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (*state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+/*
+ * Function:    clampGain
+ * -----------------------
+ * Rounds a gain and limits it to its search range.
+ *
+ * @params:
+ *      - double gain: The gain.
+ *      - uint32_t index: Which gain, in the order of g_gainNames.
+ * @return:
+ *      - int32_t gain: The rounded, limited gain.
+ * ---------------------
+ */
+static int32_t
+clampGain(double gain, uint32_t index)
+{
+    int32_t rounded = (int32_t) lround(gain);
+
+    if (rounded < g_gainMin[index]) {
+        rounded = g_gainMin[index];
+    } else if (rounded > g_gainMax[index]) {
+        rounded = g_gainMax[index];
+    }
+    return rounded;
+}
+
+
+/*
+ * Function:    compareCandidates
+ * -------------------------------
+ * Orders candidates by cost, cheapest first. For qsort.
+ *
+ * @params:
+ *      - const void* a: A candidate_t.
+ *      - const void* b: A candidate_t.
+ * @return:
+ *      - int order: Negative if a costs less than b.
+ * ---------------------
+ */
+static int
+compareCandidates(const void* a, const void* b)
+{
+    double difference = ((const candidate_t*) a)->cost - ((const candidate_t*) b)->cost;
+
+    return (difference > 0.0) - (difference < 0.0);
+}
+
+
+/*
+ * Function:    getSeconds
+ * ------------------------
+ * Returns the time from a monotonic clock.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - double seconds: The time (s).
+ * ---------------------
+ */
+static double
+getSeconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+/*
+ * Function:    search
+ * --------------------
+ * Runs differential evolution (rand/1/bin) over the gains. The
+ * current gains are part of the first generation, so the result
+ * is never worse than them. The trial sets are drawn in order
+ * before each generation is scored, so the result depends on the
+ * seed only, not on the number of threads.
+ *
+ * @params:
+ *      - workerPool_t* pool: The pool to score on.
+ *      - candidate_t* population: Filled with the final generation,
+ *      cheapest first.
+ *      - uint32_t generations: Number of generations.
+ *      - uint64_t seed: Seed of the search.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+search(workerPool_t* pool, candidate_t* population, uint32_t generations, uint64_t seed)
+{
+    static candidate_t trials[SEARCH_POPULATION];
+    uint64_t state = seed * 0x9E3779B97F4A7C15ull + 1;
+    uint32_t generation;
+    uint32_t i;
+    uint32_t j;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+    uint32_t forced;
+    double mutant;
+
+    // First generation: the current gains, then random sets across the ranges
+    memcpy(population[0].gains, g_currentGains, sizeof(g_currentGains));
+    for (i = 1; i < SEARCH_POPULATION; i++) {
+        for (j = 0; j < SEARCH_GAINS; j++) {
+            population[i].gains[j] = clampGain(g_gainMin[j] + randomUnit(&state) * (g_gainMax[j] - g_gainMin[j]), j);
+        }
+    }
+    scoreBatch(pool, population, SEARCH_POPULATION);
+    printf("current gains cost %.3f\n", population[0].cost);
+
+    for (generation = 1; generation <= generations; generation++) {
+        for (i = 0; i < SEARCH_POPULATION; i++) {
+            // Three other members, all different
+            do { a = (uint32_t) (randomUnit(&state) * SEARCH_POPULATION); } while (a == i);
+            do { b = (uint32_t) (randomUnit(&state) * SEARCH_POPULATION); } while (b == i || b == a);
+            do { c = (uint32_t) (randomUnit(&state) * SEARCH_POPULATION); } while (c == i || c == a || c == b);
+            forced = (uint32_t) (randomUnit(&state) * SEARCH_GAINS); // At least one gain comes from the mutant
+
+            for (j = 0; j < SEARCH_GAINS; j++) {
+                if (j == forced || randomUnit(&state) < SEARCH_DE_CROSSOVER) {
+                    mutant = population[a].gains[j] +
+                             SEARCH_DE_WEIGHT * (population[b].gains[j] - population[c].gains[j]);
+                    trials[i].gains[j] = clampGain(mutant, j);
+                } else {
+                    trials[i].gains[j] = population[i].gains[j];
+                }
+            }
+        }
+        scoreBatch(pool, trials, SEARCH_POPULATION);
+
+        for (i = 0; i < SEARCH_POPULATION; i++) {
+            if (trials[i].cost <= population[i].cost) {
+                population[i] = trials[i];
+            }
+        }
+
+        qsort(population, SEARCH_POPULATION, sizeof(candidate_t), compareCandidates);
+        printf("generation %3u best %.3f:", generation, population[0].cost);
+        for (j = 0; j < SEARCH_GAINS; j++) {
+            printf(" %d", (int) population[0].gains[j]);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+}
+
+
+/*
+ * Function:    writeGains
+ * ------------------------
+ * Writes the best gains in the form of pidGains.h, with the
+ * runners up as comments. The feedforward gains are carried over
+ * unchanged.
+ *
+ * @params:
+ *      - FILE* file: Where to write.
+ *      - const candidate_t* population: Candidates, cheapest first.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+writeGains(FILE* file, const candidate_t* population)
+{
+    const int32_t* best = population[0].gains;
+    uint32_t i;
+    uint32_t j;
+
+    fprintf(file,
+            "/* ****************************************************************\n"
+            " * pidGains.h\n"
+            " *\n"
+            " * Gains of the altitude and yaw controllers. Kept apart from\n"
+            " * pidController.h so the gain search in sim/ can write a tuned\n"
+            " * set straight over this file.\n"
+            " *\n"
+            " * Written by sim/gainSearch with a cost of %.3f. Check them\n"
+            " * with sim/heliSim before flying.\n"
+            " *\n"
+            " * ENCE464 Assignment 1 Group 2\n"
+            " * Creators: Grayson Mynott      56353855\n"
+            " *           Ryan Earwaker       12832870\n"
+            " *           Matt Blake          58979250\n"
+            " * Last modified: 19/08/2020\n"
+            " *\n"
+            " * ***************************************************************/\n"
+            "\n"
+            "#ifndef PIDGAINS_H_\n"
+            "#define PIDGAINS_H_\n"
+            "\n", population[0].cost);
+    fprintf(file, "#define ALT_KP              %-11d // Altitude proportional gain\n", (int) best[0]);
+    fprintf(file, "#define ALT_KI              %-11d // Altitude integral gain\n", (int) best[1]);
+    fprintf(file, "#define ALT_KD              %-11d // Altitude derivative gain\n", (int) best[2]);
+    fprintf(file, "#define ALT_KFF             %-11d // Altitude reference rate feedforward gain\n", ALT_KFF);
+    fprintf(file, "\n");
+    fprintf(file, "#define YAW_KP              %-11d // Yaw proportional gain\n", (int) best[3]);
+    fprintf(file, "#define YAW_KI              %-11d // Yaw integral gain\n", (int) best[4]);
+    fprintf(file, "#define YAW_KD              %-11d // Yaw derivative gain\n", (int) best[5]);
+    fprintf(file, "#define YAW_KFF             %-11d // Yaw reference rate feedforward gain\n", YAW_KFF);
+    fprintf(file, "\n// Runners up (cost:");
+    for (j = 0; j < SEARCH_GAINS; j++) {
+        fprintf(file, " %s", g_gainNames[j]);
+    }
+    fprintf(file, ")\n");
+    for (i = 1; i <= SEARCH_RUNNERS_UP && i < SEARCH_POPULATION; i++) {
+        fprintf(file, "//  %.3f:", population[i].cost);
+        for (j = 0; j < SEARCH_GAINS; j++) {
+            fprintf(file, " %d", (int) population[i].gains[j]);
+        }
+        fprintf(file, "\n");
+    }
+    fprintf(file, "\n#endif /* PIDGAINS_H_ */\n");
+}
+
+
+/*
+ * Function:    benchmark
+ * -----------------------
+ * Scores the same batch with 1, 2, 4 and so on up to a number of
+ * threads, and prints the throughput and speed-up of each.
+ *
+ * @params:
+ *      - uint32_t maxThreads: Largest number of threads to try.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+benchmark(uint32_t maxThreads)
+{
+    static candidate_t batch[SEARCH_POPULATION * 2];
+    static worker_t workers[SEARCH_MAX_THREADS];
+    workerPool_t pool;
+    uint64_t state = 1;
+    uint32_t threads = 1;
+    double start;
+    double rate;
+    double baseRate = 0.0;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i < SEARCH_POPULATION * 2; i++) {
+        for (j = 0; j < SEARCH_GAINS; j++) {
+            batch[i].gains[j] = clampGain(g_gainMin[j] + randomUnit(&state) * (g_gainMax[j] - g_gainMin[j]), j);
+        }
+    }
+
+    while (1) {
+        startPool(&pool, workers, threads);
+        start = getSeconds();
+        scoreBatch(&pool, batch, SEARCH_POPULATION * 2);
+        rate = SEARCH_POPULATION * 2 * SEARCH_SEEDS / (getSeconds() - start);
+        stopPool(&pool);
+
+        if (threads == 1) {
+            baseRate = rate;
+        }
+        printf("%2u threads: %7.0f flights/s, %5.2fx\n", threads, rate, rate / baseRate);
+        if (threads == maxThreads) {
+            break;
+        }
+        threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads;
+    }
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    static candidate_t population[SEARCH_POPULATION];
+    static worker_t workers[SEARCH_MAX_THREADS];
+    workerPool_t pool;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t threads = (cores > 0) ? (uint32_t) cores : 1;
+    uint32_t generations = SEARCH_GENERATIONS;
+    uint64_t seed = 1;
+    const char* outputPath = NULL;
+    bool runBenchmark = false;
+    FILE* output;
+    double start;
+    int option;
+
+    while ((option = getopt(argc, argv, "j:g:s:o:b")) != -1) {
+        switch (option) {
+            case 'j':
+                threads = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'g':
+                generations = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                seed = strtoull(optarg, NULL, 0);
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            case 'b':
+                runBenchmark = true;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-j threads] [-g generations] [-s seed] [-o pidGains.h] [-b]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    } else if (threads > SEARCH_MAX_THREADS) {
+        threads = SEARCH_MAX_THREADS;
+    }
+
+    if (runBenchmark) {
+        benchmark(threads);
+        return EXIT_SUCCESS;
+    }
+
+    startPool(&pool, workers, threads);
+    start = getSeconds();
+    search(&pool, population, generations, seed);
+    printf("%u flights on %u threads in %.1f s\n", (unsigned) ((generations + 1) * SEARCH_POPULATION * SEARCH_SEEDS),
+           (unsigned) threads, getSeconds() - start);
+    stopPool(&pool);
+
+    if (outputPath != NULL) {
+        output = fopen(outputPath, "w");
+        if (output == NULL) {
+            perror(outputPath);
+            return EXIT_FAILURE;
+        }
+        writeGains(output, population);
+        fclose(output);
+        printf("wrote %s\n", outputPath);
+    } else {
+        printf("\n");
+        writeGains(stdout, population);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,245 @@
+/* ****************************************************************
+ * heliPlant.c
+ *
+ * Source file of the HeliRig plant model.
+ * Models the helicopter on its stand: the rotor speeds lag the
+ * PWM duty cycles, the main rotor lifts against gravity and its
+ * torque spins the body against the tail rotor. The sensors are
+ * modelled as the firmware sees them: a quantised, noisy ADC
+ * voltage for altitude and a 448 slot quadrature encoder with a
+ * reference mark for yaw.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <math.h>
+#include "heliPlant.h"
+#include "ADC.h"
+
+#define PLANT_DEGREES_CIRCLE    360.0
+#define PLANT_ALT_MAX           100.0       // Top of the rig's travel (%)
+
+// Channel levels for each position within a cycle of four transitions. Counts up through the
+// firmware's quadrature table (00, 10, 11, 01 as B then A)
+static const uint8_t g_encoderPhases[4] = {0x0, 0x2, 0x3, 0x1};
+
+
+/*
+ * Function:    noise
+ * -------------------
+ * Returns a triangular distributed integer from a linear
+ * congruential generator, so every run with a seed is identical.
+ *
+ * @params:
+ *      - heliPlant_t* plant: The rig, holding the generator state.
+ * @return:
+ *      - int32_t noise: -PLANT_ADC_NOISE to PLANT_ADC_NOISE.
+ * ---------------------
+ */
+static int32_t
+noise(heliPlant_t* plant)
+{
+    int32_t sum = 0;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        plant->noiseState = plant->noiseState * 1664525u + 1013904223u;
+        sum += (int32_t) ((plant->noiseState >> 16) % (PLANT_ADC_NOISE + 1));
+    }
+    return sum - PLANT_ADC_NOISE;
+}
+
+
+/*
+ * Function:    clampDuty
+ * -----------------------
+ * Limits a duty cycle to 0 to 1.
+ *
+ * @params:
+ *      - double duty: The duty cycle.
+ * @return:
+ *      - double duty: The limited duty cycle.
+ * ---------------------
+ */
+static double
+clampDuty(double duty)
+{
+    return (duty < 0.0) ? 0.0 : (duty > 1.0) ? 1.0 : duty;
+}
+
+
+/*
+ * Function:    initHeliPlant
+ * ---------------------------
+ * Puts the rig at rest on the ground.
+ *
+ * @params:
+ *      - heliPlant_t* plant: The rig.
+ *      - uint32_t seed: Seed of the ADC noise.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initHeliPlant(heliPlant_t* plant, uint32_t seed)
+{
+    plant->mainSpeed = 0.0;
+    plant->tailSpeed = 0.0;
+    plant->altitude = 0.0;
+    plant->climbRate = 0.0;
+    plant->yaw = PLANT_YAW_START;
+    plant->yawRate = 0.0;
+    plant->noiseState = seed;
+}
+
+
+/*
+ * Function:    stepHeliPlant
+ * ---------------------------
+ * Advances the rig by one integration step.
+ *
+ * @params:
+ *      - heliPlant_t* plant: The rig.
+ *      - double mainDuty: Main rotor duty (0 to 1).
+ *      - double tailDuty: Tail rotor duty (0 to 1).
+ *      - double dt: Step length (s).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+stepHeliPlant(heliPlant_t* plant, double mainDuty, double tailDuty, double dt)
+{
+    double climbAccel;
+    double yawAccel;
+    double friction;
+
+    plant->mainSpeed += (clampDuty(mainDuty) - plant->mainSpeed) * dt / PLANT_MAIN_LAG;
+    plant->tailSpeed += (clampDuty(tailDuty) - plant->tailSpeed) * dt / PLANT_TAIL_LAG;
+
+    // Altitude. The stand stops the body at the ground and at the top of its travel
+    climbAccel = PLANT_LIFT_GAIN * (plant->mainSpeed - PLANT_HOVER_SPEED) - PLANT_CLIMB_DAMPING * plant->climbRate;
+    plant->climbRate += climbAccel * dt;
+    plant->altitude += plant->climbRate * dt;
+    if (plant->altitude <= 0.0) {
+        plant->altitude = 0.0;
+        if (plant->climbRate < 0.0) {
+            plant->climbRate = 0.0;
+        }
+    } else if (plant->altitude >= PLANT_ALT_MAX) {
+        plant->altitude = PLANT_ALT_MAX;
+        if (plant->climbRate > 0.0) {
+            plant->climbRate = 0.0;
+        }
+    }
+
+    // Yaw. The tail pushes the body round one way and the main rotor's torque the other
+    yawAccel = PLANT_TAIL_GAIN * plant->tailSpeed - PLANT_COUPLING_GAIN * plant->mainSpeed
+               - PLANT_YAW_DAMPING * plant->yawRate;
+
+    // Dry friction opposes the motion, or holds the body still if the torque is too small to break it away
+    friction = PLANT_YAW_FRICTION * dt;
+    if (plant->yawRate > friction) {
+        yawAccel -= PLANT_YAW_FRICTION;
+    } else if (plant->yawRate < -friction) {
+        yawAccel += PLANT_YAW_FRICTION;
+    } else if (fabs(yawAccel) <= PLANT_YAW_FRICTION) {
+        yawAccel = 0.0;
+        plant->yawRate = 0.0;
+    } else {
+        yawAccel -= copysign(PLANT_YAW_FRICTION, yawAccel);
+    }
+    plant->yawRate += yawAccel * dt;
+    plant->yaw += plant->yawRate * dt;
+}
+
+
+/*
+ * Function:    readHeliADC
+ * -------------------------
+ * Returns the ADC result for the current altitude, with noise.
+ *
+ * @params:
+ *      - heliPlant_t* plant: The rig.
+ * @return:
+ *      - uint16_t result: 12-bit ADC result.
+ * ---------------------
+ */
+uint16_t
+readHeliADC(heliPlant_t* plant)
+{
+    int32_t result = (int32_t) lround(PLANT_ADC_GROUND - plant->altitude * VOLTAGE_DROP_ADC / PLANT_ALT_MAX)
+                     + noise(plant);
+
+    if (result < 0) {
+        result = 0;
+    } else if (result > PLANT_ADC_MAX) {
+        result = PLANT_ADC_MAX;
+    }
+    return (uint16_t) result;
+}
+
+
+/*
+ * Function:    getHeliEncoderSlot
+ * --------------------------------
+ * Returns the encoder position as a count of transitions.
+ *
+ * @params:
+ *      - const heliPlant_t* plant: The rig.
+ * @return:
+ *      - int32_t slot: Transitions from the reference mark.
+ * ---------------------
+ */
+int32_t
+getHeliEncoderSlot(const heliPlant_t* plant)
+{
+    return (int32_t) floor(plant->yaw * PLANT_ENCODER_SLOTS / PLANT_DEGREES_CIRCLE);
+}
+
+
+/*
+ * Function:    getHeliEncoderPhases
+ * ----------------------------------
+ * Returns the levels of the encoder channels at a position.
+ *
+ * @params:
+ *      - int32_t slot: Encoder position.
+ * @return:
+ *      - uint8_t phases: Channel A in bit 0, channel B in bit 1.
+ * ---------------------
+ */
+uint8_t
+getHeliEncoderPhases(int32_t slot)
+{
+    return g_encoderPhases[slot & 3];
+}
+
+
+/*
+ * Function:    isHeliAtReference
+ * -------------------------------
+ * Returns whether an encoder position is over the reference mark,
+ * where the active low reference pin reads low.
+ *
+ * @params:
+ *      - int32_t slot: Encoder position.
+ * @return:
+ *      - bool atReference: True over the mark.
+ * ---------------------
+ */
+bool
+isHeliAtReference(int32_t slot)
+{
+    int32_t offset = slot % PLANT_ENCODER_SLOTS;
+
+    if (offset < 0) {
+        offset += PLANT_ENCODER_SLOTS;
+    }
+    return (offset <= PLANT_REFERENCE_WIDTH) || (offset >= PLANT_ENCODER_SLOTS - PLANT_REFERENCE_WIDTH);
+}
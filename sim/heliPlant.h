@@ -0,0 +1,147 @@
+/* ****************************************************************
+ * heliPlant.h
+ *
+ * Header file of the HeliRig plant model.
+ * Models the helicopter on its stand: the rotor speeds lag the
+ * PWM duty cycles, the main rotor lifts against gravity and its
+ * torque spins the body against the tail rotor. The sensors are
+ * modelled as the firmware sees them: a quantised, noisy ADC
+ * voltage for altitude and a 448 slot quadrature encoder with a
+ * reference mark for yaw.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef HELIPLANT_H_
+#define HELIPLANT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Rotors
+#define PLANT_MAIN_LAG          0.25        // Main rotor speed time constant (s)
+#define PLANT_TAIL_LAG          0.08        // Tail rotor speed time constant (s)
+
+// Altitude (% of the rig's travel)
+#define PLANT_HOVER_SPEED       0.36        // Main rotor speed that holds the weight. The firmware feeds forward 30 %
+#define PLANT_LIFT_GAIN         400.0       // Climb acceleration per unit of main rotor speed over hover (%/s^2)
+#define PLANT_CLIMB_DAMPING     2.0         // Drag on the climb rate (1/s)
+
+// Yaw (degrees)
+#define PLANT_TAIL_GAIN         900.0       // Yaw acceleration per unit of tail rotor speed (deg/s^2)
+#define PLANT_COUPLING_GAIN     600.0       // Yaw deceleration per unit of main rotor speed, from its torque (deg/s^2)
+#define PLANT_YAW_DAMPING       3.0         // Drag on the yaw rate (1/s)
+#define PLANT_YAW_FRICTION      15.0        // Dry friction of the stand's bearing (deg/s^2)
+#define PLANT_YAW_START         100.0       // Yaw at power on, measured from the reference mark
+
+// Sensors
+#define PLANT_ADC_GROUND        2500        // ADC result on the ground
+#define PLANT_ADC_NOISE         4           // Peak ADC noise (counts, triangular)
+#define PLANT_ADC_MAX           4095
+#define PLANT_ENCODER_SLOTS     448         // Quadrature transitions per revolution
+#define PLANT_REFERENCE_WIDTH   2           // Slots either side of the mark where the reference pin reads low
+
+
+/* ******************************************************
+ * State of the rig.
+ * *****************************************************/
+typedef struct HeliPlants {
+    double      mainSpeed;        // Main rotor speed (fraction of full)
+    double      tailSpeed;        // Tail rotor speed (fraction of full)
+    double      altitude;         // % of travel, 0 on the ground
+    double      climbRate;        // %/s
+    double      yaw;              // Degrees from the reference mark, not wrapped
+    double      yawRate;          // deg/s
+    uint32_t    noiseState;       // ADC noise generator state
+} heliPlant_t;
+
+
+/*
+ * Function:    initHeliPlant
+ * ---------------------------
+ * Puts the rig at rest on the ground.
+ *
+ * @params:
+ *      - heliPlant_t* plant: The rig.
+ *      - uint32_t seed: Seed of the ADC noise.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initHeliPlant(heliPlant_t* plant, uint32_t seed);
+
+/*
+ * Function:    stepHeliPlant
+ * ---------------------------
+ * Advances the rig by one integration step.
+ *
+ * @params:
+ *      - heliPlant_t* plant: The rig.
+ *      - double mainDuty: Main rotor duty (0 to 1).
+ *      - double tailDuty: Tail rotor duty (0 to 1).
+ *      - double dt: Step length (s).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void stepHeliPlant(heliPlant_t* plant, double mainDuty, double tailDuty, double dt);
+
+/*
+ * Function:    readHeliADC
+ * -------------------------
+ * Returns the ADC result for the current altitude, with noise.
+ *
+ * @params:
+ *      - heliPlant_t* plant: The rig.
+ * @return:
+ *      - uint16_t result: 12-bit ADC result.
+ * ---------------------
+ */
+uint16_t readHeliADC(heliPlant_t* plant);
+
+/*
+ * Function:    getHeliEncoderSlot
+ * --------------------------------
+ * Returns the encoder position as a count of transitions.
+ *
+ * @params:
+ *      - const heliPlant_t* plant: The rig.
+ * @return:
+ *      - int32_t slot: Transitions from the reference mark.
+ * ---------------------
+ */
+int32_t getHeliEncoderSlot(const heliPlant_t* plant);
+
+/*
+ * Function:    getHeliEncoderPhases
+ * ----------------------------------
+ * Returns the levels of the encoder channels at a position.
+ *
+ * @params:
+ *      - int32_t slot: Encoder position.
+ * @return:
+ *      - uint8_t phases: Channel A in bit 0, channel B in bit 1.
+ * ---------------------
+ */
+uint8_t getHeliEncoderPhases(int32_t slot);
+
+/*
+ * Function:    isHeliAtReference
+ * -------------------------------
+ * Returns whether an encoder position is over the reference mark,
+ * where the active low reference pin reads low.
+ *
+ * @params:
+ *      - int32_t slot: Encoder position.
+ * @return:
+ *      - bool atReference: True over the mark.
+ * ---------------------
+ */
+bool isHeliAtReference(int32_t slot);
+
+#endif /* HELIPLANT_H_ */
@@ -0,0 +1,569 @@
+/* ****************************************************************
+ * heliReplay.c
+ *
+ * Replays flight recordings through the firmware on the host.
+ * Each recording is fed back from start-up into the unmodified
+ * firmware, with no plant: the recorded ADC blocks, quadrature
+ * readings, reference pulses and UART characters are raised as
+ * the interrupts they came from, at the tick they were recorded,
+ * the button and switch levels are driven before the polls that
+ * read them, and every edge timer read is served the recorded
+ * count. The firmware records the replay as it runs, and the two
+ * recordings are compared record by record, so any change in the
+ * rotor duties, or in the order the inputs are used, is reported
+ * with the tick it first appears at.
+ *
+ * Recordings written by heliSim -r replay exactly. Recordings
+ * dumped from the target with the "trace" command, as the raw
+ * UART log, replay each interrupt after the tasks of its tick, so
+ * an interrupt which beat a task within a tick on the target can
+ * show as a divergence at that tick.
+ *
+ * Each recording runs in its own process, as the firmware only
+ * starts once. The exit status is non-zero if any recording
+ * diverges, so the tool can drive git bisect over a set of them.
+ *
+ * Usage: heliReplay [-v] recording...
+ *      -v  Copy the firmware's UART output to stdout
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "simRTOS.h"
+#include "simHardware.h"
+#include "flightRecorder.h"
+#include "FreeRTOSCreate.h"
+#include "buttons.h"
+#include "yaw.h"
+
+#define REPLAY_LINE_SIZE        256         // Longest UART log line read
+#define REPLAY_MS_PER_SECOND    1000.0
+
+// Record types each reader walks, as bit masks of the record type
+#define REPLAY_TRIGGERS         ((1 << FLIGHT_RECORD_ADC_BLOCK) | (1 << FLIGHT_RECORD_QUADRATURE) | \
+                                 (1 << FLIGHT_RECORD_REFERENCE) | (1 << FLIGHT_RECORD_UART_RX) | \
+                                 (1 << FLIGHT_RECORD_CONTROL_TIMER))
+#define REPLAY_LEVELS           ((1 << FLIGHT_RECORD_BUTTONS) | (1 << FLIGHT_RECORD_SWITCHES))
+#define REPLAY_TIMER_READS      (1 << FLIGHT_RECORD_EDGE_TIMER)
+
+/* ******************************************************
+ * A reader that only returns some record types, with
+ * the next one decoded ahead.
+ * *****************************************************/
+typedef struct ReplayStreams {
+    flightReader_t  reader;
+    uint32_t        types;
+    bool            pending;
+    flightRecord_t  next;
+} replayStream_t;
+
+static uint8_t* g_recording = NULL;
+static uint32_t g_recordingLength = 0;
+static const char* g_recordingName = NULL;
+static replayStream_t g_triggers;
+static replayStream_t g_levels;
+static replayStream_t g_timerReads;
+static uint32_t g_lastEdgeTime = 0;
+static uint16_t g_adcSamples[FLIGHT_RECORD_MAX_SAMPLES];
+static uint8_t g_adcNext = 0;
+
+extern int firmwareMain(void);              // main() of main.c, renamed by the Makefile
+
+
+/*
+ * Function:    advanceStream
+ * ---------------------------
+ * Decodes the next record of a stream's types.
+ *
+ * @params:
+ *      - replayStream_t* stream: The stream.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+advanceStream(replayStream_t* stream)
+{
+    stream->pending = false;
+    while (readFlightRecord(&stream->reader, &stream->next)) {
+        if (stream->types & (1 << stream->next.type)) {
+            stream->pending = true;
+            return;
+        }
+    }
+}
+
+
+/*
+ * Function:    initStream
+ * ------------------------
+ * Starts a stream over the recording and decodes its first record.
+ *
+ * @params:
+ *      - replayStream_t* stream: The stream.
+ *      - uint32_t types: Mask of the record types it returns.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+initStream(replayStream_t* stream, uint32_t types)
+{
+    initFlightReader(&stream->reader, g_recording, g_recordingLength);
+    stream->types = types;
+    advanceStream(stream);
+}
+
+
+/*
+ * Function:    replayEdgeTimer
+ * -----------------------------
+ * Edge timer input of the replay. Serves the recorded reads in
+ * order, repeating the last once they run out.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint32_t count: Edge timer count.
+ * ---------------------
+ */
+static uint32_t
+replayEdgeTimer(void)
+{
+    if (g_timerReads.pending) {
+        g_lastEdgeTime = g_timerReads.next.value;
+        advanceStream(&g_timerReads);
+    }
+    return g_lastEdgeTime;
+}
+
+
+/*
+ * Function:    replayADC
+ * -----------------------
+ * ADC input of the replay. Serves the samples of the block being
+ * replayed.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint16_t result: 12-bit ADC result.
+ * ---------------------
+ */
+static uint16_t
+replayADC(void)
+{
+    return g_adcSamples[g_adcNext++ % FLIGHT_RECORD_MAX_SAMPLES];
+}
+
+
+/*
+ * Function:    applyLevels
+ * -------------------------
+ * Drives the button and switch levels recorded by the polls of a
+ * tick, before the polls run.
+ *
+ * @params:
+ *      - TickType_t tick: The tick about to run.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+applyLevels(TickType_t tick)
+{
+    flightRecord_t* record = &g_levels.next;
+
+    while (g_levels.pending && record->tick == tick) {
+        if (record->type == FLIGHT_RECORD_BUTTONS) {
+            simDrivePins(U_BTN_PORT_BASE, U_BTN_PIN, (record->value & (1 << UP)) ? U_BTN_PIN : 0);
+            simDrivePins(D_BTN_PORT_BASE, D_BTN_PIN, (record->value & (1 << DOWN)) ? D_BTN_PIN : 0);
+            simDrivePins(L_BTN_PORT_BASE, L_BTN_PIN, (record->value & (1 << LEFT)) ? L_BTN_PIN : 0);
+            simDrivePins(R_BTN_PORT_BASE, R_BTN_PIN, (record->value & (1 << RIGHT)) ? R_BTN_PIN : 0);
+        } else {
+            simDrivePins(SW_PORT_BASE, R_SW_PIN | L_SW_PIN, record->value);
+        }
+        advanceStream(&g_levels);
+    }
+}
+
+
+/*
+ * Function:    raiseInterrupts
+ * -----------------------------
+ * Raises the interrupts recorded during a tick, in order.
+ * Characters received together are delivered together.
+ *
+ * @params:
+ *      - TickType_t tick: The current tick.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+raiseInterrupts(TickType_t tick)
+{
+    flightRecord_t* record = &g_triggers.next;
+    char received[SIM_UART_RX_SIZE];
+    uint32_t length;
+    uint8_t i;
+
+    while (g_triggers.pending && record->tick == tick) {
+        switch (record->type) {
+            case FLIGHT_RECORD_ADC_BLOCK:
+                memcpy(g_adcSamples, record->samples, sizeof(g_adcSamples));
+                g_adcNext = 0;
+                for (i = 0; i < record->count; i++) {
+                    simConvertADC();
+                }
+                advanceStream(&g_triggers);
+                break;
+            case FLIGHT_RECORD_QUADRATURE:
+                simDrivePins(YAW_GPIO_BASE, QEI_PIN0 | QEI_PIN1, record->value);
+                simRaisePinInterrupt(YAW_GPIO_BASE, QEI_PIN0 | QEI_PIN1);
+                advanceStream(&g_triggers);
+                break;
+            case FLIGHT_RECORD_REFERENCE:
+                simRaisePinInterrupt(YAW_REFERENCE_BASE, YAW_REFERENCE_PIN);
+                advanceStream(&g_triggers);
+                break;
+            case FLIGHT_RECORD_CONTROL_TIMER:
+                simRaiseTimerInterrupt(CONTROL_TIMER_BASE);
+                advanceStream(&g_triggers);
+                break;
+            default:
+                length = 0;
+                do {
+                    received[length++] = (char) record->value;
+                    advanceStream(&g_triggers);
+                } while (g_triggers.pending && record->type == FLIGHT_RECORD_UART_RX && record->tick == tick &&
+                         length < SIM_UART_RX_SIZE - 1);
+                received[length] = '\0';
+                simUARTReceive(received);
+                break;
+        }
+    }
+}
+
+
+/*
+ * Function:    describeRecord
+ * ----------------------------
+ * Writes a record in words, for the divergence report.
+ *
+ * @params:
+ *      - const flightRecord_t* record: The record, or NULL if missing.
+ *      - char* text: Where to write.
+ *      - size_t size: Size of text.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+describeRecord(const flightRecord_t* record, char* text, size_t size)
+{
+    static const char* names[] = {
+        "?", "ADC block", "quadrature", "reference", "UART", "buttons", "switches",
+        "edge timer", "main duty", "tail duty", "full", "control timer"
+    };
+
+    if (record == NULL) {
+        snprintf(text, size, "nothing");
+    } else if (record->type == FLIGHT_RECORD_ADC_BLOCK) {
+        snprintf(text, size, "ADC block at tick %u starting %u", (unsigned) record->tick, record->samples[0]);
+    } else {
+        snprintf(text, size, "%s %u at tick %u", names[record->type], (unsigned) record->value,
+                 (unsigned) record->tick);
+    }
+}
+
+
+/*
+ * Function:    sameRecord
+ * ------------------------
+ * Compares two decoded records.
+ *
+ * @params:
+ *      - const flightRecord_t* a: A record.
+ *      - const flightRecord_t* b: Another.
+ * @return:
+ *      - bool same: True if they match.
+ * ---------------------
+ */
+static bool
+sameRecord(const flightRecord_t* a, const flightRecord_t* b)
+{
+    return a->type == b->type && a->tick == b->tick && a->value == b->value && a->count == b->count &&
+           memcmp(a->samples, b->samples, a->count * sizeof(a->samples[0])) == 0;
+}
+
+
+/*
+ * Function:    runSimulation
+ * ---------------------------
+ * Called by the scheduler once the firmware is running. Replays
+ * the recording tick by tick, then compares the firmware's
+ * recording of the replay with it and exits with the result.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+runSimulation(void)
+{
+    flightReader_t expected;
+    flightReader_t replayed;
+    flightRecord_t expectedRecord;
+    flightRecord_t replayedRecord;
+    const uint8_t* replay;
+    uint32_t replayLength;
+    TickType_t lastTick = 0;
+    TickType_t tick = 0;
+    uint32_t records = 0;
+    uint32_t duties = 0;
+    bool full = false;
+    bool haveReplayed;
+    struct timespec wallStart;
+    struct timespec wallEnd;
+    double wallSeconds;
+    char want[REPLAY_LINE_SIZE];
+    char got[REPLAY_LINE_SIZE];
+
+    // Find how long the recording runs
+    initFlightReader(&expected, g_recording, g_recordingLength);
+    while (readFlightRecord(&expected, &expectedRecord)) {
+        lastTick = expectedRecord.tick;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+    while (tick <= lastTick) {
+        raiseInterrupts(tick);
+        tick++;
+        applyLevels(tick);
+        simRTOSTick();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+    wallSeconds = (wallEnd.tv_sec - wallStart.tv_sec) + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+
+    // Compare up to the end of the original, or where it filled
+    replay = getFlightRecording(&replayLength);
+    initFlightReader(&expected, g_recording, g_recordingLength);
+    initFlightReader(&replayed, replay, replayLength);
+    while (readFlightRecord(&expected, &expectedRecord)) {
+        if (expectedRecord.type == FLIGHT_RECORD_FULL) {
+            full = true;
+            break;
+        }
+        haveReplayed = readFlightRecord(&replayed, &replayedRecord);
+        if (!haveReplayed || !sameRecord(&expectedRecord, &replayedRecord)) {
+            describeRecord(&expectedRecord, want, sizeof(want));
+            describeRecord(haveReplayed ? &replayedRecord : NULL, got, sizeof(got));
+            printf("%s: diverged at %.3f s, record %u: recorded %s, replayed %s\n", g_recordingName,
+                   expectedRecord.tick / REPLAY_MS_PER_SECOND, (unsigned) records, want, got);
+            exit(EXIT_FAILURE);
+        }
+        if (expectedRecord.type == FLIGHT_RECORD_MAIN_DUTY || expectedRecord.type == FLIGHT_RECORD_TAIL_DUTY) {
+            duties++;
+        }
+        records++;
+    }
+    if (expected.offset != g_recordingLength) {
+        printf("%s: corrupt recording at byte %u\n", g_recordingName, (unsigned) expected.offset);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%s: match, %u records and %u duties over %.1f s%s, replayed in %.3f s (%.0fx real time)\n",
+           g_recordingName, (unsigned) records, (unsigned) duties, lastTick / REPLAY_MS_PER_SECOND,
+           full ? " until the buffer filled" : "", wallSeconds,
+           (wallSeconds > 0.0) ? lastTick / REPLAY_MS_PER_SECOND / wallSeconds : 0.0);
+    exit(EXIT_SUCCESS);
+}
+
+
+/*
+ * Function:    parseDump
+ * -----------------------
+ * Reads a recording dumped over UART by the "trace" command from
+ * a log of the UART output. Lines which are not part of the dump
+ * are skipped.
+ *
+ * @params:
+ *      - FILE* file: The log, from its start.
+ * @return:
+ *      - bool found: False if the dump is missing or incomplete.
+ * ---------------------
+ */
+static bool
+parseDump(FILE* file)
+{
+    char line[REPLAY_LINE_SIZE];
+    unsigned size;
+    unsigned offset;
+    unsigned byte;
+    uint32_t filled = 0;
+    int used;
+    char* hex;
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (sscanf(line, "REC SIZE %u", &size) == 1) {
+            free(g_recording);
+            g_recording = malloc(size + 1);
+            g_recordingLength = size;
+            filled = 0;
+        } else if (strncmp(line, "REC END", 7) == 0 && g_recording != NULL) {
+            if (filled != g_recordingLength) {
+                fprintf(stderr, "%s: dump is missing bytes from %u, dump it again\n", g_recordingName,
+                        (unsigned) filled);
+                return false;
+            }
+            return true;
+        } else if (g_recording != NULL && sscanf(line, "REC %x %n", &offset, &used) == 1) {
+            if (offset != filled) {
+                fprintf(stderr, "%s: dump is missing bytes from %u, dump it again\n", g_recordingName,
+                        (unsigned) filled);
+                return false;
+            }
+            for (hex = &line[used]; filled < g_recordingLength && sscanf(hex, "%2x", &byte) == 1; hex += 2) {
+                g_recording[filled++] = (uint8_t) byte;
+            }
+        }
+    }
+
+    fprintf(stderr, "%s: no complete dump found\n", g_recordingName);
+    return false;
+}
+
+
+/*
+ * Function:    loadRecording
+ * ---------------------------
+ * Reads a recording, either as written by heliSim or as a UART
+ * log holding a dump.
+ *
+ * @params:
+ *      - const char* path: The file.
+ * @return:
+ *      - bool found: False if the file cannot be read.
+ * ---------------------
+ */
+static bool
+loadRecording(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    bool isLog = false;
+    long length;
+    long i;
+    bool found;
+
+    g_recordingName = path;
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    rewind(file);
+    g_recording = malloc(length + 1);
+    g_recordingLength = (uint32_t) length;
+    found = g_recording != NULL && fread(g_recording, 1, length, file) == (size_t) length;
+
+    // A UART log holds the dump's size line
+    for (i = 0; found && !isLog && i + 8 <= length; i++) {
+        isLog = memcmp(&g_recording[i], "REC SIZE", 8) == 0;
+    }
+    if (isLog) {
+        free(g_recording);
+        g_recording = NULL;
+        rewind(file);
+        found = parseDump(file);
+    }
+    fclose(file);
+    return found;
+}
+
+
+/*
+ * Function:    replayRecording
+ * -----------------------------
+ * Replays one recording. Runs in its own process and never
+ * returns.
+ *
+ * @params:
+ *      - const char* path: The recording.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+replayRecording(const char* path)
+{
+    if (!loadRecording(path)) {
+        exit(EXIT_FAILURE);
+    }
+
+    initStream(&g_triggers, REPLAY_TRIGGERS);
+    initStream(&g_levels, REPLAY_LEVELS);
+    initStream(&g_timerReads, REPLAY_TIMER_READS);
+
+    simSetADCInput(replayADC);
+    simSetTimerInput(YAW_EDGE_TMR_BASE, replayEdgeTimer);
+    applyLevels(0);
+
+    exit(firmwareMain()); // Never returns. The scheduler calls runSimulation
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    int option;
+    int status;
+    int failures = 0;
+    pid_t child;
+
+    while ((option = getopt(argc, argv, "v")) != -1) {
+        switch (option) {
+            case 'v':
+                simSetUARTEcho(true);
+                break;
+            default:
+                optind = argc;
+                break;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-v] recording...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (; optind < argc; optind++) {
+        fflush(stdout);
+        child = fork();
+        if (child < 0) {
+            perror("fork");
+            return EXIT_FAILURE;
+        }
+        if (child == 0) {
+            replayRecording(argv[optind]);
+        }
+        if (waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            failures++;
+        }
+    }
+
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
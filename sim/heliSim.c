@@ -0,0 +1,600 @@
+/* ****************************************************************
+ * heliSim.c
+ *
+ * Closed-loop simulator of the helicopter on the HeliRig.
+ * Runs the unmodified firmware, from main() down, against the
+ * plant model, faster than real time. Flies the profile a pilot
+ * would: takeoff with the right switch, hover, a 180 degree flip
+ * with a double tap of the down button, then land with the switch.
+ * Prints the step response of the takeoff and the flip and the
+ * error over the whole flight, so a change to the control code
+ * can be compared against the last run.
+ *
+ * Usage: heliSim [-v] [-s seed] [-t trace.csv] [-r flight.rec]
+ *      -v  Copy the firmware's UART output to stdout
+ *      -s  Seed of the ADC noise (default 1)
+ *      -t  Write the flight, one row per tick, to a CSV file
+ *      -r  Write the flight recorder's recording, for heliReplay
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "simRTOS.h"
+#include "simHardware.h"
+#include "heliPlant.h"
+#include "FreeRTOSCreate.h"
+#include "buttons.h"
+#include "yaw.h"
+#include "pwm.h"
+#include "FSM.h"
+#include "flightRecorder.h"
+#include "flightState.h"
+
+#define SIM_SUBSTEPS            20          // Plant integration steps per tick
+#define SIM_TICK_NS             (SIM_NS_PER_SECOND / configTICK_RATE_HZ)
+#define SIM_SWITCH_UP_MS        500         // When the pilot flips the switch to take off
+#define SIM_HOVER_MS            3000        // Time hovering before the flip
+#define SIM_FLIP_HOLD_MS        8000        // Time after the flip before landing
+#define SIM_TAP_MS              100         // Length of each button press and the gap between them
+#define SIM_TIMEOUT_MS          30000       // Longest a takeoff or a landing may take
+#define SIM_AFTER_LANDED_MS     1000        // Time simulated after touchdown
+#define SIM_MS_PER_SECOND       1000.0
+
+typedef enum {
+    PHASE_ON_GROUND = 0,
+    PHASE_TAKEOFF,
+    PHASE_HOVER,
+    PHASE_FLIP,
+    PHASE_LANDING,
+    PHASE_LANDED
+} simPhase_t;
+
+/* ******************************************************
+ * Step response of one axis to one setpoint change.
+ * *****************************************************/
+typedef struct StepMetrics {
+    const char* name;
+    const char* units;
+    bool        started;
+    bool        isYaw;
+    double      start;            // Value when the step was commanded
+    double      target;
+    double      band;             // Settled when within this of the target
+    uint32_t    startMs;
+    uint32_t    riseStartMs;      // First time 10 % of the way
+    uint32_t    riseEndMs;        // First time 90 % of the way
+    uint32_t    lastOutsideMs;    // Last time outside the band
+    double      peak;             // Furthest fraction of the step reached
+    double      iae;              // Integral of the absolute error (units.s)
+} stepMetrics_t;
+
+static heliPlant_t g_plant;
+static int32_t g_encoderSlot;
+static bool g_referenceSeen = false;
+static int32_t g_referenceSlot = 0;         // Encoder position where the firmware set zero yaw
+static FILE* g_trace = NULL;
+static const char* g_recordPath = NULL;
+
+static stepMetrics_t g_takeoffStep = { .name = "takeoff altitude", .units = "%" };
+static stepMetrics_t g_flipStep = { .name = "flip yaw", .units = "deg" };
+static double g_altitudeIAE = 0.0;
+static double g_yawIAE = 0.0;
+
+extern int firmwareMain(void);              // main() of main.c, renamed by the Makefile
+
+
+/*
+ * Function:    convertADC
+ * ------------------------
+ * ADC input of the simulated board. Reads the plant.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint16_t result: 12-bit ADC result.
+ * ---------------------
+ */
+static uint16_t
+convertADC(void)
+{
+    return readHeliADC(&g_plant);
+}
+
+
+/*
+ * Function:    moveEncoder
+ * -------------------------
+ * Drives the encoder and reference pins to follow the plant's yaw
+ * over the last integration step. Each transition is timed by
+ * interpolating between the step's end points, so the firmware's
+ * edge timestamps see the true rate.
+ *
+ * @params:
+ *      - uint64_t startNs: Time at the start of the step.
+ *      - uint64_t endNs: Time at the end of the step.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+moveEncoder(uint64_t startNs, uint64_t endNs)
+{
+    int32_t target = getHeliEncoderSlot(&g_plant);
+    int32_t startSlot = g_encoderSlot;
+    int32_t steps = abs(target - startSlot);
+    int32_t direction = (target > startSlot) ? 1 : -1;
+    uint8_t phases;
+    bool wasAtReference;
+    int32_t i;
+
+    for (i = 1; i <= steps; i++) {
+        simAdvanceTime(startNs + (endNs - startNs) * i / (steps + 1));
+
+        wasAtReference = isHeliAtReference(g_encoderSlot);
+        g_encoderSlot += direction;
+        phases = getHeliEncoderPhases(g_encoderSlot);
+        simSetPin(YAW_GPIO_BASE, QEI_PIN0, (phases & QEI_PIN0) != 0);
+        simSetPin(YAW_GPIO_BASE, QEI_PIN1, (phases & QEI_PIN1) != 0);
+
+        if (isHeliAtReference(g_encoderSlot) != wasAtReference) {
+            if (!wasAtReference && !g_referenceSeen) {
+                g_referenceSeen = true;
+                g_referenceSlot = g_encoderSlot;
+            }
+            simSetPin(YAW_REFERENCE_BASE, YAW_REFERENCE_PIN, wasAtReference); // Active low
+        }
+    }
+}
+
+
+/*
+ * Function:    getTrueYaw
+ * ------------------------
+ * Returns the plant's yaw from the zero the firmware chose.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - double yaw: Degrees, not wrapped.
+ * ---------------------
+ */
+static double
+getTrueYaw(void)
+{
+    return g_plant.yaw - (double) g_referenceSlot * DEGREES_CIRCLE / PLANT_ENCODER_SLOTS;
+}
+
+
+/*
+ * Function:    wrapDegrees
+ * -------------------------
+ * Wraps an angle to -180 to 180 degrees.
+ *
+ * @params:
+ *      - double angle: Degrees.
+ * @return:
+ *      - double angle: The wrapped angle.
+ * ---------------------
+ */
+static double
+wrapDegrees(double angle)
+{
+    return angle - DEGREES_CIRCLE * floor((angle + DEGREES_HALF_CIRCLE) / DEGREES_CIRCLE);
+}
+
+
+/*
+ * Function:    startStep
+ * -----------------------
+ * Starts measuring a step response.
+ *
+ * @params:
+ *      - stepMetrics_t* step: The measurement.
+ *      - double start: The value when the step was commanded.
+ *      - double target: The commanded value.
+ *      - double band: Settling tolerance.
+ *      - bool isYaw: True if the values are yaw.
+ *      - uint32_t nowMs: Time of the step.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+startStep(stepMetrics_t* step, double start, double target, double band, bool isYaw, uint32_t nowMs)
+{
+    step->started = true;
+    step->isYaw = isYaw;
+    step->start = start;
+    step->target = isYaw ? start + wrapDegrees(target - start) : target;
+    step->band = band;
+    step->startMs = nowMs;
+    step->riseStartMs = 0;
+    step->riseEndMs = 0;
+    step->lastOutsideMs = nowMs;
+    step->peak = 0.0;
+    step->iae = 0.0;
+}
+
+
+/*
+ * Function:    updateStep
+ * ------------------------
+ * Adds one tick of the response to a step measurement.
+ *
+ * @params:
+ *      - stepMetrics_t* step: The measurement.
+ *      - double value: The true value this tick.
+ *      - uint32_t nowMs: The time.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+updateStep(stepMetrics_t* step, double value, uint32_t nowMs)
+{
+    double error;
+    double progress;
+
+    // Near a half turn either way round is as short, so take the target on the side the helicopter turns to
+    if (step->isYaw && fabs(step->target - step->start) > DEGREES_HALF_CIRCLE - step->band
+        && fabs(value - step->start) > step->band && (value - step->start) * (step->target - step->start) < 0.0) {
+        step->target -= copysign(DEGREES_CIRCLE, step->target - step->start);
+    }
+    error = step->target - value;
+    progress = (value - step->start) / (step->target - step->start);
+
+    if (step->isYaw) {
+        error = wrapDegrees(error);
+    }
+    step->iae += fabs(error) / SIM_MS_PER_SECOND;
+
+    if (progress > step->peak) {
+        step->peak = progress;
+    }
+    if (step->riseStartMs == 0 && progress >= 0.1) {
+        step->riseStartMs = nowMs;
+    }
+    if (step->riseEndMs == 0 && progress >= 0.9) {
+        step->riseEndMs = nowMs;
+    }
+    if (fabs(error) > step->band) {
+        step->lastOutsideMs = nowMs;
+    }
+}
+
+
+/*
+ * Function:    printStep
+ * -----------------------
+ * Prints the metrics of a step response.
+ *
+ * @params:
+ *      - const stepMetrics_t* step: The measurement.
+ *      - uint32_t endMs: End of the measurement window.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+printStep(const stepMetrics_t* step, uint32_t endMs)
+{
+    if (!step->started) {
+        printf("%-17s not reached\n", step->name);
+        return;
+    }
+
+    printf("%-17s %.0f -> %.0f %s\n", step->name, step->start, step->target, step->units);
+    if (step->riseEndMs != 0) {
+        printf("    rise time     %.2f s\n", (step->riseEndMs - step->riseStartMs) / SIM_MS_PER_SECOND);
+    } else {
+        printf("    rise time     - (90 %% never reached)\n");
+    }
+    printf("    overshoot     %.1f %%\n", (step->peak > 1.0) ? (step->peak - 1.0) * 100.0 : 0.0);
+    if (step->lastOutsideMs < endMs) {
+        printf("    settling time %.2f s (within %.0f %s)\n",
+               (step->lastOutsideMs + 1 - step->startMs) / SIM_MS_PER_SECOND, step->band, step->units);
+    } else {
+        printf("    settling time - (not within %.0f %s)\n", step->band, step->units);
+    }
+    printf("    IAE           %.2f %s.s\n", step->iae, step->units);
+}
+
+
+/*
+ * Function:    getState
+ * ----------------------
+ * Returns the firmware's flight state.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t state: A HELI_STATE.
+ * ---------------------
+ */
+static int32_t
+getState(void)
+{
+    return getFSMState();
+}
+
+
+/*
+ * Function:    pressDown
+ * -----------------------
+ * Works the down button for the double tap that flips the
+ * helicopter: press, release, press, release.
+ *
+ * @params:
+ *      - uint32_t elapsedMs: Time since the first press.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+pressDown(uint32_t elapsedMs)
+{
+    uint32_t tap = elapsedMs / SIM_TAP_MS;
+
+    simSetPin(D_BTN_PORT_BASE, D_BTN_PIN, (tap == 0) || (tap == 2)); // Active high
+}
+
+
+/*
+ * Function:    traceTick
+ * -----------------------
+ * Writes one row of the flight to the trace file.
+ *
+ * @params:
+ *      - uint32_t nowMs: The time.
+ *      - int32_t state: The firmware's flight state.
+ *      - int32_t altDesired: The desired altitude.
+ *      - int32_t yawDesired: The desired yaw.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+traceTick(uint32_t nowMs, int32_t state, int32_t altDesired, int32_t yawDesired)
+{
+    altitudeSample_t altMeasured = {0};
+
+    if (g_trace == NULL) {
+        return;
+    }
+    getAltMeasured(&altMeasured);
+    fprintf(g_trace, "%u,%d,%d,%.2f,%d,%d,%.2f,%d,%.1f,%.1f\n", (unsigned) nowMs, (int) state,
+            (int) altDesired, g_plant.altitude, (int) altMeasured.altitude,
+            (int) yawDesired, wrapDegrees(getTrueYaw()), (int) getYaw(),
+            simGetPWMDuty(PWM_MAIN_BASE, PWM_MAIN_OUTNUM) * 100.0,
+            simGetPWMDuty(PWM_TAIL_BASE, PWM_TAIL_OUTNUM) * 100.0);
+}
+
+
+/*
+ * Function:    writeRecording
+ * ----------------------------
+ * Writes the flight recorder's recording to a file.
+ *
+ * @params:
+ *      - const char* path: The file.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+writeRecording(const char* path)
+{
+    uint32_t length;
+    const uint8_t* data = getFlightRecording(&length);
+    FILE* file = fopen(path, "wb");
+
+    if (file == NULL || fwrite(data, 1, length, file) != length) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    fclose(file);
+    printf("%-17s %u bytes written to %s\n", "recording", (unsigned) length, path);
+}
+
+
+/*
+ * Function:    runSimulation
+ * ---------------------------
+ * Flies the profile once the firmware has started its scheduler,
+ * prints the results and exits.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+runSimulation(void)
+{
+    simPhase_t phase = PHASE_ON_GROUND;
+    uint32_t nowMs = 0;
+    uint32_t phaseStartMs = 0;
+    uint32_t landingMs = 0;
+    uint64_t stepStartNs;
+    int32_t state;
+    int32_t altDesired = 0;
+    int32_t yawDesired = 0;
+    bool timedOut = false;
+    double dt = 1.0 / configTICK_RATE_HZ / SIM_SUBSTEPS;
+    struct timespec wallStart;
+    struct timespec wallEnd;
+    double wallSeconds;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+
+    while (phase != PHASE_LANDED || nowMs < phaseStartMs + SIM_AFTER_LANDED_MS) {
+        state = getState();
+        altDesired = getAltDesired();
+        yawDesired = getYawDesired();
+
+        // Pilot
+        switch (phase) {
+            case PHASE_ON_GROUND:
+                if (nowMs >= SIM_SWITCH_UP_MS) {
+                    simSetPin(SW_PORT_BASE, R_SW_PIN, true);
+                    phase = PHASE_TAKEOFF;
+                    phaseStartMs = nowMs;
+                }
+                break;
+            case PHASE_TAKEOFF:
+                if (!g_takeoffStep.started && isYawReferenced() && altDesired == TAKEOFF_ALT) {
+                    startStep(&g_takeoffStep, g_plant.altitude, TAKEOFF_ALT, ALT_TOLERANCE, false, nowMs);
+                }
+                if (state == FLYING) {
+                    phase = PHASE_HOVER;
+                    phaseStartMs = nowMs;
+                }
+                break;
+            case PHASE_HOVER:
+                if (nowMs >= phaseStartMs + SIM_HOVER_MS) {
+                    phase = PHASE_FLIP;
+                    phaseStartMs = nowMs;
+                }
+                break;
+            case PHASE_FLIP:
+                pressDown(nowMs - phaseStartMs);
+                if (!g_flipStep.started && yawDesired != 0) {
+                    startStep(&g_flipStep, getTrueYaw(), yawDesired, YAW_TOLERANCE, true, nowMs);
+                }
+                if (nowMs >= phaseStartMs + SIM_FLIP_HOLD_MS) {
+                    simSetPin(SW_PORT_BASE, R_SW_PIN, false);
+                    phase = PHASE_LANDING;
+                    phaseStartMs = nowMs;
+                }
+                break;
+            case PHASE_LANDING:
+                if (state == LANDED) {
+                    landingMs = nowMs - phaseStartMs;
+                    phase = PHASE_LANDED;
+                    phaseStartMs = nowMs;
+                }
+                break;
+            default:
+                break;
+        }
+        if ((phase == PHASE_TAKEOFF || phase == PHASE_LANDING) && nowMs > phaseStartMs + SIM_TIMEOUT_MS) {
+            timedOut = true;
+            break;
+        }
+
+        // Plant and sensors
+        for (i = 0; i < SIM_SUBSTEPS; i++) {
+            stepStartNs = simGetTime();
+            stepHeliPlant(&g_plant, simGetPWMDuty(PWM_MAIN_BASE, PWM_MAIN_OUTNUM),
+                          simGetPWMDuty(PWM_TAIL_BASE, PWM_TAIL_OUTNUM), dt);
+            moveEncoder(stepStartNs, stepStartNs + SIM_TICK_NS / SIM_SUBSTEPS);
+            simAdvanceTime(stepStartNs + SIM_TICK_NS / SIM_SUBSTEPS);
+        }
+
+        // Firmware
+        simRTOSTick();
+        nowMs++;
+
+        // Measurements
+        if (g_takeoffStep.started && !g_flipStep.started) {
+            updateStep(&g_takeoffStep, g_plant.altitude, nowMs);
+        }
+        if (g_flipStep.started && phase != PHASE_LANDING && phase != PHASE_LANDED) {
+            updateStep(&g_flipStep, getTrueYaw(), nowMs);
+        }
+        if (phase == PHASE_HOVER || phase == PHASE_FLIP) {
+            g_altitudeIAE += fabs(altDesired - g_plant.altitude) / SIM_MS_PER_SECOND;
+            g_yawIAE += fabs(wrapDegrees(yawDesired - getTrueYaw())) / SIM_MS_PER_SECOND;
+        }
+        traceTick(nowMs, state, altDesired, yawDesired);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+    wallSeconds = (wallEnd.tv_sec - wallStart.tv_sec) + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+
+    printStep(&g_takeoffStep, g_flipStep.started ? g_flipStep.startMs : nowMs);
+    printStep(&g_flipStep, (landingMs != 0 || timedOut) ? nowMs - landingMs : nowMs);
+    if (landingMs != 0) {
+        printf("%-17s %.2f s, touchdown yaw %.1f deg\n", "landing", landingMs / SIM_MS_PER_SECOND,
+               wrapDegrees(getTrueYaw()));
+    } else {
+        printf("%-17s not completed\n", "landing");
+    }
+    printf("%-17s altitude %.2f %%.s, yaw %.2f deg.s\n", "flight IAE", g_altitudeIAE, g_yawIAE);
+    printf("%-17s %u\n", "quadrature errors", (unsigned) getQuadratureErrors());
+    printf("%-17s %.1f s in %.3f s (%.0fx real time)\n", "simulated", nowMs / SIM_MS_PER_SECOND, wallSeconds,
+           (wallSeconds > 0.0) ? nowMs / SIM_MS_PER_SECOND / wallSeconds : 0.0);
+
+    if (g_trace != NULL) {
+        fclose(g_trace);
+    }
+    if (g_recordPath != NULL) {
+        writeRecording(g_recordPath);
+    }
+    if (timedOut) {
+        fprintf(stderr, "heliSim: timed out in the %s\n", (phase == PHASE_TAKEOFF) ? "takeoff" : "landing");
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t seed = 1;
+    int option;
+
+    while ((option = getopt(argc, argv, "vs:t:r:")) != -1) {
+        switch (option) {
+            case 'v':
+                simSetUARTEcho(true);
+                break;
+            case 's':
+                seed = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                g_trace = fopen(optarg, "w");
+                if (g_trace == NULL) {
+                    perror(optarg);
+                    return EXIT_FAILURE;
+                }
+                fprintf(g_trace, "ms,state,alt_desired,alt_true,alt_measured,"
+                                 "yaw_desired,yaw_true,yaw_measured,main_duty,tail_duty\n");
+                break;
+            case 'r':
+                g_recordPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-v] [-s seed] [-t trace.csv] [-r flight.rec]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    // Power on with the rig at rest, the switches down and the buttons released
+    initHeliPlant(&g_plant, seed);
+    g_encoderSlot = getHeliEncoderSlot(&g_plant);
+    simSetADCInput(convertADC);
+    simSetPin(YAW_GPIO_BASE, QEI_PIN0 | QEI_PIN1, false);
+    simSetPin(YAW_GPIO_BASE, getHeliEncoderPhases(g_encoderSlot), true);
+    simSetPin(YAW_REFERENCE_BASE, YAW_REFERENCE_PIN, !isHeliAtReference(g_encoderSlot));
+    simSetPin(SW_PORT_BASE, R_SW_PIN | L_SW_PIN, false);
+    simSetPin(U_BTN_PORT_BASE, U_BTN_PIN, false);
+    simSetPin(D_BTN_PORT_BASE, D_BTN_PIN, false);
+    simSetPin(L_BTN_PORT_BASE, L_BTN_PIN, true);
+    simSetPin(R_BTN_PORT_BASE, R_BTN_PIN, true);
+
+    return firmwareMain(); // Never returns. The scheduler calls runSimulation
+}
@@ -0,0 +1,65 @@
+/* ****************************************************************
+ * FreeRTOS.h
+ *
+ * Simulator stand-in for the FreeRTOS kernel header.
+ * Declares the types and macros the firmware uses. The kernel
+ * itself is emulated by simRTOS.c.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef FREERTOS_H_
+#define FREERTOS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "FreeRTOSConfig.h"
+
+typedef long                BaseType_t;
+typedef unsigned long       UBaseType_t;
+typedef uint32_t            TickType_t;
+typedef TickType_t          portTickType;
+
+#define pdFALSE             ((BaseType_t) 0)
+#define pdTRUE              ((BaseType_t) 1)
+#define pdFAIL              pdFALSE
+#define pdPASS              pdTRUE
+#define portMAX_DELAY       ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS  ((TickType_t) 1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS    portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(ms)   ((TickType_t) (((TickType_t) (ms) * (TickType_t) configTICK_RATE_HZ) / (TickType_t) 1000))
+
+// Interrupts only run between task switches in the simulator, so critical sections need no masking
+#if SIM_COUNT_CRITICAL
+// Counts the critical sections entered instead, for stateBench to show a module never masks
+extern volatile uint32_t g_simCriticalSections;
+#define taskENTER_CRITICAL()                    do { g_simCriticalSections++; } while (0)
+#define taskENTER_CRITICAL_FROM_ISR()           (g_simCriticalSections++, (UBaseType_t) 0)
+#define portSET_INTERRUPT_MASK_FROM_ISR()       (g_simCriticalSections++, (UBaseType_t) 0)
+#else
+#define taskENTER_CRITICAL()                    do { } while (0)
+#define taskENTER_CRITICAL_FROM_ISR()           ((UBaseType_t) 0)
+#define portSET_INTERRUPT_MASK_FROM_ISR()       ((UBaseType_t) 0)
+#endif /* SIM_COUNT_CRITICAL */
+#define taskEXIT_CRITICAL()                     do { } while (0)
+#define taskEXIT_CRITICAL_FROM_ISR(x)           ((void) (x))
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)    ((void) (x))
+
+// Tasks woken by an interrupt run as soon as the handler returns
+#define portYIELD_FROM_ISR(x)                   ((void) (x))
+#define portEND_SWITCHING_ISR(x)                ((void) (x))
+
+// Trace hooks FreeRTOSConfig.h leaves out do nothing, as in the kernel
+#ifndef traceTASK_SWITCHED_IN
+#define traceTASK_SWITCHED_IN()                 do { } while (0)
+#endif
+#ifndef traceTASK_SWITCHED_OUT
+#define traceTASK_SWITCHED_OUT()                do { } while (0)
+#endif
+
+#endif /* FREERTOS_H_ */
@@ -0,0 +1,22 @@
+/* ****************************************************************
+ * OrbitOLEDInterface.h
+ *
+ * Simulator stand-in for the Orbit BoosterPack OLED driver.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef ORBITOLEDINTERFACE_H_
+#define ORBITOLEDINTERFACE_H_
+
+#include <stdint.h>
+
+void OLEDInitialise(void);
+void OLEDStringDraw(const char* pcStr, uint32_t ulColumn, uint32_t ulRow);
+
+#endif /* ORBITOLEDINTERFACE_H_ */
@@ -0,0 +1,34 @@
+/* ****************************************************************
+ * adc.h
+ *
+ * Simulator stand-in for the TivaWare ADC API. Conversions are
+ * triggered by the simulated ADC timer and read the plant model.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef ADC_DRIVERLIB_H_
+#define ADC_DRIVERLIB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ADC_TRIGGER_PROCESSOR   0x00000000
+#define ADC_TRIGGER_TIMER       0x00000005
+#define ADC_CTL_CH9             0x00000009
+#define ADC_CTL_IE              0x00000040
+#define ADC_CTL_END             0x00000020
+
+void ADCSequenceConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t ui32Trigger, uint32_t ui32Priority);
+void ADCSequenceStepConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t ui32Step, uint32_t ui32Config);
+void ADCSequenceEnable(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCSequenceDMAEnable(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCIntRegister(uint32_t ui32Base, uint32_t ui32SequenceNum, void (*pfnHandler)(void));
+void ADCIntClear(uint32_t ui32Base, uint32_t ui32SequenceNum);
+
+#endif /* ADC_DRIVERLIB_H_ */
@@ -0,0 +1,65 @@
+/* ****************************************************************
+ * gpio.h
+ *
+ * Simulator stand-in for the TivaWare GPIO API. Pin levels come
+ * from the plant model and the scenario through simHardware.h.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef GPIO_H_
+#define GPIO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GPIO_PIN_0              0x00000001
+#define GPIO_PIN_1              0x00000002
+#define GPIO_PIN_2              0x00000004
+#define GPIO_PIN_3              0x00000008
+#define GPIO_PIN_4              0x00000010
+#define GPIO_PIN_5              0x00000020
+#define GPIO_PIN_6              0x00000040
+#define GPIO_PIN_7              0x00000080
+
+#define GPIO_INT_PIN_0          0x00000001
+#define GPIO_INT_PIN_1          0x00000002
+#define GPIO_INT_PIN_2          0x00000004
+#define GPIO_INT_PIN_3          0x00000008
+#define GPIO_INT_PIN_4          0x00000010
+#define GPIO_INT_PIN_5          0x00000020
+#define GPIO_INT_PIN_6          0x00000040
+#define GPIO_INT_PIN_7          0x00000080
+
+#define GPIO_FALLING_EDGE       0x00000000
+#define GPIO_RISING_EDGE        0x00000004
+#define GPIO_BOTH_EDGES         0x00000001
+
+#define GPIO_STRENGTH_2MA       0x00000001
+#define GPIO_STRENGTH_4MA       0x00000002
+#define GPIO_PIN_TYPE_STD       0x00000008
+#define GPIO_PIN_TYPE_STD_WPU   0x0000000A
+#define GPIO_PIN_TYPE_STD_WPD   0x0000000C
+
+void GPIOPinTypeGPIOInput(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypeGPIOOutput(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypePWM(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypeQEI(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypeUART(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinConfigure(uint32_t ui32PinConfig);
+void GPIOPadConfigSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32Strength, uint32_t ui32PadType);
+int32_t GPIOPinRead(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val);
+void GPIOIntRegister(uint32_t ui32Port, void (*pfnIntHandler)(void));
+void GPIOIntTypeSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32IntType);
+void GPIOIntEnable(uint32_t ui32Port, uint32_t ui32IntFlags);
+void GPIOIntDisable(uint32_t ui32Port, uint32_t ui32IntFlags);
+void GPIOIntClear(uint32_t ui32Port, uint32_t ui32IntFlags);
+uint32_t GPIOIntStatus(uint32_t ui32Port, bool bMasked);
+
+#endif /* GPIO_H_ */
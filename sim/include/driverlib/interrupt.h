@@ -0,0 +1,26 @@
+/* ****************************************************************
+ * interrupt.h
+ *
+ * Simulator stand-in for the TivaWare interrupt controller API.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef INTERRUPT_H_
+#define INTERRUPT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+bool IntMasterEnable(void);
+bool IntMasterDisable(void);
+void IntEnable(uint32_t ui32Interrupt);
+void IntDisable(uint32_t ui32Interrupt);
+void IntPrioritySet(uint32_t ui32Interrupt, uint8_t ui8Priority);
+
+#endif /* INTERRUPT_H_ */
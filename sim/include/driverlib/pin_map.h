@@ -0,0 +1,25 @@
+/* ****************************************************************
+ * pin_map.h
+ *
+ * Simulator stand-in for the TivaWare pin mux definitions.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef PIN_MAP_H_
+#define PIN_MAP_H_
+
+#define GPIO_PA0_U0RX       0x00000001
+#define GPIO_PA1_U0TX       0x00000401
+#define GPIO_PC5_M0PWM7     0x00021404
+#define GPIO_PD3_IDX0       0x00030C06
+#define GPIO_PD6_PHA0       0x00031806
+#define GPIO_PD7_PHB0       0x00031C06
+#define GPIO_PF1_M1PWM5     0x00050405
+
+#endif /* PIN_MAP_H_ */
@@ -0,0 +1,40 @@
+/* ****************************************************************
+ * pwm.h
+ *
+ * Simulator stand-in for the TivaWare PWM API. The duty cycles
+ * set here drive the plant model.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef PWM_DRIVERLIB_H_
+#define PWM_DRIVERLIB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PWM_GEN_0               0x00000040
+#define PWM_GEN_1               0x00000080
+#define PWM_GEN_2               0x000000C0
+#define PWM_GEN_3               0x00000100
+#define PWM_OUT_5               0x000000C1
+#define PWM_OUT_7               0x00000101
+#define PWM_OUT_5_BIT           0x00000020
+#define PWM_OUT_7_BIT           0x00000080
+#define PWM_GEN_MODE_UP_DOWN    0x00000002
+#define PWM_GEN_MODE_NO_SYNC    0x00000000
+
+void PWMGenConfigure(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Config);
+void PWMGenPeriodSet(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Period);
+uint32_t PWMGenPeriodGet(uint32_t ui32Base, uint32_t ui32Gen);
+void PWMGenEnable(uint32_t ui32Base, uint32_t ui32Gen);
+void PWMPulseWidthSet(uint32_t ui32Base, uint32_t ui32PWMOut, uint32_t ui32Width);
+uint32_t PWMPulseWidthGet(uint32_t ui32Base, uint32_t ui32PWMOut);
+void PWMOutputState(uint32_t ui32Base, uint32_t ui32PWMOutBits, bool bEnable);
+
+#endif /* PWM_DRIVERLIB_H_ */
@@ -0,0 +1,43 @@
+/* ****************************************************************
+ * qei.h
+ *
+ * Simulator stand-in for the TivaWare QEI API. Declared so yaw.h
+ * compiles. The simulator uses the GPIO yaw backend.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef QEI_H_
+#define QEI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define QEI_CONFIG_CAPTURE_A_B  0x00000008
+#define QEI_CONFIG_NO_RESET     0x00000000
+#define QEI_CONFIG_QUADRATURE   0x00000000
+#define QEI_CONFIG_NO_SWAP      0x00000000
+#define QEI_CONFIG_SWAP         0x00000002
+#define QEI_VELDIV_1            0x00000000
+#define QEI_INTERROR            0x00000008
+#define QEI_INTINDEX            0x00000001
+#define QEI_INTTIMER            0x00000002
+
+void QEIConfigure(uint32_t ui32Base, uint32_t ui32Config, uint32_t ui32MaxPosition);
+void QEIEnable(uint32_t ui32Base);
+uint32_t QEIPositionGet(uint32_t ui32Base);
+int32_t QEIDirectionGet(uint32_t ui32Base);
+void QEIVelocityConfigure(uint32_t ui32Base, uint32_t ui32PreDiv, uint32_t ui32Period);
+void QEIVelocityEnable(uint32_t ui32Base);
+uint32_t QEIVelocityGet(uint32_t ui32Base);
+void QEIIntRegister(uint32_t ui32Base, void (*pfnHandler)(void));
+void QEIIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+void QEIIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+uint32_t QEIIntStatus(uint32_t ui32Base, bool bMasked);
+
+#endif /* QEI_H_ */
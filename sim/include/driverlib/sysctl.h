@@ -0,0 +1,49 @@
+/* ****************************************************************
+ * sysctl.h
+ *
+ * Simulator stand-in for the TivaWare system control API.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef SYSCTL_H_
+#define SYSCTL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SYSCTL_SYSDIV_2_5       0xC1000000
+#define SYSCTL_USE_PLL          0x00000000
+#define SYSCTL_OSC_MAIN         0x00000000
+#define SYSCTL_XTAL_16MHZ       0x00000540
+#define SYSCTL_PWMDIV_16        0x00060000
+
+#define SYSCTL_PERIPH_ADC0      0xf0003800
+#define SYSCTL_PERIPH_GPIOA     0xf0000800
+#define SYSCTL_PERIPH_GPIOB     0xf0000801
+#define SYSCTL_PERIPH_GPIOC     0xf0000802
+#define SYSCTL_PERIPH_GPIOD     0xf0000803
+#define SYSCTL_PERIPH_GPIOE     0xf0000804
+#define SYSCTL_PERIPH_GPIOF     0xf0000805
+#define SYSCTL_PERIPH_PWM0      0xf0004000
+#define SYSCTL_PERIPH_PWM1      0xf0004001
+#define SYSCTL_PERIPH_QEI0      0xf0004400
+#define SYSCTL_PERIPH_TIMER0    0xf0000400
+#define SYSCTL_PERIPH_TIMER1    0xf0000401
+#define SYSCTL_PERIPH_TIMER2    0xf0000402
+#define SYSCTL_PERIPH_UART0     0xf0001800
+#define SYSCTL_PERIPH_UDMA      0xf0000c00
+
+void SysCtlClockSet(uint32_t ui32Config);
+uint32_t SysCtlClockGet(void);
+void SysCtlPWMClockSet(uint32_t ui32Config);
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral);
+bool SysCtlPeripheralReady(uint32_t ui32Peripheral);
+void SysCtlReset(void);
+
+#endif /* SYSCTL_H_ */
@@ -0,0 +1,36 @@
+/* ****************************************************************
+ * timer.h
+ *
+ * Simulator stand-in for the TivaWare general purpose timer API.
+ * Timers count from the simulated system clock.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TIMER_CFG_PERIODIC      0x00000022
+#define TIMER_CFG_PERIODIC_UP   0x00000032
+#define TIMER_A                 0x000000FF
+#define TIMER_TIMA_TIMEOUT      0x00000001
+
+void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config);
+void TimerLoadSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value);
+void TimerEnable(uint32_t ui32Base, uint32_t ui32Timer);
+void TimerDisable(uint32_t ui32Base, uint32_t ui32Timer);
+void TimerControlTrigger(uint32_t ui32Base, uint32_t ui32Timer, bool bEnable);
+uint32_t TimerValueGet(uint32_t ui32Base, uint32_t ui32Timer);
+void TimerIntRegister(uint32_t ui32Base, uint32_t ui32Timer, void (*pfnHandler)(void));
+void TimerIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+void TimerIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+
+#endif /* TIMER_H_ */
@@ -0,0 +1,38 @@
+/* ****************************************************************
+ * uart.h
+ *
+ * Simulator stand-in for the TivaWare UART API. Transmitted text
+ * goes to stdout when the simulator is run verbose.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef UART_DRIVERLIB_H_
+#define UART_DRIVERLIB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UART_CONFIG_WLEN_8      0x00000060
+#define UART_CONFIG_STOP_ONE    0x00000000
+#define UART_CONFIG_PAR_NONE    0x00000000
+#define UART_INT_RX             0x00000010
+#define UART_INT_RT             0x00000040
+
+void UARTConfigSetExpClk(uint32_t ui32Base, uint32_t ui32UARTClk, uint32_t ui32Baud, uint32_t ui32Config);
+void UARTFIFOEnable(uint32_t ui32Base);
+void UARTEnable(uint32_t ui32Base);
+void UARTCharPut(uint32_t ui32Base, unsigned char ucData);
+bool UARTCharsAvail(uint32_t ui32Base);
+int32_t UARTCharGetNonBlocking(uint32_t ui32Base);
+void UARTIntRegister(uint32_t ui32Base, void (*pfnHandler)(void));
+void UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+void UARTIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+uint32_t UARTIntStatus(uint32_t ui32Base, bool bMasked);
+
+#endif /* UART_DRIVERLIB_H_ */
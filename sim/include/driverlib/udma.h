@@ -0,0 +1,41 @@
+/* ****************************************************************
+ * udma.h
+ *
+ * Simulator stand-in for the TivaWare uDMA API. Only the ADC
+ * ping-pong transfer is modelled.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef UDMA_H_
+#define UDMA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UDMA_CHANNEL_ADC3       17
+#define UDMA_PRI_SELECT         0x00000000
+#define UDMA_ALT_SELECT         0x00000020
+#define UDMA_SIZE_16            0x11000000
+#define UDMA_SRC_INC_NONE       0x0c000000
+#define UDMA_DST_INC_16         0x40000000
+#define UDMA_ARB_1              0x00000000
+#define UDMA_MODE_STOP          0x00000000
+#define UDMA_MODE_PINGPONG      0x00000003
+#define UDMA_ATTR_ALL           0x0000000F
+
+void uDMAEnable(void);
+void uDMAControlBaseSet(void* pControlTable);
+void uDMAChannelAttributeDisable(uint32_t ui32ChannelNum, uint32_t ui32Attr);
+void uDMAChannelControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control);
+void uDMAChannelTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode,
+                            void* pvSrcAddr, void* pvDstAddr, uint32_t ui32TransferSize);
+void uDMAChannelEnable(uint32_t ui32ChannelNum);
+uint32_t uDMAChannelModeGet(uint32_t ui32ChannelStructIndex);
+
+#endif /* UDMA_H_ */
@@ -0,0 +1,30 @@
+/* ****************************************************************
+ * event_groups.h
+ *
+ * Simulator stand-in for the FreeRTOS event group API.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef EVENT_GROUPS_H_
+#define EVENT_GROUPS_H_
+
+#include "FreeRTOS.h"
+
+typedef void* EventGroupHandle_t;
+typedef TickType_t EventBits_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup);
+EventBits_t xEventGroupGetBitsFromISR(EventGroupHandle_t xEventGroup);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet);
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet,
+                                     BaseType_t* pxHigherPriorityTaskWoken);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear);
+
+#endif /* EVENT_GROUPS_H_ */
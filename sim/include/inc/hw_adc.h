@@ -0,0 +1,19 @@
+/* ****************************************************************
+ * hw_adc.h
+ *
+ * Simulator stand-in for the TivaWare ADC register offsets.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef HW_ADC_H_
+#define HW_ADC_H_
+
+#define ADC_O_SSFIFO3       0x000000A8      // Sample sequence 3 result FIFO
+
+#endif /* HW_ADC_H_ */
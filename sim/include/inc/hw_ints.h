@@ -0,0 +1,30 @@
+/* ****************************************************************
+ * hw_ints.h
+ *
+ * Simulator stand-in for the TivaWare interrupt numbers.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef HW_INTS_H_
+#define HW_INTS_H_
+
+#define INT_GPIOA           16
+#define INT_GPIOB           17
+#define INT_GPIOC           18
+#define INT_GPIOD           19
+#define INT_GPIOE           20
+#define INT_UART0           21
+#define INT_QEI0            29
+#define INT_ADC0SS3         33
+#define INT_TIMER0A         35
+#define INT_TIMER1A         37
+#define INT_TIMER2A         39
+#define INT_GPIOF           46
+
+#endif /* HW_INTS_H_ */
@@ -0,0 +1,38 @@
+/* ****************************************************************
+ * tm4c123gh6pm.h
+ *
+ * Simulator stand-in for the TM4C123GH6PM register definitions.
+ * The GPIO commit and debug registers are plain variables, as
+ * nothing on the host is memory mapped. The cycle counter reads
+ * the simulated clock.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef TM4C123GH6PM_H_
+#define TM4C123GH6PM_H_
+
+#include <stdint.h>
+
+extern volatile uint32_t g_simGpioLockRegs[4];
+
+#define GPIO_PORTD_LOCK_R   (g_simGpioLockRegs[0])
+#define GPIO_PORTD_CR_R     (g_simGpioLockRegs[1])
+#define GPIO_PORTF_LOCK_R   (g_simGpioLockRegs[2])
+#define GPIO_PORTF_CR_R     (g_simGpioLockRegs[3])
+#define GPIO_LOCK_KEY       0x4C4F434B
+#define GPIO_LOCK_M         0xFFFFFFFF
+
+extern volatile uint32_t g_simDebugRegs[2];
+uint32_t simReadCycleCounter(void);
+
+#define DEMCR_R             (g_simDebugRegs[0])
+#define DWT_CTRL_R          (g_simDebugRegs[1])
+#define DWT_CYCCNT_R        (simReadCycleCounter())
+
+#endif /* TM4C123GH6PM_H_ */
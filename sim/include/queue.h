@@ -0,0 +1,33 @@
+/* ****************************************************************
+ * queue.h
+ *
+ * Simulator stand-in for the FreeRTOS queue API.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef QUEUE_H_
+#define QUEUE_H_
+
+#include "FreeRTOS.h"
+
+typedef void* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void* pvItemToQueue, BaseType_t* pxHigherPriorityTaskWoken);
+BaseType_t xQueueOverwrite(QueueHandle_t xQueue, const void* pvItemToQueue);
+BaseType_t xQueueOverwriteFromISR(QueueHandle_t xQueue, const void* pvItemToQueue, BaseType_t* pxHigherPriorityTaskWoken);
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait);
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait);
+BaseType_t xQueuePeekFromISR(QueueHandle_t xQueue, void* pvBuffer);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue);
+
+#define xQueueSendToBack(q, item, wait)     xQueueSend((q), (item), (wait))
+
+#endif /* QUEUE_H_ */
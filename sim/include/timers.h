@@ -0,0 +1,32 @@
+/* ****************************************************************
+ * timers.h
+ *
+ * Simulator stand-in for the FreeRTOS software timer API.
+ * Callbacks run in the timer service task, as in FreeRTOS.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef TIMERS_H_
+#define TIMERS_H_
+
+#include "FreeRTOS.h"
+
+typedef void* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t xTimer);
+
+TimerHandle_t xTimerCreate(const char* pcTimerName, TickType_t xTimerPeriod, UBaseType_t uxAutoReload,
+                           void* pvTimerID, TimerCallbackFunction_t pxCallbackFunction);
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerIsTimerActive(TimerHandle_t xTimer);
+void* pvTimerGetTimerID(TimerHandle_t xTimer);
+void vTimerSetTimerID(TimerHandle_t xTimer, void* pvNewID);
+
+#endif /* TIMERS_H_ */
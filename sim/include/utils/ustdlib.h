@@ -0,0 +1,22 @@
+/* ****************************************************************
+ * ustdlib.h
+ *
+ * Simulator stand-in for the TivaWare string utilities, backed by
+ * the C library.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef USTDLIB_H_
+#define USTDLIB_H_
+
+#include <stdio.h>
+
+#define usnprintf   snprintf
+
+#endif /* USTDLIB_H_ */
@@ -0,0 +1,496 @@
+/* ****************************************************************
+ * observerTest.c
+ *
+ * Compares the altitude observer with the boxcar mean it replaced.
+ * Feeds a 1 kHz ADC sequence through both, one estimate every
+ * ALTITUDE_PERIOD, and reports each one's noise variance and lag
+ * for the altitude and the vertical rate. The mean filter's rate
+ * is its finite difference, as the PID's derivative took it.
+ *
+ * By default the sequence is the plant model's ADC, with its noise,
+ * while the altitude follows a known path: on the ground, a climb, a
+ * hover, a sine and a descent. The noise is measured in the hover
+ * and the lag in the sine, against the true altitude and rate.
+ * With -r, the sequence is the ADC blocks of a recording made by
+ * heliSim -r. The true altitude is not known, so a centred mean of
+ * the raw samples stands in for it, and both are measured over the
+ * whole recording.
+ *
+ * Usage: observerTest [-v] [-r flight.rec]
+ *      -v  Print every check, not just the failures
+ *      -r  Read the ADC sequence from a recording
+ *
+ * The observer trades lag for noise, so the checks, on the plant's
+ * sequence only, bound both. They check that the observer:
+ *      - has at most a tenth of the mean filter's altitude noise
+ *      - has at most a hundredth of the mean filter's rate noise
+ *      - lags the altitude by less than ALT_TEST_MAX_ALT_LAG
+ *      - lags the rate by less than ALT_TEST_MAX_RATE_LAG
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "simTest.h"
+#include "heliPlant.h"
+#include "FreeRTOSCreate.h"
+#include "flightRecorder.h"
+
+#define ALT_TEST_MAX_SAMPLES    (1 << 20)   // Longest sequence read from a recording (about 17 minutes)
+#define ALT_TEST_MEAN_WINDOW    8           // Samples in the mean filter, as it was
+#define ALT_TEST_MAX_LAG        200         // Longest lag searched for (samples, ms)
+#define ALT_TEST_MAX_ALT_LAG    30          // Longest altitude lag passed (ms)
+#define ALT_TEST_MAX_RATE_LAG   150         // Longest rate lag passed (ms)
+#define ALT_TEST_ALT_NOISE_GAIN 10          // Least reduction in altitude noise passed
+#define ALT_TEST_RATE_NOISE_GAIN 100        // Least reduction in rate noise passed
+#define ALT_TEST_CENTRED_HALF   32          // Half width of the centred mean standing in for a recording's altitude
+#define ALT_TEST_SEED           1
+
+// The plant's path (ms and %)
+#define PATH_GROUND_MS          1000
+#define PATH_CLIMB_MS           2000
+#define PATH_HOVER_MS           3000
+#define PATH_SINE_MS            4000
+#define PATH_DESCENT_MS         2000
+#define PATH_HOVER_ALT          50.0
+#define PATH_SINE_AMPLITUDE     10.0
+#define PATH_SINE_HZ            1.0
+#define PATH_END_ALT            20.0
+#define PATH_PHASE_PER_MS       (360.0 * PATH_SINE_HZ / 1000.0) // Phase of the sine per ms of lag (deg)
+#define PATH_SETTLE_MS          500         // Skipped at the start of the hover before measuring the noise
+
+/* ******************************************************
+ * A filter's estimates, one per ALTITUDE_PERIOD.
+ * *****************************************************/
+typedef struct Estimates {
+    const char* name;
+    double*     altitude;       // %
+    double*     rate;           // %/s
+} estimates_t;
+
+static uint16_t* g_samples;                 // ADC sequence, one sample per ms
+static double* g_altitude;                  // True or reference altitude (%)
+static double* g_rate;                      // True or reference rate (%/s)
+static uint32_t g_length = 0;
+static int32_t g_ground;                    // ADC result on the ground
+
+
+// The test drives the filters itself and never starts the scheduler
+void runSimulation(void) {}
+
+
+/*
+ * Function:    allocateSequence
+ * ------------------------------
+ * Allocates the sequence and the estimates.
+ *
+ * @params:
+ *      - uint32_t length: Samples.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+allocateSequence(uint32_t length)
+{
+    g_samples = calloc(length, sizeof(*g_samples));
+    g_altitude = calloc(length, sizeof(*g_altitude));
+    g_rate = calloc(length, sizeof(*g_rate));
+    if (g_samples == NULL || g_altitude == NULL || g_rate == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+/*
+ * Function:    getPathAltitude
+ * -----------------------------
+ * Returns the altitude of the plant's path.
+ *
+ * @params:
+ *      - double ms: Time (ms).
+ * @return:
+ *      - double altitude: Altitude (%).
+ * ---------------------
+ */
+static double
+getPathAltitude(double ms)
+{
+    double sineStart = PATH_GROUND_MS + PATH_CLIMB_MS + PATH_HOVER_MS;
+    double descentStart = sineStart + PATH_SINE_MS;
+
+    if (ms < PATH_GROUND_MS) {
+        return 0.0;
+    } else if (ms < PATH_GROUND_MS + PATH_CLIMB_MS) {
+        return PATH_HOVER_ALT * (1.0 - cos(M_PI * (ms - PATH_GROUND_MS) / PATH_CLIMB_MS)) / 2.0;
+    } else if (ms < sineStart) {
+        return PATH_HOVER_ALT;
+    } else if (ms < descentStart) {
+        return PATH_HOVER_ALT + PATH_SINE_AMPLITUDE * sin(2.0 * M_PI * PATH_SINE_HZ * (ms - sineStart) / 1000.0);
+    } else if (ms < descentStart + PATH_DESCENT_MS) {
+        return PATH_HOVER_ALT + (PATH_END_ALT - PATH_HOVER_ALT) *
+               (1.0 - cos(M_PI * (ms - descentStart) / PATH_DESCENT_MS)) / 2.0;
+    }
+    return PATH_END_ALT;
+}
+
+
+/*
+ * Function:    makePlantSequence
+ * -------------------------------
+ * Fills the sequence with the plant's ADC as the altitude follows
+ * the path, and the true altitude and rate.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+makePlantSequence(void)
+{
+    heliPlant_t plant;
+    uint32_t i;
+
+    g_length = PATH_GROUND_MS + PATH_CLIMB_MS + PATH_HOVER_MS + PATH_SINE_MS + PATH_DESCENT_MS + PATH_GROUND_MS;
+    allocateSequence(g_length);
+    initHeliPlant(&plant, ALT_TEST_SEED);
+    for (i = 0; i < g_length; i++) {
+        plant.altitude = getPathAltitude(i);
+        g_samples[i] = readHeliADC(&plant);
+        g_altitude[i] = plant.altitude;
+        g_rate[i] = (getPathAltitude(i + 0.5) - getPathAltitude(i - 0.5)) * 1000.0;
+    }
+}
+
+
+/*
+ * Function:    readRecordedSequence
+ * ----------------------------------
+ * Fills the sequence with the ADC blocks of a recording, and a
+ * centred mean of the samples and its slope as the altitude and
+ * rate.
+ *
+ * @params:
+ *      - const char* path: The recording, as written by heliSim -r.
+ * @return:
+ *      - bool found: False if the file cannot be read or holds too
+ *      few samples.
+ * ---------------------
+ */
+static bool
+readRecordedSequence(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    flightReader_t reader;
+    flightRecord_t record;
+    uint8_t* data;
+    long length;
+    int32_t ground = 0;
+    uint32_t i;
+    uint32_t j;
+    int32_t sum;
+
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    rewind(file);
+    data = malloc(length + 1);
+    if (data == NULL || fread(data, 1, length, file) != (size_t) length) {
+        fprintf(stderr, "%s: cannot read the recording\n", path);
+        fclose(file);
+        return false;
+    }
+    fclose(file);
+
+    allocateSequence(ALT_TEST_MAX_SAMPLES);
+    initFlightReader(&reader, data, (uint32_t) length);
+    while (readFlightRecord(&reader, &record) && g_length + record.count <= ALT_TEST_MAX_SAMPLES) {
+        if (record.type == FLIGHT_RECORD_ADC_BLOCK) {
+            memcpy(&g_samples[g_length], record.samples, record.count * sizeof(*g_samples));
+            g_length += record.count;
+        }
+    }
+    free(data);
+    if (g_length < ADC_BUF_SIZE + 2 * ALT_TEST_CENTRED_HALF) {
+        fprintf(stderr, "%s: only %u ADC samples recorded\n", path, (unsigned) g_length);
+        return false;
+    }
+
+    // The recording starts on the ground, as the firmware's does
+    for (i = 0; i < ADC_BUF_SIZE; i++) {
+        ground += g_samples[i];
+    }
+    ground /= ADC_BUF_SIZE;
+
+    for (i = ALT_TEST_CENTRED_HALF; i + ALT_TEST_CENTRED_HALF < g_length; i++) {
+        sum = 0;
+        for (j = i - ALT_TEST_CENTRED_HALF; j <= i + ALT_TEST_CENTRED_HALF; j++) {
+            sum += g_samples[j];
+        }
+        g_altitude[i] = (double) HUNDRED_PERCENT * (ground - (double) sum / (2 * ALT_TEST_CENTRED_HALF + 1))
+                        / VOLTAGE_DROP_ADC;
+    }
+    for (i = 2 * ALT_TEST_CENTRED_HALF; i + 2 * ALT_TEST_CENTRED_HALF < g_length; i++) {
+        g_rate[i] = (g_altitude[i + ALT_TEST_CENTRED_HALF] - g_altitude[i - ALT_TEST_CENTRED_HALF]) * 1000.0
+                    / (2 * ALT_TEST_CENTRED_HALF);
+    }
+    return true;
+}
+
+
+/*
+ * Function:    findGround
+ * ------------------------
+ * Takes the ground reading from the first full window of samples,
+ * as the firmware does once the ADC buffer fills.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint32_t start: Index of the first sample after the ground
+ *      reading.
+ * ---------------------
+ */
+static uint32_t
+findGround(void)
+{
+    sampleRing_t ring;
+    uint32_t i;
+
+    initSampleRing(&ring, ADC_BUF_SIZE);
+    for (i = 0; i < ADC_BUF_SIZE; i++) {
+        writeSampleRing(&ring, g_samples[i]);
+    }
+    g_ground = readSampleRingMean(&ring);
+    return ADC_BUF_SIZE;
+}
+
+
+/*
+ * Function:    runMeanFilter
+ * ---------------------------
+ * Runs the mean filter the observer replaced: an integer percentage
+ * of the mean of ALT_TEST_MEAN_WINDOW samples, and its difference
+ * over ALTITUDE_PERIOD as the rate.
+ *
+ * @params:
+ *      - estimates_t* estimates: Filled at each ALTITUDE_PERIOD.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+runMeanFilter(estimates_t* estimates)
+{
+    sampleRing_t ring;
+    int32_t maxHeight = g_ground - VOLTAGE_DROP_ADC;
+    int32_t percent;
+    int32_t previous = 0;
+    uint32_t i;
+
+    initSampleRing(&ring, ALT_TEST_MEAN_WINDOW);
+    for (i = 0; i < g_length; i++) {
+        writeSampleRing(&ring, g_samples[i]);
+        if (i >= ADC_BUF_SIZE && (i + 1) % ALTITUDE_PERIOD == 0) {
+            percent = HUNDRED_PERCENT - HUNDRED_PERCENT * (readSampleRingMean(&ring) - maxHeight) / VOLTAGE_DROP_ADC;
+            estimates->altitude[i] = percent;
+            estimates->rate[i] = (double) (percent - previous) * MS_TO_SECONDS / ALTITUDE_PERIOD;
+            previous = percent;
+        }
+    }
+}
+
+
+/*
+ * Function:    runObserver
+ * -------------------------
+ * Runs the firmware's filter: the mean of ALT_FILTER_WINDOW samples
+ * as a fractional percentage, through the altitude observer.
+ *
+ * @params:
+ *      - estimates_t* estimates: Filled at each ALTITUDE_PERIOD.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+runObserver(estimates_t* estimates)
+{
+    sampleRing_t ring;
+    observer_t observer;
+    int32_t percent;
+    uint32_t i;
+
+    initSampleRing(&ring, ALT_FILTER_WINDOW);
+    initObserver(&observer, ALT_OBSERVER_ALPHA, ALT_OBSERVER_BETA, ALTITUDE_PERIOD);
+    for (i = 0; i < g_length; i++) {
+        writeSampleRing(&ring, g_samples[i]);
+        if (i >= ADC_BUF_SIZE && (i + 1) % ALTITUDE_PERIOD == 0) {
+            percent = (int32_t) (((int64_t) HUNDRED_PERCENT * OBSERVER_Q_ONE *
+                                  (g_ground - readSampleRingMean(&ring))) / VOLTAGE_DROP_ADC);
+            updateObserver(&observer, percent);
+            estimates->altitude[i] = (double) observer.position / OBSERVER_Q_ONE;
+            estimates->rate[i] = (double) observer.velocity / OBSERVER_Q_ONE;
+        }
+    }
+}
+
+
+/*
+ * Function:    measure
+ * ---------------------
+ * Finds the lag, in whole samples, at which the estimates best
+ * match the reference, and the variance of the difference at that
+ * lag.
+ *
+ * @params:
+ *      - const double* estimate: Estimates, at each ALTITUDE_PERIOD.
+ *      - const double* reference: Reference, at each sample.
+ *      - uint32_t start: First sample measured.
+ *      - uint32_t end: Sample after the last one measured.
+ *      - bool findLag: False to measure at no lag.
+ *      - double* variance: Set to the variance of the difference.
+ * @return:
+ *      - uint32_t lag: Best lag (samples, ms).
+ * ---------------------
+ */
+static uint32_t
+measure(const double* estimate, const double* reference, uint32_t start, uint32_t end, bool findLag,
+        double* variance)
+{
+    uint32_t bestLag = 0;
+    double bestError = INFINITY;
+    double sum;
+    double sumSquares;
+    double difference;
+    uint32_t count;
+    uint32_t lag;
+    uint32_t i;
+
+    if (start < ADC_BUF_SIZE + ALT_TEST_MAX_LAG) {
+        start = ADC_BUF_SIZE + ALT_TEST_MAX_LAG;
+    }
+    for (lag = 0; lag <= (findLag ? ALT_TEST_MAX_LAG : 0); lag++) {
+        sum = 0.0;
+        sumSquares = 0.0;
+        count = 0;
+        for (i = start; i < end; i++) {
+            if ((i + 1) % ALTITUDE_PERIOD == 0) {
+                difference = estimate[i] - reference[i - lag];
+                sum += difference;
+                sumSquares += difference * difference;
+                count++;
+            }
+        }
+        if (count > 0 && sumSquares < bestError) {
+            bestError = sumSquares;
+            bestLag = lag;
+            *variance = sumSquares / count - (sum / count) * (sum / count);
+        }
+    }
+    return bestLag;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    const char* recording = NULL;
+    estimates_t filters[2] = { { .name = "mean filter" }, { .name = "observer" } };
+    double altNoise[2];
+    double rateNoise[2];
+    double ignored;
+    uint32_t altLag[2];
+    uint32_t rateLag[2];
+    uint32_t noiseStart = ADC_BUF_SIZE;
+    uint32_t noiseEnd;
+    uint32_t lagStart = ADC_BUF_SIZE;
+    uint32_t lagEnd;
+    uint32_t i;
+    int option;
+
+    while ((option = getopt(argc, argv, "vr:")) != -1) {
+        switch (option) {
+            case 'v':
+                simSetCheckVerbose(true);
+                break;
+            case 'r':
+                recording = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-v] [-r flight.rec]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (recording == NULL) {
+        makePlantSequence();
+        noiseStart = PATH_GROUND_MS + PATH_CLIMB_MS + PATH_SETTLE_MS;
+        noiseEnd = PATH_GROUND_MS + PATH_CLIMB_MS + PATH_HOVER_MS;
+        lagStart = noiseEnd + PATH_SETTLE_MS;
+        lagEnd = noiseEnd + PATH_SINE_MS;
+    } else if (!readRecordedSequence(recording)) {
+        return EXIT_FAILURE;
+    } else {
+        noiseEnd = g_length - 2 * ALT_TEST_CENTRED_HALF;
+        lagEnd = noiseEnd;
+    }
+
+    findGround();
+    for (i = 0; i < 2; i++) {
+        filters[i].altitude = calloc(g_length, sizeof(double));
+        filters[i].rate = calloc(g_length, sizeof(double));
+    }
+    runMeanFilter(&filters[0]);
+    runObserver(&filters[1]);
+
+    printf("%u ms of ADC samples from %s\n", (unsigned) g_length, (recording == NULL) ? "the plant" : recording);
+    printf("filter           altitude noise (%%^2)  lag (ms)   rate noise (%%^2/s^2)  lag (ms)\n");
+    for (i = 0; i < 2; i++) {
+        if (recording == NULL) {
+            measure(filters[i].altitude, g_altitude, noiseStart, noiseEnd, false, &altNoise[i]);
+            measure(filters[i].rate, g_rate, noiseStart, noiseEnd, false, &rateNoise[i]);
+            altLag[i] = measure(filters[i].altitude, g_altitude, lagStart, lagEnd, true, &ignored);
+            rateLag[i] = measure(filters[i].rate, g_rate, lagStart, lagEnd, true, &ignored);
+        } else {
+            altLag[i] = measure(filters[i].altitude, g_altitude, lagStart, lagEnd, true, &altNoise[i]);
+            rateLag[i] = measure(filters[i].rate, g_rate, lagStart, lagEnd, true, &rateNoise[i]);
+        }
+        printf("%-16s %19.4f  %8u   %20.2f  %8u\n", filters[i].name, altNoise[i], (unsigned) altLag[i],
+               rateNoise[i], (unsigned) rateLag[i]);
+    }
+
+    // A recording's reference is only an estimate, so only the plant's sequence is checked
+    if (recording == NULL) {
+        for (i = 0; i < 2; i++) {
+            printf("%-16s phase lag at %.1f Hz: altitude %.0f deg, rate %.0f deg\n", filters[i].name,
+                   PATH_SINE_HZ, altLag[i] * PATH_PHASE_PER_MS, rateLag[i] * PATH_PHASE_PER_MS);
+        }
+        simCheck(altNoise[1] * ALT_TEST_ALT_NOISE_GAIN <= altNoise[0],
+                 "observer altitude noise %.4f at most 1/%u of the mean filter's %.4f",
+                 altNoise[1], ALT_TEST_ALT_NOISE_GAIN, altNoise[0]);
+        simCheck(rateNoise[1] * ALT_TEST_RATE_NOISE_GAIN <= rateNoise[0],
+                 "observer rate noise %.2f at most 1/%u of the mean filter's %.2f",
+                 rateNoise[1], ALT_TEST_RATE_NOISE_GAIN, rateNoise[0]);
+        simCheck(altLag[1] < ALT_TEST_MAX_ALT_LAG, "observer altitude lag %u ms under %u ms",
+                 (unsigned) altLag[1], ALT_TEST_MAX_ALT_LAG);
+        simCheck(rateLag[1] < ALT_TEST_MAX_RATE_LAG, "observer rate lag %u ms under %u ms",
+                 (unsigned) rateLag[1], ALT_TEST_MAX_RATE_LAG);
+    }
+    return simCheckResult("observerTest");
+}
@@ -0,0 +1,223 @@
+/* ****************************************************************
+ * pidBench.c
+ *
+ * Compares the firmware's fixed-point PID kernel, with the legacy
+ * preset, against the original double-precision kernel it
+ * replaced. Feeds both the same sequence of altitude and yaw
+ * setpoint steps, with the measurement lagging each step, reports
+ * the largest difference in duty and times a call of each.
+ *
+ * The host has a double-precision FPU, so the double kernel runs
+ * far faster here than in the M4F's software emulation. The times
+ * compare the kernels' arithmetic, not the target's cycle counts.
+ *
+ * Usage: pidBench [-n iterations]
+ *      -n  Calls of each kernel timed (default 10000000)
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "pidController.h"
+#include "pidReference.h"
+
+#define BENCH_ITERATIONS        10000000
+#define BENCH_SEQUENCE_LENGTH   4096        // Cycles in the step sequence, replayed until the iterations are done
+#define BENCH_STEP_CYCLES       128         // Cycles between setpoint steps
+#define BENCH_LAG_SHIFT         3           // The measurement closes 1/8 of its error each cycle
+#define BENCH_NOISE             2           // Peak measurement noise
+#define BENCH_TOLERANCE         1           // Largest duty difference allowed (%)
+#define BENCH_NS_PER_SECOND     1e9
+
+/* ******************************************************
+ * One control cycle's inputs.
+ * *****************************************************/
+typedef struct BenchInputs {
+    int32_t     reference;
+    int32_t     measurement;
+} benchInput_t;
+
+static benchInput_t g_altInputs[BENCH_SEQUENCE_LENGTH];
+static benchInput_t g_yawInputs[BENCH_SEQUENCE_LENGTH];
+
+
+/*
+ * Function:    getSeconds
+ * ------------------------
+ * Returns the monotonic clock.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - double seconds: Time (s).
+ * ---------------------
+ */
+static double
+getSeconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / BENCH_NS_PER_SECOND;
+}
+
+
+/*
+ * Function:    makeSequence
+ * --------------------------
+ * Fills a step sequence. The setpoint steps to a random value
+ * every BENCH_STEP_CYCLES and the measurement follows it with a
+ * first order lag and some noise, as the rig would.
+ *
+ * @params:
+ *      - benchInput_t* inputs: The sequence.
+ *      - int32_t low: Lowest setpoint.
+ *      - int32_t high: Highest setpoint.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+makeSequence(benchInput_t* inputs, int32_t low, int32_t high)
+{
+    int32_t reference = 0;
+    int32_t measurement = 0;
+    uint32_t i;
+
+    for (i = 0; i < BENCH_SEQUENCE_LENGTH; i++) {
+        if (i % BENCH_STEP_CYCLES == 0) {
+            reference = low + rand() % (high - low + 1);
+        }
+        measurement += (reference - measurement) / (1 << BENCH_LAG_SHIFT);
+        inputs[i].reference = reference;
+        inputs[i].measurement = measurement + rand() % (2 * BENCH_NOISE + 1) - BENCH_NOISE;
+    }
+}
+
+
+/*
+ * Function:    compareKernels
+ * ----------------------------
+ * Runs both kernels over a sequence and returns the largest
+ * difference between their duty cycles.
+ *
+ * @params:
+ *      - const benchInput_t* inputs: The sequence.
+ *      - bool isYaw: True for the yaw controller.
+ * @return:
+ *      - int32_t difference: Largest difference (% duty).
+ * ---------------------
+ */
+static int32_t
+compareKernels(const benchInput_t* inputs, bool isYaw)
+{
+    controller_t controller;
+    referenceController_t legacy;
+    int32_t largest = 0;
+    int32_t difference;
+    uint32_t i;
+
+    initController(&controller, isYaw);
+    setControllerPreset(&controller, PID_PRESET_LEGACY, isYaw);
+    initReferenceController(&legacy, &controller);
+
+    for (i = 0; i < BENCH_SEQUENCE_LENGTH; i++) {
+        difference = abs(getControlSignal(&controller, inputs[i].reference, inputs[i].measurement, isYaw) -
+                         getLegacyControlSignal(&legacy, inputs[i].reference, inputs[i].measurement, isYaw));
+        if (difference > largest) {
+            largest = difference;
+        }
+    }
+    return largest;
+}
+
+
+/*
+ * Function:    timeKernels
+ * -------------------------
+ * Times a call of each kernel on the altitude sequence and prints
+ * the times.
+ *
+ * @params:
+ *      - uint32_t iterations: Calls of each kernel.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+timeKernels(uint32_t iterations)
+{
+    controller_t controller;
+    referenceController_t legacy;
+    volatile int32_t sink = 0;              // Keeps the calls from being optimised out
+    double start;
+    double fixedSeconds;
+    double doubleSeconds;
+    uint32_t i;
+
+    initController(&controller, false);
+    setControllerPreset(&controller, PID_PRESET_LEGACY, false);
+    initReferenceController(&legacy, &controller);
+
+    start = getSeconds();
+    for (i = 0; i < iterations; i++) {
+        const benchInput_t* input = &g_altInputs[i % BENCH_SEQUENCE_LENGTH];
+        sink += getControlSignal(&controller, input->reference, input->measurement, false);
+    }
+    fixedSeconds = getSeconds() - start;
+
+    start = getSeconds();
+    for (i = 0; i < iterations; i++) {
+        const benchInput_t* input = &g_altInputs[i % BENCH_SEQUENCE_LENGTH];
+        sink += getLegacyControlSignal(&legacy, input->reference, input->measurement, false);
+    }
+    doubleSeconds = getSeconds() - start;
+
+    printf("fixed point      %6.1f ns per call\n", fixedSeconds * BENCH_NS_PER_SECOND / iterations);
+    printf("double           %6.1f ns per call, %.2fx the fixed point kernel\n",
+           doubleSeconds * BENCH_NS_PER_SECOND / iterations, doubleSeconds / fixedSeconds);
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t iterations = BENCH_ITERATIONS;
+    int32_t altDifference;
+    int32_t yawDifference;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:")) != -1) {
+        switch (option) {
+            case 'n':
+                iterations = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    srand(1);
+    makeSequence(g_altInputs, 0, 100);
+    makeSequence(g_yawInputs, -180, 179);
+
+    altDifference = compareKernels(g_altInputs, false);
+    yawDifference = compareKernels(g_yawInputs, true);
+    printf("largest difference altitude %d %%, yaw %d %% duty over %u cycles (tolerance %d %%)\n",
+           (int) altDifference, (int) yawDifference, (unsigned) BENCH_SEQUENCE_LENGTH, BENCH_TOLERANCE);
+    timeKernels(iterations);
+
+    return (altDifference <= BENCH_TOLERANCE && yawDifference <= BENCH_TOLERANCE) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
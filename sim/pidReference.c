@@ -0,0 +1,381 @@
+/* ****************************************************************
+ * pidReference.c
+ *
+ * Source file of the host reference PID kernels.
+ * Keeps the original double-precision getControlSignal, as it was
+ * before the fixed-point kernel replaced it, so the firmware's
+ * kernel can be timed and checked against it on the host. Also
+ * keeps a double-precision copy of the generalised kernel, with
+ * every anti-windup, derivative and weighting option, which the
+ * firmware dropped when it went fixed point only. Never built
+ * for the target.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include "pidReference.h"
+
+#define REFERENCE_Q_ONE     ((double) PID_Q_ONE)
+
+
+/*
+ * Function:    initReferenceController
+ * -------------------------------------
+ * Copies the gains and time step of a firmware controller and
+ * clears the state.
+ *
+ * @params:
+ *      - referenceController_t* reference: The reference controller.
+ *      - const controller_t* controller: The firmware controller.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initReferenceController(referenceController_t* reference, const controller_t* controller)
+{
+    reference->Kp = controller->Kp;
+    reference->Ki = controller->Ki;
+    reference->Kd = controller->Kd;
+    reference->timeStep = controller->timeStep;
+    reference->divisor = controller->divisor;
+    reference->previousError = 0;
+    reference->integratedError = 0;
+}
+
+
+/*
+ * Function:    getLegacyControlSignal
+ * ------------------------------------
+ * The original double-precision kernel: derivative on error,
+ * integrator backed off above MAX_DUTY only, output limited to
+ * MIN_DUTY to MAX_DUTY.
+ *
+ * @params:
+ *      - referenceController_t* controller: The reference controller.
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - bool isYaw: True if the controller is for yaw.
+ * @return:
+ *      - int32_t dutyCycle: The duty cycle.
+ * ---------------------
+ */
+int32_t
+getLegacyControlSignal(referenceController_t* controller, int32_t reference, int32_t measurement, bool isYaw)
+{
+    int32_t dutyCycle;
+    int32_t controlSignal;
+
+    double errorSignal;
+    double derivativeError;
+
+    // Calculate error signal
+    errorSignal = reference - measurement;
+
+    //Clockwise rotation corresponds to low power in motors
+    if(isYaw)
+    {
+        // If the error would cause a rotation in the wrong direction
+        if(errorSignal >= (DEGREES_CIRCLE/2))
+        {
+            errorSignal = errorSignal - DEGREES_CIRCLE;
+        } else if(errorSignal < (-(DEGREES_CIRCLE/2)))
+        {
+            errorSignal = DEGREES_CIRCLE + errorSignal;
+        }
+    }
+
+    //Calculate the control signal using PID methods and duty cycle
+    derivativeError = (errorSignal - controller->previousError)/(controller->timeStep);
+    controller->integratedError += controller->timeStep * errorSignal;
+    controlSignal = (controller->Kp * errorSignal)  + (controller->Ki * controller->integratedError)/MS_TO_SECONDS + (controller->Kd) * derivativeError * MS_TO_SECONDS;
+    dutyCycle = (controlSignal/(controller->divisor));
+
+    controller->previousError = errorSignal;
+
+    //Enforce duty cycle output limits
+    if(dutyCycle > MAX_DUTY)
+    {
+        dutyCycle = MAX_DUTY;
+        controller->integratedError -= controller->timeStep * errorSignal/MS_TO_SECONDS;
+    } else if(dutyCycle < MIN_DUTY)
+    {
+        dutyCycle = MIN_DUTY;
+    }
+
+    return dutyCycle;
+}
+
+
+/*
+ * Function:    initReferencePid
+ * ------------------------------
+ * Copies the gains, options, limits and feedforward of a firmware
+ * controller and clears the state.
+ *
+ * @params:
+ *      - referencePid_t* reference: The reference controller.
+ *      - const controller_t* controller: The firmware controller.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initReferencePid(referencePid_t* reference, const controller_t* controller)
+{
+    double divisor = controller->divisor;
+    double timeStep = controller->timeStep;
+
+    reference->Kp = controller->Kp / divisor;
+    reference->Ki = controller->Ki * timeStep / (MS_TO_SECONDS * divisor);
+    reference->Kd = controller->Kd * MS_TO_SECONDS / (timeStep * divisor);
+    reference->KdRate = controller->Kd / divisor;
+    reference->Kff = controller->Kff / divisor;
+
+    reference->antiWindup = controller->antiWindup;
+    reference->backCalc = controller->backCalcQ / REFERENCE_Q_ONE;
+    reference->derivativeOnMeasurement = controller->derivativeOnMeasurement;
+    reference->dFilter = controller->dFilterQ / REFERENCE_Q_ONE;
+    reference->setpointWeight = controller->setpointWeightQ / REFERENCE_Q_ONE;
+    reference->outputMin = controller->outputMin;
+    reference->outputMax = controller->outputMax;
+    reference->feedforward = controller->feedforward;
+
+    reference->previousError = 0;
+    reference->previousMeasurement = 0;
+    reference->previousReference = 0;
+    reference->primed = false;
+    reference->derivativeState = 0;
+    reference->integral = 0;
+}
+
+
+/*
+ * Function:    wrapReferenceDifference
+ * -------------------------------------
+ * Wraps a difference in yaw so the helicopter always turns the
+ * short way round. Altitude differences are returned unchanged.
+ *
+ * @params:
+ *      - double difference: The difference to wrap.
+ *      - bool isYaw: True if the difference is in yaw.
+ * @return:
+ *      - double difference: The (wrapped) difference.
+ * ---------------------
+ */
+static double
+wrapReferenceDifference(double difference, bool isYaw)
+{
+    if (isYaw) {
+        if (difference >= DEGREES_CIRCLE / 2) {
+            difference -= DEGREES_CIRCLE;
+        } else if (difference < -(DEGREES_CIRCLE / 2)) {
+            difference += DEGREES_CIRCLE;
+        }
+    }
+
+    return difference;
+}
+
+
+/*
+ * Function:    clampReference
+ * ----------------------------
+ * Limits a duty contribution to +/-PID_INTEGRAL_LIMIT.
+ *
+ * @params:
+ *      - double value: The value to limit.
+ * @return:
+ *      - double value: The limited value.
+ * ---------------------
+ */
+static double
+clampReference(double value)
+{
+    if (value > PID_INTEGRAL_LIMIT) {
+        value = PID_INTEGRAL_LIMIT;
+    } else if (value < -PID_INTEGRAL_LIMIT) {
+        value = -PID_INTEGRAL_LIMIT;
+    }
+
+    return value;
+}
+
+
+/*
+ * Function:    applyReferenceControl
+ * -----------------------------------
+ * Kernel shared by both reference control signal functions.
+ * Filters the derivative term, integrates the error with the
+ * selected anti-windup method, sums the terms and enforces the
+ * output limits.
+ *
+ * @params:
+ *      - referencePid_t* controller: The reference controller.
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - bool isYaw: True if the controller is for yaw.
+ *      - double derivativeTerm: The unfiltered derivative
+ *      contribution to the duty cycle.
+ *      - double feedforwardTerm: Duty added to the PID terms
+ *      before the limits are applied.
+ * @return:
+ *      - int32_t dutyCycle: The limited duty cycle.
+ * ---------------------
+ */
+static int32_t
+applyReferenceControl(referencePid_t* controller, int32_t reference, int32_t measurement, bool isYaw,
+                      double derivativeTerm, double feedforwardTerm)
+{
+    double errorSignal = wrapReferenceDifference(reference - measurement, isYaw);
+    double proportionalTerm;
+    double controlSignal;
+    int32_t dutyCycle;
+    bool integrate = true;
+
+    if (isYaw) {
+        proportionalTerm = controller->Kp * errorSignal;
+    } else {
+        proportionalTerm = controller->Kp * (controller->setpointWeight * reference - measurement);
+    }
+
+    controller->derivativeState = clampReference(controller->derivativeState +
+        (derivativeTerm - controller->derivativeState) * controller->dFilter);
+
+    if (controller->antiWindup == PID_WINDUP_CONDITIONAL) {
+        controlSignal = feedforwardTerm + proportionalTerm + controller->integral + controller->derivativeState;
+        if ((controlSignal > controller->outputMax && errorSignal > 0) ||
+            (controlSignal < controller->outputMin && errorSignal < 0)) {
+            integrate = false;
+        }
+    }
+    if (integrate) {
+        controller->integral = clampReference(controller->integral + controller->Ki * errorSignal);
+    }
+
+    controlSignal = feedforwardTerm + proportionalTerm + controller->integral + controller->derivativeState;
+    dutyCycle = (int32_t) controlSignal;                            // Truncates towards zero
+
+    controller->previousError = errorSignal;
+    controller->previousMeasurement = measurement;
+    controller->previousReference = reference;
+
+    if (dutyCycle > controller->outputMax) {
+        dutyCycle = controller->outputMax;
+        if (controller->antiWindup == PID_WINDUP_LEGACY) {
+            controller->integral -= controller->Ki * errorSignal / MS_TO_SECONDS;
+        }
+    } else if (dutyCycle < controller->outputMin) {
+        dutyCycle = controller->outputMin;
+    } else {
+        return dutyCycle;
+    }
+
+    if (controller->antiWindup == PID_WINDUP_BACK_CALC) {
+        controller->integral = clampReference(controller->integral +
+                                              (dutyCycle - controlSignal) * controller->backCalc);
+    }
+
+    return dutyCycle;
+}
+
+
+/*
+ * Function:    primeReferencePid
+ * -------------------------------
+ * Records the current measurement and reference as the previous
+ * values on the first cycle after a reset.
+ *
+ * @params:
+ *      - referencePid_t* controller: The reference controller.
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t measurement: Actual yaw/altitude
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+primeReferencePid(referencePid_t* controller, int32_t reference, int32_t measurement)
+{
+    if (!controller->primed) {
+        controller->previousMeasurement = measurement;
+        controller->previousReference = reference;
+        controller->primed = true;
+    }
+}
+
+
+/*
+ * Function:    getReferenceControlSignal
+ * ---------------------------------------
+ * The generalised kernel in double precision, as getControlSignal
+ * computes it in fixed point.
+ *
+ * @params:
+ *      - referencePid_t* controller: The reference controller.
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - bool isYaw: True if the controller is for yaw.
+ * @return:
+ *      - int32_t dutyCycle: The duty cycle.
+ * ---------------------
+ */
+int32_t
+getReferenceControlSignal(referencePid_t* controller, int32_t reference, int32_t measurement, bool isYaw)
+{
+    double derivativeTerm;
+
+    primeReferencePid(controller, reference, measurement);
+
+    if (controller->derivativeOnMeasurement) {
+        derivativeTerm = -controller->Kd *
+                         wrapReferenceDifference(measurement - controller->previousMeasurement, isYaw);
+    } else {
+        derivativeTerm = controller->Kd *
+                         (wrapReferenceDifference(reference - measurement, isYaw) - controller->previousError);
+    }
+
+    return applyReferenceControl(controller, reference, measurement, isYaw, derivativeTerm,
+                                 controller->feedforward);
+}
+
+
+/*
+ * Function:    getReferenceControlSignalWithRate
+ * -----------------------------------------------
+ * The generalised kernel in double precision, as
+ * getControlSignalWithRate computes it in fixed point.
+ *
+ * @params:
+ *      - referencePid_t* controller: The reference controller.
+ *      - int32_t reference: Target yaw/altitude
+ *      - double referenceRate: Rate of change of the reference (units/s)
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - double measurementRate: Rate of change of the measurement (units/s)
+ *      - bool isYaw: True if the controller is for yaw.
+ * @return:
+ *      - int32_t dutyCycle: The duty cycle.
+ * ---------------------
+ */
+int32_t
+getReferenceControlSignalWithRate(referencePid_t* controller, int32_t reference, double referenceRate,
+                                  int32_t measurement, double measurementRate, bool isYaw)
+{
+    double derivativeTerm = -controller->KdRate * measurementRate;
+    double feedforwardTerm = controller->feedforward + controller->Kff * referenceRate;
+
+    primeReferencePid(controller, reference, measurement);
+
+    if (controller->derivativeOnMeasurement) {
+        derivativeTerm += controller->KdRate * referenceRate;
+    } else {
+        derivativeTerm += controller->Kd * wrapReferenceDifference(reference - controller->previousReference, isYaw);
+    }
+
+    return applyReferenceControl(controller, reference, measurement, isYaw, derivativeTerm, feedforwardTerm);
+}
@@ -0,0 +1,159 @@
+/* ****************************************************************
+ * pidReference.h
+ *
+ * Header file of the host reference PID kernels.
+ * Keeps the original double-precision getControlSignal, as it was
+ * before the fixed-point kernel replaced it, so the firmware's
+ * kernel can be timed and checked against it on the host. Also
+ * keeps a double-precision copy of the generalised kernel, with
+ * every anti-windup, derivative and weighting option, which the
+ * firmware dropped when it went fixed point only. Never built
+ * for the target.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef PIDREFERENCE_H_
+#define PIDREFERENCE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pidController.h"
+
+/* ******************************************************
+ * State of the original kernel. The gains and time step
+ * are copied from a firmware controller.
+ * *****************************************************/
+typedef struct ReferenceControllers {
+    int32_t     Kp;
+    int32_t     Ki;
+    int32_t     Kd;
+    uint32_t    timeStep;         // Control period (ms)
+    int32_t     divisor;
+    int32_t     previousError;
+    int32_t     integratedError;  // Integrated error (error.ms)
+} referenceController_t;
+
+
+/* ******************************************************
+ * State of the generalised double-precision kernel. The
+ * gains are in duty per unit, per control cycle for Ki and
+ * Kd, and are copied from a firmware controller's integer
+ * gains without its gain schedule.
+ * *****************************************************/
+typedef struct ReferencePids {
+    double      Kp;
+    double      Ki;
+    double      Kd;
+    double      KdRate;           // Duty per unit/s of rate
+    double      Kff;              // Duty per unit/s of reference rate
+
+    pidAntiWindup_t antiWindup;
+    double      backCalc;
+    bool        derivativeOnMeasurement;
+    double      dFilter;
+    double      setpointWeight;
+    int32_t     outputMin;
+    int32_t     outputMax;
+    double      feedforward;
+
+    double      previousError;
+    double      previousMeasurement;
+    double      previousReference;
+    bool        primed;
+    double      derivativeState;
+    double      integral;         // Integral contribution to the duty cycle
+} referencePid_t;
+
+
+/*
+ * Function:    initReferenceController
+ * -------------------------------------
+ * Copies the gains and time step of a firmware controller and
+ * clears the state.
+ *
+ * @params:
+ *      - referenceController_t* reference: The reference controller.
+ *      - const controller_t* controller: The firmware controller.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initReferenceController(referenceController_t* reference, const controller_t* controller);
+
+/*
+ * Function:    getLegacyControlSignal
+ * ------------------------------------
+ * The original double-precision kernel: derivative on error,
+ * integrator backed off above MAX_DUTY only, output limited to
+ * MIN_DUTY to MAX_DUTY.
+ *
+ * @params:
+ *      - referenceController_t* controller: The reference controller.
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - bool isYaw: True if the controller is for yaw.
+ * @return:
+ *      - int32_t dutyCycle: The duty cycle.
+ * ---------------------
+ */
+int32_t getLegacyControlSignal(referenceController_t* controller, int32_t reference, int32_t measurement, bool isYaw);
+
+/*
+ * Function:    initReferencePid
+ * ------------------------------
+ * Copies the gains, options, limits and feedforward of a firmware
+ * controller and clears the state.
+ *
+ * @params:
+ *      - referencePid_t* reference: The reference controller.
+ *      - const controller_t* controller: The firmware controller.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initReferencePid(referencePid_t* reference, const controller_t* controller);
+
+/*
+ * Function:    getReferenceControlSignal
+ * ---------------------------------------
+ * The generalised kernel in double precision, as getControlSignal
+ * computes it in fixed point.
+ *
+ * @params:
+ *      - referencePid_t* controller: The reference controller.
+ *      - int32_t reference: Target yaw/altitude
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - bool isYaw: True if the controller is for yaw.
+ * @return:
+ *      - int32_t dutyCycle: The duty cycle.
+ * ---------------------
+ */
+int32_t getReferenceControlSignal(referencePid_t* controller, int32_t reference, int32_t measurement, bool isYaw);
+
+/*
+ * Function:    getReferenceControlSignalWithRate
+ * -----------------------------------------------
+ * The generalised kernel in double precision, as
+ * getControlSignalWithRate computes it in fixed point.
+ *
+ * @params:
+ *      - referencePid_t* controller: The reference controller.
+ *      - int32_t reference: Target yaw/altitude
+ *      - double referenceRate: Rate of change of the reference (units/s)
+ *      - int32_t measurement: Actual yaw/altitude
+ *      - double measurementRate: Rate of change of the measurement (units/s)
+ *      - bool isYaw: True if the controller is for yaw.
+ * @return:
+ *      - int32_t dutyCycle: The duty cycle.
+ * ---------------------
+ */
+int32_t getReferenceControlSignalWithRate(referencePid_t* controller, int32_t reference, double referenceRate,
+                                          int32_t measurement, double measurementRate, bool isYaw);
+
+#endif /* PIDREFERENCE_H_ */
@@ -0,0 +1,262 @@
+/* ****************************************************************
+ * pidTest.c
+ *
+ * Checks the firmware's fixed-point PID kernel against the
+ * double-precision reference kernels kept in pidReference.c.
+ * Each case sets a controller's options, then closes the loop
+ * around a simple rotor model through a sequence of setpoint
+ * steps, driven by the firmware's duty. Both kernels see the same
+ * references and measurements each cycle.
+ *
+ * Usage: pidTest [-v]
+ *      -v  Print every check, not just the failures
+ *
+ * Checks that, over every cycle of the sequence:
+ *      - the legacy preset gives the original kernel's duty to
+ *        within PID_TEST_TOLERANCE
+ *      - each combination of anti-windup, derivative form and
+ *        rate input gives the generalised reference kernel's
+ *        duty to within PID_TEST_TOLERANCE
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include "simTest.h"
+#include "pidController.h"
+#include "pidReference.h"
+
+#define PID_TEST_TOLERANCE      1           // Largest duty difference allowed (%)
+#define PID_TEST_STEP_CYCLES    200         // Cycles each setpoint is held
+#define PID_TEST_RAMP           1           // Reference change per cycle of the rate cases
+#define PID_TEST_HOVER_DUTY     40          // Duty the rotor model holds still at
+#define PID_TEST_ALT_GAIN       2.0         // Altitude model's climb rate per duty above hover (%/s)
+#define PID_TEST_YAW_GAIN       20.0        // Yaw model's spin rate per duty above hover (deg/s)
+#define PID_TEST_LAG            3.0         // Rotor model's rate bandwidth (1/s)
+#define PID_TEST_ALT_FEEDFORWARD 30         // Duty fed forward in the altitude cases
+#define PID_TEST_SECONDS        (1.0 / MS_TO_SECONDS)
+#define PID_TEST_ORIGINAL       -1          // Option left as the preset sets it
+
+/* ******************************************************
+ * One controller configuration to check.
+ * *****************************************************/
+typedef struct PidCases {
+    const char* name;
+    bool        isYaw;
+    pidPreset_t preset;
+    int32_t     antiWindup;       // A pidAntiWindup_t, or PID_TEST_ORIGINAL
+    int32_t     derivativeOnMeasurement; // 0 or 1, or PID_TEST_ORIGINAL
+    bool        withRate;         // True to call getControlSignalWithRate
+} pidCase_t;
+
+static const int32_t g_altSteps[] = {0, 10, 20, 50, 100, 40, 0, 90, 30};
+static const int32_t g_yawSteps[] = {0, 90, 179, -180, -90, 45, 170, -170, 0};
+
+static const pidCase_t g_cases[] = {
+    {"altitude legacy",           false, PID_PRESET_LEGACY,   PID_TEST_ORIGINAL,      PID_TEST_ORIGINAL, false},
+    {"altitude improved",         false, PID_PRESET_IMPROVED, PID_TEST_ORIGINAL,      PID_TEST_ORIGINAL, false},
+    {"altitude conditional",      false, PID_PRESET_IMPROVED, PID_WINDUP_CONDITIONAL, PID_TEST_ORIGINAL, false},
+    {"altitude D on error",       false, PID_PRESET_IMPROVED, PID_TEST_ORIGINAL,      0,                 false},
+    {"altitude with rate",        false, PID_PRESET_IMPROVED, PID_TEST_ORIGINAL,      PID_TEST_ORIGINAL, true},
+    {"yaw legacy",                true,  PID_PRESET_LEGACY,   PID_TEST_ORIGINAL,      PID_TEST_ORIGINAL, false},
+    {"yaw improved",              true,  PID_PRESET_IMPROVED, PID_TEST_ORIGINAL,      PID_TEST_ORIGINAL, false},
+    {"yaw conditional",           true,  PID_PRESET_IMPROVED, PID_WINDUP_CONDITIONAL, PID_TEST_ORIGINAL, false},
+    {"yaw with rate",             true,  PID_PRESET_IMPROVED, PID_TEST_ORIGINAL,      PID_TEST_ORIGINAL, true},
+    {"yaw with rate, D on error", true,  PID_PRESET_IMPROVED, PID_TEST_ORIGINAL,      0,                 true},
+};
+
+#define PID_TEST_CASES          (sizeof(g_cases) / sizeof(g_cases[0]))
+#define PID_TEST_STEPS          (sizeof(g_altSteps) / sizeof(g_altSteps[0]))
+
+
+// The test calls the kernels itself and never starts the scheduler
+void runSimulation(void) {}
+
+
+/*
+ * Function:    toQ16
+ * -------------------
+ * Converts a rate to the Q16.16 the firmware's kernel takes.
+ *
+ * @params:
+ *      - double rate: The rate (units/s).
+ * @return:
+ *      - int32_t rate: The rate in Q16.16.
+ * ---------------------
+ */
+static int32_t
+toQ16(double rate)
+{
+    return (int32_t) lround(rate * (1 << PID_RATE_Q_BITS));
+}
+
+
+/*
+ * Function:    wrapYaw
+ * ---------------------
+ * Wraps a yaw to -180 to 180 degrees.
+ *
+ * @params:
+ *      - double yaw: The yaw (degrees).
+ * @return:
+ *      - double yaw: The wrapped yaw.
+ * ---------------------
+ */
+static double
+wrapYaw(double yaw)
+{
+    while (yaw >= DEGREES_CIRCLE / 2) {
+        yaw -= DEGREES_CIRCLE;
+    }
+    while (yaw < -(DEGREES_CIRCLE / 2)) {
+        yaw += DEGREES_CIRCLE;
+    }
+    return yaw;
+}
+
+
+/*
+ * Function:    runCase
+ * ---------------------
+ * Runs one configuration through the step sequence and checks
+ * the firmware's duty against the reference kernel's each cycle.
+ *
+ * @params:
+ *      - const pidCase_t* test: The configuration.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+runCase(const pidCase_t* test)
+{
+    const int32_t* steps = test->isYaw ? g_yawSteps : g_altSteps;
+    double seconds = CONTROL_PERIOD * PID_TEST_SECONDS;
+    double gain = test->isYaw ? PID_TEST_YAW_GAIN : PID_TEST_ALT_GAIN;
+    controller_t controller;
+    referencePid_t reference;
+    referenceController_t original;
+    double position = 0;
+    double rate = 0;
+    int32_t setpoint = 0;
+    int32_t target;
+    int32_t referenceRate;
+    int32_t measurement;
+    int32_t measurementRate;
+    int32_t duty;
+    int32_t expected;
+    int32_t differences = 0;
+    int32_t worst = 0;
+    int32_t originalWorst = 0;
+    uint32_t cycle;
+
+    initController(&controller, test->isYaw);
+    setControllerPreset(&controller, test->preset, test->isYaw);
+    if (test->antiWindup != PID_TEST_ORIGINAL) {
+        controller.antiWindup = (pidAntiWindup_t) test->antiWindup;
+    }
+    if (test->derivativeOnMeasurement != PID_TEST_ORIGINAL) {
+        controller.derivativeOnMeasurement = test->derivativeOnMeasurement;
+    }
+    if (!test->isYaw && test->preset != PID_PRESET_LEGACY) {
+        setControllerFeedforward(&controller, PID_TEST_ALT_FEEDFORWARD);
+    }
+    initReferencePid(&reference, &controller);
+    initReferenceController(&original, &controller);
+
+    for (cycle = 0; cycle < PID_TEST_STEPS * PID_TEST_STEP_CYCLES; cycle++) {
+        target = steps[cycle / PID_TEST_STEP_CYCLES];
+        referenceRate = 0;
+        if (!test->withRate) {
+            setpoint = target;
+        } else if (setpoint != target) {
+            // Ramp the short way round, as the trajectory generator does
+            int32_t direction = (wrapDifference(target - setpoint, test->isYaw) > 0) ? 1 : -1;
+            setpoint += direction * PID_TEST_RAMP;
+            if (test->isYaw) {
+                setpoint = (int32_t) wrapYaw(setpoint);
+            }
+            referenceRate = toQ16(direction * PID_TEST_RAMP / seconds);
+        }
+        measurement = (int32_t) lround(position);
+        if (test->isYaw) {
+            measurement = (int32_t) wrapYaw(measurement);
+        }
+        measurementRate = toQ16(rate);
+
+        if (test->withRate) {
+            duty = getControlSignalWithRate(&controller, setpoint, referenceRate, measurement, measurementRate,
+                                            test->isYaw);
+            expected = getReferenceControlSignalWithRate(&reference, setpoint,
+                                                         (double) referenceRate / (1 << PID_RATE_Q_BITS),
+                                                         measurement,
+                                                         (double) measurementRate / (1 << PID_RATE_Q_BITS),
+                                                         test->isYaw);
+        } else {
+            duty = getControlSignal(&controller, setpoint, measurement, test->isYaw);
+            expected = getReferenceControlSignal(&reference, setpoint, measurement, test->isYaw);
+        }
+        if (duty != expected) {
+            differences++;
+        }
+        if (abs(duty - expected) > worst) {
+            worst = abs(duty - expected);
+        }
+        if (test->preset == PID_PRESET_LEGACY) {
+            expected = getLegacyControlSignal(&original, setpoint, measurement, test->isYaw);
+            if (abs(duty - expected) > originalWorst) {
+                originalWorst = abs(duty - expected);
+            }
+        }
+
+        // First order rotor model, driven by the firmware's duty
+        rate += (gain * (duty - PID_TEST_HOVER_DUTY) - rate) * PID_TEST_LAG * seconds;
+        position += rate * seconds;
+        if (test->isYaw) {
+            position = wrapYaw(position);
+        } else if (position < 0 || position > 100) {
+            position = (position < 0) ? 0 : 100;
+            rate = 0;
+        }
+    }
+
+    simCheck(worst <= PID_TEST_TOLERANCE, "%s: duty within %d of the reference kernel (%d cycles differ by %d at most)",
+             test->name, PID_TEST_TOLERANCE, (int) differences, (int) worst);
+    if (test->preset == PID_PRESET_LEGACY) {
+        simCheck(originalWorst <= PID_TEST_TOLERANCE, "%s: duty within %d of the original kernel (%d at most)",
+                 test->name, PID_TEST_TOLERANCE, (int) originalWorst);
+    }
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t i;
+    int option;
+
+    while ((option = getopt(argc, argv, "v")) != -1) {
+        switch (option) {
+            case 'v':
+                simSetCheckVerbose(true);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    for (i = 0; i < PID_TEST_CASES; i++) {
+        runCase(&g_cases[i]);
+    }
+
+    return simCheckResult("pidTest");
+}
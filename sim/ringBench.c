@@ -0,0 +1,176 @@
+/* ****************************************************************
+ * ringBench.c
+ *
+ * Checks the sample ring's running mean against a mean summed
+ * over the window, including across the wrap of its count of
+ * samples written, then times a sample written and a mean read
+ * for windows of 8 to SAMPLE_RING_CAPACITY samples. The ring's
+ * time should not grow with the window. The summed mean, as the
+ * circular buffer it replaced took, is timed alongside. Only the
+ * mean check fails the benchmark; the times are for reading.
+ *
+ * Usage: ringBench [-n iterations]
+ *      -n  Samples written and means read per window (default 1000000)
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "sampleRing.h"
+#include "simTest.h"
+
+#define BENCH_ITERATIONS        1000000
+#define BENCH_MIN_WINDOW        8
+#define BENCH_CHECK_SAMPLES     100000      // Samples written in the mean check
+#define BENCH_WINDOW_CHANGES    64          // Samples between window changes in the mean check
+#define BENCH_SAMPLE_MASK       0xFFF       // Samples are 12 bit, as the ADC's
+#define BENCH_NS_PER_SECOND     1e9
+
+static sampleRing_t g_ring;
+
+
+/*
+ * Function:    getSummedMean
+ * ---------------------------
+ * Sums the newest samples in the ring, one at a time, as the
+ * circular buffer's mean did.
+ *
+ * @params:
+ *      - sampleRing_t* ring: The ring.
+ * @return:
+ *      - int32_t mean: Mean of the newest 'window' samples.
+ * ---------------------
+ */
+static int32_t
+getSummedMean(sampleRing_t* ring)
+{
+    uint32_t count = (ring->filled < ring->window) ? ring->filled : ring->window;
+    uint32_t sum = 0;
+    uint32_t i;
+
+    if (count == 0) {
+        return 0;
+    }
+    for (i = 1; i <= count; i++) {
+        sum += ring->data[(ring->windex - i) & SAMPLE_RING_MASK];
+    }
+    return (int32_t) (sum / count);
+}
+
+
+/*
+ * Function:    checkMeans
+ * ------------------------
+ * Writes random samples, changing the window every few samples,
+ * and checks the running mean against the summed mean after each.
+ * The ring's count of samples written starts at 'start', so the
+ * check can be run across its wrap.
+ *
+ * @params:
+ *      - uint32_t start: Count of samples written to start from.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+checkMeans(uint32_t start)
+{
+    uint32_t mismatches = 0;
+    uint32_t i;
+
+    initSampleRing(&g_ring, BENCH_MIN_WINDOW);
+    g_ring.windex = start;
+    for (i = 0; i < BENCH_CHECK_SAMPLES; i++) {
+        if (i % BENCH_WINDOW_CHANGES == 0) {
+            setSampleRingWindow(&g_ring, 1 + rand() % SAMPLE_RING_CAPACITY);
+        }
+        writeSampleRing(&g_ring, rand() & BENCH_SAMPLE_MASK);
+        if (readSampleRingMean(&g_ring) != getSummedMean(&g_ring)) {
+            mismatches++;
+        }
+    }
+    simCheck(mismatches == 0, "running mean from sample %u matches the summed mean (%u of %u differ)",
+             (unsigned) start, (unsigned) mismatches, (unsigned) BENCH_CHECK_SAMPLES);
+}
+
+
+/*
+ * Function:    timeWindow
+ * ------------------------
+ * Times a sample written and a mean read with a full window,
+ * using the running mean or the summed mean.
+ *
+ * @params:
+ *      - uint32_t window: Samples averaged.
+ *      - uint32_t iterations: Samples written and means read.
+ *      - bool summed: True to read the summed mean.
+ * @return:
+ *      - double time: Time of a write and read (ns).
+ * ---------------------
+ */
+static double
+timeWindow(uint32_t window, uint32_t iterations, bool summed)
+{
+    volatile int32_t sink = 0;              // Keeps the reads from being optimised out
+    double start;
+    uint32_t i;
+
+    initSampleRing(&g_ring, window);
+    for (i = 0; i < window; i++) {
+        writeSampleRing(&g_ring, i & BENCH_SAMPLE_MASK);
+    }
+
+    start = simGetSeconds();
+    for (i = 0; i < iterations; i++) {
+        writeSampleRing(&g_ring, i & BENCH_SAMPLE_MASK);
+        sink += summed ? getSummedMean(&g_ring) : readSampleRingMean(&g_ring);
+    }
+    return (simGetSeconds() - start) * BENCH_NS_PER_SECOND / iterations;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t iterations = BENCH_ITERATIONS;
+    uint32_t summedIterations;
+    uint32_t window;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:")) != -1) {
+        switch (option) {
+            case 'n':
+                iterations = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    srand(1);
+    checkMeans(0);
+    checkMeans(UINT32_MAX - BENCH_CHECK_SAMPLES / 2);          // Across the wrap of the count of samples written
+
+    printf("window   ring (ns)   summed (ns)\n");
+    for (window = BENCH_MIN_WINDOW; window <= SAMPLE_RING_CAPACITY; window *= 2) {
+        summedIterations = iterations / (window / BENCH_MIN_WINDOW);   // The summed mean slows with the window
+        if (summedIterations < 1) {
+            summedIterations = 1;
+        }
+        printf("%6u   %9.1f   %11.1f\n", (unsigned) window, timeWindow(window, iterations, false),
+               timeWindow(window, summedIterations, true));
+    }
+
+    return simCheckResult("ringBench");
+}
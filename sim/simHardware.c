@@ -0,0 +1,1209 @@
+/* ****************************************************************
+ * simHardware.c
+ *
+ * Source file of the simulator's TM4C123 peripheral models.
+ * Implements the driverlib calls the firmware makes against a
+ * simulated clock. Only the behaviour the firmware depends on is
+ * modelled: GPIO levels and edge interrupts, periodic and free
+ * running timers, PWM duty cycles, timer triggered ADC
+ * conversions into uDMA ping-pong blocks, the quadrature encoder
+ * interface, and the UART.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simHardware.h"
+#include "simRTOS.h"
+#include "inc/hw_memmap.h"
+#include "inc/tm4c123gh6pm.h"
+#include "driverlib/adc.h"
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/pwm.h"
+#include "driverlib/qei.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+#include "OrbitOLED/OrbitOLEDInterface.h"
+#include "profiler.h"
+
+#define SIM_UDMA_CHANNEL_MASK   0x1F        // Channel number within a channel structure index
+#define SIM_TIMER_UP            0x10        // Count up bit of the timer configuration
+#define SIM_QEI_PORT            GPIO_PORTD_BASE
+#define SIM_QEI_PHA             GPIO_PIN_6
+#define SIM_QEI_PHB             GPIO_PIN_7
+#define SIM_QEI_IDX             GPIO_PIN_3
+
+/* ******************************************************
+ * A GPIO port. Pins not driven from outside read their
+ * pull resistor, or low without one.
+ * *****************************************************/
+typedef struct SimGPIOPorts {
+    uint8_t     outputs;          // Pins configured as outputs
+    uint8_t     outputLevel;      // Levels written to the outputs
+    uint8_t     driven;           // Input pins driven from outside the board
+    uint8_t     drivenLevel;      // Levels of the driven inputs
+    uint8_t     pullUp;           // Undriven inputs that read high
+    uint8_t     bothEdges;        // Pins interrupting on both edges
+    uint8_t     risingEdge;       // Pins interrupting on a rising edge (otherwise falling)
+    uint8_t     intEnabled;
+    uint8_t     intStatus;
+    void        (*handler)(void);
+} simGPIOPort_t;
+
+typedef struct SimTimers {
+    uint32_t    config;
+    uint32_t    load;
+    bool        enabled;
+    bool        adcTrigger;       // Timeouts start an ADC conversion
+    bool        intEnabled;
+    uint32_t    (*input)(void);   // Supplies the count read instead of the clock, if set
+    uint64_t    startNs;          // Time the timer was enabled
+    uint64_t    nextTimeoutNs;
+    void        (*handler)(void);
+} simTimer_t;
+
+typedef struct SimPWMs {
+    uint32_t    period[SIM_PWM_OUTPUTS / 2];  // Per generator
+    bool        genEnabled[SIM_PWM_OUTPUTS / 2];
+    uint32_t    width[SIM_PWM_OUTPUTS];
+    uint32_t    outputEnabled;                // PWM_OUT_n_BIT mask
+} simPWM_t;
+
+/* ******************************************************
+ * The quadrature encoder interface. Counts every edge of
+ * the PD6 (PhA) and PD7 (PhB) pins, up when PhA leads,
+ * and raises the index interrupt on a rising edge of PD3
+ * (IDX). The position is not reset by the index.
+ * *****************************************************/
+typedef struct SimQEIs {
+    uint32_t    config;
+    uint32_t    maxPosition;
+    bool        enabled;
+    uint32_t    position;
+    int32_t     direction;        // 1 or -1, from the last edge counted
+    uint8_t     phases;           // PhA in bit 0, PhB in bit 1, after any swap
+    bool        velocityEnabled;
+    uint32_t    velocityPeriod;   // Clocks
+    uint32_t    velocityCount;    // Edges counted in this period
+    uint32_t    velocity;         // Edges counted in the last whole period
+    uint64_t    nextVelocityNs;
+    uint32_t    intEnabled;
+    uint32_t    intStatus;
+    void        (*handler)(void);
+} simQEI_t;
+
+/* ******************************************************
+ * One half of the ADC's uDMA ping-pong transfer.
+ * *****************************************************/
+typedef struct SimDMABlocks {
+    uint16_t*   destination;
+    uint32_t    size;
+    uint32_t    done;
+    uint32_t    mode;
+} simDMABlock_t;
+
+volatile uint32_t g_simGpioLockRegs[4];
+volatile uint32_t g_simDebugRegs[2];
+
+static const uint32_t g_gpioBases[SIM_GPIO_PORTS] = {
+    GPIO_PORTA_BASE, GPIO_PORTB_BASE, GPIO_PORTC_BASE, GPIO_PORTD_BASE, GPIO_PORTE_BASE, GPIO_PORTF_BASE
+};
+static const uint32_t g_timerBases[SIM_TIMERS] = {
+    TIMER0_BASE, TIMER1_BASE, TIMER2_BASE, TIMER3_BASE
+};
+
+static simGPIOPort_t g_gpio[SIM_GPIO_PORTS];
+static simTimer_t g_timers[SIM_TIMERS];
+static simPWM_t g_pwm[2];
+static simQEI_t g_qei;
+static simDMABlock_t g_adcDMA[2];                  // Primary and alternate blocks
+static uint32_t g_adcDMAActive = 0;                 // Block the next conversion goes to
+static bool g_adcDMAEnabled = false;
+static void (*g_adcHandler)(void) = NULL;
+static uint16_t (*g_adcInput)(void) = NULL;
+static uint32_t g_adcOverruns = 0;
+
+static char g_uartRx[SIM_UART_RX_SIZE];
+static uint32_t g_uartRxHead = 0;
+static uint32_t g_uartRxCount = 0;
+static void (*g_uartHandler)(void) = NULL;
+static bool g_uartEcho = false;
+static char g_uartTx[SIM_UART_TX_SIZE];
+static uint32_t g_uartTxCount = 0;
+
+static uint64_t g_timeNs = 0;
+
+
+/*
+ * Function:    hardwareFatal
+ * ---------------------------
+ * Reports a call the models do not support and stops.
+ *
+ * @params:
+ *      - const char* message: What went wrong.
+ *      - uint32_t base: The peripheral involved.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+hardwareFatal(const char* message, uint32_t base)
+{
+    fprintf(stderr, "simHardware: %s (0x%08x)\n", message, (unsigned) base);
+    exit(EXIT_FAILURE);
+}
+
+
+/*
+ * Function:    getPort
+ * ---------------------
+ * Looks up the model of a GPIO port.
+ *
+ * @params:
+ *      - uint32_t base: GPIO port base address.
+ * @return:
+ *      - simGPIOPort_t* port: The port model.
+ * ---------------------
+ */
+static simGPIOPort_t*
+getPort(uint32_t base)
+{
+    uint32_t i;
+
+    for (i = 0; i < SIM_GPIO_PORTS; i++) {
+        if (g_gpioBases[i] == base) {
+            return &g_gpio[i];
+        }
+    }
+    hardwareFatal("unknown GPIO port", base);
+    return NULL;
+}
+
+
+/*
+ * Function:    getTimer
+ * ----------------------
+ * Looks up the model of a general purpose timer.
+ *
+ * @params:
+ *      - uint32_t base: Timer base address.
+ * @return:
+ *      - simTimer_t* timer: The timer model.
+ * ---------------------
+ */
+static simTimer_t*
+getTimer(uint32_t base)
+{
+    uint32_t i;
+
+    for (i = 0; i < SIM_TIMERS; i++) {
+        if (g_timerBases[i] == base) {
+            return &g_timers[i];
+        }
+    }
+    hardwareFatal("unknown timer", base);
+    return NULL;
+}
+
+
+/*
+ * Function:    getPWM
+ * --------------------
+ * Looks up the model of a PWM module.
+ *
+ * @params:
+ *      - uint32_t base: PWM module base address.
+ * @return:
+ *      - simPWM_t* pwm: The PWM model.
+ * ---------------------
+ */
+static simPWM_t*
+getPWM(uint32_t base)
+{
+    if (base == PWM0_BASE) {
+        return &g_pwm[0];
+    } else if (base == PWM1_BASE) {
+        return &g_pwm[1];
+    }
+    hardwareFatal("unknown PWM module", base);
+    return NULL;
+}
+
+
+/*
+ * Function:    readPins
+ * ----------------------
+ * Returns the levels of every pin of a port.
+ *
+ * @params:
+ *      - const simGPIOPort_t* port: The port.
+ * @return:
+ *      - uint8_t levels: One bit per pin.
+ * ---------------------
+ */
+static uint8_t
+readPins(const simGPIOPort_t* port)
+{
+    uint8_t inputs = (port->driven & port->drivenLevel) | (~port->driven & port->pullUp);
+
+    return (port->outputs & port->outputLevel) | (~port->outputs & inputs);
+}
+
+
+/*
+ * Function:    timerPeriodNs
+ * ---------------------------
+ * Returns the time between timeouts of a timer.
+ *
+ * @params:
+ *      - const simTimer_t* timer: The timer.
+ * @return:
+ *      - uint64_t periodNs: Timeout period (ns).
+ * ---------------------
+ */
+static uint64_t
+timerPeriodNs(const simTimer_t* timer)
+{
+    return ((uint64_t) timer->load + 1) * SIM_NS_PER_SECOND / SIM_CLOCK_HZ;
+}
+
+
+/*
+ * Function:    readQEIPhases
+ * ---------------------------
+ * Returns the encoder channels as the QEI sees them.
+ *
+ * @params:
+ *      - uint8_t levels: Levels of the QEI's port.
+ * @return:
+ *      - uint8_t phases: PhA in bit 0, PhB in bit 1, after any swap.
+ * ---------------------
+ */
+static uint8_t
+readQEIPhases(uint8_t levels)
+{
+    uint8_t a = (levels & SIM_QEI_PHA) ? 1 : 0;
+    uint8_t b = (levels & SIM_QEI_PHB) ? 1 : 0;
+
+    if (g_qei.config & QEI_CONFIG_SWAP) {
+        return b | (a << 1);
+    }
+    return a | (b << 1);
+}
+
+
+/*
+ * Function:    raiseQEIInterrupt
+ * -------------------------------
+ * Sets QEI interrupt flags and runs the handler if any of them
+ * are enabled.
+ *
+ * @params:
+ *      - uint32_t flags: QEI_INT flags.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+raiseQEIInterrupt(uint32_t flags)
+{
+    g_qei.intStatus |= flags;
+    if ((flags & g_qei.intEnabled) && g_qei.handler != NULL) {
+        simRTOSRunISR(g_qei.handler);
+    }
+}
+
+
+/*
+ * Function:    updateQEI
+ * -----------------------
+ * Counts an edge of the encoder channels and raises the index and
+ * phase error interrupts, as the QEI does when its pins change.
+ *
+ * @params:
+ *      - uint8_t before: Levels of the QEI's port before the change.
+ *      - uint8_t after: Levels after the change.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+updateQEI(uint8_t before, uint8_t after)
+{
+    uint8_t phases = readQEIPhases(after);
+    uint8_t changed = g_qei.phases ^ phases;
+    int32_t step;
+
+    if (!g_qei.enabled) {
+        g_qei.phases = phases;
+        return;
+    }
+
+    if (changed == 0x3) {
+        raiseQEIInterrupt(QEI_INTERROR);                            // Both channels changed at once
+    } else if (changed != 0) {
+        // PhA leading PhB counts up: PhB takes PhA's old level when PhA moves, and the opposite level when PhB moves
+        if (changed == 0x1) {
+            step = (((phases >> 1) & 1) != (phases & 1)) ? 1 : -1;
+        } else {
+            step = (((phases >> 1) & 1) == (phases & 1)) ? 1 : -1;
+        }
+        if (step > 0) {
+            g_qei.position = (g_qei.position >= g_qei.maxPosition) ? 0 : g_qei.position + 1;
+        } else {
+            g_qei.position = (g_qei.position == 0) ? g_qei.maxPosition : g_qei.position - 1;
+        }
+        g_qei.direction = step;
+        g_qei.velocityCount++;
+    }
+    g_qei.phases = phases;
+
+    if (!(before & SIM_QEI_IDX) && (after & SIM_QEI_IDX)) {
+        raiseQEIInterrupt(QEI_INTINDEX);
+    }
+}
+
+
+/*
+ * Function:    simConvertADC
+ * ---------------------------
+ * Runs one conversion, as a timer trigger does. The result goes to
+ * the active uDMA block. A full block stops, the transfer moves to
+ * the other block and the ADC interrupt is raised.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simConvertADC(void)
+{
+    simDMABlock_t* block = &g_adcDMA[g_adcDMAActive];
+    uint16_t result = (g_adcInput != NULL) ? g_adcInput() : 0;
+
+    if (!g_adcDMAEnabled) {
+        return;
+    }
+    if (block->mode != UDMA_MODE_PINGPONG) {
+        g_adcOverruns++; // Neither block is armed, so the FIFO overflows
+        return;
+    }
+
+    block->destination[block->done++] = result;
+    if (block->done >= block->size) {
+        block->mode = UDMA_MODE_STOP;
+        g_adcDMAActive ^= 1;
+        if (g_adcHandler != NULL) {
+            simRTOSRunISR(g_adcHandler);
+        }
+    }
+}
+
+
+/*
+ * Function:    simAdvanceTime
+ * ----------------------------
+ * Moves the simulated clock forward, running the timer timeouts,
+ * the conversions they trigger and the interrupts those raise in
+ * time order.
+ *
+ * @params:
+ *      - uint64_t timeNs: The new time (ns since reset).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simAdvanceTime(uint64_t timeNs)
+{
+    simTimer_t* next;
+    uint32_t i;
+
+    while (1) {
+        // Find the earliest timeout due by the new time
+        next = NULL;
+        for (i = 0; i < SIM_TIMERS; i++) {
+            if (g_timers[i].enabled && (g_timers[i].adcTrigger || g_timers[i].intEnabled) &&
+                g_timers[i].nextTimeoutNs <= timeNs &&
+                (next == NULL || g_timers[i].nextTimeoutNs < next->nextTimeoutNs)) {
+                next = &g_timers[i];
+            }
+        }
+
+        // The QEI's velocity timer, if it is due first
+        if (g_qei.enabled && g_qei.velocityEnabled && g_qei.nextVelocityNs <= timeNs &&
+            (next == NULL || g_qei.nextVelocityNs < next->nextTimeoutNs)) {
+            g_timeNs = g_qei.nextVelocityNs;
+            g_qei.nextVelocityNs += (uint64_t) g_qei.velocityPeriod * SIM_NS_PER_SECOND / SIM_CLOCK_HZ;
+            g_qei.velocity = g_qei.velocityCount;
+            g_qei.velocityCount = 0;
+            raiseQEIInterrupt(QEI_INTTIMER);
+            continue;
+        }
+        if (next == NULL) {
+            break;
+        }
+
+        g_timeNs = next->nextTimeoutNs;
+        next->nextTimeoutNs += timerPeriodNs(next);
+        if (next->adcTrigger) {
+            simConvertADC();
+        }
+        if (next->intEnabled && next->handler != NULL) {
+            simRTOSRunISR(next->handler);
+        }
+    }
+    g_timeNs = timeNs;
+}
+
+
+/*
+ * Function:    simGetTime
+ * ------------------------
+ * Returns the simulated time.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint64_t timeNs: Time since reset (ns).
+ * ---------------------
+ */
+uint64_t
+simGetTime(void)
+{
+    return g_timeNs;
+}
+
+
+/*
+ * Function:    simReadCycleCounter
+ * ---------------------------------
+ * Returns the DWT cycle count, from the simulated clock. Code
+ * takes no time on the simulated clock, so only the time between
+ * interrupts and task releases shows.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint32_t cycles: Cycles since reset, or 0 until the
+ *      counter is enabled.
+ * ---------------------
+ */
+uint32_t
+simReadCycleCounter(void)
+{
+    if (!(DEMCR_R & DEMCR_TRCENA) || !(DWT_CTRL_R & DWT_CTRL_CYCCNTENA)) {
+        return 0;
+    }
+    return (uint32_t) (g_timeNs * (SIM_CLOCK_HZ / SIM_US_PER_SECOND) / SIM_NS_PER_US); // Whole microseconds first, so long runs do not overflow
+}
+
+
+/*
+ * Function:    simSetPin
+ * -----------------------
+ * Drives input pins from outside the board, raising the pin
+ * interrupts the firmware has enabled for the edge.
+ *
+ * @params:
+ *      - uint32_t port: GPIO port base address.
+ *      - uint8_t pins: The pins to drive.
+ *      - bool high: The level to drive them to.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simSetPin(uint32_t portBase, uint8_t pins, bool high)
+{
+    simSetPins(portBase, pins, high ? pins : 0);
+}
+
+
+/*
+ * Function:    simSetPins
+ * ------------------------
+ * Drives input pins from outside the board to levels of their
+ * own, all at the same instant, raising the pin interrupts the
+ * firmware has enabled for the edges. On the QEI's pins the QEI
+ * sees the change too.
+ *
+ * @params:
+ *      - uint32_t port: GPIO port base address.
+ *      - uint8_t pins: The pins to drive.
+ *      - uint8_t levels: Their levels, one bit per pin.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simSetPins(uint32_t portBase, uint8_t pins, uint8_t levels)
+{
+    simGPIOPort_t* port = getPort(portBase);
+    uint8_t before = readPins(port);
+    uint8_t after;
+    uint8_t rising;
+    uint8_t falling;
+    uint8_t triggered;
+
+    port->driven |= pins;
+    port->drivenLevel = (port->drivenLevel & ~pins) | (levels & pins);
+
+    after = readPins(port);
+    if (portBase == SIM_QEI_PORT && before != after) {
+        updateQEI(before, after);
+    }
+    rising = ~before & after;
+    falling = before & ~after;
+    triggered = ((rising | falling) & port->bothEdges) |
+                (rising & port->risingEdge & ~port->bothEdges) |
+                (falling & ~port->risingEdge & ~port->bothEdges);
+    triggered &= port->intEnabled;
+
+    if (triggered != 0 && port->handler != NULL) {
+        port->intStatus |= triggered;
+        simRTOSRunISR(port->handler);
+    }
+}
+
+
+/*
+ * Function:    simDrivePins
+ * --------------------------
+ * Drives input pins from outside the board without raising any
+ * interrupts, for a replay which raises the recorded interrupts
+ * itself.
+ *
+ * @params:
+ *      - uint32_t port: GPIO port base address.
+ *      - uint8_t pins: The pins to drive.
+ *      - uint8_t levels: Their levels, one bit per pin.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simDrivePins(uint32_t portBase, uint8_t pins, uint8_t levels)
+{
+    simGPIOPort_t* port = getPort(portBase);
+
+    port->driven |= pins;
+    port->drivenLevel = (port->drivenLevel & ~pins) | (levels & pins);
+}
+
+
+/*
+ * Function:    simRaisePinInterrupt
+ * ----------------------------------
+ * Runs the interrupt handler of a GPIO port as if the given pins
+ * had seen an edge, whatever their levels.
+ *
+ * @params:
+ *      - uint32_t port: GPIO port base address.
+ *      - uint8_t pins: The pins to flag in the interrupt status.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simRaisePinInterrupt(uint32_t portBase, uint8_t pins)
+{
+    simGPIOPort_t* port = getPort(portBase);
+
+    if (port->handler != NULL) {
+        port->intStatus |= pins;
+        simRTOSRunISR(port->handler);
+    }
+}
+
+
+/*
+ * Function:    simRaiseTimerInterrupt
+ * ------------------------------------
+ * Runs the timeout interrupt handler of a timer, whatever its
+ * count.
+ *
+ * @params:
+ *      - uint32_t base: Timer base address.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simRaiseTimerInterrupt(uint32_t base)
+{
+    simTimer_t* timer = getTimer(base);
+
+    if (timer->intEnabled && timer->handler != NULL) {
+        simRTOSRunISR(timer->handler);
+    }
+}
+
+
+/*
+ * Function:    simSetTimerInput
+ * ------------------------------
+ * Sets a function that supplies the counts read from a timer in
+ * place of the simulated clock, or NULL to read the clock.
+ *
+ * @params:
+ *      - uint32_t base: Timer base address.
+ *      - uint32_t (*read)(void): Returns the count.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simSetTimerInput(uint32_t base, uint32_t (*read)(void))
+{
+    getTimer(base)->input = read;
+}
+
+
+/*
+ * Function:    simSetADCInput
+ * ----------------------------
+ * Sets the function that supplies the result of each ADC
+ * conversion.
+ *
+ * @params:
+ *      - uint16_t (*convert)(void): Returns a 12-bit result.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simSetADCInput(uint16_t (*convert)(void))
+{
+    g_adcInput = convert;
+}
+
+
+/*
+ * Function:    simGetPWMDuty
+ * ---------------------------
+ * Returns the duty cycle of a PWM output, or 0 if the output or
+ * its generator is off.
+ *
+ * @params:
+ *      - uint32_t base: PWM module base address.
+ *      - uint32_t output: PWM output (PWM_OUT_n).
+ * @return:
+ *      - double duty: Duty cycle (0 to 1).
+ * ---------------------
+ */
+double
+simGetPWMDuty(uint32_t base, uint32_t output)
+{
+    simPWM_t* pwm = getPWM(base);
+    uint32_t index = (((output & 0x1C0) >> 6) - 1) * 2 + (output & 1);
+    uint32_t generator = index / 2;
+
+    if (!(pwm->outputEnabled & (1 << index)) || !pwm->genEnabled[generator] || pwm->period[generator] == 0) {
+        return 0.0;
+    }
+    return (double) pwm->width[index] / pwm->period[generator];
+}
+
+
+/*
+ * Function:    simUARTReceive
+ * ----------------------------
+ * Delivers text to the UART as if typed on the host terminal.
+ *
+ * @params:
+ *      - const char* text: The characters to receive.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simUARTReceive(const char* text)
+{
+    while (*text != '\0' && g_uartRxCount < SIM_UART_RX_SIZE) {
+        g_uartRx[(g_uartRxHead + g_uartRxCount) % SIM_UART_RX_SIZE] = *text++;
+        g_uartRxCount++;
+    }
+    if (g_uartHandler != NULL) {
+        simRTOSRunISR(g_uartHandler);
+    }
+}
+
+
+/*
+ * Function:    simSetUARTEcho
+ * ----------------------------
+ * Selects whether the firmware's UART output is copied to stdout.
+ *
+ * @params:
+ *      - bool echo: True to print the UART output.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simSetUARTEcho(bool echo)
+{
+    g_uartEcho = echo;
+}
+
+
+/*
+ * Function:    simTakeUARTOutput
+ * -------------------------------
+ * Copies the firmware's UART output since the last call, up to
+ * SIM_UART_TX_SIZE characters, and clears it.
+ *
+ * @params:
+ *      - char* text: Destination, SIM_UART_TX_SIZE + 1 characters.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simTakeUARTOutput(char* text)
+{
+    memcpy(text, g_uartTx, g_uartTxCount);
+    text[g_uartTxCount] = '\0';
+    g_uartTxCount = 0;
+}
+
+
+/* ******************************************************
+ * System control and interrupts
+ * *****************************************************/
+
+void SysCtlClockSet(uint32_t ui32Config) { }
+uint32_t SysCtlClockGet(void) { return SIM_CLOCK_HZ; }
+void SysCtlPWMClockSet(uint32_t ui32Config) { }
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral) { }
+bool SysCtlPeripheralReady(uint32_t ui32Peripheral) { return true; }
+
+void
+SysCtlReset(void)
+{
+    fprintf(stderr, "simHardware: the firmware reset the board\n");
+    exit(EXIT_FAILURE);
+}
+
+bool IntMasterEnable(void) { return false; }
+bool IntMasterDisable(void) { return false; }
+void IntEnable(uint32_t ui32Interrupt) { }
+void IntDisable(uint32_t ui32Interrupt) { }
+void IntPrioritySet(uint32_t ui32Interrupt, uint8_t ui8Priority) { }
+
+
+/* ******************************************************
+ * GPIO
+ * *****************************************************/
+
+void
+GPIOPinTypeGPIOInput(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    getPort(ui32Port)->outputs &= ~ui8Pins;
+}
+
+void
+GPIOPinTypeGPIOOutput(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    getPort(ui32Port)->outputs |= ui8Pins;
+}
+
+void
+GPIOPinTypeQEI(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    getPort(ui32Port)->outputs &= ~ui8Pins;
+}
+
+void GPIOPinTypePWM(uint32_t ui32Port, uint8_t ui8Pins) { }
+void GPIOPinTypeUART(uint32_t ui32Port, uint8_t ui8Pins) { }
+void GPIOPinConfigure(uint32_t ui32PinConfig) { }
+
+void
+GPIOPadConfigSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32Strength, uint32_t ui32PadType)
+{
+    simGPIOPort_t* port = getPort(ui32Port);
+
+    if (ui32PadType == GPIO_PIN_TYPE_STD_WPU) {
+        port->pullUp |= ui8Pins;
+    } else {
+        port->pullUp &= ~ui8Pins;
+    }
+}
+
+int32_t
+GPIOPinRead(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    return readPins(getPort(ui32Port)) & ui8Pins;
+}
+
+void
+GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val)
+{
+    simGPIOPort_t* port = getPort(ui32Port);
+
+    port->outputLevel = (port->outputLevel & ~ui8Pins) | (ui8Val & ui8Pins);
+}
+
+void
+GPIOIntRegister(uint32_t ui32Port, void (*pfnIntHandler)(void))
+{
+    getPort(ui32Port)->handler = pfnIntHandler;
+}
+
+void
+GPIOIntTypeSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32IntType)
+{
+    simGPIOPort_t* port = getPort(ui32Port);
+
+    port->bothEdges = (ui32IntType == GPIO_BOTH_EDGES) ? (port->bothEdges | ui8Pins) : (port->bothEdges & ~ui8Pins);
+    port->risingEdge = (ui32IntType == GPIO_RISING_EDGE) ? (port->risingEdge | ui8Pins) : (port->risingEdge & ~ui8Pins);
+}
+
+void
+GPIOIntEnable(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    getPort(ui32Port)->intEnabled |= ui32IntFlags;
+}
+
+void
+GPIOIntDisable(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    getPort(ui32Port)->intEnabled &= ~ui32IntFlags;
+}
+
+void
+GPIOIntClear(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    getPort(ui32Port)->intStatus &= ~ui32IntFlags;
+}
+
+uint32_t
+GPIOIntStatus(uint32_t ui32Port, bool bMasked)
+{
+    simGPIOPort_t* port = getPort(ui32Port);
+
+    return bMasked ? (port->intStatus & port->intEnabled) : port->intStatus;
+}
+
+
+/* ******************************************************
+ * Timers. Only full width timer A is modelled.
+ * *****************************************************/
+
+void
+TimerConfigure(uint32_t ui32Base, uint32_t ui32Config)
+{
+    simTimer_t* timer = getTimer(ui32Base);
+
+    timer->config = ui32Config;
+    timer->enabled = false;
+}
+
+void
+TimerLoadSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value)
+{
+    getTimer(ui32Base)->load = ui32Value;
+}
+
+void
+TimerEnable(uint32_t ui32Base, uint32_t ui32Timer)
+{
+    simTimer_t* timer = getTimer(ui32Base);
+
+    timer->enabled = true;
+    timer->startNs = g_timeNs;
+    timer->nextTimeoutNs = g_timeNs + timerPeriodNs(timer);
+}
+
+void
+TimerDisable(uint32_t ui32Base, uint32_t ui32Timer)
+{
+    getTimer(ui32Base)->enabled = false;
+}
+
+void
+TimerControlTrigger(uint32_t ui32Base, uint32_t ui32Timer, bool bEnable)
+{
+    getTimer(ui32Base)->adcTrigger = bEnable;
+}
+
+uint32_t
+TimerValueGet(uint32_t ui32Base, uint32_t ui32Timer)
+{
+    simTimer_t* timer = getTimer(ui32Base);
+    uint64_t counts = (g_timeNs - timer->startNs) * SIM_CLOCK_HZ / SIM_NS_PER_SECOND;
+    uint64_t range = (uint64_t) timer->load + 1;
+
+    if (!timer->enabled) {
+        return 0;
+    }
+    if (timer->input != NULL) {
+        return timer->input();
+    }
+    if (timer->config & SIM_TIMER_UP) {
+        return (uint32_t) (counts % range);
+    }
+    return (uint32_t) (timer->load - counts % range);
+}
+
+void
+TimerIntRegister(uint32_t ui32Base, uint32_t ui32Timer, void (*pfnHandler)(void))
+{
+    getTimer(ui32Base)->handler = pfnHandler;
+}
+
+void
+TimerIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    getTimer(ui32Base)->intEnabled = (ui32IntFlags & TIMER_TIMA_TIMEOUT) != 0;
+}
+
+void TimerIntClear(uint32_t ui32Base, uint32_t ui32IntFlags) { }
+
+
+/* ******************************************************
+ * PWM
+ * *****************************************************/
+
+void PWMGenConfigure(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Config) { }
+
+void
+PWMGenPeriodSet(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Period)
+{
+    getPWM(ui32Base)->period[(ui32Gen >> 6) - 1] = ui32Period;
+}
+
+uint32_t
+PWMGenPeriodGet(uint32_t ui32Base, uint32_t ui32Gen)
+{
+    return getPWM(ui32Base)->period[(ui32Gen >> 6) - 1];
+}
+
+void
+PWMGenEnable(uint32_t ui32Base, uint32_t ui32Gen)
+{
+    getPWM(ui32Base)->genEnabled[(ui32Gen >> 6) - 1] = true;
+}
+
+void
+PWMPulseWidthSet(uint32_t ui32Base, uint32_t ui32PWMOut, uint32_t ui32Width)
+{
+    getPWM(ui32Base)->width[(((ui32PWMOut & 0x1C0) >> 6) - 1) * 2 + (ui32PWMOut & 1)] = ui32Width;
+}
+
+uint32_t
+PWMPulseWidthGet(uint32_t ui32Base, uint32_t ui32PWMOut)
+{
+    return getPWM(ui32Base)->width[(((ui32PWMOut & 0x1C0) >> 6) - 1) * 2 + (ui32PWMOut & 1)];
+}
+
+void
+PWMOutputState(uint32_t ui32Base, uint32_t ui32PWMOutBits, bool bEnable)
+{
+    simPWM_t* pwm = getPWM(ui32Base);
+
+    pwm->outputEnabled = bEnable ? (pwm->outputEnabled | ui32PWMOutBits) : (pwm->outputEnabled & ~ui32PWMOutBits);
+}
+
+
+/* ******************************************************
+ * QEI. Only QEI0, counting both channels' edges, with
+ * its velocity timer, is modelled.
+ * *****************************************************/
+
+void
+QEIConfigure(uint32_t ui32Base, uint32_t ui32Config, uint32_t ui32MaxPosition)
+{
+    g_qei.config = ui32Config;
+    g_qei.maxPosition = ui32MaxPosition;
+    g_qei.phases = readQEIPhases(readPins(getPort(SIM_QEI_PORT)));
+}
+
+void
+QEIEnable(uint32_t ui32Base)
+{
+    g_qei.enabled = true;
+    g_qei.phases = readQEIPhases(readPins(getPort(SIM_QEI_PORT)));
+    g_qei.direction = 1;
+    g_qei.nextVelocityNs = g_timeNs + (uint64_t) g_qei.velocityPeriod * SIM_NS_PER_SECOND / SIM_CLOCK_HZ;
+}
+
+uint32_t
+QEIPositionGet(uint32_t ui32Base)
+{
+    return g_qei.position;
+}
+
+int32_t
+QEIDirectionGet(uint32_t ui32Base)
+{
+    return g_qei.direction;
+}
+
+void
+QEIVelocityConfigure(uint32_t ui32Base, uint32_t ui32PreDiv, uint32_t ui32Period)
+{
+    g_qei.velocityPeriod = ui32Period;
+}
+
+void
+QEIVelocityEnable(uint32_t ui32Base)
+{
+    g_qei.velocityEnabled = true;
+    g_qei.nextVelocityNs = g_timeNs + (uint64_t) g_qei.velocityPeriod * SIM_NS_PER_SECOND / SIM_CLOCK_HZ;
+}
+
+uint32_t
+QEIVelocityGet(uint32_t ui32Base)
+{
+    return g_qei.velocity;
+}
+
+void
+QEIIntRegister(uint32_t ui32Base, void (*pfnHandler)(void))
+{
+    g_qei.handler = pfnHandler;
+}
+
+void
+QEIIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    g_qei.intEnabled |= ui32IntFlags;
+}
+
+void
+QEIIntClear(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    g_qei.intStatus &= ~ui32IntFlags;
+}
+
+uint32_t
+QEIIntStatus(uint32_t ui32Base, bool bMasked)
+{
+    return bMasked ? (g_qei.intStatus & g_qei.intEnabled) : g_qei.intStatus;
+}
+
+
+/* ******************************************************
+ * ADC and uDMA. Only sequence 3 feeding its uDMA channel
+ * in ping-pong mode is modelled.
+ * *****************************************************/
+
+void ADCSequenceConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t ui32Trigger, uint32_t ui32Priority) { }
+void ADCSequenceStepConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t ui32Step, uint32_t ui32Config) { }
+void ADCSequenceEnable(uint32_t ui32Base, uint32_t ui32SequenceNum) { }
+void ADCSequenceDMAEnable(uint32_t ui32Base, uint32_t ui32SequenceNum) { }
+void ADCIntClear(uint32_t ui32Base, uint32_t ui32SequenceNum) { }
+
+void
+ADCIntRegister(uint32_t ui32Base, uint32_t ui32SequenceNum, void (*pfnHandler)(void))
+{
+    g_adcHandler = pfnHandler;
+}
+
+void uDMAEnable(void) { }
+void uDMAControlBaseSet(void* pControlTable) { }
+void uDMAChannelAttributeDisable(uint32_t ui32ChannelNum, uint32_t ui32Attr) { }
+void uDMAChannelControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control) { }
+
+void
+uDMAChannelTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode,
+                       void* pvSrcAddr, void* pvDstAddr, uint32_t ui32TransferSize)
+{
+    simDMABlock_t* block = &g_adcDMA[(ui32ChannelStructIndex & UDMA_ALT_SELECT) ? 1 : 0];
+
+    if ((ui32ChannelStructIndex & SIM_UDMA_CHANNEL_MASK) != UDMA_CHANNEL_ADC3) {
+        hardwareFatal("only the ADC uDMA channel is modelled", ui32ChannelStructIndex);
+    }
+    block->destination = (uint16_t*) pvDstAddr;
+    block->size = ui32TransferSize;
+    block->done = 0;
+    block->mode = ui32Mode;
+}
+
+void
+uDMAChannelEnable(uint32_t ui32ChannelNum)
+{
+    g_adcDMAEnabled = true;
+}
+
+uint32_t
+uDMAChannelModeGet(uint32_t ui32ChannelStructIndex)
+{
+    return g_adcDMA[(ui32ChannelStructIndex & UDMA_ALT_SELECT) ? 1 : 0].mode;
+}
+
+
+/* ******************************************************
+ * UART
+ * *****************************************************/
+
+void UARTConfigSetExpClk(uint32_t ui32Base, uint32_t ui32UARTClk, uint32_t ui32Baud, uint32_t ui32Config) { }
+void UARTFIFOEnable(uint32_t ui32Base) { }
+void UARTEnable(uint32_t ui32Base) { }
+void UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags) { }
+void UARTIntClear(uint32_t ui32Base, uint32_t ui32IntFlags) { }
+
+void
+UARTCharPut(uint32_t ui32Base, unsigned char ucData)
+{
+    if (g_uartEcho) {
+        putchar(ucData);
+    }
+    if (g_uartTxCount < SIM_UART_TX_SIZE) {
+        g_uartTx[g_uartTxCount++] = ucData;
+    }
+}
+
+bool
+UARTCharsAvail(uint32_t ui32Base)
+{
+    return g_uartRxCount != 0;
+}
+
+int32_t
+UARTCharGetNonBlocking(uint32_t ui32Base)
+{
+    char character;
+
+    if (g_uartRxCount == 0) {
+        return -1;
+    }
+    character = g_uartRx[g_uartRxHead];
+    g_uartRxHead = (g_uartRxHead + 1) % SIM_UART_RX_SIZE;
+    g_uartRxCount--;
+    return (int32_t) (unsigned char) character;
+}
+
+void
+UARTIntRegister(uint32_t ui32Base, void (*pfnHandler)(void))
+{
+    g_uartHandler = pfnHandler;
+}
+
+uint32_t
+UARTIntStatus(uint32_t ui32Base, bool bMasked)
+{
+    return (g_uartRxCount != 0) ? UART_INT_RX : 0;
+}
+
+
+/* ******************************************************
+ * OLED. Nothing is drawn.
+ * *****************************************************/
+
+void OLEDInitialise(void) { }
+void OLEDStringDraw(const char* pcStr, uint32_t ulColumn, uint32_t ulRow) { }
@@ -0,0 +1,241 @@
+/* ****************************************************************
+ * simHardware.h
+ *
+ * Header file of the simulator's TM4C123 peripheral models.
+ * Implements the driverlib calls the firmware makes against a
+ * simulated clock, and lets the simulator drive the input pins and
+ * the ADC and read back the PWM outputs.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef SIMHARDWARE_H_
+#define SIMHARDWARE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_CLOCK_HZ            80000000    // System clock set by main.c (SYSCTL_SYSDIV_2_5 from the PLL)
+#define SIM_NS_PER_SECOND       1000000000ULL
+#define SIM_US_PER_SECOND       1000000
+#define SIM_NS_PER_US           1000
+#define SIM_GPIO_PORTS          6           // Ports A to F
+#define SIM_TIMERS              4           // Timers 0 to 3
+#define SIM_PWM_OUTPUTS         8           // Outputs per PWM module
+#define SIM_UART_RX_SIZE        64
+#define SIM_UART_TX_SIZE        256         // UART output kept for simTakeUARTOutput
+
+
+/*
+ * Function:    simAdvanceTime
+ * ----------------------------
+ * Moves the simulated clock forward, running the timer timeouts,
+ * the conversions they trigger and the interrupts those raise in
+ * time order.
+ *
+ * @params:
+ *      - uint64_t timeNs: The new time (ns since reset).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simAdvanceTime(uint64_t timeNs);
+
+/*
+ * Function:    simGetTime
+ * ------------------------
+ * Returns the simulated time.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint64_t timeNs: Time since reset (ns).
+ * ---------------------
+ */
+uint64_t simGetTime(void);
+
+/*
+ * Function:    simSetPin
+ * -----------------------
+ * Drives input pins from outside the board, raising the pin
+ * interrupts the firmware has enabled for the edge.
+ *
+ * @params:
+ *      - uint32_t port: GPIO port base address.
+ *      - uint8_t pins: The pins to drive.
+ *      - bool high: The level to drive them to.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simSetPin(uint32_t port, uint8_t pins, bool high);
+
+/*
+ * Function:    simSetPins
+ * ------------------------
+ * Drives input pins from outside the board to levels of their
+ * own, all at the same instant, raising the pin interrupts the
+ * firmware has enabled for the edges. On the QEI's pins the QEI
+ * sees the change too.
+ *
+ * @params:
+ *      - uint32_t port: GPIO port base address.
+ *      - uint8_t pins: The pins to drive.
+ *      - uint8_t levels: Their levels, one bit per pin.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simSetPins(uint32_t port, uint8_t pins, uint8_t levels);
+
+/*
+ * Function:    simDrivePins
+ * --------------------------
+ * Drives input pins from outside the board without raising any
+ * interrupts, for a replay which raises the recorded interrupts
+ * itself.
+ *
+ * @params:
+ *      - uint32_t port: GPIO port base address.
+ *      - uint8_t pins: The pins to drive.
+ *      - uint8_t levels: Their levels, one bit per pin.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simDrivePins(uint32_t port, uint8_t pins, uint8_t levels);
+
+/*
+ * Function:    simRaisePinInterrupt
+ * ----------------------------------
+ * Runs the interrupt handler of a GPIO port as if the given pins
+ * had seen an edge, whatever their levels.
+ *
+ * @params:
+ *      - uint32_t port: GPIO port base address.
+ *      - uint8_t pins: The pins to flag in the interrupt status.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simRaisePinInterrupt(uint32_t port, uint8_t pins);
+
+/*
+ * Function:    simRaiseTimerInterrupt
+ * ------------------------------------
+ * Runs the timeout interrupt handler of a timer, whatever its
+ * count.
+ *
+ * @params:
+ *      - uint32_t base: Timer base address.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simRaiseTimerInterrupt(uint32_t base);
+
+/*
+ * Function:    simSetTimerInput
+ * ------------------------------
+ * Sets a function that supplies the counts read from a timer in
+ * place of the simulated clock, or NULL to read the clock.
+ *
+ * @params:
+ *      - uint32_t base: Timer base address.
+ *      - uint32_t (*read)(void): Returns the count.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simSetTimerInput(uint32_t base, uint32_t (*read)(void));
+
+/*
+ * Function:    simConvertADC
+ * ---------------------------
+ * Runs one conversion, as a timer trigger does. The result goes to
+ * the active uDMA block. A full block stops, the transfer moves to
+ * the other block and the ADC interrupt is raised.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simConvertADC(void);
+
+/*
+ * Function:    simSetADCInput
+ * ----------------------------
+ * Sets the function that supplies the result of each ADC
+ * conversion.
+ *
+ * @params:
+ *      - uint16_t (*convert)(void): Returns a 12-bit result.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simSetADCInput(uint16_t (*convert)(void));
+
+/*
+ * Function:    simGetPWMDuty
+ * ---------------------------
+ * Returns the duty cycle of a PWM output, or 0 if the output or
+ * its generator is off.
+ *
+ * @params:
+ *      - uint32_t base: PWM module base address.
+ *      - uint32_t output: PWM output (PWM_OUT_n).
+ * @return:
+ *      - double duty: Duty cycle (0 to 1).
+ * ---------------------
+ */
+double simGetPWMDuty(uint32_t base, uint32_t output);
+
+/*
+ * Function:    simUARTReceive
+ * ----------------------------
+ * Delivers text to the UART as if typed on the host terminal.
+ *
+ * @params:
+ *      - const char* text: The characters to receive.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simUARTReceive(const char* text);
+
+/*
+ * Function:    simSetUARTEcho
+ * ----------------------------
+ * Selects whether the firmware's UART output is copied to stdout.
+ *
+ * @params:
+ *      - bool echo: True to print the UART output.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simSetUARTEcho(bool echo);
+
+/*
+ * Function:    simTakeUARTOutput
+ * -------------------------------
+ * Copies the firmware's UART output since the last call, up to
+ * SIM_UART_TX_SIZE characters, and clears it.
+ *
+ * @params:
+ *      - char* text: Destination, SIM_UART_TX_SIZE + 1 characters.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simTakeUARTOutput(char* text);
+
+#endif /* SIMHARDWARE_H_ */
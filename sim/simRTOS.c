@@ -0,0 +1,1171 @@
+/* ****************************************************************
+ * simRTOS.c
+ *
+ * Source file of the simulator's FreeRTOS emulation.
+ * Runs the firmware's tasks as cooperative coroutines on the host.
+ * A task runs until it blocks, suspends itself or wakes a higher
+ * priority task, which matches a preemptive kernel as long as
+ * interrupts only arrive between tasks, as they do here. Queues,
+ * semaphores, event groups, notifications and software timers
+ * follow the FreeRTOS semantics the firmware relies on. The idle
+ * task is stood in for by the time between tasks, which runs the
+ * idle hook and is switched in and out through the trace hooks.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <ucontext.h>
+#include "simRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+#include "timers.h"
+
+#define SIM_NOTIFY_OBJECT       ((void*) &g_tickCount) // Wait object of a task blocked on its notification
+
+typedef enum {
+    SIM_TASK_READY = 0,
+    SIM_TASK_BLOCKED,
+    SIM_TASK_SUSPENDED,
+    SIM_TASK_DELETED
+} simTaskState_t;
+
+/* ******************************************************
+ * An emulated task. Blocked tasks wait on an object,
+ * a tick, or both.
+ * *****************************************************/
+typedef struct SimTasks {
+    ucontext_t      context;          // Starts the task
+    jmp_buf         resume;           // Resumes the task once started
+    bool            started;
+    uint8_t*        stack;
+    const char*     name;
+    TaskFunction_t  function;
+    void*           parameters;
+    UBaseType_t     priority;
+    uint16_t        stackDepth;       // Requested depth (words). Reported as the high water mark
+    simTaskState_t  state;
+    uint64_t        readySequence;    // Order the task became ready in, for round robin within a priority
+    void*           waitObject;       // Object the task is blocked on, or NULL for a delay
+    bool            timedWait;        // True if the task also wakes at wakeTick
+    TickType_t      wakeTick;
+    uint32_t        notifyValue;
+    bool            notifyPending;
+    TaskHookFunction_t pxTaskTag;     // Application tag, read by the trace hooks
+} simTask_t;
+
+/* ******************************************************
+ * A queue. Semaphores and mutexes are queues of zero
+ * sized items, as in FreeRTOS.
+ * *****************************************************/
+typedef struct SimQueues {
+    uint8_t*        storage;
+    UBaseType_t     length;
+    UBaseType_t     itemSize;
+    UBaseType_t     count;
+    UBaseType_t     head;             // Index of the oldest item
+} simQueue_t;
+
+typedef struct SimEventGroups {
+    EventBits_t     bits;
+} simEventGroup_t;
+
+typedef struct SimTimers {
+    const char*             name;
+    TickType_t              period;
+    bool                    autoReload;
+    void*                   id;
+    TimerCallbackFunction_t callback;
+    bool                    active;
+    TickType_t              expiry;
+} simTimer_t;
+
+static simTask_t g_tasks[SIM_MAX_TASKS];
+static uint32_t g_taskCount = 0;
+static simTask_t* g_currentTask = NULL;     // NULL while the scheduler or an interrupt runs
+#define pxCurrentTCB g_currentTask          // Lets the trace hooks in FreeRTOSConfig.h expand as in the kernel
+static simTask_t g_idleTask = { .name = "IDLE" };  // Only holds the tag set by the idle hook
+static bool g_idleRunning = false;          // True while no task is ready
+static jmp_buf g_schedulerResume;
+static uint64_t g_readySequence = 0;
+static volatile TickType_t g_tickCount = 0;
+
+static simTimer_t g_timers[SIM_MAX_TIMERS];
+static uint32_t g_timerCount = 0;
+
+// Application hooks, declared here as in the kernel
+void vApplicationIdleHook(void);
+void vApplicationTickHook(void);
+
+
+/*
+ * Function:    simFatal
+ * ----------------------
+ * Reports a misuse of the kernel API and stops the simulation.
+ *
+ * @params:
+ *      - const char* message: What went wrong.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+simFatal(const char* message)
+{
+    fprintf(stderr, "simRTOS: %s (task %s, tick %u)\n", message,
+            (g_currentTask != NULL) ? g_currentTask->name : "none", (unsigned) g_tickCount);
+    exit(EXIT_FAILURE);
+}
+
+
+/*
+ * Function:    makeReady
+ * -----------------------
+ * Moves a task to the back of the ready list of its priority.
+ *
+ * @params:
+ *      - simTask_t* task: The task to make ready.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+makeReady(simTask_t* task)
+{
+    task->state = SIM_TASK_READY;
+    task->waitObject = NULL;
+    task->timedWait = false;
+    task->readySequence = g_readySequence++;
+}
+
+
+/*
+ * Function:    switchToScheduler
+ * -------------------------------
+ * Saves the running task and returns to the scheduler, which
+ * resumes it once it is the highest priority ready task.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+switchToScheduler(void)
+{
+    simTask_t* task = g_currentTask;
+
+    if (task == NULL) {
+        simFatal("blocking call outside a task");
+    }
+    if (_setjmp(task->resume) == 0) {
+        _longjmp(g_schedulerResume, 1);
+    }
+    g_currentTask = task;
+}
+
+
+/*
+ * Function:    yieldIfOutranked
+ * ------------------------------
+ * Preempts the running task if a higher priority task is ready.
+ * Does nothing from an interrupt, where the woken tasks run once
+ * the handler returns.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+yieldIfOutranked(void)
+{
+    uint32_t i;
+
+    if (g_currentTask == NULL) {
+        return;
+    }
+    for (i = 0; i < g_taskCount; i++) {
+        if (g_tasks[i].state == SIM_TASK_READY && g_tasks[i].priority > g_currentTask->priority) {
+            makeReady(g_currentTask);
+            switchToScheduler();
+            return;
+        }
+    }
+}
+
+
+/*
+ * Function:    blockOn
+ * ---------------------
+ * Blocks the running task on an object until it is woken or the
+ * timeout runs out. The caller checks the object again to tell
+ * which happened.
+ *
+ * @params:
+ *      - void* object: The object to wait on, or NULL to only delay.
+ *      - TickType_t timeout: Ticks to wait. portMAX_DELAY waits
+ *      forever.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+blockOn(void* object, TickType_t timeout)
+{
+    simTask_t* task = g_currentTask;
+
+    if (task == NULL) {
+        simFatal("blocking call outside a task");
+    }
+    task->state = SIM_TASK_BLOCKED;
+    task->waitObject = object;
+    task->timedWait = (timeout != portMAX_DELAY);
+    task->wakeTick = g_tickCount + timeout;
+    switchToScheduler();
+}
+
+
+/*
+ * Function:    wakeWaiters
+ * -------------------------
+ * Makes every task blocked on an object ready. Each one checks
+ * the object again, so only the ones that can proceed do.
+ *
+ * @params:
+ *      - void* object: The object that changed.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+wakeWaiters(void* object)
+{
+    uint32_t i;
+
+    for (i = 0; i < g_taskCount; i++) {
+        if (g_tasks[i].state == SIM_TASK_BLOCKED && g_tasks[i].waitObject == object) {
+            makeReady(&g_tasks[i]);
+        }
+    }
+}
+
+
+/*
+ * Function:    remainingTicks
+ * ----------------------------
+ * Ticks left before a deadline, for calls that retry after being
+ * woken.
+ *
+ * @params:
+ *      - TickType_t deadline: Tick the wait ends at.
+ *      - TickType_t timeout: The original timeout.
+ * @return:
+ *      - TickType_t remaining: Ticks left, portMAX_DELAY if the
+ *      wait is unbounded, 0 if the deadline has passed.
+ * ---------------------
+ */
+static TickType_t
+remainingTicks(TickType_t deadline, TickType_t timeout)
+{
+    int32_t remaining;
+
+    if (timeout == portMAX_DELAY) {
+        return portMAX_DELAY;
+    }
+    remaining = (int32_t) (deadline - g_tickCount);
+    return (remaining > 0) ? (TickType_t) remaining : 0;
+}
+
+
+/*
+ * Function:    taskEntry
+ * -----------------------
+ * First code run by every task. Calls the task function, which
+ * should never return.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+taskEntry(void)
+{
+    g_currentTask->function(g_currentTask->parameters);
+
+    fprintf(stderr, "simRTOS: task %s returned\n", g_currentTask->name);
+    g_currentTask->state = SIM_TASK_DELETED;
+    switchToScheduler();
+}
+
+
+/*
+ * Function:    resumeTask
+ * ------------------------
+ * Runs a task until it blocks or yields. A task is started from
+ * its context once, then resumed with a jump, which unlike
+ * swapcontext does not save and restore the signal mask with a
+ * system call on every switch.
+ *
+ * @params:
+ *      - simTask_t* task: The task to run.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+resumeTask(simTask_t* task)
+{
+    if (g_idleRunning) {
+        g_currentTask = &g_idleTask;
+        traceTASK_SWITCHED_OUT();
+        g_idleRunning = false;
+    }
+    g_currentTask = task;
+    traceTASK_SWITCHED_IN();
+    if (_setjmp(g_schedulerResume) == 0) {
+        if (task->started) {
+            _longjmp(task->resume, 1);
+        }
+        task->started = true;
+        setcontext(&task->context);
+    }
+    traceTASK_SWITCHED_OUT();
+    g_currentTask = NULL;
+}
+
+
+/*
+ * Function:    enterIdle
+ * -----------------------
+ * Switches the idle task in once no task is ready and runs the
+ * idle hook. The idle task stays switched in, through any
+ * interrupts, until the next task is resumed.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+enterIdle(void)
+{
+    if (g_idleRunning) {
+        return;
+    }
+    g_currentTask = &g_idleTask;
+    traceTASK_SWITCHED_IN();
+#if configUSE_IDLE_HOOK
+    vApplicationIdleHook();                 // Must not block, as on the target
+#endif
+    g_currentTask = NULL;
+    g_idleRunning = true;
+}
+
+
+/*
+ * Function:    runReadyTasks
+ * ---------------------------
+ * Runs the highest priority ready task, oldest first within a
+ * priority, until no task is ready.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+runReadyTasks(void)
+{
+    simTask_t* next;
+    uint32_t i;
+
+    while (1) {
+        next = NULL;
+        for (i = 0; i < g_taskCount; i++) {
+            if (g_tasks[i].state != SIM_TASK_READY) {
+                continue;
+            }
+            if (next == NULL || g_tasks[i].priority > next->priority ||
+                (g_tasks[i].priority == next->priority && g_tasks[i].readySequence < next->readySequence)) {
+                next = &g_tasks[i];
+            }
+        }
+        if (next == NULL) {
+            enterIdle();
+            return;
+        }
+
+        resumeTask(next);
+    }
+}
+
+
+/*
+ * Function:    timerService
+ * --------------------------
+ * The timer service task. Runs the callbacks of the software
+ * timers that expire each tick.
+ *
+ * @params:
+ *      - void* pvParameters: Unused.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+timerService(void* pvParameters)
+{
+    uint32_t i;
+
+    while (1) {
+        for (i = 0; i < g_timerCount; i++) {
+            if (g_timers[i].active && (int32_t) (g_tickCount - g_timers[i].expiry) >= 0) {
+                if (g_timers[i].autoReload) {
+                    g_timers[i].expiry += g_timers[i].period;
+                } else {
+                    g_timers[i].active = false;
+                }
+                g_timers[i].callback((TimerHandle_t) &g_timers[i]);
+            }
+        }
+        vTaskDelay(1);
+    }
+}
+
+
+/*
+ * Function:    simRTOSTick
+ * -------------------------
+ * Advances the tick count by one, runs the tick hook, unblocks
+ * the tasks whose delays have run out and runs every ready task,
+ * highest priority first, until they all block again.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simRTOSTick(void)
+{
+    uint32_t i;
+
+    g_tickCount++;
+#if configUSE_TICK_HOOK
+    vApplicationTickHook();
+#endif
+    for (i = 0; i < g_taskCount; i++) {
+        if (g_tasks[i].state == SIM_TASK_BLOCKED && g_tasks[i].timedWait &&
+            (int32_t) (g_tickCount - g_tasks[i].wakeTick) >= 0) {
+            makeReady(&g_tasks[i]);
+        }
+    }
+    runReadyTasks();
+}
+
+
+/*
+ * Function:    simRTOSRunISR
+ * ---------------------------
+ * Runs an interrupt handler, then any tasks it woke, as
+ * portYIELD_FROM_ISR would on the target. Interrupts only arrive
+ * while every task is blocked, so all woken tasks outrank the
+ * interrupted code.
+ *
+ * @params:
+ *      - void (*handler)(void): The interrupt handler to run.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simRTOSRunISR(void (*handler)(void))
+{
+    handler();
+    runReadyTasks();
+}
+
+
+/* ******************************************************
+ * Tasks
+ * *****************************************************/
+
+BaseType_t
+xTaskCreate(TaskFunction_t pxTaskCode, const char* pcName, uint16_t usStackDepth,
+            void* pvParameters, UBaseType_t uxPriority, TaskHandle_t* pxCreatedTask)
+{
+    simTask_t* task;
+
+    if (g_taskCount >= SIM_MAX_TASKS) {
+        simFatal("too many tasks");
+    }
+    task = &g_tasks[g_taskCount++];
+    memset(task, 0, sizeof(*task));
+    task->name = pcName;
+    task->function = pxTaskCode;
+    task->parameters = pvParameters;
+    task->priority = uxPriority;
+    task->stackDepth = usStackDepth;
+    task->stack = malloc(SIM_TASK_STACK_BYTES);
+    if (task->stack == NULL) {
+        simFatal("out of memory for a task stack");
+    }
+
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = task->stack;
+    task->context.uc_stack.ss_size = SIM_TASK_STACK_BYTES;
+    task->context.uc_link = NULL;
+    makecontext(&task->context, taskEntry, 0);
+    makeReady(task);
+
+    if (pxCreatedTask != NULL) {
+        *pxCreatedTask = (TaskHandle_t) task;
+    }
+    return pdPASS;
+}
+
+
+void
+vTaskStartScheduler(void)
+{
+    xTaskCreate(timerService, "Tmr Svc", configTIMER_TASK_STACK_DEPTH, NULL, configTIMER_TASK_PRIORITY, NULL);
+    runReadyTasks();
+    runSimulation();
+}
+
+
+void
+vTaskDelay(TickType_t xTicksToDelay)
+{
+    if (xTicksToDelay == 0) {
+        makeReady(g_currentTask);
+        switchToScheduler();
+    } else {
+        blockOn(NULL, xTicksToDelay);
+    }
+}
+
+
+void
+vTaskDelayUntil(TickType_t* pxPreviousWakeTime, TickType_t xTimeIncrement)
+{
+    TickType_t wakeTick = *pxPreviousWakeTime + xTimeIncrement;
+
+    *pxPreviousWakeTime = wakeTick;
+    if ((int32_t) (wakeTick - g_tickCount) > 0) {
+        blockOn(NULL, wakeTick - g_tickCount);
+    }
+}
+
+
+void
+vTaskSuspend(TaskHandle_t xTaskToSuspend)
+{
+    simTask_t* task = (xTaskToSuspend != NULL) ? (simTask_t*) xTaskToSuspend : g_currentTask;
+
+    task->state = SIM_TASK_SUSPENDED;
+    task->waitObject = NULL;
+    task->timedWait = false;
+    if (task == g_currentTask) {
+        switchToScheduler();
+    }
+}
+
+
+void
+vTaskResume(TaskHandle_t xTaskToResume)
+{
+    simTask_t* task = (simTask_t*) xTaskToResume;
+
+    if (task != NULL && task->state == SIM_TASK_SUSPENDED) {
+        makeReady(task);
+        yieldIfOutranked();
+    }
+}
+
+
+TickType_t
+xTaskGetTickCount(void)
+{
+    return g_tickCount;
+}
+
+
+TickType_t
+xTaskGetTickCountFromISR(void)
+{
+    return g_tickCount;
+}
+
+
+TaskHandle_t
+xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t) g_currentTask;
+}
+
+
+char*
+pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+    simTask_t* task = (xTaskToQuery != NULL) ? (simTask_t*) xTaskToQuery : g_currentTask;
+
+    return (char*) task->name;
+}
+
+
+UBaseType_t
+uxTaskGetStackHighWaterMark(TaskHandle_t xTask)
+{
+    simTask_t* task = (xTask != NULL) ? (simTask_t*) xTask : g_currentTask;
+
+    return task->stackDepth; // Host stack use says nothing about the target's, so none is reported
+}
+
+
+void
+vTaskSetApplicationTaskTag(TaskHandle_t xTask, TaskHookFunction_t pxHookFunction)
+{
+    simTask_t* task = (xTask != NULL) ? (simTask_t*) xTask : g_currentTask;
+
+    task->pxTaskTag = pxHookFunction;
+}
+
+
+/*
+ * Function:    notifyTask
+ * ------------------------
+ * Updates a task's notification value and wakes it if it is
+ * waiting for one.
+ *
+ * @params:
+ *      - simTask_t* task: The task to notify.
+ *      - uint32_t value: Value used by the action.
+ *      - eNotifyAction action: How to update the value.
+ * @return:
+ *      - BaseType_t result: pdFAIL only if eSetValueWithoutOverwrite
+ *      found a notification already pending.
+ * ---------------------
+ */
+static BaseType_t
+notifyTask(simTask_t* task, uint32_t value, eNotifyAction action)
+{
+    switch (action) {
+        case eSetBits:
+            task->notifyValue |= value;
+            break;
+        case eIncrement:
+            task->notifyValue++;
+            break;
+        case eSetValueWithOverwrite:
+            task->notifyValue = value;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (task->notifyPending) {
+                return pdFAIL;
+            }
+            task->notifyValue = value;
+            break;
+        default:
+            break;
+    }
+    task->notifyPending = true;
+
+    if (task->state == SIM_TASK_BLOCKED && task->waitObject == SIM_NOTIFY_OBJECT) {
+        makeReady(task);
+    }
+    return pdPASS;
+}
+
+
+BaseType_t
+xTaskNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction)
+{
+    BaseType_t result = notifyTask((simTask_t*) xTaskToNotify, ulValue, eAction);
+
+    yieldIfOutranked();
+    return result;
+}
+
+
+BaseType_t
+xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction,
+                   BaseType_t* pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+    return notifyTask((simTask_t*) xTaskToNotify, ulValue, eAction);
+}
+
+
+BaseType_t
+xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit,
+                uint32_t* pulNotificationValue, TickType_t xTicksToWait)
+{
+    simTask_t* task = g_currentTask;
+
+    if (!task->notifyPending) {
+        task->notifyValue &= ~ulBitsToClearOnEntry;
+        if (xTicksToWait != 0) {
+            blockOn(SIM_NOTIFY_OBJECT, xTicksToWait);
+        }
+    }
+
+    if (pulNotificationValue != NULL) {
+        *pulNotificationValue = task->notifyValue;
+    }
+    if (!task->notifyPending) {
+        return pdFALSE;
+    }
+    task->notifyValue &= ~ulBitsToClearOnExit;
+    task->notifyPending = false;
+    return pdTRUE;
+}
+
+
+BaseType_t
+xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    return xTaskNotify(xTaskToNotify, 0, eIncrement);
+}
+
+
+void
+vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    xTaskNotifyFromISR(xTaskToNotify, 0, eIncrement, pxHigherPriorityTaskWoken);
+}
+
+
+uint32_t
+ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    simTask_t* task = g_currentTask;
+    uint32_t value;
+
+    if (task->notifyValue == 0 && xTicksToWait != 0) {
+        blockOn(SIM_NOTIFY_OBJECT, xTicksToWait);
+    }
+
+    value = task->notifyValue;
+    if (value != 0) {
+        task->notifyValue = xClearCountOnExit ? 0 : value - 1;
+    }
+    task->notifyPending = false;
+    return value;
+}
+
+
+/* ******************************************************
+ * Queues and semaphores
+ * *****************************************************/
+
+/*
+ * Function:    createQueue
+ * -------------------------
+ * Allocates an empty queue.
+ *
+ * @params:
+ *      - UBaseType_t length: Number of items the queue holds.
+ *      - UBaseType_t itemSize: Size of each item (bytes). 0 for a
+ *      semaphore.
+ * @return:
+ *      - simQueue_t* queue: The new queue.
+ * ---------------------
+ */
+static simQueue_t*
+createQueue(UBaseType_t length, UBaseType_t itemSize)
+{
+    simQueue_t* queue = calloc(1, sizeof(simQueue_t));
+
+    if (queue == NULL || (itemSize != 0 && (queue->storage = calloc(length, itemSize)) == NULL)) {
+        simFatal("out of memory for a queue");
+    }
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+
+/*
+ * Function:    pushItem
+ * ----------------------
+ * Copies an item onto the back of a queue with room for it.
+ *
+ * @params:
+ *      - simQueue_t* queue: The queue.
+ *      - const void* item: The item to copy in.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+pushItem(simQueue_t* queue, const void* item)
+{
+    if (queue->itemSize != 0) {
+        memcpy(&queue->storage[((queue->head + queue->count) % queue->length) * queue->itemSize],
+               item, queue->itemSize);
+    }
+    queue->count++;
+    wakeWaiters(queue);
+}
+
+
+/*
+ * Function:    takeItem
+ * ----------------------
+ * Waits for an item at the front of a queue and copies it out.
+ *
+ * @params:
+ *      - simQueue_t* queue: The queue.
+ *      - void* buffer: Receives the item. May be NULL for a
+ *      semaphore.
+ *      - TickType_t timeout: Ticks to wait for an item.
+ *      - bool remove: True to remove the item, false to peek.
+ * @return:
+ *      - BaseType_t result: pdPASS if an item was read.
+ * ---------------------
+ */
+static BaseType_t
+takeItem(simQueue_t* queue, void* buffer, TickType_t timeout, bool remove)
+{
+    TickType_t deadline = g_tickCount + timeout;
+    TickType_t remaining = timeout;
+
+    while (queue->count == 0) {
+        if (remaining == 0) {
+            return pdFAIL;
+        }
+        blockOn(queue, remaining);
+        remaining = remainingTicks(deadline, timeout);
+    }
+
+    if (queue->itemSize != 0 && buffer != NULL) {
+        memcpy(buffer, &queue->storage[queue->head * queue->itemSize], queue->itemSize);
+    }
+    if (remove) {
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        wakeWaiters(queue);
+        yieldIfOutranked();
+    }
+    return pdPASS;
+}
+
+
+/*
+ * Function:    giveItem
+ * ----------------------
+ * Waits for room in a queue and copies an item in.
+ *
+ * @params:
+ *      - simQueue_t* queue: The queue.
+ *      - const void* item: The item to copy in.
+ *      - TickType_t timeout: Ticks to wait for room.
+ * @return:
+ *      - BaseType_t result: pdPASS if the item was queued.
+ * ---------------------
+ */
+static BaseType_t
+giveItem(simQueue_t* queue, const void* item, TickType_t timeout)
+{
+    TickType_t deadline = g_tickCount + timeout;
+    TickType_t remaining = timeout;
+
+    while (queue->count >= queue->length) {
+        if (remaining == 0 || g_currentTask == NULL) {
+            return pdFAIL;
+        }
+        blockOn(queue, remaining);
+        remaining = remainingTicks(deadline, timeout);
+    }
+
+    pushItem(queue, item);
+    yieldIfOutranked();
+    return pdPASS;
+}
+
+
+QueueHandle_t
+xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    return (QueueHandle_t) createQueue(uxQueueLength, uxItemSize);
+}
+
+
+BaseType_t
+xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait)
+{
+    return giveItem((simQueue_t*) xQueue, pvItemToQueue, xTicksToWait);
+}
+
+
+BaseType_t
+xQueueSendFromISR(QueueHandle_t xQueue, const void* pvItemToQueue, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+    return giveItem((simQueue_t*) xQueue, pvItemToQueue, 0);
+}
+
+
+BaseType_t
+xQueueOverwrite(QueueHandle_t xQueue, const void* pvItemToQueue)
+{
+    simQueue_t* queue = (simQueue_t*) xQueue;
+
+    if (queue->length != 1) {
+        simFatal("xQueueOverwrite on a queue longer than one item");
+    }
+    queue->count = 0;
+    pushItem(queue, pvItemToQueue);
+    yieldIfOutranked();
+    return pdPASS;
+}
+
+
+BaseType_t
+xQueueOverwriteFromISR(QueueHandle_t xQueue, const void* pvItemToQueue, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    simQueue_t* queue = (simQueue_t*) xQueue;
+
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+    queue->count = 0;
+    pushItem(queue, pvItemToQueue);
+    return pdPASS;
+}
+
+
+BaseType_t
+xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait)
+{
+    return takeItem((simQueue_t*) xQueue, pvBuffer, xTicksToWait, true);
+}
+
+
+BaseType_t
+xQueuePeek(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait)
+{
+    return takeItem((simQueue_t*) xQueue, pvBuffer, xTicksToWait, false);
+}
+
+
+BaseType_t
+xQueuePeekFromISR(QueueHandle_t xQueue, void* pvBuffer)
+{
+    return takeItem((simQueue_t*) xQueue, pvBuffer, 0, false);
+}
+
+
+UBaseType_t
+uxQueueMessagesWaiting(QueueHandle_t xQueue)
+{
+    return ((simQueue_t*) xQueue)->count;
+}
+
+
+SemaphoreHandle_t
+xSemaphoreCreateBinary(void)
+{
+    return (SemaphoreHandle_t) createQueue(1, 0);
+}
+
+
+SemaphoreHandle_t
+xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount)
+{
+    simQueue_t* queue = createQueue(uxMaxCount, 0);
+
+    queue->count = uxInitialCount;
+    return (SemaphoreHandle_t) queue;
+}
+
+
+SemaphoreHandle_t
+xSemaphoreCreateMutex(void)
+{
+    simQueue_t* queue = createQueue(1, 0);
+
+    queue->count = 1; // Mutexes start available. Priority inheritance is not modelled
+    return (SemaphoreHandle_t) queue;
+}
+
+
+BaseType_t
+xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime)
+{
+    return takeItem((simQueue_t*) xSemaphore, NULL, xBlockTime, true);
+}
+
+
+BaseType_t
+xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    return giveItem((simQueue_t*) xSemaphore, NULL, 0);
+}
+
+
+BaseType_t
+xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    return xQueueSendFromISR(xSemaphore, NULL, pxHigherPriorityTaskWoken);
+}
+
+
+UBaseType_t
+uxSemaphoreGetCount(SemaphoreHandle_t xSemaphore)
+{
+    return ((simQueue_t*) xSemaphore)->count;
+}
+
+
+/* ******************************************************
+ * Event groups
+ * *****************************************************/
+
+EventGroupHandle_t
+xEventGroupCreate(void)
+{
+    simEventGroup_t* group = calloc(1, sizeof(simEventGroup_t));
+
+    if (group == NULL) {
+        simFatal("out of memory for an event group");
+    }
+    return (EventGroupHandle_t) group;
+}
+
+
+EventBits_t
+xEventGroupGetBits(EventGroupHandle_t xEventGroup)
+{
+    return ((simEventGroup_t*) xEventGroup)->bits;
+}
+
+
+EventBits_t
+xEventGroupGetBitsFromISR(EventGroupHandle_t xEventGroup)
+{
+    return ((simEventGroup_t*) xEventGroup)->bits;
+}
+
+
+EventBits_t
+xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet)
+{
+    simEventGroup_t* group = (simEventGroup_t*) xEventGroup;
+
+    group->bits |= uxBitsToSet;
+    return group->bits;
+}
+
+
+BaseType_t
+xEventGroupSetBitsFromISR(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet,
+                          BaseType_t* pxHigherPriorityTaskWoken)
+{
+    xEventGroupSetBits(xEventGroup, uxBitsToSet);
+    return pdPASS;
+}
+
+
+EventBits_t
+xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear)
+{
+    simEventGroup_t* group = (simEventGroup_t*) xEventGroup;
+    EventBits_t bits = group->bits;
+
+    group->bits &= ~uxBitsToClear;
+    return bits;
+}
+
+
+/* ******************************************************
+ * Software timers
+ * *****************************************************/
+
+TimerHandle_t
+xTimerCreate(const char* pcTimerName, TickType_t xTimerPeriod, UBaseType_t uxAutoReload,
+             void* pvTimerID, TimerCallbackFunction_t pxCallbackFunction)
+{
+    simTimer_t* timer;
+
+    if (g_timerCount >= SIM_MAX_TIMERS) {
+        simFatal("too many timers");
+    }
+    timer = &g_timers[g_timerCount++];
+    timer->name = pcTimerName;
+    timer->period = xTimerPeriod;
+    timer->autoReload = (uxAutoReload != pdFALSE);
+    timer->id = pvTimerID;
+    timer->callback = pxCallbackFunction;
+    timer->active = false;
+    return (TimerHandle_t) timer;
+}
+
+
+BaseType_t
+xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+    simTimer_t* timer = (simTimer_t*) xTimer;
+
+    timer->active = true;
+    timer->expiry = g_tickCount + timer->period;
+    return pdPASS;
+}
+
+
+BaseType_t
+xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+    ((simTimer_t*) xTimer)->active = false;
+    return pdPASS;
+}
+
+
+BaseType_t
+xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+    return xTimerStart(xTimer, xTicksToWait);
+}
+
+
+BaseType_t
+xTimerIsTimerActive(TimerHandle_t xTimer)
+{
+    return ((simTimer_t*) xTimer)->active ? pdTRUE : pdFALSE;
+}
+
+
+void*
+pvTimerGetTimerID(TimerHandle_t xTimer)
+{
+    return ((simTimer_t*) xTimer)->id;
+}
+
+
+void
+vTimerSetTimerID(TimerHandle_t xTimer, void* pvNewID)
+{
+    ((simTimer_t*) xTimer)->id = pvNewID;
+}
@@ -0,0 +1,73 @@
+/* ****************************************************************
+ * simRTOS.h
+ *
+ * Header file of the simulator's FreeRTOS emulation.
+ * Runs the firmware's tasks as cooperative coroutines on the host.
+ * Time only moves when the simulator calls simRTOSTick, so a run
+ * is deterministic and goes as fast as the host allows.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef SIMRTOS_H_
+#define SIMRTOS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define SIM_MAX_TASKS           16          // Firmware tasks plus the timer service task
+#define SIM_MAX_TIMERS          8
+#define SIM_TASK_STACK_BYTES    (256 * 1024) // Host stack per task. Host frames are far larger than the target's
+
+
+/*
+ * Function:    runSimulation
+ * ---------------------------
+ * Provided by the simulator. Called by vTaskStartScheduler once
+ * the scheduler is running, and exits the process when done.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void runSimulation(void);
+
+/*
+ * Function:    simRTOSTick
+ * -------------------------
+ * Advances the tick count by one, unblocks the tasks whose delays
+ * have run out and runs every ready task, highest priority first,
+ * until they all block again.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simRTOSTick(void);
+
+/*
+ * Function:    simRTOSRunISR
+ * ---------------------------
+ * Runs an interrupt handler, then any tasks it woke that outrank
+ * the interrupted code, as portYIELD_FROM_ISR would on the target.
+ *
+ * @params:
+ *      - void (*handler)(void): The interrupt handler to run.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simRTOSRunISR(void (*handler)(void));
+
+#endif /* SIMRTOS_H_ */
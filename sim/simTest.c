@@ -0,0 +1,119 @@
+/* ****************************************************************
+ * simTest.c
+ *
+ * Source file of the simulator's test helpers.
+ * Reports the checks made by the host tests and counts the ones
+ * that fail, so each test can exit with a failure for make test.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <time.h>
+#include "simTest.h"
+
+#define SIM_TEST_NS_PER_SECOND  1e9
+
+static uint32_t g_checks = 0;
+static uint32_t g_failures = 0;
+static bool g_verbose = false;
+
+
+/*
+ * Function:    simCheck
+ * ----------------------
+ * Records the result of a check. Prints it if it failed, or if
+ * every check is printed.
+ *
+ * @params:
+ *      - bool passed: The result.
+ *      - const char* format: printf format of the check's name,
+ *      followed by its arguments.
+ * @return:
+ *      - bool passed: The result, for chaining.
+ * ---------------------
+ */
+bool
+simCheck(bool passed, const char* format, ...)
+{
+    va_list args;
+
+    g_checks++;
+    if (!passed) {
+        g_failures++;
+    }
+    if (!passed || g_verbose) {
+        printf("%s ", passed ? "ok  " : "FAIL");
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+        printf("\n");
+    }
+    return passed;
+}
+
+
+/*
+ * Function:    simSetCheckVerbose
+ * --------------------------------
+ * Selects whether passing checks are printed too.
+ *
+ * @params:
+ *      - bool verbose: True to print every check.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+simSetCheckVerbose(bool verbose)
+{
+    g_verbose = verbose;
+}
+
+
+/*
+ * Function:    simCheckResult
+ * ----------------------------
+ * Prints how many checks passed and returns the exit status of
+ * the test.
+ *
+ * @params:
+ *      - const char* name: Name of the test.
+ * @return:
+ *      - int status: EXIT_SUCCESS if every check passed.
+ * ---------------------
+ */
+int
+simCheckResult(const char* name)
+{
+    printf("%-17s %u of %u checks passed\n", name, (unsigned) (g_checks - g_failures), (unsigned) g_checks);
+    return (g_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*
+ * Function:    simGetSeconds
+ * ---------------------------
+ * Returns the host's monotonic clock, for timing.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - double seconds: Time (s).
+ * ---------------------
+ */
+double
+simGetSeconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / SIM_TEST_NS_PER_SECOND;
+}
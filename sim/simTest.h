@@ -0,0 +1,79 @@
+/* ****************************************************************
+ * simTest.h
+ *
+ * Header file of the simulator's test helpers.
+ * Reports the checks made by the host tests and counts the ones
+ * that fail, so each test can exit with a failure for make test.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef SIMTEST_H_
+#define SIMTEST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ * Function:    simCheck
+ * ----------------------
+ * Records the result of a check. Prints it if it failed, or if
+ * every check is printed.
+ *
+ * @params:
+ *      - bool passed: The result.
+ *      - const char* format: printf format of the check's name,
+ *      followed by its arguments.
+ * @return:
+ *      - bool passed: The result, for chaining.
+ * ---------------------
+ */
+bool simCheck(bool passed, const char* format, ...) __attribute__ ((format (printf, 2, 3)));
+
+/*
+ * Function:    simSetCheckVerbose
+ * --------------------------------
+ * Selects whether passing checks are printed too.
+ *
+ * @params:
+ *      - bool verbose: True to print every check.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void simSetCheckVerbose(bool verbose);
+
+/*
+ * Function:    simCheckResult
+ * ----------------------------
+ * Prints how many checks passed and returns the exit status of
+ * the test.
+ *
+ * @params:
+ *      - const char* name: Name of the test.
+ * @return:
+ *      - int status: EXIT_SUCCESS if every check passed.
+ * ---------------------
+ */
+int simCheckResult(const char* name);
+
+/*
+ * Function:    simGetSeconds
+ * ---------------------------
+ * Returns the host's monotonic clock, for timing.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - double seconds: Time (s).
+ * ---------------------
+ */
+double simGetSeconds(void);
+
+#endif /* SIMTEST_H_ */
@@ -0,0 +1,493 @@
+/* ****************************************************************
+ * stateBench.c
+ *
+ * Compares the flight state blackboard with the single item
+ * queues it replaced. Times the writes and reads one control cycle
+ * and one display refresh make, through the firmware's
+ * flightState module and through the simulator's queues. Then
+ * checks that:
+ *      - no write enters a critical section, so writers never hold
+ *        off interrupts
+ *      - the newest write of either writer of the references wins
+ *      - reads that interrupt a write part way through return at
+ *        once with a consistent snapshot
+ *      - snapshots stay consistent while two other threads keep
+ *        writing the references
+ *
+ * The simulator's queues have no critical sections, so they
+ * understate what the kernel's queue calls cost on the target.
+ *
+ * Usage: stateBench [-n iterations] [-t seconds]
+ *      -n  Iterations of each timed loop (default 10000000)
+ *      -t  Length of each consistency check (default 1 s)
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "simRTOS.h"
+#include "queue.h"
+#include "flightState.h"
+
+#define BENCH_ITERATIONS        10000000
+#define BENCH_CHECK_SECONDS     1.0
+#define BENCH_NS_PER_SECOND     1e9
+#define BENCH_INTERRUPT_US      50          // Period of the reads that interrupt the writes
+
+/* ******************************************************
+ * The queues the blackboard replaced.
+ * *****************************************************/
+typedef struct BenchQueues {
+    QueueHandle_t   altMeasured;
+    QueueHandle_t   altDesired;
+    QueueHandle_t   yawDesired;
+    QueueHandle_t   fsmState;
+} benchQueues_t;
+
+volatile uint32_t g_simCriticalSections = 0;   // Counted by the kernel stand-ins
+
+static volatile bool g_writing = true;          // Cleared to stop the consistency check's writers
+static volatile uint64_t g_interruptReads = 0;  // Reads made by the interrupt in checkInterruptedWrites
+static volatile uint64_t g_interruptTorn = 0;   // Those that saw the references from different writes
+
+// The kernel emulation calls these, but nothing here runs the scheduler
+void runSimulation(void) {}
+void vApplicationIdleHook(void) {}
+void vApplicationTickHook(void) {}
+void profileTaskSwitchedIn(void* tag) {}
+void profileTaskSwitchedOut(void* tag) {}
+
+
+/*
+ * Function:    getSeconds
+ * ------------------------
+ * Returns the monotonic clock.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - double seconds: Time (s).
+ * ---------------------
+ */
+static double
+getSeconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / BENCH_NS_PER_SECOND;
+}
+
+
+/*
+ * Function:    printTime
+ * -----------------------
+ * Prints the time per iteration of the queues and the blackboard
+ * and how many times faster the blackboard is.
+ *
+ * @params:
+ *      - const char* name: What was timed.
+ *      - double queueSeconds: Time the queues took.
+ *      - double stateSeconds: Time the blackboard took.
+ *      - uint32_t iterations: Iterations timed.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+printTime(const char* name, double queueSeconds, double stateSeconds, uint32_t iterations)
+{
+    printf("%-16s queues %6.1f ns, flight state %6.1f ns, %5.1fx\n", name,
+           queueSeconds * BENCH_NS_PER_SECOND / iterations, stateSeconds * BENCH_NS_PER_SECOND / iterations,
+           queueSeconds / stateSeconds);
+}
+
+
+/*
+ * Function:    timeAccesses
+ * --------------------------
+ * Times the accesses of one control cycle (publish the altitude,
+ * read the desired altitude and yaw), of one display refresh (read
+ * all four) and of a button press (set both references).
+ *
+ * @params:
+ *      - benchQueues_t* queues: The queues.
+ *      - uint32_t iterations: Iterations of each loop.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+timeAccesses(benchQueues_t* queues, uint32_t iterations)
+{
+    altitudeSample_t sample = {0};
+    flightState_t flight;
+    int32_t altDesired = 0;
+    int32_t yawDesired = 0;
+    uint32_t fsmState = 0;
+    volatile int32_t sink = 0;              // Keeps the reads from being optimised out
+    double start;
+    double queueSeconds;
+    uint32_t i;
+
+    start = getSeconds();
+    for (i = 0; i < iterations; i++) {
+        sample.altitude = (int32_t) i;
+        xQueueOverwrite(queues->altMeasured, &sample);
+        xQueuePeek(queues->altDesired, &altDesired, 0);
+        xQueuePeek(queues->yawDesired, &yawDesired, 0);
+        sink += altDesired + yawDesired;
+    }
+    queueSeconds = getSeconds() - start;
+    start = getSeconds();
+    for (i = 0; i < iterations; i++) {
+        sample.altitude = (int32_t) i;
+        setAltMeasured(&sample);
+        sink += getAltDesired() + getYawDesired();
+    }
+    printTime("control cycle", queueSeconds, getSeconds() - start, iterations);
+
+    start = getSeconds();
+    for (i = 0; i < iterations; i++) {
+        xQueuePeek(queues->altDesired, &altDesired, 0);
+        xQueuePeek(queues->altMeasured, &sample, 0);
+        xQueuePeek(queues->yawDesired, &yawDesired, 0);
+        xQueuePeek(queues->fsmState, &fsmState, 0);
+        sink += altDesired + sample.altitude + yawDesired + (int32_t) fsmState;
+    }
+    queueSeconds = getSeconds() - start;
+    start = getSeconds();
+    for (i = 0; i < iterations; i++) {
+        getFlightState(&flight);
+        sink += flight.altDesired + flight.altMeasured.altitude + flight.yawDesired + (int32_t) flight.fsmState;
+    }
+    printTime("display refresh", queueSeconds, getSeconds() - start, iterations);
+
+    start = getSeconds();
+    for (i = 0; i < iterations; i++) {
+        altDesired = (int32_t) i;
+        yawDesired = (int32_t) i;
+        xQueueOverwrite(queues->altDesired, &altDesired);
+        xQueueOverwrite(queues->yawDesired, &yawDesired);
+    }
+    queueSeconds = getSeconds() - start;
+    start = getSeconds();
+    for (i = 0; i < iterations; i++) {
+        setReferences(FLIGHT_WRITER_BUTTONS, (int32_t) i, (int32_t) i);
+    }
+    printTime("button press", queueSeconds, getSeconds() - start, iterations);
+}
+
+
+/*
+ * Function:    checkCriticalSections
+ * -----------------------------------
+ * Makes every kind of write and read and counts the critical
+ * sections they enter. On the board each would hold off the
+ * interrupts at or below configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ * @params:
+ *      - uint32_t iterations: Writes of each kind.
+ * @return:
+ *      - bool none: True if no critical section was entered.
+ * ---------------------
+ */
+static bool
+checkCriticalSections(uint32_t iterations)
+{
+    altitudeSample_t sample = {0};
+    flightState_t flight;
+    uint32_t i;
+
+    g_simCriticalSections = 0;
+    for (i = 0; i < iterations; i++) {
+        sample.altitude = (int32_t) i;
+        setAltMeasured(&sample);
+        setAltDesired(FLIGHT_WRITER_FSM, (int32_t) i);
+        setYawDesired(FLIGHT_WRITER_BUTTONS, (int32_t) i);
+        setReferences(FLIGHT_WRITER_BUTTONS, (int32_t) i, (int32_t) i);
+        setFSMState(i);
+        getFlightState(&flight);
+    }
+
+    printf("masking          %lu critical sections in %lu writes\n", (unsigned long) g_simCriticalSections,
+           (unsigned long) iterations * 5);
+    return g_simCriticalSections == 0;
+}
+
+
+/*
+ * Function:    checkReferences
+ * -----------------------------
+ * Checks the desired altitude and yaw against the values expected.
+ *
+ * @params:
+ *      - const char* step: The writes made.
+ *      - int32_t altitude: The expected desired altitude (%).
+ *      - int32_t yaw: The expected desired yaw (degrees).
+ * @return:
+ *      - bool match: True if both match.
+ * ---------------------
+ */
+static bool
+checkReferences(const char* step, int32_t altitude, int32_t yaw)
+{
+    flightState_t flight;
+    bool match;
+
+    getFlightState(&flight);
+    match = flight.altDesired == altitude && flight.yawDesired == yaw && getAltDesired() == altitude
+            && getYawDesired() == yaw;
+    if (!match) {
+        printf("writer order     %s: altitude %ld, yaw %ld, expected %ld, %ld\n", step, (long) flight.altDesired,
+               (long) flight.yawDesired, (long) altitude, (long) yaw);
+    }
+    return match;
+}
+
+
+/*
+ * Function:    checkWriterOrder
+ * ------------------------------
+ * Writes the references from the FSM and the buttons in turn and
+ * checks that each field takes its newest write, whichever writer
+ * made it.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - bool ordered: True if every step matched.
+ * ---------------------
+ */
+static bool
+checkWriterOrder(void)
+{
+    bool ordered = true;
+
+    initFlightState();
+    setReferences(FLIGHT_WRITER_FSM, 15, 0);
+    ordered &= checkReferences("FSM takes off", 15, 0);
+    setAltDesired(FLIGHT_WRITER_BUTTONS, 25);
+    ordered &= checkReferences("up button", 25, 0);
+    setYawDesired(FLIGHT_WRITER_BUTTONS, 345);
+    ordered &= checkReferences("left button", 25, 345);
+    setAltDesired(FLIGHT_WRITER_FSM, 20);
+    ordered &= checkReferences("FSM descends", 20, 345);
+    setReferences(FLIGHT_WRITER_BUTTONS, 30, 165);
+    ordered &= checkReferences("yaw flip", 30, 165);
+    setReferences(FLIGHT_WRITER_FSM, 0, 0);
+    ordered &= checkReferences("FSM lands", 0, 0);
+    initFlightState();
+
+    printf("writer order     %s\n", ordered ? "newest write wins" : "FAILED");
+    return ordered;
+}
+
+
+/*
+ * Function:    readInInterrupt
+ * -----------------------------
+ * Signal handler standing in for an interrupt that reads the
+ * flight state. It can land part way through a write, which it
+ * must not wait for.
+ *
+ * @params:
+ *      - int signal: Unused.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+readInInterrupt(int signal)
+{
+    flightState_t flight;
+
+    getFlightState(&flight);
+    if (flight.altDesired != flight.yawDesired || flight.altDesiredTick != flight.yawDesiredTick) {
+        g_interruptTorn++;
+    }
+    g_interruptReads++;
+}
+
+
+/*
+ * Function:    checkInterruptedWrites
+ * ------------------------------------
+ * Writes the references while a timer signal reads the flight
+ * state on the same thread. A reader that spun until the write
+ * finished would never return from the signal.
+ *
+ * @params:
+ *      - double seconds: How long to check for.
+ * @return:
+ *      - bool consistent: True if every read was consistent.
+ * ---------------------
+ */
+static bool
+checkInterruptedWrites(double seconds)
+{
+    struct sigaction action = {0};
+    struct itimerval timer = {{0, BENCH_INTERRUPT_US}, {0, BENCH_INTERRUPT_US}};
+    const struct itimerval stop = {{0, 0}, {0, 0}};
+    uint64_t writes = 0;
+    int32_t count = 0;
+    double end = getSeconds() + seconds;
+
+    g_interruptReads = 0;
+    g_interruptTorn = 0;
+    action.sa_handler = readInInterrupt;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, NULL);
+    setitimer(ITIMER_REAL, &timer, NULL);
+    while (getSeconds() < end) {
+        count++;
+        setReferences((count & 1) ? FLIGHT_WRITER_FSM : FLIGHT_WRITER_BUTTONS, count, count);
+        writes++;
+    }
+    setitimer(ITIMER_REAL, &stop, NULL);
+    signal(SIGALRM, SIG_DFL);
+
+    printf("interrupted      %llu reads during %llu writes, %llu torn\n", (unsigned long long) g_interruptReads,
+           (unsigned long long) writes, (unsigned long long) g_interruptTorn);
+    return g_interruptReads > 0 && g_interruptTorn == 0;
+}
+
+
+/*
+ * Function:    writeReferences
+ * -----------------------------
+ * Thread that keeps setting the desired altitude and yaw to the
+ * same count until told to stop. The FSM's counts are positive and
+ * the buttons' negative.
+ *
+ * @params:
+ *      - void* arg: The writer, as a flightWriter_t.
+ * @return:
+ *      - void* result: NULL.
+ * ---------------------
+ */
+static void*
+writeReferences(void* arg)
+{
+    flightWriter_t writer = (flightWriter_t) (intptr_t) arg;
+    int32_t step = (writer == FLIGHT_WRITER_FSM) ? 1 : -1;
+    int32_t count = 0;
+
+    while (g_writing) {
+        count += step;
+        setReferences(writer, count, count);
+    }
+    return NULL;
+}
+
+
+/*
+ * Function:    checkSnapshots
+ * ----------------------------
+ * Takes snapshots while two other threads, one for each writer,
+ * write the references and counts any where the desired altitude
+ * and yaw come from different writes.
+ *
+ * @params:
+ *      - double seconds: How long to check for.
+ * @return:
+ *      - bool consistent: True if every snapshot was consistent.
+ * ---------------------
+ */
+static bool
+checkSnapshots(double seconds)
+{
+    pthread_t writers[NUM_FLIGHT_WRITERS];
+    flightState_t flight;
+    uint64_t snapshots = 0;
+    uint64_t torn = 0;
+    uint64_t changes = 0;
+    int32_t last = 0;
+    double end = getSeconds() + seconds;
+    intptr_t writer;
+
+    g_writing = true;
+    for (writer = 0; writer < NUM_FLIGHT_WRITERS; writer++) {
+        if (pthread_create(&writers[writer], NULL, writeReferences, (void*) writer) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    while (getSeconds() < end) {
+        getFlightState(&flight);
+        if (flight.altDesired != flight.yawDesired || flight.altDesiredTick != flight.yawDesiredTick) {
+            torn++;
+        }
+        if (flight.altDesired != last) {
+            changes++;
+            last = flight.altDesired;
+        }
+        snapshots++;
+    }
+    g_writing = false;
+    for (writer = 0; writer < NUM_FLIGHT_WRITERS; writer++) {
+        pthread_join(writers[writer], NULL);
+    }
+
+    printf("consistency      %llu snapshots across %llu writes, %llu torn\n", (unsigned long long) snapshots,
+           (unsigned long long) changes, (unsigned long long) torn);
+    return torn == 0;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    benchQueues_t queues;
+    altitudeSample_t sample = {0};
+    int32_t zero = 0;
+    uint32_t iterations = BENCH_ITERATIONS;
+    double seconds = BENCH_CHECK_SECONDS;
+    bool pass;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:t:")) != -1) {
+        switch (option) {
+            case 'n':
+                iterations = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                seconds = strtod(optarg, NULL);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-t seconds]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    queues.altMeasured = xQueueCreate(1, sizeof(altitudeSample_t));
+    queues.altDesired = xQueueCreate(1, sizeof(int32_t));
+    queues.yawDesired = xQueueCreate(1, sizeof(int32_t));
+    queues.fsmState = xQueueCreate(1, sizeof(uint32_t));
+    xQueueOverwrite(queues.altMeasured, &sample);
+    xQueueOverwrite(queues.altDesired, &zero);
+    xQueueOverwrite(queues.yawDesired, &zero);
+    xQueueOverwrite(queues.fsmState, &zero);
+    initFlightState();
+
+    timeAccesses(&queues, iterations);
+    pass = checkCriticalSections(iterations);
+    pass &= checkWriterOrder();
+    pass &= checkInterruptedWrites(seconds);
+    pass &= checkSnapshots(seconds);
+    return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
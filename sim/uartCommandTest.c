@@ -0,0 +1,309 @@
+/* ****************************************************************
+ * uartCommandTest.c
+ *
+ * Tests the UART command path that reads and changes controller
+ * parameters at runtime. Types commands into the simulator's UART,
+ * lets the firmware's command task run them and checks its replies
+ * and the controllers. The control tasks are not run, so the test
+ * calls applyControllerParams itself where a control cycle would.
+ *
+ * Usage: uartCommandTest [-v]
+ *      -v  Print every check, not just the failures
+ *
+ * Checks that:
+ *      - "get" reports the parameters the controller runs with
+ *      - "set" edits a copy, which only reaches the controller when
+ *        applied and swapped in at a control cycle
+ *      - a second "apply" before the swap is refused as busy, and
+ *        the edit behind it keeps the staged changes
+ *      - gains outside 0 to PID_MAX_GAIN, time steps that are not a
+ *        whole number of executive cycles and crossed limits are
+ *        refused and leave the controller unchanged
+ *      - the largest gains at the shortest time step give the exact
+ *        fixed-point gains
+ *      - malformed commands are refused
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "simRTOS.h"
+#include "simHardware.h"
+#include "simTest.h"
+#include "FreeRTOSCreate.h"
+#include "controlExecutive.h"
+#include "pidController.h"
+#include "uartCommand.h"
+
+#define TEST_LINE_SIZE          64
+
+
+/*
+ * Function:    sendCommand
+ * -------------------------
+ * Types a command line into the UART and checks the command task's
+ * reply.
+ *
+ * @params:
+ *      - const char* command: The command, without the line end.
+ *      - const char* expected: The whole reply expected.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+sendCommand(const char* command, const char* expected)
+{
+    char line[TEST_LINE_SIZE];
+    char reply[SIM_UART_TX_SIZE + 1];
+
+    snprintf(line, sizeof(line), "%s\n", command);
+    simUARTReceive(line);
+    simTakeUARTOutput(reply);
+    simCheck(strcmp(reply, expected) == 0, "\"%s\" replies \"%.*s\" (expected \"%.*s\")", command,
+             (int) strcspn(reply, "\n"), reply, (int) strcspn(expected, "\n"), expected);
+}
+
+
+/*
+ * Function:    sendValue
+ * -----------------------
+ * Sets one parameter of the altitude controller's edit copy.
+ *
+ * @params:
+ *      - const char* name: The parameter.
+ *      - int32_t value: Its new value.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+sendValue(const char* name, int32_t value)
+{
+    char line[TEST_LINE_SIZE];
+
+    snprintf(line, sizeof(line), "set alt %s %d", name, (int) value);
+    sendCommand(line, "OK\n");
+}
+
+
+/*
+ * Function:    getExpectedQ
+ * --------------------------
+ * Returns a gain ratio in Q format, rounded, computed in double
+ * precision.
+ *
+ * @params:
+ *      - double numerator: Numerator of the gain ratio.
+ *      - double denominator: Denominator of the gain ratio.
+ * @return:
+ *      - int64_t gain: The ratio in Q format.
+ * ---------------------
+ */
+static int64_t
+getExpectedQ(double numerator, double denominator)
+{
+    return llround(numerator * PID_Q_ONE / denominator);
+}
+
+
+/*
+ * Function:    testGetSetApply
+ * -----------------------------
+ * Reads the altitude controller, edits it, applies the edit and
+ * swaps it in.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testGetSetApply(void)
+{
+    char expected[SIM_UART_TX_SIZE];
+
+    snprintf(expected, sizeof(expected), "alt Kp %d Ki %d Kd %d\nalt ts %d min %d max %d\n",
+             ALT_KP, ALT_KI, ALT_KD, CONTROL_PERIOD, MIN_DUTY, MAX_DUTY);
+    sendCommand("get alt", expected);
+
+    sendValue("kp", ALT_KP + 15);
+    simCheck(g_alt_controller.Kp == ALT_KP, "a set edit does not reach the controller");
+    sendCommand("apply alt", "OK\n");
+    simCheck(g_alt_controller.paramsPending && g_alt_controller.Kp == ALT_KP,
+             "an applied edit waits for the control cycle");
+
+    // An edit started before the swap builds on the staged set
+    sendValue("ki", ALT_KI + 5);
+    sendCommand("apply alt", "BUSY\n");
+
+    applyControllerParams(&g_alt_controller);
+    simCheck(g_alt_controller.Kp == ALT_KP + 15 && !g_alt_controller.paramsPending,
+             "the control cycle swaps in Kp %d (expected %d)", (int) g_alt_controller.Kp, ALT_KP + 15);
+    simCheck(g_alt_controller.KpBaseQ == getExpectedQ(ALT_KP + 15, CONTROL_DIVISOR),
+             "the swapped in Kp is rescaled to Q format");
+
+    sendCommand("apply alt", "OK\n");
+    applyControllerParams(&g_alt_controller);
+    simCheck(g_alt_controller.Ki == ALT_KI + 5, "the edit refused as busy is applied again (Ki %d, expected %d)",
+             (int) g_alt_controller.Ki, ALT_KI + 5);
+
+    sendCommand("set yaw kp 40", "OK\n");
+    sendCommand("apply yaw", "OK\n");
+    applyControllerParams(&g_yaw_controller);
+    simCheck(g_yaw_controller.Kp == 40 && g_alt_controller.Kp == ALT_KP + 15,
+             "a yaw edit only changes the yaw controller (yaw Kp %d, alt Kp %d)",
+             (int) g_yaw_controller.Kp, (int) g_alt_controller.Kp);
+}
+
+
+/*
+ * Function:    testRejected
+ * --------------------------
+ * Applies edits that are out of range and checks each is refused
+ * without changing the controller, then restores a valid edit.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testRejected(void)
+{
+    static const struct {
+        const char* name;
+        int32_t value;
+        int32_t valid;
+    } edits[] = {
+        {"kp", PID_MAX_GAIN + 1, ALT_KP},
+        {"kp", -1, ALT_KP},
+        {"ki", PID_MAX_GAIN + 1, ALT_KI},
+        {"kd", -1, ALT_KD},
+        {"kd", PID_MAX_GAIN + 1, ALT_KD},
+        // Not a whole number of executive cycles. At 1 kHz every step is, so too long instead
+        {"ts", (EXECUTIVE_PERIOD > 1) ? EXECUTIVE_PERIOD + 1 : PID_MAX_TIME_STEP + 1, CONTROL_PERIOD},
+        {"ts", 0, CONTROL_PERIOD},
+        {"min", MAX_DUTY, MIN_DUTY},
+        {"min", MIN_DUTY - 1, MIN_DUTY},
+        {"max", MAX_DUTY + 1, MAX_DUTY},
+    };
+    controllerParams_t before;
+    controllerParams_t after;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(edits) / sizeof(edits[0]); i++) {
+        getControllerParams(&g_alt_controller, &before);
+        sendValue(edits[i].name, edits[i].value);
+        sendCommand("apply alt", "ERR\n");
+        getControllerParams(&g_alt_controller, &after);
+        simCheck(!g_alt_controller.paramsPending && memcmp(&before, &after, sizeof(before)) == 0,
+                 "%s %d leaves the controller unchanged", edits[i].name, (int) edits[i].value);
+        sendValue(edits[i].name, edits[i].valid);
+    }
+    sendCommand("apply alt", "OK\n");
+    applyControllerParams(&g_alt_controller);
+
+    sendCommand("set alt kp 1x", "ERR\n");
+    sendCommand("set alt gain 1", "ERR\n");
+    sendCommand("set alt kp", "ERR\n");
+    sendCommand("get rotor", "ERR\n");
+    sendCommand("apply", "ERR\n");
+}
+
+
+/*
+ * Function:    testLargestGains
+ * ------------------------------
+ * Applies the largest gains at the shortest time step and checks
+ * the fixed-point gains against the double-precision ratios.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testLargestGains(void)
+{
+    int32_t timeStep = EXECUTIVE_PERIOD;
+
+    sendValue("kp", PID_MAX_GAIN);
+    sendValue("ki", PID_MAX_GAIN);
+    sendValue("kd", PID_MAX_GAIN);
+    sendValue("ts", timeStep);
+    sendCommand("apply alt", "OK\n");
+    applyControllerParams(&g_alt_controller);
+
+    simCheck(g_alt_controller.KpBaseQ == getExpectedQ(PID_MAX_GAIN, CONTROL_DIVISOR),
+             "largest Kp is %d in Q format (expected %lld)", (int) g_alt_controller.KpBaseQ,
+             (long long) getExpectedQ(PID_MAX_GAIN, CONTROL_DIVISOR));
+    simCheck(g_alt_controller.KiBaseQ == getExpectedQ((double) PID_MAX_GAIN * timeStep, MS_TO_SECONDS * CONTROL_DIVISOR),
+             "largest Ki is %d in Q format (expected %lld)", (int) g_alt_controller.KiBaseQ,
+             (long long) getExpectedQ((double) PID_MAX_GAIN * timeStep, MS_TO_SECONDS * CONTROL_DIVISOR));
+    simCheck(g_alt_controller.KdBaseQ == getExpectedQ((double) PID_MAX_GAIN * MS_TO_SECONDS, timeStep * CONTROL_DIVISOR),
+             "largest Kd is %d in Q format (expected %lld)", (int) g_alt_controller.KdBaseQ,
+             (long long) getExpectedQ((double) PID_MAX_GAIN * MS_TO_SECONDS, timeStep * CONTROL_DIVISOR));
+}
+
+
+/*
+ * Function:    runSimulation
+ * ---------------------------
+ * Runs the tests once the scheduler has started the command task,
+ * and exits with the result.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+runSimulation(void)
+{
+    testGetSetApply();
+    testRejected();
+    testLargestGains();
+    exit(simCheckResult("uartCommandTest"));
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    int option;
+
+    while ((option = getopt(argc, argv, "v")) != -1) {
+        switch (option) {
+            case 'v':
+                simSetCheckVerbose(true);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    xUARTRxQueue = xQueueCreate(UART_RX_QUEUE_SIZE, sizeof(char));
+    xUARTMutex = xSemaphoreCreateMutex();
+    initController(&g_alt_controller, false);
+    initController(&g_yaw_controller, true);
+    initUARTCommand();
+    xTaskCreate(UARTCommand, "UART Cmd", UART_CMD_STACK_DEPTH, NULL, UART_CMD_TASK_PRIORITY, NULL);
+
+    vTaskStartScheduler();                                          // Never returns. Calls runSimulation
+    return EXIT_FAILURE;
+}
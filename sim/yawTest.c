@@ -0,0 +1,777 @@
+/* ****************************************************************
+ * yawTest.c
+ *
+ * Tests the yaw decoder against the simulator's stand-ins. Drives
+ * the encoder channels as the rig's encoder would. Built twice
+ * from this file: yawTest decodes with GPIO interrupts on PB0 and
+ * PB1, and yawQeiTest with the QEI on PD6 and PD7, which the
+ * simulator models register by register. Both run the same
+ * vectors and must give the same counts.
+ *
+ * Usage: yawTest [-v] [-b] [-n edges]
+ *        yawQeiTest [-v]
+ *      -v  Print every check, not just the failures
+ *      -b  Also time the quadrature interrupt (GPIO backend only)
+ *      -n  Edges timed with -b (default 10000000)
+ *
+ * Checks that:
+ *      - each of the 16 transitions between two channel readings
+ *        changes the slot count by the step between them in the
+ *        encoder's Gray code: +1 forwards, -1 backwards, 0 for no
+ *        change or a skipped state
+ *      - only the skipped states count as quadrature errors
+ *      - the count rises as the plant's encoder turns forwards
+ *      - a steady turn either way reads the right yaw rate
+ *      - the first reference crossing sets zero yaw and tells the
+ *        FSM, and later crossings a whole revolution on measure
+ *        no drift
+ *      - crossings entering the mark from its other side are not
+ *        latched, as the mark's other edge would read as drift
+ *      - slots lost to a skipped state are measured as drift at
+ *        the next crossing and slewed out a slot per update,
+ *        without a step in the yaw
+ *      - a long spin either way keeps the turn count, and the
+ *        wrapped yaw agrees with the unwrapped yaw at every edge
+ *
+ * The GPIO backend's benchmark times the interrupt per edge, less the cost of
+ * driving the pins, against a copy of the switch decoder it
+ * replaced. That decoder passed the slot count through queues
+ * and converted it to degrees on every edge. The firmware's
+ * handler also feeds the flight recorder and the profiler, which
+ * the old one did not, so the comparison is conservative. The
+ * simulator's queues skip the kernel's critical sections, so the
+ * board gains more than the host shows.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include "simRTOS.h"
+#include "simHardware.h"
+#include "simTest.h"
+#include "heliPlant.h"
+#include "FreeRTOSCreate.h"
+#include "FSM.h"
+#include "yaw.h"
+
+#if YAW_SENSOR_QEI
+#define YAW_TEST_NAME           "yawQeiTest"
+#define YAW_TEST_PORT           YAW_QEI_GPIO_BASE
+#define YAW_TEST_PIN_A          GPIO_PIN_6
+#define YAW_TEST_PIN_B          GPIO_PIN_7
+#define YAW_TEST_INDEX_PIN      GPIO_PIN_3
+#else
+#define YAW_TEST_NAME           "yawTest"
+#define YAW_TEST_PORT           YAW_GPIO_BASE
+#define YAW_TEST_PIN_A          QEI_PIN0
+#define YAW_TEST_PIN_B          QEI_PIN1
+#endif /* YAW_SENSOR_QEI */
+#define YAW_TEST_PINS           (YAW_TEST_PIN_A | YAW_TEST_PIN_B)
+#define YAW_TEST_READINGS       4           // Channel readings, two bits each
+#define YAW_TEST_SPIN_SLOTS     (4 * MAX_YAW_SLOTS)
+#define YAW_TEST_SPIN_US        100         // Time between edges of the spin, about 8000 deg/s
+#define YAW_TEST_RATE_SLOTS     100         // Slots turned at a steady rate
+#define YAW_TEST_RATE_US        1000        // Time between edges of the steady turn (us)
+#define YAW_TEST_RATE_TOLERANCE 0.02        // Largest fractional rate error passed
+#define YAW_TEST_MARK_SLOT      100         // Plant slot at the centre of the reference mark
+#define YAW_TEST_TURNS          3           // Revolutions through the mark before drift is added
+#define YAW_TEST_LOST_SLOTS     2           // Slots lost by a skipped state
+#define YAW_TEST_LONG_TURNS     100         // Revolutions of the long spin each way
+#define YAW_TEST_UPDATE_EDGES   20          // Edges between reference updates
+#define YAW_TEST_MAX_UPDATES    100         // Most reference updates waited for the correction
+#define YAW_BENCH_EDGES         10000000
+#define YAW_BENCH_NS_PER_SECOND 1e9
+
+static uint8_t g_phases[YAW_TEST_READINGS]; // Channel readings of the plant's encoder, in forward order
+static int32_t g_encoderSlot = 0;          // Slot of the plant's encoder in the reference tests
+static int32_t g_zeroSlot = 0;             // Slot of the plant's encoder the yaw should read zero at
+static uint32_t g_steps = 0;               // Edges where the yaw stepped since the last tracking check
+static uint32_t g_wrapErrors = 0;          // Edges where the wrapped yaw disagreed since the last tracking check
+#if !YAW_SENSOR_QEI
+static QueueHandle_t g_legacySlotQueue;
+static QueueHandle_t g_legacyYawQueue;
+static uint32_t g_legacyErrors = 0;        // States the switch decoder saw skipped
+#endif /* YAW_SENSOR_QEI */
+
+
+// The test drives the decoder itself and never starts the scheduler
+void runSimulation(void) {}
+
+
+/*
+ * Function:    getPhaseIndex
+ * ---------------------------
+ * Returns where a channel reading falls in the encoder's Gray
+ * code.
+ *
+ * @params:
+ *      - uint8_t reading: The channel levels.
+ * @return:
+ *      - int32_t index: 0 to 3, forwards.
+ * ---------------------
+ */
+static int32_t
+getPhaseIndex(uint8_t reading)
+{
+    int32_t i;
+
+    for (i = 0; i < YAW_TEST_READINGS; i++) {
+        if (g_phases[i] == reading) {
+            break;
+        }
+    }
+    return i;
+}
+
+
+/*
+ * Function:    toPinLevels
+ * -------------------------
+ * Maps a channel reading onto the backend's pins.
+ *
+ * @params:
+ *      - uint8_t reading: Channel A in bit 0, channel B in bit 1.
+ * @return:
+ *      - uint8_t levels: Levels of the port's pins.
+ * ---------------------
+ */
+static uint8_t
+toPinLevels(uint8_t reading)
+{
+    return ((reading & 1) ? YAW_TEST_PIN_A : 0) | ((reading & 2) ? YAW_TEST_PIN_B : 0);
+}
+
+
+/*
+ * Function:    setReading
+ * ------------------------
+ * Drives the channels to a reading, changing both at the same
+ * instant if both differ. With the GPIO backend an unchanged
+ * reading raises the pin interrupt anyway, as a glitch would.
+ *
+ * @params:
+ *      - uint8_t reading: The channel levels.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+setReading(uint8_t reading)
+{
+#if !YAW_SENSOR_QEI
+    if ((GPIOPinRead(YAW_TEST_PORT, YAW_TEST_PINS)) == toPinLevels(reading)) {
+        simRaisePinInterrupt(YAW_TEST_PORT, YAW_TEST_PINS);
+        return;
+    }
+#endif /* YAW_SENSOR_QEI */
+    simSetPins(YAW_TEST_PORT, YAW_TEST_PINS, toPinLevels(reading));
+}
+
+
+/*
+ * Function:    testTransitions
+ * -----------------------------
+ * Takes the decoder through each of the 16 transitions between
+ * two readings and checks the slot change and error count of each.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testTransitions(void)
+{
+    uint8_t previous;
+    uint8_t next;
+    int32_t step;
+    int32_t expected;
+    int32_t slots;
+    uint32_t errors;
+
+    for (previous = 0; previous < YAW_TEST_READINGS; previous++) {
+        for (next = 0; next < YAW_TEST_READINGS; next++) {
+            setReading(previous);                                   // The decoder's last reading
+            slots = getYawSlots();
+            errors = getQuadratureErrors();
+            setReading(next);
+
+            step = (getPhaseIndex(next) - getPhaseIndex(previous)) & (YAW_TEST_READINGS - 1);
+            expected = (step == 1) ? 1 : (step == YAW_TEST_READINGS - 1) ? -1 : 0;
+            simCheck(getYawSlots() - slots == expected, "transition 0b%u%u to 0b%u%u moves %d slots (expected %d)",
+                     (previous >> 1) & 1, previous & 1, (next >> 1) & 1, next & 1,
+                     (int) (getYawSlots() - slots), (int) expected);
+            simCheck(getQuadratureErrors() - errors == (step == 2),
+                     "transition 0b%u%u to 0b%u%u counts %u quadrature errors (expected %u)",
+                     (previous >> 1) & 1, previous & 1, (next >> 1) & 1, next & 1,
+                     (unsigned) (getQuadratureErrors() - errors), (unsigned) (step == 2));
+        }
+    }
+}
+
+
+/*
+ * Function:    testPlantEncoder
+ * ------------------------------
+ * Turns the plant's encoder forwards and back over several
+ * revolutions, one edge every YAW_TEST_SPIN_US, and checks the
+ * slot count follows it. The QEI backend folds its wrapping
+ * position into the count on its velocity timer, so time must
+ * pass as the encoder turns.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testPlantEncoder(void)
+{
+    int32_t start;
+    int32_t slot;
+    uint32_t errors;
+
+    setReading(getHeliEncoderPhases(0));
+    start = getYawSlots();
+    errors = getQuadratureErrors();
+    for (slot = 1; slot <= YAW_TEST_SPIN_SLOTS; slot++) {
+        simAdvanceTime(simGetTime() + YAW_TEST_SPIN_US * SIM_NS_PER_US);
+        setReading(getHeliEncoderPhases(slot));
+    }
+    simCheck(getYawSlots() - start == YAW_TEST_SPIN_SLOTS, "%d slots counted forwards over %d",
+             (int) (getYawSlots() - start), YAW_TEST_SPIN_SLOTS);
+
+    for (slot = YAW_TEST_SPIN_SLOTS - 1; slot >= 0; slot--) {
+        simAdvanceTime(simGetTime() + YAW_TEST_SPIN_US * SIM_NS_PER_US);
+        setReading(getHeliEncoderPhases(slot));
+    }
+    simCheck(getYawSlots() == start, "back to the start after turning back (%d slots off)",
+             (int) (getYawSlots() - start));
+    simCheck(getQuadratureErrors() == errors, "no quadrature errors turning one edge at a time");
+}
+
+
+/*
+ * Function:    turnSteadily
+ * --------------------------
+ * Turns the plant's encoder at a steady rate, one edge every
+ * YAW_TEST_RATE_US, and returns the yaw rate read at the end.
+ *
+ * @params:
+ *      - int32_t direction: 1 forwards, -1 backwards.
+ * @return:
+ *      - double rate: Yaw rate read (degrees per second).
+ * ---------------------
+ */
+static double
+turnSteadily(int32_t direction)
+{
+    static int32_t slot = 0;
+    int32_t i;
+
+    updateYawRate();                                                // Starts the GPIO backend's edge period
+    for (i = 0; i < YAW_TEST_RATE_SLOTS; i++) {
+        simAdvanceTime(simGetTime() + YAW_TEST_RATE_US * SIM_NS_PER_US);
+        slot += direction;
+        setReading(getHeliEncoderPhases(slot));
+    }
+    updateYawRate();
+    return (double) getYawRate() / (1 << YAW_RATE_Q_BITS);
+}
+
+
+/*
+ * Function:    testRate
+ * ----------------------
+ * Turns steadily forwards then backwards and checks the yaw rate
+ * read each way.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testRate(void)
+{
+    double expected = (double) DEGREES_CIRCLE * SIM_US_PER_SECOND / (MAX_YAW_SLOTS * YAW_TEST_RATE_US);
+    double rate;
+
+    setReading(getHeliEncoderPhases(0));
+    rate = turnSteadily(1);
+    simCheck(fabs(rate - expected) <= YAW_TEST_RATE_TOLERANCE * expected,
+             "forward turn reads %.1f deg/s (expected %.1f)", rate, expected);
+    rate = turnSteadily(-1);
+    simCheck(fabs(rate + expected) <= YAW_TEST_RATE_TOLERANCE * expected,
+             "backward turn reads %.1f deg/s (expected %.1f)", rate, -expected);
+}
+
+
+/*
+ * Function:    setReferenceMark
+ * ------------------------------
+ * Drives the backend's reference input: the active low reference
+ * pin for the GPIO backend, the QEI's index for the QEI backend.
+ *
+ * @params:
+ *      - bool atMark: True while the encoder is over the mark.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+setReferenceMark(bool atMark)
+{
+#if YAW_SENSOR_QEI
+    simSetPin(YAW_QEI_GPIO_BASE, YAW_TEST_INDEX_PIN, atMark);
+#else
+    simSetPin(YAW_REFERENCE_BASE, YAW_REFERENCE_PIN, !atMark);
+#endif /* YAW_SENSOR_QEI */
+}
+
+
+/*
+ * Function:    checkStep
+ * -----------------------
+ * Checks the yaw read after an edge against the yaw read before
+ * it. The slot count may move by the edge and by one slew of the
+ * drift correction, and the wrapped yaw must agree with the
+ * unwrapped yaw to within the degree lost converting each.
+ *
+ * @params:
+ *      - int32_t slots: Slots read before the edge.
+ *      - int32_t direction: 1 forwards, -1 backwards, 0 for no edge.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+checkStep(int32_t slots, int32_t direction)
+{
+    int32_t step = getYawSlots() - slots - direction;
+    int32_t offset = (getYawUnwrapped() - getYaw()) % DEGREES_CIRCLE;
+
+    if (step > YAW_DRIFT_SLEW || step < -YAW_DRIFT_SLEW) {
+        g_steps++;
+    }
+    if (offset < 0) {
+        offset += DEGREES_CIRCLE;
+    }
+    if (getYaw() < MIN_YAW_LIMIT || getYaw() > MAX_YAW_LIMIT || (offset > 1 && offset < DEGREES_CIRCLE - 1)) {
+        g_wrapErrors++;
+    }
+}
+
+
+/*
+ * Function:    turnTo
+ * --------------------
+ * Turns the plant's encoder one edge at a time to a slot, driving
+ * the reference mark as it passes. Updates the reference every
+ * YAW_TEST_UPDATE_EDGES edges as the yaw task would, and checks
+ * every edge with checkStep.
+ *
+ * @params:
+ *      - int32_t target: Slot of the plant's encoder to stop at.
+ *      - uint32_t usPerEdge: Time between edges (us).
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+turnTo(int32_t target, uint32_t usPerEdge)
+{
+    int32_t direction = (target > g_encoderSlot) ? 1 : -1;
+    uint32_t edges = 0;
+    int32_t slots;
+
+    while (g_encoderSlot != target) {
+        slots = getYawSlots();
+        simAdvanceTime(simGetTime() + usPerEdge * SIM_NS_PER_US);
+        g_encoderSlot += direction;
+        setReading(getHeliEncoderPhases(g_encoderSlot));
+        setReferenceMark(isHeliAtReference(g_encoderSlot - YAW_TEST_MARK_SLOT));
+        if (++edges % YAW_TEST_UPDATE_EDGES == 0) {
+            updateYawReference();
+        }
+        checkStep(slots, direction);
+    }
+}
+
+
+/*
+ * Function:    settleReference
+ * -----------------------------
+ * Updates the reference without turning until the drift
+ * correction has been slewed in, checking each update with
+ * checkStep.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint32_t updates: Updates made.
+ * ---------------------
+ */
+static uint32_t
+settleReference(void)
+{
+    yawDriftStats_t stats;
+    uint32_t updates = 0;
+    int32_t slots;
+
+    do {
+        slots = getYawSlots();
+        updateYawReference();
+        checkStep(slots, 0);
+        getYawDriftStats(&stats);
+        updates++;
+    } while (stats.pending != 0 && updates < YAW_TEST_MAX_UPDATES);
+    return updates;
+}
+
+
+/*
+ * Function:    checkTracking
+ * ---------------------------
+ * Checks the yaw read against the plant's encoder, and that no
+ * edge since the last check stepped the yaw or broke the wrap.
+ *
+ * @params:
+ *      - const char* when: Where in the test the check is made.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+checkTracking(const char* when)
+{
+    int32_t expected = g_encoderSlot - g_zeroSlot;
+    int32_t turns = (expected >= 0) ? expected / MAX_YAW_SLOTS : -((MAX_YAW_SLOTS - 1 - expected) / MAX_YAW_SLOTS);
+
+    simCheck(getYawSlots() == expected, "%s: %d slots from the reference (expected %d)",
+             when, (int) getYawSlots(), (int) expected);
+    simCheck(getYawTurns() == turns, "%s: %d turns from the reference (expected %d)",
+             when, (int) getYawTurns(), (int) turns);
+    simCheck(g_steps == 0, "%s: no step larger than an edge and a slew (%u seen)", when, (unsigned) g_steps);
+    simCheck(g_wrapErrors == 0, "%s: wrapped yaw agrees with the unwrapped yaw (%u edges differ)",
+             when, (unsigned) g_wrapErrors);
+    g_steps = 0;
+    g_wrapErrors = 0;
+}
+
+
+/*
+ * Function:    testReference
+ * ---------------------------
+ * Finds the reference, turns several revolutions through it, then
+ * loses a state and checks the drift is measured at the next
+ * crossing and slewed out without a step. Finally turns back
+ * through the mark, entering it from the other side, which must
+ * not be read as drift.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testReference(void)
+{
+    yawDriftStats_t stats;
+    uint8_t event = 0;
+    uint32_t crossings;
+    uint32_t errors;
+    uint32_t updates;
+
+    setReading(getHeliEncoderPhases(g_encoderSlot));
+    setReferenceMark(false);
+    simCheck(!isYawReferenced(), "not referenced before the mark is crossed");
+
+    // The first crossing sets zero yaw where the mark starts, stepping the yaw once
+    turnTo(YAW_TEST_MARK_SLOT + MAX_YAW_SLOTS / 4, YAW_TEST_RATE_US);
+    g_zeroSlot = YAW_TEST_MARK_SLOT - PLANT_REFERENCE_WIDTH;
+    simCheck(g_steps == 1, "the first crossing steps the yaw to zero once (%u steps)", (unsigned) g_steps);
+    g_steps = 0;
+    simCheck(isYawReferenced(), "referenced after the mark is crossed");
+    simCheck(xQueueReceive(xFSMEventQueue, &event, 0) == pdPASS && event == FSM_EVENT_REFERENCE_FOUND,
+             "the FSM is told the reference was found");
+    settleReference();
+    checkTracking("first crossing");
+
+    // Whole revolutions through the mark measure no drift
+    turnTo(g_encoderSlot + YAW_TEST_TURNS * MAX_YAW_SLOTS, YAW_TEST_RATE_US);
+    settleReference();
+    getYawDriftStats(&stats);
+    simCheck(stats.crossings == 1 + YAW_TEST_TURNS && stats.maxDrift == 0,
+             "%u crossings with %d slots of drift (expected %u with none)",
+             (unsigned) stats.crossings, (int) stats.maxDrift, (unsigned) (1 + YAW_TEST_TURNS));
+    simCheck(xQueueReceive(xFSMEventQueue, &event, 0) != pdPASS, "only the first crossing is sent to the FSM");
+    checkTracking("whole revolutions");
+
+    // A skipped state loses the slots between, until the next crossing
+    errors = getQuadratureErrors();
+    g_encoderSlot += YAW_TEST_LOST_SLOTS;
+    setReading(getHeliEncoderPhases(g_encoderSlot));
+    g_zeroSlot += YAW_TEST_LOST_SLOTS;
+    simCheck(getQuadratureErrors() == errors + 1, "the skipped state is counted");
+    turnTo(g_encoderSlot + MAX_YAW_SLOTS, YAW_TEST_RATE_US);
+    g_zeroSlot -= YAW_TEST_LOST_SLOTS;
+    updates = settleReference();
+    getYawDriftStats(&stats);
+    simCheck(stats.lastDrift == -YAW_TEST_LOST_SLOTS && stats.correction == -YAW_TEST_LOST_SLOTS,
+             "drift of %d slots measured, %d corrected (expected %d)",
+             (int) stats.lastDrift, (int) stats.correction, -YAW_TEST_LOST_SLOTS);
+    simCheck(updates <= YAW_TEST_LOST_SLOTS / YAW_DRIFT_SLEW + 1, "correction slewed in over %u updates",
+             (unsigned) updates);
+    checkTracking("re-sync");
+
+    // The mark is entered from its other side turning back, which is not latched
+    crossings = stats.crossings;
+    turnTo(g_encoderSlot - 2 * MAX_YAW_SLOTS, YAW_TEST_RATE_US);
+    settleReference();
+    getYawDriftStats(&stats);
+    simCheck(stats.crossings == crossings && stats.correction == -YAW_TEST_LOST_SLOTS,
+             "turning back latches %u crossings and corrects %d slots (expected none, %d)",
+             (unsigned) (stats.crossings - crossings), (int) stats.correction, -YAW_TEST_LOST_SLOTS);
+    checkTracking("turning back");
+}
+
+
+/*
+ * Function:    testLongSpin
+ * --------------------------
+ * Spins YAW_TEST_LONG_TURNS revolutions forwards then twice that
+ * backwards, through the reference each revolution, one edge every
+ * YAW_TEST_SPIN_US.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+testLongSpin(void)
+{
+    yawDriftStats_t stats;
+    uint32_t crossings;
+
+    getYawDriftStats(&stats);
+    crossings = stats.crossings;
+
+    turnTo(g_encoderSlot + YAW_TEST_LONG_TURNS * MAX_YAW_SLOTS, YAW_TEST_SPIN_US);
+    settleReference();
+    checkTracking("long spin forwards");
+
+    turnTo(g_encoderSlot - 2 * YAW_TEST_LONG_TURNS * MAX_YAW_SLOTS, YAW_TEST_SPIN_US);
+    settleReference();
+    checkTracking("long spin backwards");
+
+    getYawDriftStats(&stats);
+    simCheck(stats.crossings - crossings == YAW_TEST_LONG_TURNS && stats.lastDrift == 0,
+             "%u forward crossings in the spins, the last with %d slots of drift (expected %u with none)",
+             (unsigned) (stats.crossings - crossings), (int) stats.lastDrift, YAW_TEST_LONG_TURNS);
+}
+
+
+#if !YAW_SENSOR_QEI
+/*
+ * Function:    legacyQuadratureInterrupt
+ * -----------------------------------------
+ * The switch decoder the table replaced, as it was, with its error
+ * message counted instead of sent.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+legacyQuadratureInterrupt(void)
+{
+    int32_t yaw_slot;
+    int32_t yaw;
+    int32_t newChannelReading = GPIOPinRead(YAW_GPIO_BASE, QEI_PIN0|QEI_PIN1);
+    static int32_t currentChannelReading = 0;
+    uint8_t state_code = currentChannelReading << VALUES_PER_READING | newChannelReading;
+
+    xQueuePeekFromISR(g_legacySlotQueue, &yaw_slot);
+
+    switch (state_code){
+        case (0b0010): yaw_slot++; break;
+        case (0b0001): yaw_slot--; break;
+        case (0b0100): yaw_slot++; break;
+        case (0b0111): yaw_slot--; break;
+        case (0b1101): yaw_slot++; break;
+        case (0b1110): yaw_slot--; break;
+        case (0b1011): yaw_slot++; break;
+        case (0b1000): yaw_slot--; break;
+        default: g_legacyErrors++;
+    }
+    currentChannelReading = newChannelReading;
+
+    if (yaw_slot >= MAX_YAW_SLOTS || yaw_slot <= -MAX_YAW_SLOTS) {
+        yaw_slot = 0;
+    }
+    xQueueOverwriteFromISR(g_legacySlotQueue, &yaw_slot, pdFALSE);
+
+    // checkYawThresholds, called from the interrupt
+    xQueuePeek(g_legacySlotQueue, &yaw_slot, 0);
+    yaw = yaw_slot * DEGREES_CIRCLE / MAX_YAW_SLOTS;
+    if (yaw >= MAX_YAW_LIMIT) {
+        yaw = yaw - DEGREES_CIRCLE;
+    } else if (yaw <= MIN_YAW_LIMIT) {
+        yaw = DEGREES_CIRCLE + yaw;
+    }
+    xQueueOverwrite(g_legacyYawQueue, &yaw);
+
+    GPIOIntClear(YAW_GPIO_BASE, QEI_PIN0);
+    GPIOIntClear(YAW_GPIO_BASE, QEI_PIN1);
+}
+
+
+/*
+ * Function:    skipInterrupt
+ * ---------------------------
+ * Stands in for an interrupt handler that does nothing, to time
+ * the benchmark's own loop.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+skipInterrupt(void)
+{
+}
+
+
+/*
+ * Function:    timeEdges
+ * -----------------------
+ * Turns the encoder forwards one edge at a time, calling a handler
+ * for each, and returns the time per edge.
+ *
+ * @params:
+ *      - void (*handler)(void): The interrupt handler.
+ *      - uint32_t edges: Edges timed.
+ * @return:
+ *      - double time: Time per edge (ns).
+ * ---------------------
+ */
+static double
+timeEdges(void (*volatile handler)(void), uint32_t edges)
+{
+    double start = simGetSeconds();
+    uint32_t i;
+
+    for (i = 0; i < edges; i++) {
+        simDrivePins(YAW_TEST_PORT, YAW_TEST_PINS, toPinLevels(g_phases[i & (YAW_TEST_READINGS - 1)]));
+        handler();
+    }
+    return (simGetSeconds() - start) * YAW_BENCH_NS_PER_SECOND / edges;
+}
+
+
+/*
+ * Function:    benchInterrupts
+ * -----------------------------
+ * Times the table decoder's interrupt and the switch decoder's
+ * per edge, and prints the times.
+ *
+ * @params:
+ *      - uint32_t edges: Edges timed.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+benchInterrupts(uint32_t edges)
+{
+    int32_t zero = 0;
+    double loop;
+    double table;
+    double legacy;
+
+    g_legacySlotQueue = xQueueCreate(1, sizeof(int32_t));
+    g_legacyYawQueue = xQueueCreate(1, sizeof(int32_t));
+    xQueueOverwrite(g_legacySlotQueue, &zero);
+    xQueueOverwrite(g_legacyYawQueue, &zero);
+
+    loop = timeEdges(skipInterrupt, edges);
+    table = timeEdges(quadratureFSMInterrupt, edges) - loop;
+    legacy = timeEdges(legacyQuadratureInterrupt, edges) - loop;
+
+    printf("table decoder    %6.1f ns per edge\n", table);
+    printf("switch decoder   %6.1f ns per edge, %.2fx the table decoder\n", legacy, legacy / table);
+}
+#endif /* YAW_SENSOR_QEI */
+
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t edges = YAW_BENCH_EDGES;
+    bool bench = false;
+    int32_t i;
+    int option;
+
+    while ((option = getopt(argc, argv, "vbn:")) != -1) {
+        switch (option) {
+            case 'v':
+                simSetCheckVerbose(true);
+                break;
+            case 'b':
+                bench = true;
+                break;
+            case 'n':
+                edges = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-v] [-b] [-n edges]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (edges < 1) {
+        edges = 1;
+    }
+
+    for (i = 0; i < YAW_TEST_READINGS; i++) {
+        g_phases[i] = getHeliEncoderPhases(i);
+    }
+    xFSMEventQueue = xQueueCreate(FSM_EVENT_QUEUE_SIZE, sizeof(uint8_t));
+    initQuadrature();
+    initReferenceYaw();
+
+    testTransitions();
+    testPlantEncoder();
+    testRate();
+    testReference();
+    testLongSpin();
+#if YAW_SENSOR_QEI
+    if (bench) {
+        printf("the QEI counts edges without an interrupt, so there is nothing to time\n");
+    }
+#else
+    if (bench) {
+        benchInterrupts(edges);
+    }
+#endif /* YAW_SENSOR_QEI */
+
+    return simCheckResult(YAW_TEST_NAME);
+}
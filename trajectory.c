@@ -0,0 +1,242 @@
+/* ****************************************************************
+ * trajectory.c
+ *
+ * Source file of the setpoint trajectory module.
+ * Turns the step changes written to the desired altitude and yaw
+ * queues into trapezoidal reference profiles, limited in rate and
+ * acceleration, for the control loops to track.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include "trajectory.h"
+
+#define TRAJ_MS_TO_SECONDS      1000        // Conversion factor from ms to s
+#define TRAJ_HALF_CIRCLE        180         // Half a revolution of yaw (degrees)
+#define TRAJ_HALF_CIRCLE_Q      ((int64_t) TRAJ_HALF_CIRCLE * TRAJ_Q_ONE)
+
+trajectory_t g_alt_trajectory;
+trajectory_t g_yaw_trajectory;
+
+
+#if TRAJECTORY_ENABLE
+/*
+ * Function:    squareRoot
+ * ------------------------
+ * Integer square root, rounded down.
+ *
+ * @params:
+ *      - uint64_t value: The value to take the root of.
+ * @return:
+ *      - uint32_t root: The square root.
+ * ---------------------
+ */
+static uint32_t
+squareRoot(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t) 1 << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+
+    // Work out one bit of the root per pass, from the top down
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t) root;
+}
+
+
+/*
+ * Function:    wrapPosition
+ * --------------------------
+ * Wraps a yaw position or difference to -180 to 179 degrees.
+ * Altitudes are returned unchanged.
+ *
+ * @params:
+ *      - int64_t value: Position or difference (Q format).
+ *      - bool isYaw: True if the value is a yaw.
+ * @return:
+ *      - int64_t value: The (wrapped) value.
+ * ---------------------
+ */
+static int64_t
+wrapPosition(int64_t value, bool isYaw)
+{
+    if (isYaw) {
+        if (value >= TRAJ_HALF_CIRCLE_Q) {
+            value -= 2 * TRAJ_HALF_CIRCLE_Q;
+        } else if (value < -TRAJ_HALF_CIRCLE_Q) {
+            value += 2 * TRAJ_HALF_CIRCLE_Q;
+        }
+    }
+
+    return value;
+}
+#endif /* TRAJECTORY_ENABLE */
+
+
+/*
+ * Function:    initTrajectory
+ * ----------------------------
+ * Sets the limits of a reference profile and resets it.
+ *
+ * @params:
+ *      - trajectory_t* trajectory: The profile to initialise.
+ *      - int32_t maxRate: Rate limit (units/s).
+ *      - int32_t maxAccel: Acceleration limit (units/s^2).
+ *      - bool isYaw: True if the profile is for yaw.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initTrajectory(trajectory_t* trajectory, int32_t maxRate, int32_t maxAccel, bool isYaw)
+{
+    trajectory->maxRateQ = maxRate * TRAJ_Q_ONE;
+    trajectory->maxAccelQ = maxAccel * TRAJ_Q_ONE;
+    trajectory->isYaw = isYaw;
+
+    resetTrajectory(trajectory);
+}
+
+
+/*
+ * Function:    resetTrajectory
+ * -----------------------------
+ * Makes the next update restart the profile from the measurement,
+ * at rest, so it does not jump after a landing.
+ *
+ * @params:
+ *      - trajectory_t* trajectory: The profile to reset.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+resetTrajectory(trajectory_t* trajectory)
+{
+    trajectory->positionQ = 0;
+    trajectory->rateQ = 0;
+    trajectory->primed = false;
+}
+
+
+/*
+ * Function:    updateTrajectory
+ * ------------------------------
+ * Advances a reference profile by one control period towards the
+ * desired value. The rate heads for the fastest rate the profile
+ * can still stop from before the desired value, changing by at
+ * most one acceleration step per cycle. This accelerates, cruises
+ * at the rate limit and then brakes, and handles the desired value
+ * changing part way through a move.
+ *
+ * @params:
+ *      - trajectory_t* trajectory: The profile to advance.
+ *      - int32_t desired: The desired yaw/altitude.
+ *      - int32_t measurement: The measured yaw/altitude. Only used
+ *      to start the profile after a reset.
+ *      - uint32_t timeStep: The control period (in ms).
+ * @return:
+ *      - int32_t reference: The reference for the controller to
+ *      track this cycle.
+ * ---------------------
+ */
+int32_t
+updateTrajectory(trajectory_t* trajectory, int32_t desired, int32_t measurement, uint32_t timeStep)
+{
+    int32_t reference;
+#if TRAJECTORY_ENABLE
+    int64_t distance;
+    int64_t step;
+    int32_t accelStep;
+    int32_t stopRate;
+    int32_t targetRate;
+#endif /* TRAJECTORY_ENABLE */
+
+    if (!trajectory->primed) {
+        trajectory->positionQ = measurement * TRAJ_Q_ONE;
+        trajectory->rateQ = 0;
+        trajectory->primed = true;
+    }
+
+#if TRAJECTORY_ENABLE
+    distance = wrapPosition((int64_t) desired * TRAJ_Q_ONE - trajectory->positionQ, trajectory->isYaw);
+    accelStep = (int32_t) (((int64_t) trajectory->maxAccelQ * timeStep) / TRAJ_MS_TO_SECONDS);
+
+    // Fastest rate that still stops at the desired value when braking one step per cycle. The half step
+    // terms account for the rate being held over each cycle, so the profile lands without overshoot
+    stopRate = (int32_t) squareRoot((uint64_t) accelStep * accelStep / 4 +
+                                    2 * (uint64_t) trajectory->maxAccelQ * (distance < 0 ? -distance : distance))
+               - accelStep / 2;
+    if (stopRate > trajectory->maxRateQ) {
+        stopRate = trajectory->maxRateQ;
+    }
+    targetRate = (distance < 0) ? -stopRate : stopRate;
+
+    // Change the rate towards the target by at most one acceleration step
+    if (targetRate > trajectory->rateQ + accelStep) {
+        trajectory->rateQ += accelStep;
+    } else if (targetRate < trajectory->rateQ - accelStep) {
+        trajectory->rateQ -= accelStep;
+    } else {
+        trajectory->rateQ = targetRate;
+    }
+
+    step = ((int64_t) trajectory->rateQ * timeStep) / TRAJ_MS_TO_SECONDS;
+
+    // Finish the move once this step would reach the desired value slowly enough to stop there. A profile
+    // going faster than that (the desired value moved onto it) carries on past and brakes back
+    if (((distance >= 0 && step >= distance) || (distance <= 0 && step <= distance)) &&
+        trajectory->rateQ <= accelStep && trajectory->rateQ >= -accelStep) {
+        trajectory->positionQ = desired * TRAJ_Q_ONE;
+        trajectory->rateQ = 0;
+    } else {
+        trajectory->positionQ = (int32_t) wrapPosition(trajectory->positionQ + step, trajectory->isYaw);
+    }
+#else
+    trajectory->positionQ = desired * TRAJ_Q_ONE;
+#endif /* TRAJECTORY_ENABLE */
+
+    // Round to the nearest whole unit, keeping yaw in range
+    reference = (trajectory->positionQ + TRAJ_Q_ONE / 2) >> TRAJ_Q_BITS;
+    if (trajectory->isYaw && reference >= TRAJ_HALF_CIRCLE) {
+        reference -= 2 * TRAJ_HALF_CIRCLE;
+    }
+
+    return reference;
+}
+
+
+/*
+ * Function:    getTrajectoryRate
+ * -------------------------------
+ * Returns the rate of change of the reference from the last
+ * update, for use as velocity feedforward.
+ *
+ * @params:
+ *      - trajectory_t* trajectory: The profile.
+ * @return:
+ *      - int32_t rate: Reference rate (units/s, Q format).
+ * ---------------------
+ */
+int32_t
+getTrajectoryRate(trajectory_t* trajectory)
+{
+    return trajectory->rateQ;
+}
@@ -0,0 +1,118 @@
+/* ****************************************************************
+ * trajectory.h
+ *
+ * Header file of the setpoint trajectory module.
+ * Turns the step changes written to the desired altitude and yaw
+ * queues into trapezoidal reference profiles, limited in rate and
+ * acceleration, for the control loops to track.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef TRAJECTORY_H_
+#define TRAJECTORY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TRAJECTORY_ENABLE
+#define TRAJECTORY_ENABLE       1           // 1 profiles the setpoints, 0 passes the steps straight to the controllers. The host build can set it
+#endif
+
+#define TRAJ_Q_BITS             16          // Fractional bits of the profile position and rate (16 gives Q16.16)
+#define TRAJ_Q_ONE              (1 << TRAJ_Q_BITS)
+
+#define ALT_TRAJ_MAX_RATE       50          // Fastest altitude reference change (%/s)
+#define ALT_TRAJ_MAX_ACCEL      100         // Fastest altitude reference rate change (%/s^2)
+#define YAW_TRAJ_MAX_RATE       60          // Fastest yaw reference change (deg/s). About the fastest the tail can spin against the main rotor torque
+#define YAW_TRAJ_MAX_ACCEL      160         // Fastest yaw reference rate change (deg/s^2)
+
+
+/* ******************************************************
+ * State of a reference profile. The position and rate
+ * are Q format so slow profiles do not stall between
+ * whole units.
+ * *****************************************************/
+typedef struct Trajectories {
+    int32_t     maxRateQ;         // Rate limit (units/s, Q format)
+    int32_t     maxAccelQ;        // Acceleration limit (units/s^2, Q format)
+    bool        isYaw;            // True to wrap the position to -180 to 179 and move the short way round
+
+    int32_t     positionQ;        // Current reference (units, Q format)
+    int32_t     rateQ;            // Current reference rate (units/s, Q format)
+    bool        primed;           // False until the profile has been started from a measurement
+} trajectory_t;
+
+extern trajectory_t g_alt_trajectory;
+extern trajectory_t g_yaw_trajectory;
+
+
+/*
+ * Function:    initTrajectory
+ * ----------------------------
+ * Sets the limits of a reference profile and resets it.
+ *
+ * @params:
+ *      - trajectory_t* trajectory: The profile to initialise.
+ *      - int32_t maxRate: Rate limit (units/s).
+ *      - int32_t maxAccel: Acceleration limit (units/s^2).
+ *      - bool isYaw: True if the profile is for yaw.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initTrajectory(trajectory_t* trajectory, int32_t maxRate, int32_t maxAccel, bool isYaw);
+
+/*
+ * Function:    resetTrajectory
+ * -----------------------------
+ * Makes the next update restart the profile from the measurement,
+ * at rest, so it does not jump after a landing.
+ *
+ * @params:
+ *      - trajectory_t* trajectory: The profile to reset.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void resetTrajectory(trajectory_t* trajectory);
+
+/*
+ * Function:    updateTrajectory
+ * ------------------------------
+ * Advances a reference profile by one control period towards the
+ * desired value. Must be called once per control cycle.
+ *
+ * @params:
+ *      - trajectory_t* trajectory: The profile to advance.
+ *      - int32_t desired: The desired yaw/altitude.
+ *      - int32_t measurement: The measured yaw/altitude. Only used
+ *      to start the profile after a reset.
+ *      - uint32_t timeStep: The control period (in ms).
+ * @return:
+ *      - int32_t reference: The reference for the controller to
+ *      track this cycle.
+ * ---------------------
+ */
+int32_t updateTrajectory(trajectory_t* trajectory, int32_t desired, int32_t measurement, uint32_t timeStep);
+
+/*
+ * Function:    getTrajectoryRate
+ * -------------------------------
+ * Returns the rate of change of the reference from the last
+ * update, for use as velocity feedforward.
+ *
+ * @params:
+ *      - trajectory_t* trajectory: The profile.
+ * @return:
+ *      - int32_t rate: Reference rate (units/s, Q format).
+ * ---------------------
+ */
+int32_t getTrajectoryRate(trajectory_t* trajectory);
+
+#endif /* TRAJECTORY_H_ */
@@ -22,6 +22,10 @@
  * ***************************************************************/
 
 #include "uart.h"
+#include "profiler.h"
+#include "hookFunctions.h"
+#include "flightState.h"
+#include "altitude.h"
 
 
 /*
@@ -100,32 +104,44 @@ void
 UARTDisplay (void *pvParameters)
 {
 
-    int32_t    des_alt;         // Desired altitude
-    int32_t    act_alt;         // Actual altitude
-    int32_t    des_yaw;         // Desired yaw
+    flightState_t flight;       // Desired and actual altitude, desired yaw and FSM state
     int32_t    act_yaw;         // Actual yaw
-    uint32_t   state;           // Current state in the FSM
+    yawDriftStats_t drift;      // Yaw reference drift statistics
+    loadReport_t load;          // CPU use over the last load window
 
     char UARTstring[20];        // String to be sent over UART
-    char* states[4] = {"Landed", "Take Off", "Flying", "Landing"};
+    char* states[NUM_STATES] = {"Landed", "Take Off", "Flying", "Landing", "Autotune"};
+
+    profileTask(PROFILE_UART_TASK);
     while(1)
     {
+        profileStart(PROFILE_UART_TASK);
+
         // Retrieve altitude, yaw and PWM information
-        xQueuePeek(xAltDesQueue,  &des_alt, TICKS_TO_WAIT);
-        xQueuePeek(xAltMeasQueue, &act_alt, TICKS_TO_WAIT);
-        xQueuePeek(xYawDesQueue,  &des_yaw, TICKS_TO_WAIT);
-        xQueuePeek(xYawMeasQueue, &act_yaw, TICKS_TO_WAIT);
-        xQueuePeek(xFSMQueue,     &state,   TICKS_TO_WAIT);
+        getFlightState(&flight);
+        act_yaw = getYaw();
+        getYawDriftStats(&drift);
+        getLoadReport(&load);
 
         // Send information over UART
+        reportGround();
         UARTSend("------------\n");
-        usnprintf(UARTstring, sizeof(UARTstring), "Alt(%%) %3d|%3d\n", des_alt, act_alt);
+        usnprintf(UARTstring, sizeof(UARTstring), "Alt(%%) %3d|%3d\n", flight.altDesired, flight.altMeasured.altitude);
+        UARTSend(UARTstring);
+        usnprintf(UARTstring, sizeof(UARTstring), "Alt age %3d ms\n", flight.altMeasured.sampleAge * portTICK_RATE_MS);
+        UARTSend(UARTstring);
+        usnprintf(UARTstring, sizeof(UARTstring), "Yaw   %4d|%3d\n", flight.yawDesired, act_yaw);
+        UARTSend(UARTstring);
+        usnprintf(UARTstring, sizeof(UARTstring), "QD errors %5d\n", getQuadratureErrors());
+        UARTSend(UARTstring);
+        usnprintf(UARTstring, sizeof(UARTstring), "Drift %3d|%3d\n", drift.lastDrift, drift.maxDrift);
         UARTSend(UARTstring);
-        usnprintf(UARTstring, sizeof(UARTstring), "Yaw   %4d|%3d\n", des_yaw, act_yaw);
+        usnprintf(UARTstring, sizeof(UARTstring), "CPU %3d.%d%%\n", load.load / 10, load.load % 10);
         UARTSend(UARTstring);
-        usnprintf(UARTstring, sizeof(UARTstring), "%s\n", states[state]);
+        usnprintf(UARTstring, sizeof(UARTstring), "%s\n", states[flight.fsmState]);
         UARTSend(UARTstring);
         UARTSend("------------\n");
+        profileEnd(PROFILE_UART_TASK);
 
         vTaskDelay(UART_PERIOD / portTICK_RATE_MS);
     }
@@ -0,0 +1,513 @@
+/* ****************************************************************
+ * uartCommand.c
+ *
+ * Source file of the UART command module.
+ * Receives text commands over the USB UART to read and change the
+ * controller parameters at runtime. Edits are made to a local copy
+ * and only reach a controller when applied, through its shadow
+ * parameter set, so the control tasks never run with a half
+ * updated set.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#include "uartCommand.h"
+#include "autotune.h"
+#include "flightRecorder.h"
+#include "profiler.h"
+#include "hookFunctions.h"
+#include "flightState.h"
+
+enum cmdAxes {CMD_ALT = 0, CMD_YAW, CMD_RATE, NUM_CMD_AXES};
+
+static controllerParams_t g_editParams[NUM_CMD_AXES]; // Parameters being edited, indexed by axis
+static bool g_editLoaded[NUM_CMD_AXES] = {false, false, false}; // True once the edit copy has been loaded from the controller
+
+
+/*
+ * Function:    UARTRxIntHandler
+ * ------------------------------
+ * Handler for the UART receive and receive timeout interrupts.
+ * Moves every received character into the command queue.
+ * Characters are dropped if the queue is full.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+UARTRxIntHandler(void)
+{
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    uint32_t status = UARTIntStatus(UART_USB_BASE, true);
+    char character;
+
+    profileStart(PROFILE_UART_ISR);
+    UARTIntClear(UART_USB_BASE, status);
+
+    while (UARTCharsAvail(UART_USB_BASE)) {
+        character = (char) UARTCharGetNonBlocking(UART_USB_BASE);
+        recordUARTChar(character);
+        xQueueSendFromISR(xUARTRxQueue, &character, &higherPriorityTaskWoken);
+    }
+    profileEnd(PROFILE_UART_ISR);
+
+    portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+
+/*
+ * Function:    getController
+ * ---------------------------
+ * Looks up the controller named in a command.
+ *
+ * @params:
+ *      - const char* name: "alt", "yaw" or "rate".
+ *      - uint8_t* axis: Set to the axis of the named controller.
+ * @return:
+ *      - controller_t* controller: The named controller, or NULL.
+ * ---------------------
+ */
+static controller_t*
+getController(const char* name, uint8_t* axis)
+{
+    if (strcmp(name, "alt") == 0) {
+        *axis = CMD_ALT;
+        return &g_alt_controller;
+    } else if (strcmp(name, "yaw") == 0) {
+        *axis = CMD_YAW;
+        return &g_yaw_controller;
+    } else if (strcmp(name, "rate") == 0) {
+        *axis = CMD_RATE;
+        return &g_yaw_rate_controller;
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Function:    loadEditParams
+ * ----------------------------
+ * Starts an edit from the newest parameters of a controller: the
+ * staged set if the control task has not swapped it in yet, so
+ * the edit does not undo it, otherwise the running set.
+ *
+ * @params:
+ *      - controller_t* controller: The controller being edited.
+ *      - uint8_t axis: Its axis.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+loadEditParams(controller_t* controller, uint8_t axis)
+{
+    taskENTER_CRITICAL();                                          // Don't read the staged set mid-swap
+    if (controller->paramsPending) {
+        g_editParams[axis] = controller->shadowParams;
+    } else {
+        getControllerParams(controller, &g_editParams[axis]);
+    }
+    taskEXIT_CRITICAL();
+    g_editLoaded[axis] = true;
+}
+
+
+/*
+ * Function:    getTuneRule
+ * -------------------------
+ * Looks up the tuning rule named in a command.
+ *
+ * @params:
+ *      - const char* name: "zn", "tl" or "no".
+ * @return:
+ *      - tuneRule_t rule: The named rule, or NUM_TUNE_RULES.
+ * ---------------------
+ */
+static tuneRule_t
+getTuneRule(const char* name)
+{
+    if (strcmp(name, "zn") == 0) {
+        return TUNE_ZIEGLER_NICHOLS;
+    } else if (strcmp(name, "tl") == 0) {
+        return TUNE_TYREUS_LUYBEN;
+    } else if (strcmp(name, "no") == 0) {
+        return TUNE_NO_OVERSHOOT;
+    }
+
+    return NUM_TUNE_RULES;
+}
+
+
+/*
+ * Function:    setParam
+ * ----------------------
+ * Writes one named parameter of an edit copy.
+ *
+ * @params:
+ *      - controllerParams_t* params: The edit copy.
+ *      - const char* name: Parameter name.
+ *      - int32_t value: New value.
+ * @return:
+ *      - bool found: False if the name is not a parameter.
+ * ---------------------
+ */
+static bool
+setParam(controllerParams_t* params, const char* name, int32_t value)
+{
+    if (strcmp(name, "kp") == 0) {
+        params->Kp = value;
+    } else if (strcmp(name, "ki") == 0) {
+        params->Ki = value;
+    } else if (strcmp(name, "kd") == 0) {
+        params->Kd = value;
+    } else if (strcmp(name, "ts") == 0) {
+        params->timeStep = value;
+    } else if (strcmp(name, "min") == 0) {
+        params->outputMin = value;
+    } else if (strcmp(name, "max") == 0) {
+        params->outputMax = value;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+
+/*
+ * Function:    sendExecutiveStats
+ * --------------------------------
+ * Sends the control executive's cycle count, missed timer
+ * releases, start latency and longest run time since the last
+ * time they were sent.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+sendExecutiveStats(void)
+{
+    char reply[MAX_STR_LEN];
+    executiveStats_t stats;
+
+    getExecutiveStats(&stats);
+    usnprintf(reply, sizeof(reply), "exec %u cycles %u over\n", stats.cycles, stats.overruns);
+    UARTSend(reply);
+    usnprintf(reply, sizeof(reply), "late %u-%u avg %u us\n", stats.latencyMin, stats.latencyMax,
+              stats.latencyMean);
+    UARTSend(reply);
+    usnprintf(reply, sizeof(reply), "run max %u us\n", stats.runMax);
+    UARTSend(reply);
+}
+
+
+/*
+ * Function:    sendProfile
+ * -------------------------
+ * Sends the longest execution and response times of every
+ * profiled handler and task or, given a name, the job count and
+ * the non-empty buckets of that one's histograms. A bucket is
+ * named by its lowest time in cycles, as a power of two.
+ *
+ * @params:
+ *      - const char* name: Profile slot name, or NULL for all.
+ * @return:
+ *      - bool found: False if there is no slot by that name.
+ * ---------------------
+ */
+static bool
+sendProfile(const char* name)
+{
+    static const char* histogramNames[PROFILE_HISTOGRAMS] = {"exec", "jit", "resp"};
+    char reply[MAX_STR_LEN];
+    profileSummary_t summary;
+    uint16_t counts[PROFILE_BUCKETS];
+    int8_t slot;
+    uint8_t histogram;
+    uint8_t bucket;
+
+    if (name == NULL) {
+        for (slot = 0; slot < PROFILE_SLOTS; slot++) {
+            getProfileSummary(slot, &summary);
+            usnprintf(reply, sizeof(reply), "%s %u/%u cyc\n", summary.name, summary.executionMax,
+                      summary.responseMax);
+            UARTSend(reply);
+        }
+        return true;
+    }
+
+    if ((slot = getProfileSlot(name)) < 0) {
+        return false;
+    }
+    getProfileSummary(slot, &summary);
+    usnprintf(reply, sizeof(reply), "%s %u jobs\n", summary.name, summary.jobs);
+    UARTSend(reply);
+    for (histogram = 0; histogram < PROFILE_HISTOGRAMS; histogram++) {
+        getProfileHistogram(slot, histogram, counts);
+        for (bucket = 0; bucket < PROFILE_BUCKETS; bucket++) {
+            if (counts[bucket] == 0) {
+                continue;
+            }
+            if (bucket == 0) {
+                usnprintf(reply, sizeof(reply), "%s <2^%u %u\n", histogramNames[histogram],
+                          PROFILE_MIN_BITS, counts[bucket]);
+            } else {
+                usnprintf(reply, sizeof(reply), "%s 2^%u %u\n", histogramNames[histogram],
+                          bucket + PROFILE_MIN_BITS - 1, counts[bucket]);
+            }
+            UARTSend(reply);
+        }
+    }
+    return true;
+}
+
+
+/*
+ * Function:    sendLoadReport
+ * ----------------------------
+ * Sends the CPU load of the last load window, then the share of
+ * each profiled task, the profiled interrupt handlers and the
+ * rest, in tenths of a percent.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+sendLoadReport(void)
+{
+    char reply[MAX_STR_LEN];
+    loadReport_t report;
+    profileSummary_t summary;
+    uint8_t i;
+
+    getLoadReport(&report);
+    usnprintf(reply, sizeof(reply), "load %u.%u%% win %u\n", report.load / 10, report.load % 10, report.windows);
+    UARTSend(reply);
+    for (i = 0; i < PROFILE_TASKS; i++) {
+        getProfileSummary(PROFILE_FIRST_TASK + i, &summary);
+        usnprintf(reply, sizeof(reply), "%s %u.%u%%\n", summary.name, report.tasks[i] / 10, report.tasks[i] % 10);
+        UARTSend(reply);
+    }
+    usnprintf(reply, sizeof(reply), "irq %u.%u%%\n", report.interrupts / 10, report.interrupts % 10);
+    UARTSend(reply);
+    usnprintf(reply, sizeof(reply), "other %u.%u%%\n", report.other / 10, report.other % 10);
+    UARTSend(reply);
+}
+
+
+/*
+ * Function:    sendFSMLog
+ * ------------------------
+ * Sends the FSM's transition log, oldest first, as the tick each
+ * state was entered, the states left and entered and the event.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+sendFSMLog(void)
+{
+    char reply[MAX_STR_LEN];
+    fsmTransition_t transition;
+    int8_t age;
+
+    for (age = FSM_LOG_SIZE - 1; age >= 0; age--) {
+        if (getFSMTransition(age, &transition)) {
+            usnprintf(reply, sizeof(reply), "%u %s>%s %s\n", transition.tick, getFSMStateName(transition.from),
+                      getFSMStateName(transition.to), getFSMEventName(transition.event));
+            UARTSend(reply);
+        }
+    }
+}
+
+
+/*
+ * Function:    runCommand
+ * ------------------------
+ * Splits a command line into words and carries it out.
+ * Replies with the parameters, "OK", "BUSY" if the previous set
+ * has not been swapped in yet, or "ERR".
+ *
+ * @params:
+ *      - char* line: The null terminated command line.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+runCommand(char* line)
+{
+    char* tokens[UART_CMD_MAX_TOKENS];
+    uint8_t count = 0;
+    char reply[MAX_STR_LEN];
+    controller_t* controller;
+    controllerParams_t params;
+    uint8_t axis;
+    char* end;
+    int32_t value;
+
+    // Split on spaces
+    while (*line && count < UART_CMD_MAX_TOKENS) {
+        while (*line == ' ') {
+            *line++ = '\0';
+        }
+        if (*line) {
+            tokens[count++] = line;
+            while (*line && *line != ' ') {
+                line++;
+            }
+        }
+    }
+
+    if (count == 1 && strcmp(tokens[0], "trace") == 0) {
+        dumpFlightRecording();                                     // Ends the recording
+        return;
+    }
+    if (count == 1 && strcmp(tokens[0], "exec") == 0) {
+        sendExecutiveStats();
+        return;
+    }
+    if (count == 1 && strcmp(tokens[0], "load") == 0) {
+        sendLoadReport();
+        return;
+    }
+    if (count == 1 && strcmp(tokens[0], "fsm") == 0) {
+        sendFSMLog();
+        return;
+    }
+    if ((count == 1 || count == 2) && strcmp(tokens[0], "prof") == 0) {
+        if (!sendProfile((count == 2) ? tokens[1] : NULL)) {
+            UARTSend("ERR\n");
+        }
+        return;
+    }
+
+    if (count < 2 || (controller = getController(tokens[1], &axis)) == NULL) {
+        UARTSend("ERR\n");
+        return;
+    }
+
+    if (strcmp(tokens[0], "get") == 0 && count == 2) {
+        getControllerParams(controller, &params);
+        usnprintf(reply, sizeof(reply), "%s Kp %d Ki %d Kd %d\n", tokens[1], params.Kp, params.Ki, params.Kd);
+        UARTSend(reply);
+        usnprintf(reply, sizeof(reply), "%s ts %d min %d max %d\n", tokens[1], params.timeStep,
+                  params.outputMin, params.outputMax);
+        UARTSend(reply);
+    } else if (strcmp(tokens[0], "set") == 0 && count == 4) {
+        if (!g_editLoaded[axis]) {
+            loadEditParams(controller, axis);
+        }
+        value = strtol(tokens[3], &end, 10);
+        if (*end != '\0' || !setParam(&g_editParams[axis], tokens[2], value)) {
+            UARTSend("ERR\n");
+        } else {
+            UARTSend("OK\n");
+        }
+    } else if (strcmp(tokens[0], "apply") == 0 && count == 2) {
+        if (!g_editLoaded[axis]) {
+            UARTSend("OK\n");                                       // Nothing edited
+        } else if (controller->paramsPending) {
+            UARTSend("BUSY\n");
+        } else if (stageControllerParams(controller, &g_editParams[axis])) {
+            g_editLoaded[axis] = false;                            // Reload from the controller on the next edit
+            UARTSend("OK\n");
+        } else {
+            UARTSend("ERR\n");
+        }
+    } else if (strcmp(tokens[0], "tune") == 0 && count == 3 && axis != CMD_RATE) {
+        if (getFSMState() == FLYING && requestAutotune(axis == CMD_YAW, getTuneRule(tokens[2]))) {
+            if (!postFSMEvent(FSM_EVENT_TUNE_START)) {
+                cancelAutotune();                                  // The FSM could not take the event
+                UARTSend("ERR\n");
+                return;
+            }
+            UARTSend("OK\n");
+        } else {
+            UARTSend("ERR\n");                                     // Only while flying, with a known rule
+        }
+    } else {
+        UARTSend("ERR\n");
+    }
+}
+
+
+/*
+ * Function:    initUARTCommand
+ * -----------------------------
+ * Enables the UART receive interrupts which feed the command task.
+ * Must be called after the FreeRTOS queues are created.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initUARTCommand(void)
+{
+    UARTIntRegister(UART_USB_BASE, UARTRxIntHandler);
+    IntPrioritySet(UART_RX_INT, UART_RX_INT_PRIORITY);             // Allow the handler to use FreeRTOS ISR functions
+    UARTIntEnable(UART_USB_BASE, UART_INT_RX | UART_INT_RT);
+}
+
+
+/*
+ * Function:    UARTCommand
+ * -------------------------
+ * FreeRTOS task which assembles received characters into lines
+ * and runs each line as a command. Over-long lines are discarded.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+UARTCommand(void *pvParameters)
+{
+    char line[UART_CMD_LINE_SIZE];
+    uint8_t length = 0;
+    bool overflow = false;
+    char character;
+
+    while (1)
+    {
+        xQueueReceive(xUARTRxQueue, &character, portMAX_DELAY);    // Block until a character arrives
+
+        if (character == '\r' || character == '\n') {
+            if (length > 0 && !overflow) {
+                line[length] = '\0';
+                runCommand(line);
+            } else if (overflow) {
+                UARTSend("ERR\n");
+            }
+            length = 0;
+            overflow = false;
+        } else if (length < UART_CMD_LINE_SIZE - 1) {
+            line[length++] = character;
+        } else {
+            overflow = true;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+/* ****************************************************************
+ * uartCommand.h
+ *
+ * Header file of the UART command module.
+ * Receives text commands over the USB UART to read and change the
+ * controller parameters at runtime.
+ *
+ * Commands (one per line):
+ *      get <alt|yaw|rate>                           Print the running parameters
+ *      set <alt|yaw|rate> <kp|ki|kd|ts|min|max> <n> Edit a parameter
+ *      apply <alt|yaw|rate>                         Stage the edited set for the next control cycle
+ *      tune <alt|yaw> <zn|tl|no>                    Autotune one axis while flying (Ziegler-Nichols,
+ *                                                   Tyreus-Luyben or no overshoot rule)
+ *      trace                                        Stop the flight recorder and dump its recording
+ *      exec                                         Print the control executive timing since the last exec
+ *      prof [name]                                  Print the longest execution and response times of the
+ *                                                   profiled handlers and tasks, or one's histograms
+ *      load                                         Print the CPU load and each task's share of the last
+ *                                                   load window
+ *      fsm                                          Print the FSM's latest transitions: tick, states and event
+ *
+ * "rate" is the inner yaw rate loop, only used when yaw control is
+ * cascaded. The yaw angle loop's min and max are then rates in deg/s.
+ * A ts must be a multiple of the control executive's period, and
+ * kp, ki and kd must be 0 to PID_MAX_GAIN, or apply replies ERR.
+ *
+ * ENCE464 Assignment 1 Group 2
+ * Creators: Grayson Mynott      56353855
+ *           Ryan Earwaker       12832870
+ *           Matt Blake          58979250
+ * Last modified: 19/08/2020
+ *
+ * ***************************************************************/
+
+#ifndef UARTCOMMAND_H_
+#define UARTCOMMAND_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "driverlib/uart.h"
+#include "driverlib/interrupt.h"
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "uart.h"
+#include "pidController.h"
+
+#define UART_RX_QUEUE_SIZE      32          // Received characters buffered between the ISR and the command task
+#define UART_RX_INT             INT_UART0
+#define UART_RX_INT_PRIORITY    (2 << 5)    // Must be numerically >= configMAX_SYSCALL_INTERRUPT_PRIORITY
+#define UART_CMD_LINE_SIZE      32          // Longest command line accepted, including the terminator
+#define UART_CMD_MAX_TOKENS     4           // Most words in a command
+
+
+/*
+ * Function:    initUARTCommand
+ * -----------------------------
+ * Enables the UART receive interrupts which feed the command task.
+ * Must be called after the FreeRTOS queues are created.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void initUARTCommand(void);
+
+/*
+ * Function:    UARTCommand
+ * -------------------------
+ * FreeRTOS task which assembles received characters into lines
+ * and runs each line as a command.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void UARTCommand(void *pvParameters);
+
+#endif /* UARTCOMMAND_H_ */
@@ -20,42 +20,126 @@
  * ***************************************************************/
 
 #include "yaw.h"
+#include "flightRecorder.h"
+#include "profiler.h"
+#include "FSM.h"
+
+// Reference latch, written only by the yaw interrupts
+static volatile uint32_t g_referenceCount = 0;      // Number of reference crossings seen
+static volatile int32_t g_firstReferenceSlot = 0;   // Raw slot count at the first crossing. Defines zero yaw
+static volatile int32_t g_lastReferenceSlot = 0;    // Raw slot count at the latest crossing
+static int32_t g_referenceDirection = 0;            // Direction of the first crossing. Only crossings this way are latched
+static bool g_referencePosted = false;              // Set once the FSM has been sent the reference found event
+
+// Drift correction, owned by updateYawReference
+static int32_t g_driftTarget = 0;                   // Total correction measured from the reference crossings
+static volatile int32_t g_driftCorrection = 0;      // Correction applied so far, slewed towards g_driftTarget
+static yawDriftStats_t g_driftStats;
 
 
 /*
- * Function:    referenceInterrupt
- * --------------------------------
- * Handler for the interrupt which occurs when the helicopter
- * reaches the reference yaw position.
- * Resets the current yaw position and the number of quadrature
- * slots from reference to be 0.
+ * Function:    wrapSlots
+ * -----------------------
+ * Wraps a slot count to a single revolution, from 0 to
+ * MAX_YAW_SLOTS - 1. Works for negative counts.
  *
  * @params:
- *      - NULL
+ *      - int32_t slots: Slot count to wrap.
  * @return:
- *      - NULL
+ *      - int32_t wrapped: Slot count within one revolution.
  * ---------------------
  */
-void
-referenceInterrupt(void)
+static int32_t
+wrapSlots(int32_t slots)
 {
-    int32_t reset = 0;
+    int32_t wrapped = slots % MAX_YAW_SLOTS;
 
-    UARTSend("REF_INT\n\r");
+    if (wrapped < 0) {
+        wrapped += MAX_YAW_SLOTS;
+    }
 
-    xQueueOverwriteFromISR(xYawMeasQueue, &reset, pdFALSE);         // Reset the current yaw to 0 (reference position)
-    xQueueOverwriteFromISR(xYawSlotQueue, &reset, pdFALSE);         // Reset the curreny yaw_slow position to 0
-    xEventGroupSetBitsFromISR(xFoundYawReference, YAW_REFERENCE_FLAG, pdFALSE); // Set reference flag
-    GPIOIntClear(YAW_REFERENCE_BASE, YAW_REFERENCE_PIN);            // Clear the interrupt
+    return wrapped;
 }
 
 
 /*
- * Function:    checkYawThresholds
- * --------------------------------
- * This function checks whether the yaw has reached the
- * positive or negative thresholds and resets it to the
- * opposite threshold if necessary.
+ * Function:    nearestTurn
+ * -------------------------
+ * Rounds a slot count to the nearest whole revolution. Used to
+ * re-sync to the reference without losing the turn count.
+ *
+ * @params:
+ *      - int32_t slots: Unwrapped slot count.
+ * @return:
+ *      - int32_t slots: Slot count of the nearest whole revolution.
+ * ---------------------
+ */
+static int32_t
+nearestTurn(int32_t slots)
+{
+    int32_t offset = wrapSlots(slots);
+
+    if (offset >= MAX_YAW_SLOTS / 2) {
+        offset -= MAX_YAW_SLOTS;
+    }
+
+    return slots - offset;
+}
+
+
+/*
+ * Function:    latchReference
+ * ----------------------------
+ * Records the raw slot count at a reference crossing. Only called
+ * from the yaw interrupts, which do nothing else with the
+ * reference. The first latch tells the FSM the reference has
+ * been found, and later ones try again if its queue was full. The
+ * mark is wider than a slot and is seen where
+ * the encoder enters it, so crossings the other way are ignored
+ * rather than read as drift.
+ *
+ * @params:
+ *      - int32_t rawSlot: Raw slot count at the crossing.
+ *      - int32_t direction: 1 if the last edge counted up, -1 if down.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+static void
+latchReference(int32_t rawSlot, int32_t direction)
+{
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    bool first = (g_referenceCount == 0);
+
+    if (first) {
+        g_firstReferenceSlot = rawSlot;
+        g_referenceDirection = direction;
+    } else if (direction != g_referenceDirection) {
+        return;
+    }
+    g_lastReferenceSlot = rawSlot;
+    g_referenceCount++;                                             // Written last so readers can detect a latch mid-read
+    if (!g_referencePosted) {
+        g_referencePosted = postFSMEventFromISR(FSM_EVENT_REFERENCE_FOUND, &higherPriorityTaskWoken);
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    }
+}
+
+
+#if YAW_SENSOR_QEI
+static volatile uint32_t g_quadratureErrors = 0;    // Number of phase errors detected by the QEI
+static volatile int32_t g_yawRate = 0;              // Last yaw rate estimate (Q16 degrees per second)
+static volatile int32_t g_yawSlot = 0;              // Raw unwrapped slots from start-up at g_lastPosition
+static volatile uint32_t g_lastPosition = 0;        // QEI position when g_yawSlot was last updated
+
+
+/*
+ * Function:    foldPosition
+ * --------------------------
+ * Adds the QEI position change since the last call to the
+ * unwrapped slot count. The QEI position wraps every revolution,
+ * so this must run at least twice per revolution. Call with the
+ * QEI interrupt masked.
  *
  * @params:
  *      - NULL
@@ -64,35 +148,279 @@ referenceInterrupt(void)
  * ---------------------
  */
 static void
-checkYawThresholds(void)
+foldPosition(void)
 {
-    int32_t yaw;
-    int32_t yaw_slot;
+    uint32_t position = QEIPositionGet(YAW_QEI_BASE);
+    int32_t change = wrapSlots((int32_t) position - (int32_t) g_lastPosition);
 
-    xQueuePeek(xYawSlotQueue, &yaw_slot, TICKS_TO_WAIT);
+    if (change >= MAX_YAW_SLOTS / 2) {
+        change -= MAX_YAW_SLOTS;                                    // Take the short way round
+    }
+    g_yawSlot += change;
+    g_lastPosition = position;
+}
 
-    yaw = yaw_slot * DEGREES_CIRCLE / MAX_YAW_SLOTS;
 
-    if (yaw >= MAX_YAW_LIMIT)
-    {
-        yaw = (yaw - DEGREES_CIRCLE);
+/*
+ * Function:    qeiInterrupt
+ * --------------------------
+ * Handler for the QEI peripheral interrupt. Each velocity period
+ * folds the wrapping QEI position into the unwrapped slot count.
+ * The index (reference) pulse latches the count. Also counts
+ * phase errors.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+qeiInterrupt(void)
+{
+    uint32_t status;
+
+    profileStart(PROFILE_QUADRATURE_ISR);
+    status = QEIIntStatus(YAW_QEI_BASE, true);
+    QEIIntClear(YAW_QEI_BASE, status);
+
+    if (status & (QEI_INTTIMER | QEI_INTINDEX)) {
+        foldPosition();
     }
-    else if (yaw <= MIN_YAW_LIMIT)
-    {
-        yaw = DEGREES_CIRCLE + yaw;
+    if (status & QEI_INTINDEX) {
+        latchReference(g_yawSlot, QEIDirectionGet(YAW_QEI_BASE));
+    }
+    if (status & QEI_INTERROR) {
+        g_quadratureErrors++;
     }
+    profileEnd(PROFILE_QUADRATURE_ISR);
+}
+
+
+/*
+ * Function:    getRawSlots
+ * -------------------------
+ * Returns the unwrapped number of quadrature slots travelled since
+ * start-up, including the QEI position change since the last fold.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t yaw_slot: Raw slot count.
+ * ---------------------
+ */
+static int32_t
+getRawSlots(void)
+{
+    int32_t yaw_slot;
+
+    taskENTER_CRITICAL();                                           // Masks the QEI interrupt
+    foldPosition();
+    yaw_slot = g_yawSlot;
+    taskEXIT_CRITICAL();
+
+    return yaw_slot;
+}
+
+
+/*
+ * Function:    updateYawRate
+ * ---------------------------
+ * Updates the yaw rate from the edges counted by the QEI over
+ * its last velocity period and the direction of rotation.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t rate: Yaw rate in degrees per second (Q16).
+ * ---------------------
+ */
+int32_t
+updateYawRate(void)
+{
+    int64_t rate = (int64_t) QEIVelocityGet(YAW_QEI_BASE) * YAW_QEI_VEL_RATE_HZ * DEGREES_CIRCLE;
+
+    rate = (rate << YAW_RATE_Q_BITS) / MAX_YAW_SLOTS;
+    g_yawRate = (int32_t) rate * QEIDirectionGet(YAW_QEI_BASE);
+
+    return g_yawRate;
+}
+
+
+/*
+ * Function:    getYawRate
+ * ------------------------
+ * Returns the yaw rate from the last call to updateYawRate.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t rate: Yaw rate in degrees per second (Q16).
+ * ---------------------
+ */
+int32_t
+getYawRate(void)
+{
+    return g_yawRate;
+}
+
+
+/*
+ * Function:    getQuadratureErrors
+ * ---------------------------------
+ * Returns the number of quadrature edges where a state was
+ * skipped
+ * (a QEI phase error).
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint32_t errors: Number of skipped states.
+ * ---------------------
+ */
+uint32_t
+getQuadratureErrors(void)
+{
+    return g_quadratureErrors;
+}
+
+
+
+/*
+ * Function:    initReferenceYaw
+ * ------------------------------
+ * Initialises the interrupt for the yaw reference. The reference
+ * signal is the QEI index input. The velocity timer interrupt is
+ * also used to keep the unwrapped slot count up to date.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initReferenceYaw(void)
+{
+    QEIIntRegister(YAW_QEI_BASE, qeiInterrupt);
+    IntPrioritySet(YAW_QEI_INT, YAW_QEI_INT_PRIORITY);             // Lets getRawSlots mask the handler with a critical section
+    QEIIntEnable(YAW_QEI_BASE, QEI_INTINDEX | QEI_INTTIMER | QEI_INTERROR);
+}
+
+
+/*
+ * Function:    initQuadrature
+ * ----------------------------
+ * Initialises the QEI peripheral to count every edge of both
+ * channels and capture velocity. The index pulse is handled in
+ * software so the turn count is kept.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+initQuadrature(void)
+{
+    SysCtlPeripheralEnable(YAW_QEI_PERIPH);
+    while(!SysCtlPeripheralReady(YAW_QEI_PERIPH));
+    SysCtlPeripheralEnable(YAW_QEI_GPIO_PERIPH);
+    while(!SysCtlPeripheralReady(YAW_QEI_GPIO_PERIPH));
+
+    // PD7 is locked (NMI) by default and must be unlocked to be used as phase B
+    GPIO_PORTD_LOCK_R = GPIO_LOCK_KEY;
+    GPIO_PORTD_CR_R |= GPIO_PIN_7;
+    GPIO_PORTD_LOCK_R = GPIO_LOCK_M;
+
+    GPIOPinConfigure(GPIO_PD6_PHA0);
+    GPIOPinConfigure(GPIO_PD7_PHB0);
+    GPIOPinConfigure(GPIO_PD3_IDX0);
+    GPIOPinTypeQEI(YAW_QEI_GPIO_BASE, YAW_QEI_PINS);
+
+    QEIConfigure(YAW_QEI_BASE, QEI_CONFIG_CAPTURE_A_B | QEI_CONFIG_NO_RESET |
+                 QEI_CONFIG_QUADRATURE | YAW_QEI_SWAP, MAX_YAW_SLOTS - 1);  // Count all four edges per line, one revolution per wrap
+    QEIVelocityConfigure(YAW_QEI_BASE, QEI_VELDIV_1, SysCtlClockGet() / YAW_QEI_VEL_RATE_HZ);
+    QEIVelocityEnable(YAW_QEI_BASE);
+    QEIEnable(YAW_QEI_BASE);
+}
+#else
+// Slot change for each 4-bit state code (previous reading << 2 | new reading)
+static const int8_t g_quadratureTable[QUADRATURE_STATES] = {
+     0, -1, +1,  0,         // 0b00xx
+    +1,  0,  0, -1,         // 0b01xx
+    -1,  0,  0, +1,         // 0b10xx
+     0, +1, -1,  0          // 0b11xx
+};
 
-    xQueueOverwrite(xYawMeasQueue, &yaw);// Store the resulting yaw measurement in the RTOS queues
+static volatile int32_t g_yawSlot = 0;              // Raw unwrapped slots travelled since start-up. Owned by quadratureFSMInterrupt
+static volatile uint32_t g_quadratureErrors = 0;    // Number of edges where a state was skipped
+static volatile int32_t g_yawDirection = 0;         // Direction of the last counted edge, 1 up or -1 down
+
+// Edge record for the rate estimator, written only by quadratureFSMInterrupt
+static volatile uint32_t g_edgeSequence = 0;        // Incremented before and after each update, odd while updating
+static volatile int32_t g_yawTravel = 0;            // Net slots travelled since start-up. Never reset or wrapped
+static volatile uint32_t g_edgeTime = 0;            // Edge timer count at the last edge
+static uint32_t g_edgeTimerHz = 0;                  // Edge timer clock rate
+static int32_t g_yawRate = 0;                       // Last yaw rate estimate (Q16 degrees per second)
+
+
+/*
+ * Function:    readEdgeTimer
+ * ---------------------------
+ * Reads the edge timer for the interrupt and the rate estimator,
+ * passing the count to the flight recorder so a replay can serve
+ * the same reads.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint32_t count: Edge timer count.
+ * ---------------------
+ */
+static uint32_t
+readEdgeTimer(void)
+{
+    uint32_t count = TimerValueGet(YAW_EDGE_TMR_BASE, TIMER_A);
+
+    recordEdgeTimer(count);
+    return count;
+}
+
+
+/*
+ * Function:    referenceInterrupt
+ * --------------------------------
+ * Handler for the interrupt which occurs when the helicopter
+ * reaches the reference yaw position. Only latches the slot
+ * count. The correction is applied by updateYawReference.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+referenceInterrupt(void)
+{
+    profileStart(PROFILE_REFERENCE_ISR);
+    GPIOIntClear(YAW_REFERENCE_BASE, YAW_REFERENCE_PIN);            // Clear the interrupt
+    recordReference();
+    latchReference(g_yawSlot, g_yawDirection);
+    profileEnd(PROFILE_REFERENCE_ISR);
 }
 
 
 /*
  * Function:    quadratureFSMInterrupt
  * ------------------------------------
- * Pin change interrupt handler for the quadrature decoder
- * Contains a Finite State Machine which increments the
- * yaw (rotation) according to the values obtained by the
- * quadrature decoder.
+ * Pin change interrupt handler for the quadrature decoder.
+ * Looks up the slot change for the transition between the
+ * previous and new channel readings and updates the slot count.
+ * The count is never wrapped here. Conversion to degrees is left
+ * to the consumer.
  *
  * @params:
  *      - NULL
@@ -103,57 +431,182 @@ checkYawThresholds(void)
 void
 quadratureFSMInterrupt(void)
 {
-    int32_t yaw_slot;
-    int32_t newChannelReading = GPIOPinRead(GPIO_PORTB_BASE, QEI_PIN0|QEI_PIN1);
-    static int32_t currentChannelReading = 0;
-
-    // Bit shift the old reading and combine with new reading. Creates a 4-bit code unique to each state.
-    uint8_t state_code = currentChannelReading << VALUES_PER_READING | newChannelReading;
-
-    xQueuePeekFromISR(xYawSlotQueue, &yaw_slot); // Get the current number of slots traveled
-
-    switch (state_code){
-        case (0b0010):
-                yaw_slot++;
-                break;
-        case (0b0001):
-                yaw_slot--;
-                break;
-        case (0b0100):
-                yaw_slot++;
-                break;
-        case (0b0111):
-                yaw_slot--;
-                break;
-        case (0b1101):
-                yaw_slot++;
-                break;
-        case (0b1110):
-                yaw_slot--;
-                break;
-        case (0b1011):
-                yaw_slot++;
-                break;
-        case (0b1000):
-                yaw_slot--;
-                break;
-        default:                            // Goes into default when a state is skipped. Occurs when you turn too fast.
-                UARTSend("QD Err\n");
+    static uint8_t currentChannelReading = 0;
+    uint32_t edge_time = readEdgeTimer();                           // Timestamp the edge before anything else
+    uint8_t newChannelReading = GPIOPinRead(YAW_GPIO_BASE, QEI_PIN0|QEI_PIN1);
+    int32_t yaw_slot = g_yawSlot;
+    int8_t slot_change;
+
+    profileStart(PROFILE_QUADRATURE_ISR);
+    GPIOIntClear(YAW_GPIO_BASE, QEI_PIN0|QEI_PIN1);                // Clears the interrupt on either of the pins
+    recordQuadrature(newChannelReading);
+
+    // Bit shift the old reading and combine with new reading. Creates a 4-bit code unique to each transition.
+    slot_change = g_quadratureTable[(currentChannelReading << VALUES_PER_READING) | newChannelReading];
+    yaw_slot += slot_change;
+
+    if (slot_change != 0) {
+        g_edgeSequence++;
+        g_yawTravel += slot_change;
+        g_edgeTime = edge_time;
+        g_edgeSequence++;
+        g_yawDirection = slot_change;
     }
 
+    // Both channels changing at once means a state was skipped. Occurs when you turn too fast.
+    if ((currentChannelReading ^ newChannelReading) == QUADRATURE_SKIPPED) {
+        g_quadratureErrors++;
+    }
     currentChannelReading = newChannelReading;
+    g_yawSlot = yaw_slot;
+    profileEnd(PROFILE_QUADRATURE_ISR);
+}
 
-    // Reset the yaw if it has reached upper or lower limit
-    if (yaw_slot >= MAX_YAW_SLOTS || yaw_slot <= MIN_YAW_SLOTS)
-    {
-        yaw_slot = 0;
+
+/*
+ * Function:    getRawSlots
+ * -------------------------
+ * Returns the unwrapped number of quadrature slots travelled since
+ * start-up.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t yaw_slot: Raw slot count.
+ * ---------------------
+ */
+static int32_t
+getRawSlots(void)
+{
+    return g_yawSlot;
+}
+
+
+/*
+ * Function:    slotsToRate
+ * -------------------------
+ * Converts a number of slots travelled over a number of edge
+ * timer counts to a rate.
+ *
+ * @params:
+ *      - int32_t slots: Slots travelled.
+ *      - uint32_t counts: Edge timer counts taken (non-zero).
+ * @return:
+ *      - int32_t rate: Degrees per second (Q16).
+ * ---------------------
+ */
+static int32_t
+slotsToRate(int32_t slots, uint32_t counts)
+{
+    int64_t numerator = ((int64_t) slots * g_edgeTimerHz * DEGREES_CIRCLE) << YAW_RATE_Q_BITS;
+
+    return (int32_t) (numerator / ((int64_t) MAX_YAW_SLOTS * counts));
+}
+
+
+/*
+ * Function:    updateYawRate
+ * ---------------------------
+ * Updates the yaw rate estimate. When edges have arrived since
+ * the last estimate the rate is the net slots travelled over the
+ * time between the last edge of the previous estimate and the
+ * newest edge. This is a period measurement when edges are
+ * slower than the control period and an edge count when they
+ * are faster. Without new edges the magnitude is limited to one
+ * slot over the time since the last edge, so the rate decays
+ * towards zero as the helicopter slows, and reads zero after
+ * YAW_RATE_TIMEOUT_MS. Must only be called by one task.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t rate: Yaw rate in degrees per second (Q16).
+ * ---------------------
+ */
+int32_t
+updateYawRate(void)
+{
+    static uint32_t lastSequence = 0;
+    static int32_t lastTravel = 0;
+    static uint32_t lastEdgeTime = 0;
+    static bool stale = true;                                       // The last edge is too old to measure a period from
+    uint32_t sequence;
+    int32_t travel;
+    uint32_t edge_time;
+    uint32_t elapsed;
+    int32_t limit;
+
+    // Take a consistent copy of the edge record, retrying if an edge interrupted the read
+    do {
+        sequence = g_edgeSequence;
+        travel = g_yawTravel;
+        edge_time = g_edgeTime;
+    } while ((sequence & 1) || sequence != g_edgeSequence);
+
+    if (sequence != lastSequence) {
+        elapsed = edge_time - lastEdgeTime;                         // Unsigned difference handles timer wrap
+        if (stale || elapsed == 0) {
+            g_yawRate = 0;                                          // First edge after a stop only starts the period
+        } else {
+            g_yawRate = slotsToRate(travel - lastTravel, elapsed);
+        }
+        lastSequence = sequence;
+        lastTravel = travel;
+        lastEdgeTime = edge_time;
+        stale = false;
+    } else if (!stale) {
+        elapsed = readEdgeTimer() - lastEdgeTime;
+        if (elapsed > (g_edgeTimerHz / 1000) * YAW_RATE_TIMEOUT_MS) {
+            g_yawRate = 0;
+            stale = true;
+        } else if (elapsed != 0) {
+            limit = slotsToRate(1, elapsed);                        // Fastest rate consistent with no edge since
+            if (g_yawRate > limit) {
+                g_yawRate = limit;
+            } else if (g_yawRate < -limit) {
+                g_yawRate = -limit;
+            }
+        }
     }
 
-    // Calculate yaw in degrees and store the results
-    xQueueOverwriteFromISR(xYawSlotQueue, &yaw_slot, pdFALSE);  // Store the current number of slots traveled in the RTOS queue
-    checkYawThresholds();                                       //Check if yaw has reached its threshold values
-    GPIOIntClear(YAW_GPIO_BASE, QEI_PIN0);
-    GPIOIntClear(YAW_GPIO_BASE, QEI_PIN1);     // Clears the interrupt on either of the pins
+    return g_yawRate;
+}
+
+
+/*
+ * Function:    getYawRate
+ * ------------------------
+ * Returns the yaw rate from the last call to updateYawRate.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t rate: Yaw rate in degrees per second (Q16).
+ * ---------------------
+ */
+int32_t
+getYawRate(void)
+{
+    return g_yawRate;
+}
+
+
+/*
+ * Function:    getQuadratureErrors
+ * ---------------------------------
+ * Returns the number of quadrature edges where a state was
+ * skipped.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint32_t errors: Number of skipped states.
+ * ---------------------
+ */
+uint32_t
+getQuadratureErrors(void)
+{
+    return g_quadratureErrors;
 }
 
 
@@ -183,7 +636,8 @@ initReferenceYaw(void)
 /*
  * Function:    initQuadrature
  * ----------------------------
- * Initialises the pins and interrupts for quadrature decoding.
+ * Initialises the pins and interrupts for quadrature decoding,
+ * and the free-running timer used to timestamp edges.
  *
  * @params:
  *      - NULL
@@ -194,6 +648,13 @@ initReferenceYaw(void)
 void
 initQuadrature(void)
 {
+    SysCtlPeripheralEnable(YAW_EDGE_TMR_PERIPH);
+    while(!SysCtlPeripheralReady(YAW_EDGE_TMR_PERIPH));
+    TimerConfigure(YAW_EDGE_TMR_BASE, TIMER_CFG_PERIODIC_UP);      // Full-width 32-bit timer counting up at the system clock
+    TimerLoadSet(YAW_EDGE_TMR_BASE, TIMER_A, UINT32_MAX);           // Wraps at the full range so unsigned differences hold
+    TimerEnable(YAW_EDGE_TMR_BASE, TIMER_A);
+    g_edgeTimerHz = SysCtlClockGet();
+
     SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
     GPIOPinTypeQEI(YAW_GPIO_BASE, QEI_PIN0|QEI_PIN1);    // Sets pin types to be Quad Decoding pins (Just makes Phase B HIGH = 2 instead of 1)
     GPIOIntRegister(YAW_GPIO_BASE, quadratureFSMInterrupt);                  // Sets QDIntHandler to be function to handle interrupt
@@ -202,3 +663,196 @@ initQuadrature(void)
     GPIOIntEnable(YAW_GPIO_BASE, QEI_PIN0|QEI_PIN1);       // Enables interruptss
 
 }
+#endif /* YAW_SENSOR_QEI */
+
+
+/*
+ * Function:    updateYawReference
+ * --------------------------------
+ * Applies the reference crossings latched by the interrupts. The
+ * first crossing defines zero yaw. At each later crossing in the
+ * same direction the slot count should be a whole number of
+ * revolutions, and any difference is drift. The drift is added to
+ * the correction target, and the applied correction is slewed
+ * towards the target by YAW_DRIFT_SLEW slots per call so the
+ * measured yaw does not step. Must be called once per control period by a
+ * single task (ControlExecutive).
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+updateYawReference(void)
+{
+    static uint32_t lastCount = 0;
+    uint32_t count;
+    int32_t reference_slot;
+    int32_t position;
+    int32_t drift;
+
+    // Take a consistent copy of the latest latch
+    do {
+        count = g_referenceCount;
+        reference_slot = g_lastReferenceSlot;
+    } while (count != g_referenceCount);
+
+    if (count != lastCount) {
+        if (count > 1) {
+            position = reference_slot - g_firstReferenceSlot - g_driftTarget;
+            drift = position - nearestTurn(position);               // Slots away from a whole revolution
+            g_driftTarget += drift;
+
+            g_driftStats.lastDrift = drift;
+            if (drift > g_driftStats.maxDrift || -drift > g_driftStats.maxDrift) {
+                g_driftStats.maxDrift = (drift > 0) ? drift : -drift;
+            }
+        }
+        g_driftStats.crossings = count;
+        lastCount = count;
+    }
+
+    // Slew the applied correction towards the target
+    if (g_driftCorrection < g_driftTarget - YAW_DRIFT_SLEW) {
+        g_driftCorrection += YAW_DRIFT_SLEW;
+    } else if (g_driftCorrection > g_driftTarget + YAW_DRIFT_SLEW) {
+        g_driftCorrection -= YAW_DRIFT_SLEW;
+    } else {
+        g_driftCorrection = g_driftTarget;
+    }
+    g_driftStats.correction = g_driftCorrection;
+    g_driftStats.pending = g_driftTarget - g_driftCorrection;
+}
+
+
+/*
+ * Function:    isYawReferenced
+ * -----------------------------
+ * Returns whether the reference has been found, which sets zero
+ * yaw.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - bool referenced: True once a reference crossing is latched.
+ * ---------------------
+ */
+bool
+isYawReferenced(void)
+{
+    return g_referenceCount != 0;
+}
+
+
+/*
+ * Function:    getYawDriftStats
+ * ------------------------------
+ * Copies the drift statistics from the last call to
+ * updateYawReference.
+ *
+ * @params:
+ *      - yawDriftStats_t *stats: Destination for the statistics.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void
+getYawDriftStats(yawDriftStats_t *stats)
+{
+    *stats = g_driftStats;
+}
+
+
+/*
+ * Function:    getYawSlots
+ * -------------------------
+ * Returns the unwrapped number of quadrature slots travelled from
+ * the reference position, less the drift correction applied so
+ * far. Before the reference is found this is the slot count since
+ * start-up.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t yaw_slot: Slots from the reference.
+ * ---------------------
+ */
+int32_t
+getYawSlots(void)
+{
+    int32_t yaw_slot = getRawSlots();
+
+    if (g_referenceCount != 0) {
+        yaw_slot -= g_firstReferenceSlot + g_driftCorrection;
+    }
+
+    return yaw_slot;
+}
+
+
+/*
+ * Function:    getYawTurns
+ * -------------------------
+ * Returns the number of whole revolutions from the reference,
+ * rounded towards negative infinity.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t turns: Whole revolutions from the reference.
+ * ---------------------
+ */
+int32_t
+getYawTurns(void)
+{
+    int32_t yaw_slot = getYawSlots();
+
+    return (yaw_slot - wrapSlots(yaw_slot)) / MAX_YAW_SLOTS;
+}
+
+
+/*
+ * Function:    getYaw
+ * --------------------
+ * Converts the current slot count to degrees, wrapped to
+ * the range MIN_YAW_LIMIT to MAX_YAW_LIMIT.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t yaw: Current yaw in degrees.
+ * ---------------------
+ */
+int32_t
+getYaw(void)
+{
+    int32_t yaw = wrapSlots(getYawSlots()) * DEGREES_CIRCLE / MAX_YAW_SLOTS;
+
+    if (yaw > MAX_YAW_LIMIT)
+    {
+        yaw -= DEGREES_CIRCLE;
+    }
+
+    return yaw;
+}
+
+
+/*
+ * Function:    getYawUnwrapped
+ * -----------------------------
+ * Converts the current slot count to degrees without wrapping,
+ * so the angle keeps growing over multiple revolutions.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t yaw: Yaw from the reference in degrees.
+ * ---------------------
+ */
+int32_t
+getYawUnwrapped(void)
+{
+    return (int32_t) ((int64_t) getYawSlots() * DEGREES_CIRCLE / MAX_YAW_SLOTS);
+}
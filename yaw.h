@@ -27,12 +27,26 @@
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "event_groups.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "inc/tm4c123gh6pm.h"
+#include "driverlib/gpio.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/qei.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
 #include "uart.h"
 
-#define YAW_REFERENCE_FLAG  (1 << 0)
+// Yaw sensor backend. The GPIO backend decodes every edge in software on PB0/PB1, matching the
+// HeliRig wiring. The QEI backend needs channel A, channel B and the reference wired to PD6, PD7
+// and PD3 (QEI0 PhA0, PhB0, IDX0) as PB0/PB1 cannot be routed to a QEI module.
+#ifndef YAW_SENSOR_QEI
+#define YAW_SENSOR_QEI      0                           // 1 decodes yaw with the QEI peripheral, 0 with GPIO interrupts. The host tests build both
+#endif
+
 #define YAW_REF_TMR_PERIOD  1000
-#define MAX_YAW_SLOTS       448
-#define MIN_YAW_SLOTS       -448
+#define MAX_YAW_SLOTS       448                         // Quadrature slots per revolution
 #define DEGREES_HALF_CIRCLE 180                         // The number of degrees in a half circle
 #define DEGREES_CIRCLE      360                         // The number of degrees in a circle
 #define MAX_YAW_LIMIT       179                         // The maximum yaw (degrees)
@@ -44,12 +58,41 @@
 #define YAW_REFERENCE_BASE  GPIO_PORTC_BASE
 #define YAW_REFERENCE_PIN   GPIO_INT_PIN_4
 #define VALUES_PER_READING  2                           // Number of bits per quadrature reading
+#define QUADRATURE_STATES   16                          // Number of 4-bit quadrature transition codes
+#define QUADRATURE_SKIPPED  0b11                        // Reading change when both channels change at once
+
+#define YAW_QEI_PERIPH      SYSCTL_PERIPH_QEI0
+#define YAW_QEI_BASE        QEI0_BASE
+#define YAW_QEI_INT         INT_QEI0
+#define YAW_QEI_INT_PRIORITY (2 << 5)                   // Must be numerically >= configMAX_SYSCALL_INTERRUPT_PRIORITY
+#define YAW_QEI_GPIO_PERIPH SYSCTL_PERIPH_GPIOD
+#define YAW_QEI_GPIO_BASE   GPIO_PORTD_BASE
+#define YAW_QEI_PINS        (GPIO_PIN_3 | GPIO_PIN_6 | GPIO_PIN_7)  // Index, channel A and channel B
+#define YAW_QEI_SWAP        QEI_CONFIG_SWAP             // Channel B leads when the GPIO backend counts up, and the QEI counts up when PhA leads
+#define YAW_QEI_VEL_RATE_HZ 100                         // Rate at which the QEI captures velocity
+
+#define YAW_RATE_Q_BITS     16                          // Fractional bits of the yaw rate (matches PID_RATE_Q_BITS)
+#define YAW_EDGE_TMR_PERIPH SYSCTL_PERIPH_TIMER1        // Free-running timer used to timestamp quadrature edges
+#define YAW_EDGE_TMR_BASE   TIMER1_BASE
+#define YAW_RATE_TIMEOUT_MS 250                         // The rate reads zero if no edge arrives for this long
+#define YAW_DRIFT_SLEW      1                           // Most the drift correction changes per control period (slots)
+
+
+// Reference drift statistics
+typedef struct YawDriftStats {
+    uint32_t crossings;     // Reference crossings latched
+    int32_t lastDrift;      // Drift measured at the latest crossing (slots)
+    int32_t maxDrift;       // Largest drift magnitude measured (slots)
+    int32_t correction;     // Correction currently applied (slots)
+    int32_t pending;        // Correction still to be slewed in (slots)
+} yawDriftStats_t;
 
 
 /*
  * Function:    initReferenceYaw
  * ------------------------------
  * Initialises the pins and interrupt for the yaw reference.
+ * With the QEI backend the reference is the QEI index input.
  *
  * @params:
  *      - NULL
@@ -62,7 +105,8 @@ void initReferenceYaw(void);
 /*
  * Function:    initQuadrature
  * ----------------------------
- * Initialises the pins and interrupts for quadrature decoding.
+ * Initialises the pins and interrupts for quadrature decoding,
+ * or the QEI peripheral when YAW_SENSOR_QEI is set.
  *
  * @params:
  *      - NULL
@@ -72,4 +116,169 @@ void initReferenceYaw(void);
  */
 void initQuadrature(void);
 
+/*
+ * Function:    updateYawReference
+ * --------------------------------
+ * Applies the reference crossings latched by the interrupts. The
+ * first crossing sets zero yaw. Later crossings in the same
+ * direction measure encoder drift, which is corrected gradually
+ * by YAW_DRIFT_SLEW slots per call. Must be called once per
+ * control period by a single task (ControlExecutive).
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void updateYawReference(void);
+
+/*
+ * Function:    isYawReferenced
+ * -----------------------------
+ * Returns whether the reference has been found, which sets zero
+ * yaw.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - bool referenced: True once a reference crossing is latched.
+ * ---------------------
+ */
+bool isYawReferenced(void);
+
+/*
+ * Function:    getYawDriftStats
+ * ------------------------------
+ * Copies the drift statistics from the last call to
+ * updateYawReference.
+ *
+ * @params:
+ *      - yawDriftStats_t *stats: Destination for the statistics.
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void getYawDriftStats(yawDriftStats_t *stats);
+
+/*
+ * Function:    getYawSlots
+ * -------------------------
+ * Returns the unwrapped number of quadrature slots travelled from
+ * the reference position, less the drift correction applied so
+ * far. The count keeps going past a full revolution.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t yaw_slot: Slots from the reference.
+ * ---------------------
+ */
+int32_t getYawSlots(void);
+
+/*
+ * Function:    getYaw
+ * --------------------
+ * Converts the current slot count to degrees, wrapped to
+ * the range MIN_YAW_LIMIT to MAX_YAW_LIMIT.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t yaw: Current yaw in degrees.
+ * ---------------------
+ */
+int32_t getYaw(void);
+
+/*
+ * Function:    getYawUnwrapped
+ * -----------------------------
+ * Converts the current slot count to degrees without wrapping,
+ * so the angle keeps growing over multiple revolutions.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t yaw: Yaw from the reference in degrees.
+ * ---------------------
+ */
+int32_t getYawUnwrapped(void);
+
+/*
+ * Function:    getYawTurns
+ * -------------------------
+ * Returns the number of whole revolutions from the reference,
+ * rounded towards negative infinity.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t turns: Whole revolutions from the reference.
+ * ---------------------
+ */
+int32_t getYawTurns(void);
+
+/*
+ * Function:    updateYawRate
+ * ---------------------------
+ * Updates the yaw rate estimate. Must be called once per control
+ * period by a single task (ControlExecutive). With the GPIO backend the
+ * rate is slots travelled over the time between the timestamps
+ * of the first and last edges seen since the last estimate, so
+ * it measures the edge period at low speed and counts edges at
+ * high speed. With the QEI backend it is read from the velocity
+ * capture.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t rate: Yaw rate in degrees per second (Q16).
+ * ---------------------
+ */
+int32_t updateYawRate(void);
+
+/*
+ * Function:    getYawRate
+ * ------------------------
+ * Returns the yaw rate from the last call to updateYawRate.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - int32_t rate: Yaw rate in degrees per second (Q16).
+ * ---------------------
+ */
+int32_t getYawRate(void);
+
+/*
+ * Function:    getQuadratureErrors
+ * ---------------------------------
+ * Returns the number of quadrature edges where a state was
+ * skipped.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - uint32_t errors: Number of skipped states.
+ * ---------------------
+ */
+uint32_t getQuadratureErrors(void);
+
+#if !YAW_SENSOR_QEI
+/*
+ * Function:    quadratureFSMInterrupt
+ * ------------------------------------
+ * Pin change interrupt handler for the quadrature decoder.
+ * Looks up the slot change for the transition between the
+ * previous and new channel readings and updates the slot count.
+ *
+ * @params:
+ *      - NULL
+ * @return:
+ *      - NULL
+ * ---------------------
+ */
+void quadratureFSMInterrupt(void);
+#endif /* YAW_SENSOR_QEI */
+
 #endif /* YAW_H_ */